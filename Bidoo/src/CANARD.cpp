@@ -8,6 +8,7 @@
 // #include <sstream>
 #include <algorithm>
 #include <atomic>
+#include <thread>
 #include "dep/waves.hpp"
 
 #if defined(METAMODULE)
@@ -59,24 +60,63 @@ struct CANARD : BidooModule {
 
 	bool play = false;
 	bool record = false;
-	bool save = false;
+	std::atomic<bool> save{false};
 	int channels = 2;
 	int sampleRate = 0;
-  int totalSampleCount = 0;
-	vector<dsp::Frame<2>> playBuffer, recordBuffer;
+	// what the audio thread and the display read, writers publish a new one under lock()
+	struct Content {
+		waves::SampleBuffer<2> buffer;
+		waves::PeakPyramid<2> peaks;
+		std::vector<int> slices;
+	};
+	enum Readers {
+		AUDIO_READER,
+		DISPLAY_READER,
+		NUM_READERS
+	};
+	waves::Published<Content, NUM_READERS> content;
+	// entered for the current process() call
+	const Content *playing = NULL;
+	waves::SaveJob saveJob;
+	waves::RecordArena<2> recorder;
+#if defined(METAMODULE)
+	static constexpr int defaultRecordLength = 60;
+#else
+	static constexpr int defaultRecordLength = 300;
+#endif
+	// seconds, a take stops by itself once it is that long
+	int maxRecordLength = defaultRecordLength;
+	// slice mode when the take stopped, read by serviceRecording
+	bool appendTake = false;
+	waves::OnsetDetector onsets;
+	int onsetFeature = waves::ONSET_ENERGY;
+	// bumped with each buffer or onset feature change, the worker analyses the new content
+	std::atomic<unsigned> bufferVersion{1};
+	std::atomic<unsigned> analysedVersion{0};
+	// set by calcTransients, the worker thresholds the features once they are up to date
+	std::atomic<bool> detect{false};
 	float samplePos = 0.0f, sampleStart = 0.0f, loopLength = 0.0f, fadeLenght = 0.0f, fadeCoeff = 1.0f, speedFactor = 1.0f;
 	size_t prevPlayedSlice = 0;
 	size_t playedSlice = 0;
 	bool changedSlice = false;
 	int readMode = 0; // 0 formward, 1 backward, 2 repeat
 	float speed;
-	std::vector<int> slices;
 	int selected = -1;
-	bool deleteFlag = false;
 	int addSliceMarker = -1;
-	bool addSliceMarkerFlag = false;
 	int deleteSliceMarker = -1;
-	bool deleteSliceMarkerFlag = false;
+	enum SliceEdits {
+		SLICE_DELETE,
+		MARKER_ADD,
+		MARKER_DELETE
+	};
+	struct SliceEdit {
+		int type;
+		// slice index for SLICE_DELETE, frame for the markers
+		int position;
+	};
+	// posted by the widget, applied by the worker on a copy of the content, the audio thread
+	// keeps playing the previous one meanwhile
+	waves::SpscQueue<SliceEdit, 32> edits;
 	size_t index = 0;
 	float prevGateState = 0.0f;
 	float prevTrigState = 0.0f;
@@ -84,10 +124,14 @@ struct CANARD : BidooModule {
 	std::string waveFileName;
 	std::string waveExtension;
 	bool loading = false;
+	// the worker has no APP, the engine rate is kept here from the UI and engine threads
+	std::atomic<float> engineRate{44100.0f};
+	std::atomic<bool> clearing{false};
 	dsp::SchmittTrigger trigTrigger;
 	dsp::SchmittTrigger recordTrigger;
 	dsp::SchmittTrigger clearTrigger;
 	dsp::PulseGenerator eocPulse;
+	// serializes the writers, readers never take it
 	std::atomic<bool> locked{false};
 	bool newStop = false;
 	bool first=true;
@@ -100,6 +144,14 @@ struct CANARD : BidooModule {
 	MetaModule::AsyncThread saveSampleAsync{this, [this]() {
 		this->saveSampleInternal();
 	}};
+
+	MetaModule::AsyncThread workerAsync{this, [this]() {
+		this->serviceWorker();
+	}};
+#else
+	std::thread saveThread;
+	std::thread workerThread;
+	std::atomic<bool> running{true};
 #endif
 
 	CANARD() {
@@ -115,8 +167,11 @@ struct CANARD : BidooModule {
 		configParam(THRESHOLD_PARAM, 0.01f, 10.0f, 1.0f, "Threshold");
 		configSwitch(MODE_PARAM, 0, 1, 0, "Slice mode", {"Off", "On"});
 
-		playBuffer.resize(0);
-		recordBuffer.resize(0);
+		engineRate = APP->engine->getSampleRate();
+
+		Content *initial = new Content();
+		initial->buffer.reset(waves::getCompactSamples());
+		content.publish(initial);
 
 		configInput(INL_INPUT, "In L");
 		configInput(INR_INPUT, "In R");
@@ -134,7 +189,32 @@ struct CANARD : BidooModule {
 		configOutput(OUTL_OUTPUT, "Out L");
 		configOutput(OUTR_OUTPUT, "Out R");
 		configOutput(EOC_OUTPUT, "EOC");
+
+#if !defined(METAMODULE)
+		workerThread = std::thread([this]() {
+			while (running) {
+				if (this->loading) {
+					this->loadSampleInternal();
+				}
+				if (!this->serviceWorker()) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				}
+			}
+		});
+#endif
+	}
+
+#if !defined(METAMODULE)
+	~CANARD() {
+		running = false;
+		if (workerThread.joinable()) {
+			workerThread.join();
+		}
+		if (saveThread.joinable()) {
+			saveThread.join();
+		}
 	}
+#endif
 
 	void process(const ProcessArgs &args) override;
 
@@ -144,6 +224,10 @@ struct CANARD : BidooModule {
 	void saveSample();
 	void loadSampleInternal();
 	void saveSampleInternal();
+	void serviceRecording();
+	bool serviceOnsets();
+	bool serviceEdits();
+	bool serviceWorker();
 	void calcTransients();
 
 	void lock() {
@@ -161,79 +245,69 @@ struct CANARD : BidooModule {
 		json_t *rootJ = BidooModule::dataToJson();
 		// lastPath
 		json_object_set_new(rootJ, "lastPath", json_string(lastPath.c_str()));
+		lock();
+		std::vector<int> slices(content.get().slices);
+		unlock();
 		json_t *slicesJ = json_array();
 		for (size_t i = 0; i<slices.size() ; i++) {
 			json_t *sliceJ = json_integer(slices[i]);
 			json_array_append_new(slicesJ, sliceJ);
 		}
 		json_object_set_new(rootJ, "slices", slicesJ);
+		json_object_set_new(rootJ, "maxRecordLength", json_integer(maxRecordLength));
+		json_object_set_new(rootJ, "onsetFeature", json_integer(onsetFeature));
 
 		return rootJ;
 	}
 
 	void dataFromJson(json_t *rootJ) override {
 		BidooModule::dataFromJson(rootJ);
+		json_t *maxRecordLengthJ = json_object_get(rootJ, "maxRecordLength");
+		if (maxRecordLengthJ) {
+			maxRecordLength = json_integer_value(maxRecordLengthJ);
+		}
+		json_t *onsetFeatureJ = json_object_get(rootJ, "onsetFeature");
+		if (onsetFeatureJ) {
+			onsetFeature = clamp((int)json_integer_value(onsetFeatureJ), 0, waves::NUM_ONSET_FEATURES - 1);
+			bufferVersion++;
+		}
 		json_t *lastPathJ = json_object_get(rootJ, "lastPath");
 		if (lastPathJ) {
 			lastPath = json_string_value(lastPathJ);
 			waveFileName = rack::system::getFilename(lastPath);
 			waveExtension = rack::system::getExtension(lastPath);
 			if (!lastPath.empty()) loadSample();
-			if (totalSampleCount>0) {
+			lock();
+			if (content.get().buffer.size()>0) {
 				json_t *slicesJ = json_object_get(rootJ, "slices");
 				if (slicesJ) {
+					Content *next = new Content(content.get());
 					size_t i;
 					json_t *sliceJ;
 					json_array_foreach(slicesJ, i, sliceJ) {
 							if (i != 0)
-								slices.push_back(json_integer_value(sliceJ));
+								next->slices.push_back(json_integer_value(sliceJ));
 					}
+					content.publish(next);
 				}
 			}
+			unlock();
 		}
 	}
 
-	void onSampleRateChange() override {
-		if (!lastPath.empty()) loadSample();
+	void onSampleRateChange(const SampleRateChangeEvent &e) override {
+		engineRate = e.sampleRate;
+		if (!lastPath.empty()) loading = true;
 	}
 };
 
+// slices are set by the worker from the cached features, right away unless the sample just
+// changed and is still being analysed
 void CANARD::calcTransients() {
-	slices.clear();
-	slices.push_back(0);
-	int i = 0;
-	int size = 256;
-	vector<dsp::Frame<2>>::const_iterator first;
-	vector<dsp::Frame<2>>::const_iterator last;
-	float prevNrgy = 0.0f;
-	while (i+size<totalSampleCount) {
-		first = playBuffer.begin() + i;
-		last = playBuffer.begin() + i + size;
-		vector<dsp::Frame<2>> newVec(first, last);
-		float nrgy = 0.0f;
-		float zcRate = 0.0f;
-		unsigned int zcIdx = 0;
-		bool first = true;
-		for (int k = 0; k < size; k++) {
-			nrgy += 100*newVec[k].samples[0]*newVec[k].samples[0]/size;
-			if (newVec[k].samples[0]==0.0f) {
-				zcRate += 1;
-				if (first) {
-					zcIdx = k;
-					first = false;
-				}
-			}
-		}
-		if ((nrgy > params[CANARD::THRESHOLD_PARAM].getValue()) && (nrgy > 10*prevNrgy))
-			slices.push_back(i+zcIdx);
-		i+=size;
-		prevNrgy = nrgy;
-	}
+	detect = true;
 }
 
 void CANARD::loadSampleInternal() {
-	APP->engine->yieldWorkers();
-	
 	// Get extension and validate
 	std::string ext = rack::system::getExtension(lastPath);
 	std::string upperExt = rack::string::uppercase(ext);
@@ -246,50 +320,214 @@ void CANARD::loadSampleInternal() {
 		return;
 	}
 	
+	// decoded aside, the audio thread keeps playing the previous sample until the publish
+	Content *next = new Content();
+	int frames = 0;
+	waves::getStereoWav(lastPath, engineRate, waveFileName, waveExtension, channels, sampleRate, frames, next->buffer);
+	next->peaks.build(next->buffer);
 	lock();
-	playBuffer = waves::getStereoWav(lastPath, APP->engine->getSampleRate(), waveFileName, waveExtension, channels, sampleRate, totalSampleCount);
+	content.publish(next);
+	bufferVersion++;
 	unlock();
-	slices.clear();
 	loading = false;
-
-	vector<dsp::Frame<2>>(playBuffer).swap(playBuffer);
 }
 
 void CANARD::loadSample() {
 #if defined(METAMODULE)
 	loadSampleAsync.run_once();
 #else
+	APP->engine->yieldWorkers();
 	loadSampleInternal();
 #endif
 }
 
 void CANARD::saveSampleInternal() {
-	APP->engine->yieldWorkers();
+	saveJob.run();
+}
+
+// called by the worker, the job holds a snapshot of the buffer and the file is written aside
+void CANARD::saveSample() {
 	lock();
-	waves::saveWave(playBuffer, APP->engine->getSampleRate(), lastPath);
+	const bool started = saveJob.start(content.get().buffer, engineRate, lastPath);
 	unlock();
+	if (!started) {
+		return;
+	}
 	save = false;
+#if !defined(METAMODULE)
+	if (saveThread.joinable()) {
+		saveThread.join();
+	}
+	saveThread = std::thread([this]() {
+		this->saveSampleInternal();
+	});
+#endif
 }
 
-void CANARD::saveSample() {
-	saveSampleInternal();
+// keeps segments ready for the audio thread and stitches the stopped takes, runs on its own
+// thread so that recording never allocates nor locks
+void CANARD::serviceRecording() {
+	recorder.reserve();
+	if (!recorder.stopped()) {
+		return;
+	}
+	lock();
+	Content *next = appendTake ? new Content(content.get()) : new Content();
+	if (appendTake) {
+		const size_t from = next->buffer.size();
+		next->slices.push_back(from > 0 ? (from-1) : 0);
+		recorder.stitch(next->buffer);
+		next->peaks.update(next->buffer, from);
+	}
+	else {
+		next->slices.push_back(0);
+		next->buffer.reset(waves::getCompactSamples());
+		recorder.stitch(next->buffer);
+		next->peaks.build(next->buffer);
+		lastPath = "";
+		waveFileName = "";
+		waveExtension = "";
+	}
+	content.publish(next);
+	bufferVersion++;
+	unlock();
+}
+
+// applies one posted slice edit, false once the queue is empty. The edit works on a copy of
+// the content, the copy on write buffer gets a private storage before the erase
+bool CANARD::serviceEdits() {
+	SliceEdit edit;
+	if (!edits.pop(edit)) {
+		return false;
+	}
+	lock();
+	const unsigned version = bufferVersion;
+	Content *next = new Content(content.get());
+	unlock();
+
+	std::vector<int> &s = next->slices;
+	bool changed = false;
+	if (edit.type == SLICE_DELETE) {
+		const int i = edit.position;
+		if ((i >= 0) && ((size_t)i < s.size())) {
+			int nbSample = 0;
+			if ((size_t)i < (s.size()-1)) {
+				nbSample = s[i + 1] - s[i] - 1;
+				next->buffer.erase(s[i], s[i + 1]-1);
+			}
+			else {
+				nbSample = next->buffer.size() - s[i];
+				next->buffer.erase(s[i], next->buffer.size());
+			}
+			next->peaks.update(next->buffer, s[i]);
+			s.erase(s.begin()+i);
+			for (size_t k = i; k < s.size(); k++) {
+				s[k] = s[k]-nbSample;
+			}
+			changed = true;
+		}
+	}
+	else if (edit.type == MARKER_ADD) {
+		if ((edit.position >= 0) && (std::find(s.begin(), s.end(), edit.position) == s.end())) {
+			s.insert(std::upper_bound(s.begin(), s.end(), edit.position), edit.position);
+		}
+	}
+	else if (edit.type == MARKER_DELETE) {
+		auto it = std::find(s.begin(), s.end(), edit.position);
+		if (it != s.end()) {
+			s.erase(it);
+		}
+	}
+
+	lock();
+	// dropped if a load, a clear or a take replaced the buffer meanwhile
+	if (bufferVersion == version) {
+		content.publish(next);
+		if (changed) {
+			bufferVersion++;
+		}
+	}
+	else {
+		delete next;
+	}
+	unlock();
+	return true;
+}
+
+// computes the features of the current sample a step at a time, false once there is
+// nothing left to do
+bool CANARD::serviceOnsets() {
+	if (onsets.version != bufferVersion) {
+		lock();
+		const unsigned version = bufferVersion;
+		onsets.start(content.get().buffer, version, onsetFeature);
+		unlock();
+	}
+	if (onsets.running) {
+		if (!onsets.step()) {
+			return true;
+		}
+		analysedVersion = onsets.version;
+	}
+	if (detect.exchange(false)) {
+		std::vector<int> result;
+		onsets.slices(params[THRESHOLD_PARAM].getValue(), result);
+		lock();
+		if (onsets.version == bufferVersion) {
+			Content *next = new Content(content.get());
+			next->slices.swap(result);
+			content.publish(next);
+		}
+		else {
+			detect = true;
+		}
+		unlock();
+	}
+	return onsets.version != bufferVersion;
+}
+
+// background side of the module, false when idle
+bool CANARD::serviceWorker() {
+	if (clearing.exchange(false)) {
+		Content *next = new Content();
+		next->buffer.reset(waves::getCompactSamples());
+		lock();
+		content.publish(next);
+		bufferVersion++;
+		unlock();
+		lastPath = "";
+		waveFileName = "";
+		waveExtension = "";
+	}
+	if (save) {
+		saveSample();
+	}
+	serviceRecording();
+	while (serviceEdits()) {}
+	const bool busy = serviceOnsets();
+	lock();
+	content.reclaim();
+	unlock();
+	return busy;
 }
 
 void CANARD::calcLoop() {
+	const std::vector<int> &slices = playing->slices;
+	const int totalSampleCount = playing->buffer.size();
 	prevPlayedSlice = index;
 	index = 0;
 	int sliceStart = 0;
 	int sliceEnd = totalSampleCount > 0 ? totalSampleCount - 1 : 0;
 	
 	// Only calculate slices if module is not loading and we have a valid buffer
-	if (!loading && !locked.load() && (params[MODE_PARAM].getValue() == 1) && (slices.size()>0))
+	if (!loading && (params[MODE_PARAM].getValue() == 1) && (slices.size()>0))
 	{
 		index = round(clamp(params[SLICE_PARAM].getValue() + inputs[SLICE_INPUT].getVoltage(), 0.0f,10.0f)*(slices.size()-1)/10);
 		sliceStart = slices[index];
 		sliceEnd = (index < (slices.size() - 1)) ? (slices[index+1] - 1) : (totalSampleCount - 1);
 	}
 
-	if (totalSampleCount > 0 && !loading && !locked.load()) {
+	if (totalSampleCount > 0 && !loading) {
 		sampleStart = rescale(clamp(inputs[SAMPLE_START_INPUT].getVoltage() + params[SAMPLE_START_PARAM].getValue(), 0.0f, 10.0f), 0.0f, 10.0f, sliceStart, sliceEnd);
 		loopLength = clamp(rescale(clamp(inputs[LOOP_LENGTH_INPUT].getVoltage() + params[LOOP_LENGTH_PARAM].getValue(), 0.0f, 10.0f), 0.0f, 10.0f, 0.0f, sliceEnd - sliceStart + 1),1.0f,sliceEnd-sampleStart+1);
 		fadeLenght = rescale(clamp(inputs[FADE_INPUT].getVoltage() + params[FADE_PARAM].getValue(), 0.0f, 10.0f), 0.0f, 10.0f,0.0f, floor(loopLength/2));
@@ -304,7 +542,7 @@ void CANARD::calcLoop() {
 
 void CANARD::initPos() {
 	// Don't try to play if we're loading or don't have valid data
-	if (loading || locked.load() || totalSampleCount <= 0 || playBuffer.size() <= 0) {
+	if (loading || playing->buffer.size() <= 0) {
 		samplePos = 0;
 		speedFactor = 1.0f;
 		return;
@@ -322,120 +560,58 @@ void CANARD::initPos() {
 }
 
 void CANARD::process(const ProcessArgs &args) {
+	playing = content.enter(AUDIO_READER);
+	const std::vector<int> &slices = playing->slices;
+	const int totalSampleCount = playing->buffer.size();
+	const waves::SampleBuffer<2> &playBuffer = playing->buffer;
+
+#if defined(METAMODULE)
 	if (loading) {
 		loadSample();
 	}
 
-	if (save) {
-		saveSample();
+	if (saveJob.state == waves::SaveJob::SAVE_PENDING) {
+		saveSampleAsync.run_once();
 	}
+#endif
 
 	if (clearTrigger.process(inputs[CLEAR_INPUT].getVoltage() + params[CLEAR_PARAM].getValue()))
 	{
-		lock();
-		playBuffer.clear();
-		totalSampleCount = 0;
-		slices.clear();
-		unlock();
-		lastPath = "";
-		waveFileName = "";
-		waveExtension = "";
-	}
-
-	if ((selected>=0) && (deleteFlag)) {
-		int nbSample=0;
-		if ((size_t)selected<(slices.size()-1)) {
-			nbSample = slices[selected + 1] - slices[selected] - 1;
-			lock();
-			playBuffer.erase(playBuffer.begin() + slices[selected], playBuffer.begin() + slices[selected + 1]-1);
-			unlock();
-		}
-		else {
-			nbSample = totalSampleCount - slices[selected];
-			lock();
-			playBuffer.erase(playBuffer.begin() + slices[selected], playBuffer.end());
-			unlock();
-		}
-		slices.erase(slices.begin()+selected);
-		totalSampleCount = playBuffer.size();
-		for (size_t i = selected; i < slices.size(); i++)
-		{
-			slices[i] = slices[i]-nbSample;
-		}
-		selected = -1;
-		deleteFlag = false;
-		calcLoop();
-	}
-
-	if ((addSliceMarker>=0) && (addSliceMarkerFlag)) {
-		if (std::find(slices.begin(), slices.end(), addSliceMarker) != slices.end()) {
-			addSliceMarker = -1;
-			addSliceMarkerFlag = false;
-		}
-		else {
-			auto it = std::upper_bound(slices.begin(), slices.end(), addSliceMarker);
-			lock();
-			slices.insert(it, addSliceMarker);
-			unlock();
-			addSliceMarker = -1;
-			addSliceMarkerFlag = false;
-			calcLoop();
-		}
-	}
-
-	if ((deleteSliceMarker>=0) && (deleteSliceMarkerFlag)) {
-		if (std::find(slices.begin(), slices.end(), deleteSliceMarker) != slices.end()) {
-			lock();
-			slices.erase(std::find(slices.begin(), slices.end(), deleteSliceMarker));
-			unlock();
-			deleteSliceMarker = -1;
-			deleteSliceMarkerFlag = false;
-			calcLoop();
-		}
+		clearing = true;
 	}
 
 	if (recordTrigger.process(inputs[RECORD_INPUT].getVoltage() + params[RECORD_PARAM].getValue()))
 	{
 		if(record) {
-			if (floor(params[MODE_PARAM].getValue()) == 0) {
-				lock();
-				slices.clear();
-				slices.push_back(0);
-				playBuffer.resize(0);
-				for (int i = 0; i < (int)recordBuffer.size(); i++) {
-					dsp::Frame<2> frame = recordBuffer[i];
-					playBuffer.push_back(frame);
-				}
-				totalSampleCount = playBuffer.size();
-				unlock();
-				lastPath = "";
-				waveFileName = "";
-				waveExtension = "";
-			}
-			else {
-				lock();
-				slices.push_back(totalSampleCount > 0 ? (totalSampleCount-1) : 0);
-				playBuffer.insert(playBuffer.end(), recordBuffer.begin(), recordBuffer.end());
-				totalSampleCount = playBuffer.size();
-				unlock();
-			}
-			lock();
-			recordBuffer.resize(0);
-			unlock();
+			appendTake = floor(params[MODE_PARAM].getValue()) != 0;
+			recorder.stop();
+			record = false;
 			lights[REC_LIGHT].setBrightness(0.0f);
 		}
-		record = !record;
+		else {
+			// refused until the previous take is stitched
+			record = recorder.start((size_t)(maxRecordLength * args.sampleRate));
+		}
 	}
 
 	if (record) {
 		lights[REC_LIGHT].setBrightness(10.0f);
-		lock();
 		dsp::Frame<2> frame;
 		frame.samples[0] = inputs[INL_INPUT].getVoltage()/10.0f;
 		frame.samples[1] = inputs[INR_INPUT].getVoltage()/10.0f;
-		recordBuffer.push_back(frame);
-		unlock();
+		if (!recorder.push(frame)) {
+			appendTake = floor(params[MODE_PARAM].getValue()) != 0;
+			recorder.stop();
+			record = false;
+			lights[REC_LIGHT].setBrightness(0.0f);
+		}
+	}
+
+#if defined(METAMODULE)
+	if (clearing || save || recorder.stopped() || (recorder.ready() < waves::RecordArena<2>::ahead) || !edits.empty() || detect || (analysedVersion != bufferVersion) || content.retiring()) {
+		workerAsync.run_once();
 	}
+#endif
 
 	int trigMode = inputs[TRIG_INPUT].isConnected() ? 1 : (inputs[GATE_INPUT].isConnected() ? 2 : 0);
 	int readMode = round(clamp(inputs[READ_MODE_INPUT].getVoltage() + params[READ_MODE_PARAM].getValue(),0.0f,2.0f));
@@ -443,7 +619,7 @@ void CANARD::process(const ProcessArgs &args) {
 	calcLoop();
 
 	if (trigMode == 1) {
-		if (trigTrigger.process(inputs[TRIG_INPUT].getVoltage()) && (prevTrigState == 0.0f) && !loading && !locked.load())
+		if (trigTrigger.process(inputs[TRIG_INPUT].getVoltage()) && (prevTrigState == 0.0f) && !loading)
 		{
 			initPos();
 			if ((slices.size() == 1) && (inputs[SLICE_INPUT].isConnected())) {
@@ -484,7 +660,7 @@ void CANARD::process(const ProcessArgs &args) {
 	}
 	else if (trigMode == 2)
 	{
-		if (inputs[GATE_INPUT].getVoltage()>0.1f && !loading && !locked.load())
+		if (inputs[GATE_INPUT].getVoltage()>0.1f && !loading)
 		{
 			play = true;
 			if (inputs[SLICE_INPUT].isConnected()) {
@@ -534,7 +710,7 @@ void CANARD::process(const ProcessArgs &args) {
 
 	if (play) {
 		newStop = true;
-		if (!loading && !locked.load() && samplePos < totalSampleCount && totalSampleCount > 0 && playBuffer.size() > 0) {
+		if (!loading && samplePos < totalSampleCount && totalSampleCount > 0) {
 			if (fadeLenght>1000) {
 				if ((samplePos-sampleStart)<fadeLenght)
 					fadeCoeff = rescale(samplePos-sampleStart,0.0f,fadeLenght,0.0f,1.0f);
@@ -564,6 +740,7 @@ void CANARD::process(const ProcessArgs &args) {
 	}
 
 	outputs[EOC_OUTPUT].setVoltage(eocPulse.process(1 / args.sampleRate) ? 10.0f : 0.0f);
+	content.leave(AUDIO_READER);
 }
 
 struct BidooTransientsBlueTrimpot : BidooBlueTrimpot {
@@ -591,14 +768,17 @@ struct CANARDDisplay : OpaqueWidget {
 	}
 
 	void onButton(const event::Button &e) override {
-		if (module->slices.size()>0) {
+		const CANARD::Content *content = module->content.enter(CANARD::DISPLAY_READER);
+		const std::vector<int> &slices = content->slices;
+		if (slices.size()>0) {
 			refX = e.pos.x;
-			refIdx = ((e.pos.x - zoomLeftAnchor)/zoomWidth)*(float)module->totalSampleCount;
+			refIdx = ((e.pos.x - zoomLeftAnchor)/zoomWidth)*(float)content->buffer.size();
 			module->addSliceMarker = refIdx;
-			auto lower = std::lower_bound(module->slices.begin(), module->slices.end(), refIdx);
-			module->selected = distance(module->slices.begin(),lower-1);
+			auto lower = std::lower_bound(slices.begin(), slices.end(), refIdx);
+			module->selected = distance(slices.begin(),lower-1);
 			module->deleteSliceMarker = *(lower-1);
 		}
+		module->content.leave(CANARD::DISPLAY_READER);
 		if (e.button == 0)
 			OpaqueWidget::onButton(e);
 		else {
@@ -635,11 +815,18 @@ struct CANARDDisplay : OpaqueWidget {
 
 	void drawLayer(const DrawArgs& args, int layer) override {
 		if (layer == 1) {
-			if (module && (module->playBuffer.size()>0)) {
-				module->lock();
-				std::vector<int> s(module->slices);
-				module->unlock();
-				size_t nbSample = module->totalSampleCount;
+			const CANARD::Content *content = module ? module->content.enter(CANARD::DISPLAY_READER) : NULL;
+			if (content && (content->buffer.size()>0)) {
+				const int pixels = width + 1;
+				std::vector<float> lo[2], hi[2];
+				std::vector<int> s(content->slices);
+				size_t nbSample = content->buffer.size();
+				for (int c = 0; c < 2; c++) {
+					lo[c].resize(pixels);
+					hi[c].resize(pixels);
+					content->peaks.draw(content->buffer, c, -zoomLeftAnchor * nbSample / zoomWidth, nbSample / zoomWidth, pixels, lo[c].data(), hi[c].data());
+				}
+				module->content.leave(CANARD::DISPLAY_READER);
 
 				nvgScissor(args.vg, 0, 0, width, 2*height+10);
 
@@ -711,54 +898,28 @@ struct CANARDDisplay : OpaqueWidget {
 						nvgStroke(args.vg);
 					}
 
-					// Draw waveform
+					// Draw waveform, a min/max stroke per pixel
 
 					if (nbSample>0) {
 						nvgStrokeColor(args.vg, PINK_BIDOO);
 						nvgSave(args.vg);
-						Rect b = Rect(Vec(zoomLeftAnchor, 0), Vec(zoomWidth, height));
-						float invNbSample = 1.0f / nbSample;
-						size_t inc = std::max(nbSample/zoomWidth/4,1.f);
-						nvgBeginPath(args.vg);
-						for (size_t i = 0; i < nbSample; i+=inc) {
-							float x, y;
-							x = (float)i * invNbSample ;
-							y = (-1.f)*module->playBuffer[i].samples[0] * 0.5f + 0.5f;
-							Vec p;
-							p.x = b.pos.x + b.size.x * x;
-							p.y = b.pos.y + b.size.y * (1.0f - y);
-							if (i == 0) {
-								nvgMoveTo(args.vg, p.x, p.y);
-							}
-							else {
-								nvgLineTo(args.vg, p.x, p.y);
-							}
-						}
-
-						nvgLineCap(args.vg, NVG_MITER);
-						nvgStrokeWidth(args.vg, 1);
-						nvgGlobalCompositeOperation(args.vg, NVG_LIGHTER);
-						nvgStroke(args.vg);
-
-						b = Rect(Vec(zoomLeftAnchor, height+10), Vec(zoomWidth, height));
-						nvgBeginPath(args.vg);
-						for (size_t i = 0; i < nbSample; i+=inc) {
-							float x, y;
-							x = (float)i * invNbSample;
-							y = (-1.f)*module->playBuffer[i].samples[1] * 0.5f + 0.5f;
-							Vec p;
-							p.x = b.pos.x + b.size.x * x;
-							p.y = b.pos.y + b.size.y * (1.0f - y);
-							if (i == 0)
-								nvgMoveTo(args.vg, p.x, p.y);
-							else {
-								nvgLineTo(args.vg, p.x, p.y);
+						for (int c = 0; c < 2; c++) {
+							const float top = c == 0 ? 0.0f : height+10;
+							nvgBeginPath(args.vg);
+							for (int x = 0; x < pixels; x++) {
+								if (x == 0) {
+									nvgMoveTo(args.vg, x, top + height * (0.5f + 0.5f * hi[c][x]));
+								}
+								else {
+									nvgLineTo(args.vg, x, top + height * (0.5f + 0.5f * hi[c][x]));
+								}
+								nvgLineTo(args.vg, x, top + height * (0.5f + 0.5f * lo[c][x]));
 							}
+							nvgLineCap(args.vg, NVG_MITER);
+							nvgStrokeWidth(args.vg, 1);
+							nvgGlobalCompositeOperation(args.vg, NVG_LIGHTER);
+							nvgStroke(args.vg);
 						}
-						nvgLineCap(args.vg, NVG_MITER);
-						nvgStrokeWidth(args.vg, 1);
-						nvgGlobalCompositeOperation(args.vg, NVG_LIGHTER);
-						nvgStroke(args.vg);
 					}
 
 					//draw slices
@@ -783,9 +944,21 @@ struct CANARDDisplay : OpaqueWidget {
 					}
 
 				}
+
+				// save progress
+				if (module->saveJob.busy()) {
+					nvgFillColor(args.vg, LIGHTBLUE_BIDOO);
+					nvgBeginPath(args.vg);
+					nvgRect(args.vg, 0, 2*height+8, width * module->saveJob.progress(), 2);
+					nvgClosePath(args.vg);
+					nvgFill(args.vg);
+				}
 				nvgResetScissor(args.vg);
 				nvgRestore(args.vg);
 			}
+			else if (content) {
+				module->content.leave(CANARD::DISPLAY_READER);
+			}
 		}
 		Widget::drawLayer(args, layer);
 	}
@@ -853,28 +1026,33 @@ struct CANARDWidget : BidooWidget {
 	struct CANARDDeleteSlice : MenuItem {
 		CANARD *module;
 		void onAction(const event::Action &e) override {
-			module->deleteFlag = true;
+			if ((module->selected >= 0) && module->edits.push({CANARD::SLICE_DELETE, module->selected})) {
+				module->selected = -1;
+			}
 		}
 	};
 
 	struct CANARDDeleteSliceMarker : MenuItem {
 		CANARD *module;
 		void onAction(const event::Action &e) override {
-			module->deleteSliceMarkerFlag = true;
+			if ((module->deleteSliceMarker >= 0) && module->edits.push({CANARD::MARKER_DELETE, module->deleteSliceMarker})) {
+				module->deleteSliceMarker = -1;
+			}
 		}
 	};
 
 	struct CANARDAddSliceMarker : MenuItem {
 		CANARD *module;
 		void onAction(const event::Action &e) override {
-			module->addSliceMarkerFlag = true;
+			if ((module->addSliceMarker >= 0) && module->edits.push({CANARD::MARKER_ADD, module->addSliceMarker})) {
+				module->addSliceMarker = -1;
+			}
 		}
 	};
 
 	struct CANARDTransientDetect : MenuItem {
 		CANARD *module;
 		void onAction(const event::Action &e) override {
-			APP->engine->yieldWorkers();
 			module->calcTransients();
 		}
 	};
@@ -910,6 +1088,23 @@ struct CANARDWidget : BidooWidget {
 		module->loading=true;
 	}
 
+	struct CANARDMaxRecordLength : MenuItem {
+		CANARD *module;
+		int length;
+		void onAction(const event::Action &e) override {
+			module->maxRecordLength = length;
+		}
+	};
+
+	struct CANARDOnsetFeature : MenuItem {
+		CANARD *module;
+		int feature;
+		void onAction(const event::Action &e) override {
+			module->onsetFeature = feature;
+			module->bufferVersion++;
+		}
+	};
+
 	struct CANARDSaveSample : MenuItem {
 		CANARD *module;
 		void onAction(const event::Action &e) override {
@@ -935,6 +1130,10 @@ struct CANARDWidget : BidooWidget {
 	};
 
 
+	static std::string recordLengthLabel(const int seconds) {
+		return seconds < 60 ? std::to_string(seconds) + " s" : std::to_string(seconds / 60) + " min";
+	}
+
 	void appendContextMenu(ui::Menu *menu) override {
 		BidooWidget::appendContextMenu(menu);
 		CANARD *module = dynamic_cast<CANARD*>(this->module);
@@ -945,8 +1144,22 @@ struct CANARDWidget : BidooWidget {
 		menu->addChild(construct<CANARDDeleteSliceMarker>(&MenuItem::text, "Delete slice marker", &CANARDDeleteSliceMarker::module, module));
 		menu->addChild(construct<CANARDAddSliceMarker>(&MenuItem::text, "Add slice marker", &CANARDAddSliceMarker::module, module));
 		menu->addChild(construct<CANARDTransientDetect>(&MenuItem::text, "Detect transients", &CANARDTransientDetect::module, module));
+		menu->addChild(createSubmenuItem("Transients from", waves::onsetFeatureLabels[module->onsetFeature], [=](ui::Menu* menu) {
+			for (int i = 0; i < waves::NUM_ONSET_FEATURES; i++) {
+				menu->addChild(construct<CANARDOnsetFeature>(&MenuItem::text, module->onsetFeature == i ? waves::onsetFeatureLabels[i] + " ✓" : waves::onsetFeatureLabels[i], &CANARDOnsetFeature::module, module, &CANARDOnsetFeature::feature, i));
+			}
+		}));
 		menu->addChild(construct<CANARDLoadSample>(&MenuItem::text, "Load sample", &CANARDLoadSample::module, module));
 		menu->addChild(construct<CANARDSaveSample>(&MenuItem::text, "Save sample", &CANARDSaveSample::module, module));
+		menu->addChild(createSubmenuItem("Max recording length", recordLengthLabel(module->maxRecordLength), [=](ui::Menu* menu) {
+			static const int lengths[] = {30, 60, 120, 300, 600};
+			for (int length : lengths) {
+				menu->addChild(construct<CANARDMaxRecordLength>(&MenuItem::text, module->maxRecordLength == length ? recordLengthLabel(length) + " ✓" : recordLengthLabel(length), &CANARDMaxRecordLength::module, module, &CANARDMaxRecordLength::length, length));
+			}
+		}));
+		appendSaveFormatMenu(menu);
+		appendResampleMenu(menu);
+		appendCompactMenu(menu);
 	}
 };
 
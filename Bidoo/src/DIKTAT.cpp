@@ -8,6 +8,7 @@
 #include "dep/quantizer.hpp"
 
 using namespace std;
+using simd::float_4;
 
 struct DIKTAT : BidooModule {
 	enum ParamIds {
@@ -152,6 +153,8 @@ void DIKTAT::process(const ProcessArgs &args) {
 
 		inputNote[i] = inputs[NOTE_INPUT].getVoltage(i);
 
+		if (globalMode) continue;
+
 		chord = quant.closestChordInScale(inputNote[i], lRootNote[i], lScale[i]);
 
 		outputs[NOTE_TONIC_OUTPUT].setVoltage(chord.tonic,i);
@@ -162,6 +165,21 @@ void DIKTAT::process(const ProcessArgs &args) {
 		outputs[NOTE_ELEVENTH_OUTPUT].setVoltage(chord.eleventh,i);
 		outputs[NOTE_THIRTEENTH_OUTPUT].setVoltage(chord.thirteenth,i);
 	}
+
+	// all channels share channel 1 root note and scale, quantize them 4 at a time
+	if (globalMode) {
+		for (int i=0;i<c;i+=4) {
+			quantizer::Chord4 chord4 = quant.closestChordInScale(inputs[NOTE_INPUT].getVoltageSimd<float_4>(i), lRootNote[0], lScale[0]);
+
+			outputs[NOTE_TONIC_OUTPUT].setVoltageSimd(chord4.tonic,i);
+			outputs[NOTE_THIRD_OUTPUT].setVoltageSimd(chord4.third,i);
+			outputs[NOTE_FIFTH_OUTPUT].setVoltageSimd(chord4.fifth,i);
+			outputs[NOTE_SEVENTH_OUTPUT].setVoltageSimd(chord4.seventh,i);
+			outputs[NOTE_NINTH_OUTPUT].setVoltageSimd(chord4.ninth,i);
+			outputs[NOTE_ELEVENTH_OUTPUT].setVoltageSimd(chord4.eleventh,i);
+			outputs[NOTE_THIRTEENTH_OUTPUT].setVoltageSimd(chord4.thirteenth,i);
+		}
+	}
 }
 
 struct DIKTATWidget : BidooWidget {
@@ -13,6 +13,7 @@ Based on Laurent de Soras resampler for pitch shifting
 #include <iomanip>
 // #include <sstream>
 #include <mutex>
+#include <cstdint>
 #include "dep/waves.hpp"
 
 #if defined(METAMODULE)
@@ -101,17 +102,16 @@ struct EDSAROS : BidooModule {
 	std::string lastPath;
 	std::string waveFileName;
 	std::string waveExtension;
-	vector<dsp::Frame<1>> loadingBuffer;
+	waves::SampleBuffer<1> loadingBuffer;
+	waves::PeakPyramid<1> peaks;
 	int channels=0;
 	int sampleRate=0;
 	int totalSampleCount=0;
 	rspl::InterpPack interp_pack;
 	rspl::MipMapFlt	mip_map;
-	rspl::MipMapFlt	rev_mip_map;
 	rspl::ResamplerFlt voices[16];
 	rspl::ResamplerFlt rev_voices[16];
 	float *sample = NULL;
-	float *rev_sample = NULL;
 	bool loading = false;
 	int pos = 0;
 	dsp::DoubleRingBuffer<float,SIZE> audio[16];
@@ -148,6 +148,33 @@ struct EDSAROS : BidooModule {
   dsp::SchmittTrigger zeroCrossingTrigger;
 	std::atomic<bool> locked{false};
 
+	enum VoiceStealing {
+		STEAL_OLDEST,
+		STEAL_QUIETEST,
+		NUM_VOICE_STEALING
+	};
+#if defined(METAMODULE)
+	static constexpr int defaultMaxVoices = 8;
+#else
+	static constexpr int defaultMaxVoices = 16;
+#endif
+	// seconds, how long a stolen voice takes to fade out
+	static constexpr float stealFadeTime = 0.005f;
+	int maxVoices = defaultMaxVoices;
+	int voiceStealing = STEAL_OLDEST;
+	uint64_t frame = 0;
+	uint64_t startedAt[16] = {0};
+	bool stealing[16] = {false};
+	float stealGain[16] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+	// stolen while the gate was high, waits for the next gate
+	bool held[16] = {false};
+	// voices sounding at once and voices stolen, over the last second, for the menu
+	int voicesActive = 0;
+	int voicesStolen = 0;
+	int statsActive = 0;
+	int statsStolen = 0;
+	float statsTime = 0.0f;
+
 #if defined(METAMODULE)
 	MetaModule::AsyncThread loadSampleAsync{this, [this]() {
 		this->loadSampleInternal();
@@ -203,7 +230,6 @@ struct EDSAROS : BidooModule {
 
 	~EDSAROS() {
 		free(sample);
-		free(rev_sample);
 	}
 
 	void process(const ProcessArgs &args) override;
@@ -226,6 +252,8 @@ struct EDSAROS : BidooModule {
 		json_t *rootJ = BidooModule::dataToJson();
 		json_object_set_new(rootJ, "lastPath", json_string(lastPath.c_str()));
     json_object_set_new(rootJ, "zeroCrossing", json_boolean(zeroCrossing));
+		json_object_set_new(rootJ, "maxVoices", json_integer(maxVoices));
+		json_object_set_new(rootJ, "voiceStealing", json_integer(voiceStealing));
 		return rootJ;
 	}
 
@@ -238,6 +266,10 @@ struct EDSAROS : BidooModule {
 		}
     json_t *zeroCrossingJ = json_object_get(rootJ, "zeroCrossing");
 		if (zeroCrossingJ) zeroCrossing = json_is_true(zeroCrossingJ);
+		json_t *maxVoicesJ = json_object_get(rootJ, "maxVoices");
+		if (maxVoicesJ) maxVoices = clamp((int)json_integer_value(maxVoicesJ), 1, 16);
+		json_t *voiceStealingJ = json_object_get(rootJ, "voiceStealing");
+		if (voiceStealingJ) voiceStealing = clamp((int)json_integer_value(voiceStealingJ), 0, NUM_VOICE_STEALING - 1);
 	}
 
 	float getXBez(const float t, const float x1, const float x2, const float x3) {
@@ -298,8 +330,44 @@ struct EDSAROS : BidooModule {
 		return idx;
 	}
 
+	// reverse voices read the looped copy downward, so they can run past the start
+	// the way forward voices run past the end
 	int revIndex(const int i) {
-		return totalSampleCount-i-1;
+		return totalSampleCount+i;
+	}
+
+	// makes room for a new voice on channel c, fading out the oldest or quietest
+	// sounding voices while maxVoices are already playing
+	void allocateVoice(const int c, const int polyChannels) {
+		while (true) {
+			int sounding = 0;
+			int victim = -1;
+			for (int i=0; i<polyChannels; i++) {
+				if ((i==c) || stealing[i] || !(play[i] || rel[i])) continue;
+				sounding++;
+				if ((victim<0)
+					|| ((voiceStealing==STEAL_OLDEST) && (startedAt[i]<startedAt[victim]))
+					|| ((voiceStealing==STEAL_QUIETEST) && (gain[i]<gain[victim]))) {
+					victim = i;
+				}
+			}
+			if ((sounding<maxVoices) || (victim<0)) break;
+			stealing[victim] = true;
+			statsStolen++;
+		}
+		startedAt[c] = frame;
+	}
+
+	void endSteal(const int c) {
+		stealing[c] = false;
+		stealGain[c] = 1.0f;
+		play[c] = false;
+		rel[c] = false;
+		held[c] = true;
+		audio[c].startIncr(audio[c].size());
+		voices[c].set_playback_pos(static_cast <rspl::Int64> (sampleStart) << 32);
+		rev_voices[c].set_playback_pos(static_cast <rspl::Int64> (revIndex(sampleStart)) << 32);
+		direction[c] = 1;
 	}
 
 	void updatePoints() {
@@ -352,18 +420,15 @@ void EDSAROS::loadSampleInternal() {
 	}
 
 	lock();
-	loadingBuffer = waves::getMonoWav(lastPath, APP->engine->getSampleRate(), waveFileName, waveExtension, channels, sampleRate, totalSampleCount);
+	waves::getMonoWav(lastPath, APP->engine->getSampleRate(), waveFileName, waveExtension, channels, sampleRate, totalSampleCount, loadingBuffer);
+	peaks.build(loadingBuffer);
 	if (loadingBuffer.size()>0) {
 		free(sample);
-		free(rev_sample);
 		sample = new float[2*totalSampleCount];
-		rev_sample = new float[2*totalSampleCount];
 
 		for (int i=0; i<totalSampleCount; i++) {
 			sample[i]=loadingBuffer[i].samples[0];
 			sample[i+totalSampleCount]=loadingBuffer[i].samples[0];
-			rev_sample[i]=loadingBuffer[totalSampleCount-i-1].samples[0];
-			rev_sample[i+totalSampleCount]=loadingBuffer[totalSampleCount-i-1].samples[0];
 		}
 
 		mip_map.init_sample (
@@ -377,31 +442,19 @@ void EDSAROS::loadSampleInternal() {
 
 		mip_map.fill_sample (&sample[0], 2*totalSampleCount);
 
-		rev_mip_map.init_sample (
-			2*totalSampleCount,
-			rspl::InterpPack::get_len_pre (),
-			rspl::InterpPack::get_len_post (),
-			12,
-			rspl::ResamplerFlt::_fir_mip_map_coef_arr,
-			rspl::ResamplerFlt::MIP_MAP_FIR_LEN
-		);
-
-		rev_mip_map.fill_sample (&rev_sample[0], 2*totalSampleCount);
-
 		for (int i=0; i<16; i++) {
 			voices[i].set_sample (mip_map);
 			voices[i].set_interp (interp_pack);
 			voices[i].clear_buffers ();
-			rev_voices[i].set_sample (rev_mip_map);
+			rev_voices[i].set_sample (mip_map);
 			rev_voices[i].set_interp (interp_pack);
+			rev_voices[i].set_reverse (true);
 			rev_voices[i].clear_buffers ();
 		}
 
 	}
 	unlock();
 	loading = false;
-
-	vector<dsp::Frame<1>>(loadingBuffer).swap(loadingBuffer);
 }
 
 void EDSAROS::loadSample() {
@@ -435,10 +488,29 @@ void EDSAROS::process(const ProcessArgs &args) {
 
 	updatePoints();
 
+	frame++;
+	statsTime += args.sampleTime;
+	if (statsTime>=1.0f) {
+		voicesActive = statsActive;
+		voicesStolen = statsStolen;
+		statsActive = 0;
+		statsStolen = 0;
+		statsTime = 0.0f;
+	}
+
 	if (totalSampleCount>0) {
-		for (int i=0; i<inputs[PITCH_INPUT].getChannels(); i++) {
-			if (inputs[TRIG_INPUT].getVoltage(i)>0.5f) {
+		const int polyChannels = inputs[PITCH_INPUT].getChannels();
+		for (int i=0; i<polyChannels; i++) {
+			const bool gate = inputs[TRIG_INPUT].getVoltage(i)>0.5f;
+			if (held[i]) {
+				held[i] = gate;
+			}
+			else if (stealing[i]) {
+				// the gate is ignored until the steal fade is over
+			}
+			else if (gate) {
 				if (!play[i]) {
+					allocateVoice(i, polyChannels);
 					voiceTime[i]=0.0f;
 					rel[i]=false;
 					voices[i].set_playback_pos(static_cast <rspl::Int64> (sampleStart) << 32);
@@ -462,6 +534,15 @@ void EDSAROS::process(const ProcessArgs &args) {
 				}
 			}
 
+			// idle voices cost nothing once their last block has played
+			if (!play[i] && !rel[i] && !stealing[i] && (audio[i].size()==0)) {
+				// keeps the display playhead where the voice was reset
+				internalIntegerPosition[i] = voices[i].get_playback_pos() >> 32;
+				direction[i] = 1;
+				outputs[OUT].setVoltage(0.0f,i);
+				continue;
+			}
+
 			gain[i] = getEnv(voiceTime[i],rel[i]);
 
 			if (audio[i].size()==0) { feed[i] = true;}
@@ -485,7 +566,7 @@ void EDSAROS::process(const ProcessArgs &args) {
 					rev_voices[i].set_playback_pos(static_cast <rspl::Int64> (revIndex(loopEnd)) << 32);
 					direction[i]=-1;
 				}
-				else if (params[LOOPMODE_PARAM].getValue()==2.0f && direction[i]==-1 && internalIntegerRevPosition[i]>=revIndex(loopStart) && play[i]) {
+				else if (params[LOOPMODE_PARAM].getValue()==2.0f && direction[i]==-1 && internalIntegerRevPosition[i]<=revIndex(loopStart) && play[i]) {
 					voices[i].set_playback_pos(static_cast <rspl::Int64> (loopStart) << 32);
 					rev_voices[i].set_playback_pos(static_cast <rspl::Int64> (revIndex(loopEnd)) << 32);
 					direction[i]=1;
@@ -510,7 +591,7 @@ void EDSAROS::process(const ProcessArgs &args) {
 					rev_voices[i].set_playback_pos(static_cast <rspl::Int64> (revIndex(sampleEnd)) << 32);
 					direction[i]=-1;
 				}
-				else if (params[RELEASEMODE_PARAM].getValue()==3.0f && direction[i]==-1 && internalIntegerRevPosition[i]>=revIndex(releaseStart) && rel[i]) {
+				else if (params[RELEASEMODE_PARAM].getValue()==3.0f && direction[i]==-1 && internalIntegerRevPosition[i]<=revIndex(releaseStart) && rel[i]) {
 					voices[i].set_playback_pos(static_cast <rspl::Int64> (releaseStart) << 32);
 					rev_voices[i].set_playback_pos(static_cast <rspl::Int64> (revIndex(sampleEnd)) << 32);
 					direction[i]=1;
@@ -535,44 +616,28 @@ void EDSAROS::process(const ProcessArgs &args) {
             else {
               nbr_spl = SIZE;
             }
+            // render straight into the ring, it is empty when fed so the block fits
+            nbr_spl = std::min(nbr_spl, (long)audio[i].capacity());
             if (nbr_spl>0) {
-              float *buff = new float[nbr_spl];
-              voices[i].interpolate_block(buff, nbr_spl);
-              
-              // Make sure we don't write beyond the buffer's capacity
-              int writeSize = std::min(nbr_spl, (long)audio[i].capacity());
-              for (int j=0; j<writeSize; j++) {
-                *(audio[i].endData()+j) = buff[j];
-              }
-              audio[i].endIncr(writeSize);
-              
-              // Free the allocated memory
-              delete[] buff;
+              voices[i].interpolate_block(audio[i].endData(), nbr_spl);
+              audio[i].endIncr(nbr_spl);
             }
 			} else {
             long nbr_spl;
             if (play[i] && params[LOOPMODE_PARAM].getValue()==2.0f) {
-              nbr_spl = rspl::min (SIZE, revIndex(loopStart) - internalIntegerRevPosition[i]);
+              nbr_spl = rspl::min (SIZE, internalIntegerRevPosition[i] - revIndex(loopStart));
             }
             else if (rel[i] && params[RELEASEMODE_PARAM].getValue()>0.0f) {
-              nbr_spl = rspl::min (SIZE, revIndex(releaseStart) - internalIntegerRevPosition[i]);
+              nbr_spl = rspl::min (SIZE, internalIntegerRevPosition[i] - revIndex(releaseStart));
             }
             else {
               nbr_spl = SIZE;
             }
+            // render straight into the ring, it is empty when fed so the block fits
+            nbr_spl = std::min(nbr_spl, (long)audio[i].capacity());
             if (nbr_spl>0) {
-              float *buff = new float[nbr_spl];
-              rev_voices[i].interpolate_block(buff, nbr_spl);
-              
-              // Make sure we don't write beyond the buffer's capacity
-              int writeSize = std::min(nbr_spl, (long)audio[i].capacity());
-              for (int j=0; j<writeSize; j++) {
-                *(audio[i].endData()+j) = buff[j];
-              }
-              audio[i].endIncr(writeSize);
-              
-              // Free the allocated memory
-              delete[] buff;
+              rev_voices[i].interpolate_block(audio[i].endData(), nbr_spl);
+              audio[i].endIncr(nbr_spl);
             }
 					}
 
@@ -595,15 +660,26 @@ void EDSAROS::process(const ProcessArgs &args) {
 					audio[i].startIncr(1);
 				}
 				else {
-					outputs[OUT].setVoltage(*audio[i].startData()*5.0f*gain[i]*params[GAIN_PARAM].getValue(),i);
+					outputs[OUT].setVoltage(*audio[i].startData()*5.0f*gain[i]*stealGain[i]*params[GAIN_PARAM].getValue(),i);
 					audio[i].startIncr(1);
 				}
 			}
 			else {
 				outputs[OUT].setVoltage(0.0f,i);
 			}
+
+			if (stealing[i]) {
+				stealGain[i] -= args.sampleTime/stealFadeTime;
+				if (stealGain[i]<=0.0f) endSteal(i);
+			}
 		}
 
+		int sounding = 0;
+		for (int i=0; i<polyChannels; i++) {
+			if ((play[i] || rel[i]) && !stealing[i]) sounding++;
+		}
+		statsActive = std::max(statsActive, sounding);
+
 		outputs[OUT].setChannels(inputs[PITCH_INPUT].getChannels());
 	}
 }
@@ -779,19 +855,17 @@ struct EDSAROSDisplay : OpaqueWidget {
 
 	void drawSample(const DrawArgs &args) {
 		if (module->loadingBuffer.size()>0) {
+			const int pixels = width + 1;
+			std::vector<float> vMin(pixels), vMax(pixels);
 			module->lock();
-  		std::vector<float> vL;
-			for (int i=0;i<module->totalSampleCount;i++) {
-				vL.push_back(module->loadingBuffer[i].samples[0]*module->params[EDSAROS::GAIN_PARAM].getValue());
-			}
+			size_t nbSample = std::min((size_t)module->totalSampleCount, module->loadingBuffer.size());
+			module->peaks.draw(module->loadingBuffer, 0, -zoomLeftAnchor * nbSample / zoomWidth, nbSample / zoomWidth, pixels, vMin.data(), vMax.data());
   		module->unlock();
-  		size_t nbSample = vL.size();
+			const float gain = module->params[EDSAROS::GAIN_PARAM].getValue();
 
   		if (nbSample>0) {
 				nvgSave(args.vg);
-				Rect b = Rect(Vec(zoomLeftAnchor, 0), Vec(zoomWidth, height));
-				size_t inc = std::max(vL.size()/zoomWidth/4,1.f);
-  			nvgScissor(args.vg, -0.5f, b.pos.y-0.5f, width+1.0f, height+1.0f);
+  			nvgScissor(args.vg, -0.5f, -0.5f, width+1.0f, height+1.0f);
 
 				nvgStrokeColor(args.vg, nvgRGBA(255, 255, 255, 255));
 				nvgBeginPath(args.vg);
@@ -803,19 +877,14 @@ struct EDSAROSDisplay : OpaqueWidget {
   			nvgStrokeColor(args.vg, nvgRGBA(164, 3, 111, 200));
 
   			nvgBeginPath(args.vg);
-  			for (size_t i = 0; i < vL.size(); i+=inc) {
-  				float x, y;
-  				x = (float)i/vL.size();
-  				y = (-1.f)*vL[i] / 2.0f + 0.5f;
-  				Vec p;
-  				p.x = b.pos.x + b.size.x * x;
-  				p.y = b.pos.y + b.size.y * (1.0f - y);
-  				if (i == 0) {
-  					nvgMoveTo(args.vg, p.x, p.y);
+  			for (int x = 0; x < pixels; x++) {
+  				if (x == 0) {
+  					nvgMoveTo(args.vg, x, height * (0.5f + 0.5f * vMax[x] * gain));
   				}
   				else {
-  					nvgLineTo(args.vg, p.x, p.y);
+  					nvgLineTo(args.vg, x, height * (0.5f + 0.5f * vMax[x] * gain));
   				}
+  				nvgLineTo(args.vg, x, height * (0.5f + 0.5f * vMin[x] * gain));
   			}
   			nvgLineCap(args.vg, NVG_MITER);
   			nvgStrokeWidth(args.vg, 1);
@@ -826,8 +895,8 @@ struct EDSAROSDisplay : OpaqueWidget {
 	  			{
 	  				nvgBeginPath(args.vg);
 	  				nvgStrokeWidth(args.vg, 1);
-  					nvgMoveTo(args.vg, (module->direction[0] == 1 ? module->internalIntegerPosition[0] : module->revIndex(module->internalIntegerRevPosition[0])) * zoomWidth / nbSample + zoomLeftAnchor, 0);
-  					nvgLineTo(args.vg, (module->direction[0] == 1 ? module->internalIntegerPosition[0] : module->revIndex(module->internalIntegerRevPosition[0])) * zoomWidth / nbSample + zoomLeftAnchor, height);
+  					nvgMoveTo(args.vg, (module->direction[0] == 1 ? module->internalIntegerPosition[0] : (module->internalIntegerRevPosition[0] - module->totalSampleCount)) * zoomWidth / nbSample + zoomLeftAnchor, 0);
+  					nvgLineTo(args.vg, (module->direction[0] == 1 ? module->internalIntegerPosition[0] : (module->internalIntegerRevPosition[0] - module->totalSampleCount)) * zoomWidth / nbSample + zoomLeftAnchor, height);
 	  				nvgClosePath(args.vg);
 	  			}
 	  			nvgStroke(args.vg);
@@ -1132,12 +1201,42 @@ struct EDSAROSWidget : BidooWidget {
   	}
   };
 
+	struct EDSAROSMaxVoices : MenuItem {
+		EDSAROS *module;
+		int count;
+		void onAction(const event::Action &e) override {
+			module->maxVoices = count;
+		}
+	};
+
+	struct EDSAROSVoiceStealing : MenuItem {
+		EDSAROS *module;
+		int stealing;
+		void onAction(const event::Action &e) override {
+			module->voiceStealing = stealing;
+		}
+	};
+
   void appendContextMenu(ui::Menu *menu) override {
     BidooWidget::appendContextMenu(menu);
 		EDSAROS *module = dynamic_cast<EDSAROS*>(this->module);
 		assert(module);
 		menu->addChild(new MenuSeparator());
 		menu->addChild(construct<EDSAROSItem>(&MenuItem::text, "Load sample", &EDSAROSItem::module, module));
+		menu->addChild(createSubmenuItem("Max polyphony", std::to_string(module->maxVoices), [=](ui::Menu* menu) {
+			static const int counts[] = {1, 2, 4, 6, 8, 12, 16};
+			for (int count : counts) {
+				menu->addChild(construct<EDSAROSMaxVoices>(&MenuItem::text, module->maxVoices == count ? std::to_string(count) + " ✓" : std::to_string(count), &EDSAROSMaxVoices::module, module, &EDSAROSMaxVoices::count, count));
+			}
+		}));
+		static const std::string stealingLabels[EDSAROS::NUM_VOICE_STEALING] = {"Oldest", "Quietest"};
+		menu->addChild(createSubmenuItem("Voice stealing", stealingLabels[module->voiceStealing], [=](ui::Menu* menu) {
+			for (int i = 0; i < EDSAROS::NUM_VOICE_STEALING; i++) {
+				menu->addChild(construct<EDSAROSVoiceStealing>(&MenuItem::text, module->voiceStealing == i ? stealingLabels[i] + " ✓" : stealingLabels[i], &EDSAROSVoiceStealing::module, module, &EDSAROSVoiceStealing::stealing, i));
+			}
+		}));
+		menu->addChild(createMenuLabel("Voices " + std::to_string(module->voicesActive) + " active, " + std::to_string(module->voicesStolen) + " stolen/s"));
+		appendResampleMenu(menu);
 	}
 
 	void onPathDrop(const PathDropEvent& e) override {
@@ -6,8 +6,15 @@
 #include <random>
 #include <algorithm>
 #include <iomanip>
+#include <atomic>
+#include <mutex>
 // #include <sstream>
 #include "dep/quantizer.hpp"
+#include "dep/slidecurve.hpp"
+
+#if defined(METAMODULE)
+#include "CoreModules/async_thread.hh"
+#endif
 
 using namespace std;
 
@@ -299,6 +306,136 @@ struct TrackAttibutes {
 	inline void setRefAttributes(const unsigned long _refAttributes) {refAttributes = _refAttributes;}
 };
 
+// Everything stored per pattern, playback state (heads, current trigs, sleeping trigs) included.
+struct EncorePattern {
+	TrigAttibutes nTrigsAttibutes[8][64];
+	TrackAttibutes nTracksAttibutes[8];
+	float trigSlide[8][64];
+	bool trigSlideType[8][64];
+	int trigTrim[8][64];
+	int trigLength[8][64];
+	int trigPulseDistance[8][64];
+	float trigCV1[8][64];
+	float trigCV2[8][64];
+	int trackHead[8];
+	int rootNote[8];
+	int scale[8];
+	int quantizeCV1[8];
+	bool slideMode[8];
+};
+
+// Blocks for the patterns that have been written to. They are only allocated and freed on the
+// UI side, which keeps one spare block ready : the audio thread gives a pattern its own block by
+// taking it, it never allocates nor locks. A released block is retired until the audio thread
+// has started another process call, it then goes back to the free list and compact() gives the
+// free blocks back to the system.
+struct EncorePatternPool {
+	static const int capacity = 8;
+	std::atomic<EncorePattern*> spare{nullptr};
+	// bumped by the audio thread at the start of every process call
+	std::atomic<uint64_t> epoch{1};
+	// UI side
+	std::mutex mutex;
+	std::vector<EncorePattern*> freeBlocks;
+	std::vector<std::pair<EncorePattern*, uint64_t>> retired;
+	std::atomic<int> allocated{0};
+
+	EncorePatternPool() {
+		freeBlocks.reserve(capacity);
+		retired.reserve(capacity);
+	}
+
+	~EncorePatternPool() {
+		delete spare.load();
+		for (auto &old : retired) {
+			delete old.first;
+		}
+		for (EncorePattern *block : freeBlocks) {
+			delete block;
+		}
+	}
+
+	// audio side, nullptr until the UI side has a spare block ready
+	EncorePattern *take() {
+		return spare.exchange(nullptr);
+	}
+
+	void enter() {
+		epoch.store(epoch.load(std::memory_order_relaxed) + 1);
+		// the pattern pointers read from here on are the ones published before the bump
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+
+	// UI side
+	EncorePattern *acquire() {
+		std::lock_guard<std::mutex> guard(mutex);
+		reclaim();
+		if (!freeBlocks.empty()) {
+			EncorePattern *block = freeBlocks.back();
+			freeBlocks.pop_back();
+			return block;
+		}
+		allocated++;
+		return new EncorePattern;
+	}
+
+	// a block that was never published
+	void giveBack(EncorePattern *block) {
+		std::lock_guard<std::mutex> guard(mutex);
+		freeBlocks.push_back(block);
+	}
+
+	// a block the audio thread may still be reading
+	void release(EncorePattern *block) {
+		std::lock_guard<std::mutex> guard(mutex);
+		retired.push_back(std::make_pair(block, epoch.load()));
+	}
+
+	void refill() {
+		if (spare.load() != nullptr) return;
+		EncorePattern *block = acquire();
+		EncorePattern *expected = nullptr;
+		if (!spare.compare_exchange_strong(expected, block)) {
+			giveBack(block);
+		}
+	}
+
+	void compact() {
+		std::lock_guard<std::mutex> guard(mutex);
+		reclaim();
+		for (EncorePattern *block : freeBlocks) {
+			delete block;
+			allocated--;
+		}
+		freeBlocks.clear();
+	}
+
+	// mutex held
+	void reclaim() {
+		const uint64_t e = epoch.load();
+		size_t kept = 0;
+		for (size_t i = 0; i < retired.size(); i++) {
+			if (retired[i].second < e) freeBlocks.push_back(retired[i].first);
+			else retired[kept++] = retired[i];
+		}
+		retired.resize(kept);
+	}
+};
+
+// A pattern pointer as published to the audio thread.
+struct EncorePatternRef {
+	std::atomic<EncorePattern*> block{nullptr};
+
+	EncorePattern *operator->() const {return block.load(std::memory_order_acquire);}
+	EncorePattern &operator*() const {return *block.load(std::memory_order_acquire);}
+	operator EncorePattern*() const {return block.load(std::memory_order_acquire);}
+	EncorePatternRef &operator=(EncorePattern *p) {block.store(p); return *this;}
+
+	bool replace(EncorePattern *&expected, EncorePattern *desired) {
+		return block.compare_exchange_strong(expected, desired);
+	}
+};
+
 struct ENCORE : BidooModule {
 	enum ParamIds {
 		STEPS_PARAMS,
@@ -403,20 +540,24 @@ struct ENCORE : BidooModule {
 
 	quantizer::Quantizer quant;
 
-	TrigAttibutes nTrigsAttibutes[8][8][64];
-	TrackAttibutes nTracksAttibutes[8][8];
-	float trigSlide[8][8][64] = {{{0.0f}}};
-  bool trigSlideType[8][8][64] = {{{0}}};
-	int trigTrim[8][8][64] = {{{0}}};
-	int trigLength[8][8][64] = {{{0}}};
-	int trigPulseDistance[8][8][64] = {{{0}}};
-	float trigCV1[8][8][64] = {{{0.0f}}};
-	float trigCV2[8][8][64] = {{{0.0f}}};
-	int trackHead[8][8] = {{0}};
-	int rootNote[8][8] = {{-1}};
-	int scale[8][8] = {{0}};
-	int quantizeCV1[8][8] = {{0}};
-	bool slideMode[8][8] = {{0}};
+	// patterns that were never written share blankPattern, its settings always stay at init
+	// and only its playback state moves. Writes go through editPattern() (UI side) or
+	// tryEditPattern() (audio thread) which give the pattern its own block first, copied from
+	// pristinePattern which nothing ever writes to.
+	const EncorePattern pristinePattern = blankPatternInit();
+	EncorePattern blankPattern = pristinePattern;
+	EncorePatternRef patterns[8];
+	// set by editPattern(), the audio thread then moves the playback state of blankPattern over
+	std::atomic<bool> blankHandoff[8];
+	EncorePatternPool patternPool;
+	// audio side, a block taken from the pool but not published yet
+	EncorePattern *heldBlock = nullptr;
+
+#if defined(METAMODULE)
+	MetaModule::AsyncThread refillAsync{this, [this]() {
+		this->patternPool.refill();
+	}};
+#endif
 
 	bool fills[8] = {0};
 	bool forceTrigs[8] = {0};
@@ -429,7 +570,7 @@ struct ENCORE : BidooModule {
 
 	bool solo = false;
 
-	float powTable[100][10000] = {{0.0f}};
+	slidecurve::SlideCurve slideCurve;
 
   std::string labels[8] = {"Track 1","Track 2","Track 3","Track 4","Track 5","Track 6","Track 7","Track 8"};
 
@@ -483,22 +624,20 @@ struct ENCORE : BidooModule {
   	for (int i=0;i<8;i++) {
       configParam(TRACKSONOFF_PARAMS + i, 0.0f, 2.0f, 1.0f);
 			configParam(TRACKSELECT_PARAMS + i, 0.0f, 1.0f, i == currentTrack ? 1.0f : 0.0f);
-			for (int j=0;j<8;j++) {
-				for (int k=0;k<64;k++) {
-					nTrigsAttibutes[i][j][k].setTrigIndex(k);
-				}
-			}
+			patterns[i] = &blankPattern;
+			blankHandoff[i] = false;
   	}
 
-		for(int i=0; i<100;i++) {
-      for(int j=0; j<10000;j++) {
-				powTable[i][j] = powf(j*0.0001f,i*0.01f);
-			}
-		}
-
 		onReset();
 	}
 
+	~ENCORE() {
+		for (int i=0; i<8; i++) {
+			releasePattern(i);
+		}
+		delete heldBlock;
+	}
+
   unsigned int calc_GCD(unsigned int a, unsigned int b)
   {
     unsigned int shift, tmp;
@@ -543,35 +682,35 @@ struct ENCORE : BidooModule {
   }
 
 	void updateTrackToParams() {
-		params[TRACKLENGTH_PARAM].setValue(nTracksAttibutes[currentPattern][currentTrack].getTrackLength());
-		params[TRACKSPEED_PARAM].setValue(nTracksAttibutes[currentPattern][currentTrack].getTrackSpeed());
-		params[TRACKREADMODE_PARAM].setValue(nTracksAttibutes[currentPattern][currentTrack].getTrackReadMode());
-		params[TRACKROOTNOTE_PARAM].setValue(rootNote[currentPattern][currentTrack]);
-		params[TRACKSCALE_PARAM].setValue(scale[currentPattern][currentTrack]);
-		params[TRACKQUANTIZECV1_PARAM].setValue(quantizeCV1[currentPattern][currentTrack]);
-		params[TRACKSCALE_PARAM].setValue(scale[currentPattern][currentTrack]);
-		params[TRACKROOTNOTE_PARAM].setValue(rootNote[currentPattern][currentTrack]);
-		params[TRACKQUANTIZECV1_PARAM].setValue(quantizeCV1[currentPattern][currentTrack]);
+		params[TRACKLENGTH_PARAM].setValue(patterns[currentPattern]->nTracksAttibutes[currentTrack].getTrackLength());
+		params[TRACKSPEED_PARAM].setValue(patterns[currentPattern]->nTracksAttibutes[currentTrack].getTrackSpeed());
+		params[TRACKREADMODE_PARAM].setValue(patterns[currentPattern]->nTracksAttibutes[currentTrack].getTrackReadMode());
+		params[TRACKROOTNOTE_PARAM].setValue(patterns[currentPattern]->rootNote[currentTrack]);
+		params[TRACKSCALE_PARAM].setValue(patterns[currentPattern]->scale[currentTrack]);
+		params[TRACKQUANTIZECV1_PARAM].setValue(patterns[currentPattern]->quantizeCV1[currentTrack]);
+		params[TRACKSCALE_PARAM].setValue(patterns[currentPattern]->scale[currentTrack]);
+		params[TRACKROOTNOTE_PARAM].setValue(patterns[currentPattern]->rootNote[currentTrack]);
+		params[TRACKQUANTIZECV1_PARAM].setValue(patterns[currentPattern]->quantizeCV1[currentTrack]);
 	}
 
 	void updateTrigToParams() {
-		params[TRIGLENGTH_PARAM].setValue(trigLength[currentPattern][currentTrack][currentTrig]);
-		params[TRIGSLIDE_PARAM].setValue(trigSlide[currentPattern][currentTrack][currentTrig]);
-		params[TRIGTYPE_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigType());
-		params[TRIGTRIM_PARAM].setValue(trigTrim[currentPattern][currentTrack][currentTrig]);
-		params[TRIGPULSECOUNT_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigPulseCount());
-		params[TRIGPULSEDISTANCE_PARAM].setValue(trigPulseDistance[currentPattern][currentTrack][currentTrig]);
-		params[TRIGCV1_PARAM].setValue(trigCV1[currentPattern][currentTrack][currentTrig]);
-		params[TRIGCV2_PARAM].setValue(trigCV2[currentPattern][currentTrack][currentTrig]);
-		params[TRIGPROBA_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigProba());
-		params[TRIGPROBACOUNT_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigCount());
-		params[TRIGPROBACOUNTRESET_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigCountReset());
-    params[TRIGSLIDETYPE_PARAM].setValue(trigSlideType[currentPattern][currentTrack][currentTrig]);
+		params[TRIGLENGTH_PARAM].setValue(patterns[currentPattern]->trigLength[currentTrack][currentTrig]);
+		params[TRIGSLIDE_PARAM].setValue(patterns[currentPattern]->trigSlide[currentTrack][currentTrig]);
+		params[TRIGTYPE_PARAM].setValue(patterns[currentPattern]->nTrigsAttibutes[currentTrack][currentTrig].getTrigType());
+		params[TRIGTRIM_PARAM].setValue(patterns[currentPattern]->trigTrim[currentTrack][currentTrig]);
+		params[TRIGPULSECOUNT_PARAM].setValue(patterns[currentPattern]->nTrigsAttibutes[currentTrack][currentTrig].getTrigPulseCount());
+		params[TRIGPULSEDISTANCE_PARAM].setValue(patterns[currentPattern]->trigPulseDistance[currentTrack][currentTrig]);
+		params[TRIGCV1_PARAM].setValue(patterns[currentPattern]->trigCV1[currentTrack][currentTrig]);
+		params[TRIGCV2_PARAM].setValue(patterns[currentPattern]->trigCV2[currentTrack][currentTrig]);
+		params[TRIGPROBA_PARAM].setValue(patterns[currentPattern]->nTrigsAttibutes[currentTrack][currentTrig].getTrigProba());
+		params[TRIGPROBACOUNT_PARAM].setValue(patterns[currentPattern]->nTrigsAttibutes[currentTrack][currentTrig].getTrigCount());
+		params[TRIGPROBACOUNTRESET_PARAM].setValue(patterns[currentPattern]->nTrigsAttibutes[currentTrack][currentTrig].getTrigCountReset());
+    params[TRIGSLIDETYPE_PARAM].setValue(patterns[currentPattern]->trigSlideType[currentTrack][currentTrig]);
 	}
 
 	void updateTrigVO() {
 		for (int i=0;i<7;i++) {
-			if (nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigOctave()==i) {
+			if (patterns[currentPattern]->nTrigsAttibutes[currentTrack][currentTrig].getTrigOctave()==i) {
 				params[OCTAVE_PARAMS+i].setValue(1.0f);
 			}
 			else {
@@ -580,8 +719,8 @@ struct ENCORE : BidooModule {
 		}
 
 		for (int i=0;i<12;i++) {
-			bool focused = nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigSemiTones() == i;
-			bool tA = nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigActive();
+			bool focused = patterns[currentPattern]->nTrigsAttibutes[currentTrack][currentTrig].getTrigSemiTones() == i;
+			bool tA = patterns[currentPattern]->nTrigsAttibutes[currentTrack][currentTrig].getTrigActive();
 			if ((i!=1)&&(i!=3)&&(i!=6)&&(i!=8)&&(i!=10)) {
 				lights[NOTE_LIGHTS+3*i].setBrightness(focused ? 0.0f : 1.0f);
 				lights[NOTE_LIGHTS+3*i+1].setBrightness(focused ? (tA ? 1.0f : 0.5f) : 1.0f);
@@ -593,28 +732,68 @@ struct ENCORE : BidooModule {
 		}
 	}
 
+	// called on every sample, the pattern is only written (and given its own block) when a knob moved.
+	// Without a spare block the write is simply retried on the next sample.
 	void updateParamsToTrack() {
-		nTracksAttibutes[currentPattern][currentTrack].setTrackLength(params[TRACKLENGTH_PARAM].getValue());
-		nTracksAttibutes[currentPattern][currentTrack].setTrackSpeed(params[TRACKSPEED_PARAM].getValue());
-		nTracksAttibutes[currentPattern][currentTrack].setTrackReadMode(params[TRACKREADMODE_PARAM].getValue());
-		rootNote[currentPattern][currentTrack]=params[TRACKROOTNOTE_PARAM].getValue();
-		scale[currentPattern][currentTrack]=params[TRACKSCALE_PARAM].getValue();
-		quantizeCV1[currentPattern][currentTrack]=params[TRACKQUANTIZECV1_PARAM].getValue();
+		const EncorePattern &current = *patterns[currentPattern];
+		TrackAttibutes track = current.nTracksAttibutes[currentTrack];
+		track.setTrackLength(params[TRACKLENGTH_PARAM].getValue());
+		track.setTrackSpeed(params[TRACKSPEED_PARAM].getValue());
+		track.setTrackReadMode(params[TRACKREADMODE_PARAM].getValue());
+		const int trackRootNote = params[TRACKROOTNOTE_PARAM].getValue();
+		const int trackScale = params[TRACKSCALE_PARAM].getValue();
+		const int trackQuantizeCV1 = params[TRACKQUANTIZECV1_PARAM].getValue();
+
+		if ((track.mainAttributes != current.nTracksAttibutes[currentTrack].mainAttributes)
+		|| (trackRootNote != current.rootNote[currentTrack])
+		|| (trackScale != current.scale[currentTrack])
+		|| (trackQuantizeCV1 != current.quantizeCV1[currentTrack])) {
+			EncorePattern *edited = tryEditPattern(currentPattern);
+			if (!edited) return;
+			edited->nTracksAttibutes[currentTrack].setMainAttributes(track.mainAttributes);
+			edited->rootNote[currentTrack] = trackRootNote;
+			edited->scale[currentTrack] = trackScale;
+			edited->quantizeCV1[currentTrack] = trackQuantizeCV1;
+		}
 	}
 
 	void updateParamsToTrig() {
-		trigLength[currentPattern][currentTrack][currentTrig] = params[TRIGLENGTH_PARAM].getValue();
-    trigSlideType[currentPattern][currentTrack][currentTrig] = params[TRIGSLIDETYPE_PARAM].getValue();
-		trigSlide[currentPattern][currentTrack][currentTrig] =  params[TRIGSLIDE_PARAM].getValue();
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigType(params[TRIGTYPE_PARAM].getValue());
-		trigTrim[currentPattern][currentTrack][currentTrig] =  params[TRIGTRIM_PARAM].getValue();
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigPulseCount(params[TRIGPULSECOUNT_PARAM].getValue());
-		trigPulseDistance[currentPattern][currentTrack][currentTrig] = params[TRIGPULSEDISTANCE_PARAM].getValue();
-		trigCV1[currentPattern][currentTrack][currentTrig] = params[TRIGCV1_PARAM].getValue();
-		trigCV2[currentPattern][currentTrack][currentTrig] = params[TRIGCV2_PARAM].getValue();
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigProba(params[TRIGPROBA_PARAM].getValue());
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigCount(params[TRIGPROBACOUNT_PARAM].getValue());
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigCountReset(params[TRIGPROBACOUNTRESET_PARAM].getValue());
+		const EncorePattern &current = *patterns[currentPattern];
+		TrigAttibutes trig = current.nTrigsAttibutes[currentTrack][currentTrig];
+		trig.setTrigType(params[TRIGTYPE_PARAM].getValue());
+		trig.setTrigPulseCount(params[TRIGPULSECOUNT_PARAM].getValue());
+		trig.setTrigProba(params[TRIGPROBA_PARAM].getValue());
+		trig.setTrigCount(params[TRIGPROBACOUNT_PARAM].getValue());
+		trig.setTrigCountReset(params[TRIGPROBACOUNTRESET_PARAM].getValue());
+		const int length = params[TRIGLENGTH_PARAM].getValue();
+		const bool slideType = params[TRIGSLIDETYPE_PARAM].getValue();
+		const float slide = params[TRIGSLIDE_PARAM].getValue();
+		const int trim = params[TRIGTRIM_PARAM].getValue();
+		const int pulseDistance = params[TRIGPULSEDISTANCE_PARAM].getValue();
+		const float cv1 = params[TRIGCV1_PARAM].getValue();
+		const float cv2 = params[TRIGCV2_PARAM].getValue();
+
+		if ((trig.mainAttributes != current.nTrigsAttibutes[currentTrack][currentTrig].mainAttributes)
+		|| (trig.probAttributes != current.nTrigsAttibutes[currentTrack][currentTrig].probAttributes)
+		|| (length != current.trigLength[currentTrack][currentTrig])
+		|| (slideType != current.trigSlideType[currentTrack][currentTrig])
+		|| (slide != current.trigSlide[currentTrack][currentTrig])
+		|| (trim != current.trigTrim[currentTrack][currentTrig])
+		|| (pulseDistance != current.trigPulseDistance[currentTrack][currentTrig])
+		|| (cv1 != current.trigCV1[currentTrack][currentTrig])
+		|| (cv2 != current.trigCV2[currentTrack][currentTrig])) {
+			EncorePattern *edited = tryEditPattern(currentPattern);
+			if (!edited) return;
+			edited->nTrigsAttibutes[currentTrack][currentTrig].setMainAttributes(trig.mainAttributes);
+			edited->nTrigsAttibutes[currentTrack][currentTrig].setProbAttributes(trig.probAttributes);
+			edited->trigLength[currentTrack][currentTrig] = length;
+			edited->trigSlideType[currentTrack][currentTrig] = slideType;
+			edited->trigSlide[currentTrack][currentTrig] = slide;
+			edited->trigTrim[currentTrack][currentTrig] = trim;
+			edited->trigPulseDistance[currentTrack][currentTrig] = pulseDistance;
+			edited->trigCV1[currentTrack][currentTrig] = cv1;
+			edited->trigCV2[currentTrack][currentTrig] = cv2;
+		}
 	}
 
 
@@ -628,36 +807,37 @@ struct ENCORE : BidooModule {
       json_object_set_new(rootJ, ("label" + to_string(i)).c_str(), json_string(labels[i].c_str()));
     }
 		for (size_t i = 0; i<8; i++) {
+			if (!patternAllocated(i)) continue;
 			json_t *patternJ = json_object();
 			for (size_t j = 0; j < 8; j++) {
 				json_t *trackJ = json_object();
-				json_object_set_new(trackJ, "isActive", json_boolean(nTracksAttibutes[i][j].getTrackActive()));
-				json_object_set_new(trackJ, "isSolo", json_boolean(nTracksAttibutes[i][j].getTrackSolo()));
-				json_object_set_new(trackJ, "speed", json_real(nTracksAttibutes[i][j].getTrackSpeed()));
-				json_object_set_new(trackJ, "readMode", json_integer(nTracksAttibutes[i][j].getTrackReadMode()));
-				json_object_set_new(trackJ, "length", json_integer(nTracksAttibutes[i][j].getTrackLength()));
-				json_object_set_new(trackJ, "rootNote", json_integer(rootNote[i][j]));
-				json_object_set_new(trackJ, "scale", json_integer(scale[i][j]));
-				json_object_set_new(trackJ, "quantizeCV1", json_integer(quantizeCV1[i][j]));
-				json_object_set_new(trackJ, "slideMode", json_boolean(slideMode[i][j]));
-				for (int k = 0; k < nTracksAttibutes[i][j].getTrackLength(); k++) {
+				json_object_set_new(trackJ, "isActive", json_boolean(patterns[i]->nTracksAttibutes[j].getTrackActive()));
+				json_object_set_new(trackJ, "isSolo", json_boolean(patterns[i]->nTracksAttibutes[j].getTrackSolo()));
+				json_object_set_new(trackJ, "speed", json_real(patterns[i]->nTracksAttibutes[j].getTrackSpeed()));
+				json_object_set_new(trackJ, "readMode", json_integer(patterns[i]->nTracksAttibutes[j].getTrackReadMode()));
+				json_object_set_new(trackJ, "length", json_integer(patterns[i]->nTracksAttibutes[j].getTrackLength()));
+				json_object_set_new(trackJ, "rootNote", json_integer(patterns[i]->rootNote[j]));
+				json_object_set_new(trackJ, "scale", json_integer(patterns[i]->scale[j]));
+				json_object_set_new(trackJ, "quantizeCV1", json_integer(patterns[i]->quantizeCV1[j]));
+				json_object_set_new(trackJ, "slideMode", json_boolean(patterns[i]->slideMode[j]));
+				for (int k = 0; k < patterns[i]->nTracksAttibutes[j].getTrackLength(); k++) {
 					json_t *trigJ = json_object();
-					json_object_set_new(trigJ, "isActive", json_boolean(nTrigsAttibutes[i][j][k].getTrigActive()));
-					json_object_set_new(trigJ, "slide", json_real(trigSlide[i][j][k]));
-					json_object_set_new(trigJ, "trigType", json_integer(nTrigsAttibutes[i][j][k].getTrigType()));
-					json_object_set_new(trigJ, "index", json_integer(nTrigsAttibutes[i][j][k].getTrigIndex()));
-					json_object_set_new(trigJ, "trim", json_integer(trigTrim[i][j][k]));
-					json_object_set_new(trigJ, "length", json_integer(trigLength[i][j][k]));
-					json_object_set_new(trigJ, "pulseCount", json_integer(nTrigsAttibutes[i][j][k].getTrigPulseCount()));
-					json_object_set_new(trigJ, "pulseDistance", json_integer(trigPulseDistance[i][j][k]));
-					json_object_set_new(trigJ, "proba", json_integer(nTrigsAttibutes[i][j][k].getTrigProba()));
-					json_object_set_new(trigJ, "count", json_integer(nTrigsAttibutes[i][j][k].getTrigCount()));
-					json_object_set_new(trigJ, "countReset", json_integer(nTrigsAttibutes[i][j][k].getTrigCountReset()));
-					json_object_set_new(trigJ, "octave", json_integer(nTrigsAttibutes[i][j][k].getTrigOctave()-3));
-					json_object_set_new(trigJ, "semitones", json_integer(nTrigsAttibutes[i][j][k].getTrigSemiTones()));
-					json_object_set_new(trigJ, "CV1", json_real(trigCV1[i][j][k]));
-					json_object_set_new(trigJ, "CV2", json_real(trigCV2[i][j][k]));
-          json_object_set_new(trigJ, "trigSlideType", json_boolean(trigSlideType[i][j][k]));
+					json_object_set_new(trigJ, "isActive", json_boolean(patterns[i]->nTrigsAttibutes[j][k].getTrigActive()));
+					json_object_set_new(trigJ, "slide", json_real(patterns[i]->trigSlide[j][k]));
+					json_object_set_new(trigJ, "trigType", json_integer(patterns[i]->nTrigsAttibutes[j][k].getTrigType()));
+					json_object_set_new(trigJ, "index", json_integer(patterns[i]->nTrigsAttibutes[j][k].getTrigIndex()));
+					json_object_set_new(trigJ, "trim", json_integer(patterns[i]->trigTrim[j][k]));
+					json_object_set_new(trigJ, "length", json_integer(patterns[i]->trigLength[j][k]));
+					json_object_set_new(trigJ, "pulseCount", json_integer(patterns[i]->nTrigsAttibutes[j][k].getTrigPulseCount()));
+					json_object_set_new(trigJ, "pulseDistance", json_integer(patterns[i]->trigPulseDistance[j][k]));
+					json_object_set_new(trigJ, "proba", json_integer(patterns[i]->nTrigsAttibutes[j][k].getTrigProba()));
+					json_object_set_new(trigJ, "count", json_integer(patterns[i]->nTrigsAttibutes[j][k].getTrigCount()));
+					json_object_set_new(trigJ, "countReset", json_integer(patterns[i]->nTrigsAttibutes[j][k].getTrigCountReset()));
+					json_object_set_new(trigJ, "octave", json_integer(patterns[i]->nTrigsAttibutes[j][k].getTrigOctave()-3));
+					json_object_set_new(trigJ, "semitones", json_integer(patterns[i]->nTrigsAttibutes[j][k].getTrigSemiTones()));
+					json_object_set_new(trigJ, "CV1", json_real(patterns[i]->trigCV1[j][k]));
+					json_object_set_new(trigJ, "CV2", json_real(patterns[i]->trigCV2[j][k]));
+          json_object_set_new(trigJ, "trigSlideType", json_boolean(patterns[i]->trigSlideType[j][k]));
 					json_object_set_new(trackJ, ("trig" + to_string(k)).c_str() , trigJ);
 				}
 				json_object_set_new(patternJ, ("track" + to_string(j)).c_str() , trackJ);
@@ -695,119 +875,125 @@ struct ENCORE : BidooModule {
 		for (size_t i=0; i<8;i++) {
 			json_t *patternJ = json_object_get(rootJ, ("pattern" + to_string(i)).c_str());
 			if (patternJ){
+				EncorePattern &loaded = editPattern(i);
 				for(size_t j=0; j<8;j++) {
 					json_t *trackJ = json_object_get(patternJ, ("track" + to_string(j)).c_str());
 					if (trackJ) {
 						json_t *isActiveJ = json_object_get(trackJ, "isActive");
 						if (isActiveJ)
-							nTracksAttibutes[i][j].setTrackActive(json_boolean_value(isActiveJ));
+							loaded.nTracksAttibutes[j].setTrackActive(json_boolean_value(isActiveJ));
 						json_t *isSoloJ = json_object_get(trackJ, "isSolo");
 						if (isSoloJ)
-							nTracksAttibutes[i][j].setTrackSolo(json_boolean_value(isSoloJ));
+							loaded.nTracksAttibutes[j].setTrackSolo(json_boolean_value(isSoloJ));
 						json_t *lengthJ = json_object_get(trackJ, "length");
 						if (lengthJ)
-							nTracksAttibutes[i][j].setTrackLength(json_integer_value(lengthJ));
+							loaded.nTracksAttibutes[j].setTrackLength(json_integer_value(lengthJ));
 						json_t *speedJ = json_object_get(trackJ, "speed");
 						if (speedJ)
-							nTracksAttibutes[i][j].setTrackSpeed(json_number_value(speedJ));
+							loaded.nTracksAttibutes[j].setTrackSpeed(json_number_value(speedJ));
 						json_t *readModeJ = json_object_get(trackJ, "readMode");
 						if (readModeJ)
-							nTracksAttibutes[i][j].setTrackReadMode(json_integer_value(readModeJ));
+							loaded.nTracksAttibutes[j].setTrackReadMode(json_integer_value(readModeJ));
 						json_t *rootNoteJ = json_object_get(trackJ, "rootNote");
 						if (rootNoteJ)
-							rootNote[i][j]=json_integer_value(rootNoteJ);
+							loaded.rootNote[j]=json_integer_value(rootNoteJ);
 						json_t *scaleJ = json_object_get(trackJ, "scale");
 						if (scaleJ)
-							scale[i][j]=json_integer_value(scaleJ);
+							loaded.scale[j]=json_integer_value(scaleJ);
 						json_t *quantizeCV1J = json_object_get(trackJ, "quantizeCV1");
 						if (quantizeCV1J)
-							quantizeCV1[i][j]=json_integer_value(quantizeCV1J);
+							loaded.quantizeCV1[j]=json_integer_value(quantizeCV1J);
 						json_t *slideModeJ = json_object_get(trackJ, "slideMode");
 						if (slideModeJ)
-							slideMode[i][j]=json_boolean_value(slideModeJ);
+							loaded.slideMode[j]=json_boolean_value(slideModeJ);
 					}
-					for(int k=0;k<nTracksAttibutes[i][j].getTrackLength();k++) {
+					for(int k=0;k<loaded.nTracksAttibutes[j].getTrackLength();k++) {
 						json_t *trigJ = json_object_get(trackJ, ("trig" + to_string(k)).c_str());
 						if (trigJ) {
 							json_t *isActiveJ = json_object_get(trigJ, "isActive");
 							if (isActiveJ)
-								nTrigsAttibutes[i][j][k].setTrigActive(json_boolean_value(isActiveJ));
+								loaded.nTrigsAttibutes[j][k].setTrigActive(json_boolean_value(isActiveJ));
 							json_t *slideJ = json_object_get(trigJ, "slide");
 							if (slideJ)
-								trigSlide[i][j][k] = json_number_value(slideJ);
+								loaded.trigSlide[j][k] = json_number_value(slideJ);
 							json_t *trigTypeJ = json_object_get(trigJ, "trigType");
 							if (trigTypeJ)
-								nTrigsAttibutes[i][j][k].setTrigType(json_integer_value(trigTypeJ));
+								loaded.nTrigsAttibutes[j][k].setTrigType(json_integer_value(trigTypeJ));
 							json_t *indexJ = json_object_get(trigJ, "index");
 							if (indexJ)
-								nTrigsAttibutes[i][j][k].setTrigIndex(json_integer_value(indexJ));
+								loaded.nTrigsAttibutes[j][k].setTrigIndex(json_integer_value(indexJ));
 							json_t *trimJ = json_object_get(trigJ, "trim");
 							if (trimJ)
-								trigTrim[i][j][k] = json_integer_value(trimJ);
+								loaded.trigTrim[j][k] = json_integer_value(trimJ);
 							json_t *lengthJ = json_object_get(trigJ, "length");
 							if (lengthJ)
-								trigLength[i][j][k] = json_integer_value(lengthJ);
+								loaded.trigLength[j][k] = json_integer_value(lengthJ);
 							json_t *pulseCountJ = json_object_get(trigJ, "pulseCount");
 							if (pulseCountJ)
-								nTrigsAttibutes[i][j][k].setTrigPulseCount(json_integer_value(pulseCountJ));
+								loaded.nTrigsAttibutes[j][k].setTrigPulseCount(json_integer_value(pulseCountJ));
 							json_t *pulseDistanceJ = json_object_get(trigJ, "pulseDistance");
 							if (pulseDistanceJ)
-								trigPulseDistance[i][j][k] =  json_integer_value(pulseDistanceJ);
+								loaded.trigPulseDistance[j][k] =  json_integer_value(pulseDistanceJ);
 							json_t *probaJ = json_object_get(trigJ, "proba");
 							if (probaJ)
-								nTrigsAttibutes[i][j][k].setTrigProba(json_integer_value(probaJ));
+								loaded.nTrigsAttibutes[j][k].setTrigProba(json_integer_value(probaJ));
 							json_t *countJ = json_object_get(trigJ, "count");
 							if (countJ)
-								nTrigsAttibutes[i][j][k].setTrigCount(json_integer_value(countJ));
+								loaded.nTrigsAttibutes[j][k].setTrigCount(json_integer_value(countJ));
 							json_t *countResetJ = json_object_get(trigJ, "countReset");
 							if (countResetJ)
-								nTrigsAttibutes[i][j][k].setTrigCountReset(json_integer_value(countResetJ));
+								loaded.nTrigsAttibutes[j][k].setTrigCountReset(json_integer_value(countResetJ));
 							json_t *octaveJ = json_object_get(trigJ, "octave");
 							if (octaveJ)
-								nTrigsAttibutes[i][j][k].setTrigOctave(json_integer_value(octaveJ)+3);
+								loaded.nTrigsAttibutes[j][k].setTrigOctave(json_integer_value(octaveJ)+3);
 							json_t *semitonesJ = json_object_get(trigJ, "semitones");
 							if (semitonesJ)
-								nTrigsAttibutes[i][j][k].setTrigSemiTones(json_integer_value(semitonesJ));
+								loaded.nTrigsAttibutes[j][k].setTrigSemiTones(json_integer_value(semitonesJ));
 							json_t *CV1J = json_object_get(trigJ, "CV1");
 							if (CV1J)
-								trigCV1[i][j][k] = json_number_value(CV1J);
+								loaded.trigCV1[j][k] = json_number_value(CV1J);
 							json_t *CV2J = json_object_get(trigJ, "CV2");
 							if (CV2J)
-								trigCV2[i][j][k] = json_number_value(CV2J);
+								loaded.trigCV2[j][k] = json_number_value(CV2J);
               json_t *trigSlideTypeJ = json_object_get(trigJ, "trigSlideType");
 							if (trigSlideTypeJ)
-								trigSlideType[i][j][k]=json_boolean_value(trigSlideTypeJ);
+								loaded.trigSlideType[j][k]=json_boolean_value(trigSlideTypeJ);
 						}
 					}
 				}
 			}
+			else {
+				patternInit(i);
+			}
 		}
+		releaseEmptyPatterns();
 		updateTrackToParams();
 		updateTrigToParams();
 	}
 
 	void randomizeTrigNote(const int track, const int trig) {
-		nTrigsAttibutes[currentPattern][track][trig].fullRandomize();
+		editPattern(currentPattern).nTrigsAttibutes[track][trig].fullRandomize();
 	}
 
 	void randomizeTrigNotePlus(const int track, const int trig) {
-		nTrigsAttibutes[currentPattern][track][trig].fullRandomize();
-		trigSlide[currentPattern][track][trig]=random::uniform();
-    trigSlideType[currentPattern][track][trig]=random::uniform()>0.5f?true:false;
-		trigLength[currentPattern][track][trig]=random::uniform()*31.0f;
-		trigPulseDistance[currentPattern][track][trig]=random::uniform()*31.0f;
+		EncorePattern &edited = editPattern(currentPattern);
+		edited.nTrigsAttibutes[track][trig].fullRandomize();
+		edited.trigSlide[track][trig]=random::uniform();
+    edited.trigSlideType[track][trig]=random::uniform()>0.5f?true:false;
+		edited.trigLength[track][trig]=random::uniform()*31.0f;
+		edited.trigPulseDistance[track][trig]=random::uniform()*31.0f;
 	}
 
 	void randomizeTrigProb(const int track, const int trig) {
-		nTrigsAttibutes[currentPattern][track][trig].randomizeProbs();
+		editPattern(currentPattern).nTrigsAttibutes[track][trig].randomizeProbs();
 	}
 
 	void randomizeTrigCV1(const int track, const int trig) {
-		trigCV1[currentPattern][track][trig]=random::uniform()*10.0f;
+		editPattern(currentPattern).trigCV1[track][trig]=random::uniform()*10.0f;
 	}
 
 	void randomizeTrigCV2(const int track, const int trig) {
-		trigCV2[currentPattern][track][trig]=random::uniform()*10.0f;
+		editPattern(currentPattern).trigCV2[track][trig]=random::uniform()*10.0f;
 	}
 
 	void fullRandomizeTrig(const int track, const int trig) {
@@ -818,7 +1004,7 @@ struct ENCORE : BidooModule {
 	}
 
 	void randomizeTrack(const int track) {
-		nTracksAttibutes[currentPattern][track].randomize();
+		editPattern(currentPattern).nTracksAttibutes[track].randomize();
 	}
 
 	void randomizeTrackTrigsNotes(const int track) {
@@ -931,66 +1117,70 @@ struct ENCORE : BidooModule {
 	}
 
 	void nTrackLeft(const int track, const size_t n, const int len = 0) {
-		size_t tLen = len == 0 ? nTracksAttibutes[currentPattern][track].getTrackLength() : len;
-		array_cycle_left(trigSlide[currentPattern][track], tLen , sizeof(float), n);
-		array_cycle_left(trigTrim[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_left(trigLength[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_left(trigPulseDistance[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_left(trigCV1[currentPattern][track], (size_t) tLen, sizeof(float), n);
-		array_cycle_left(trigCV2[currentPattern][track], (size_t) tLen, sizeof(float), n);
-    array_cycle_left(trigSlideType[currentPattern][track], (size_t) tLen, sizeof(bool), n);
+		if (!patternAllocated(currentPattern)) return; // all trigs of a blank pattern are alike
+		size_t tLen = len == 0 ? patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() : len;
+		array_cycle_left(patterns[currentPattern]->trigSlide[track], tLen , sizeof(float), n);
+		array_cycle_left(patterns[currentPattern]->trigTrim[track], tLen, sizeof(float), n);
+		array_cycle_left(patterns[currentPattern]->trigLength[track], tLen, sizeof(float), n);
+		array_cycle_left(patterns[currentPattern]->trigPulseDistance[track], tLen, sizeof(float), n);
+		array_cycle_left(patterns[currentPattern]->trigCV1[track], (size_t) tLen, sizeof(float), n);
+		array_cycle_left(patterns[currentPattern]->trigCV2[track], (size_t) tLen, sizeof(float), n);
+    array_cycle_left(patterns[currentPattern]->trigSlideType[track], (size_t) tLen, sizeof(bool), n);
 
 		for (size_t j=0; j<n; j++) {
-			TrigAttibutes temp = nTrigsAttibutes[currentPattern][track][0];
+			TrigAttibutes temp = patterns[currentPattern]->nTrigsAttibutes[track][0];
 			for (size_t i = 0; i < tLen-1; i++) {
-				nTrigsAttibutes[currentPattern][track][i] = nTrigsAttibutes[currentPattern][track][i+1];
-				nTrigsAttibutes[currentPattern][track][i].setTrigIndex(i);
+				patterns[currentPattern]->nTrigsAttibutes[track][i] = patterns[currentPattern]->nTrigsAttibutes[track][i+1];
+				patterns[currentPattern]->nTrigsAttibutes[track][i].setTrigIndex(i);
 			}
-			nTrigsAttibutes[currentPattern][track][tLen-1] = temp;
-			nTrigsAttibutes[currentPattern][track][tLen-1].setTrigIndex(tLen-1);
+			patterns[currentPattern]->nTrigsAttibutes[track][tLen-1] = temp;
+			patterns[currentPattern]->nTrigsAttibutes[track][tLen-1].setTrigIndex(tLen-1);
 		}
 	}
 
 
 	void nTrackRight(const int track, const size_t n, const int len = 0) {
-		size_t tLen = len == 0 ? nTracksAttibutes[currentPattern][track].getTrackLength() : len;
-		array_cycle_right(trigSlide[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigTrim[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigLength[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigPulseDistance[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigCV1[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigCV2[currentPattern][track], tLen, sizeof(float), n);
-    array_cycle_right(trigSlideType[currentPattern][track], (size_t) tLen, sizeof(bool), n);
+		if (!patternAllocated(currentPattern)) return; // all trigs of a blank pattern are alike
+		size_t tLen = len == 0 ? patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() : len;
+		array_cycle_right(patterns[currentPattern]->trigSlide[track], tLen, sizeof(float), n);
+		array_cycle_right(patterns[currentPattern]->trigTrim[track], tLen, sizeof(float), n);
+		array_cycle_right(patterns[currentPattern]->trigLength[track], tLen, sizeof(float), n);
+		array_cycle_right(patterns[currentPattern]->trigPulseDistance[track], tLen, sizeof(float), n);
+		array_cycle_right(patterns[currentPattern]->trigCV1[track], tLen, sizeof(float), n);
+		array_cycle_right(patterns[currentPattern]->trigCV2[track], tLen, sizeof(float), n);
+    array_cycle_right(patterns[currentPattern]->trigSlideType[track], (size_t) tLen, sizeof(bool), n);
 
 		for (size_t j=0; j<n; j++) {
-			TrigAttibutes temp = nTrigsAttibutes[currentPattern][track][tLen-1];
+			TrigAttibutes temp = patterns[currentPattern]->nTrigsAttibutes[track][tLen-1];
 			for (size_t i = tLen-1; i > 0; i--) {
-				nTrigsAttibutes[currentPattern][track][i] = nTrigsAttibutes[currentPattern][track][i-1];
-				nTrigsAttibutes[currentPattern][track][i].setTrigIndex(i);
+				patterns[currentPattern]->nTrigsAttibutes[track][i] = patterns[currentPattern]->nTrigsAttibutes[track][i-1];
+				patterns[currentPattern]->nTrigsAttibutes[track][i].setTrigIndex(i);
 			}
-			nTrigsAttibutes[currentPattern][track][0] = temp;
-			nTrigsAttibutes[currentPattern][track][0].setTrigIndex(0);
+			patterns[currentPattern]->nTrigsAttibutes[track][0] = temp;
+			patterns[currentPattern]->nTrigsAttibutes[track][0].setTrigIndex(0);
 		}
 	}
 
 	void trackUp(const int track) {
+		EncorePattern &edited = editPattern(currentPattern);
 		for (int i = 0; i < 64; i++) {
-			nTrigsAttibutes[currentPattern][track][i].up();
+			edited.nTrigsAttibutes[track][i].up();
 		}
 	}
 
 	void trackDown(const int track) {
+		EncorePattern &edited = editPattern(currentPattern);
 		for (int i = 0; i < 64; i++) {
-			nTrigsAttibutes[currentPattern][track][i].down();
+			edited.nTrigsAttibutes[track][i].down();
 		}
 	}
 
 	void trigUp(const int trig) {
-		nTrigsAttibutes[currentPattern][currentTrack][trig].up();
+		editPattern(currentPattern).nTrigsAttibutes[currentTrack][trig].up();
 	}
 
 	void trigDown(const int trig) {
-		nTrigsAttibutes[currentPattern][currentTrack][trig].down();
+		editPattern(currentPattern).nTrigsAttibutes[currentTrack][trig].down();
 	}
 
 
@@ -1001,29 +1191,33 @@ struct ENCORE : BidooModule {
 	}
 
 	void pasteTrack(const int fromPattern, const int fromTrack, const int toPattern, const int toTrack) {
-		nTracksAttibutes[toPattern][toTrack].setMainAttributes(nTracksAttibutes[fromPattern][fromTrack].getMainAttributes());
-		nTracksAttibutes[toPattern][toTrack].setRefAttributes(nTracksAttibutes[fromPattern][fromTrack].getRefAttributes());
-		trackHead[toPattern][toTrack] = trackHead[fromPattern][fromTrack];
-		rootNote[toPattern][toTrack] = rootNote[fromPattern][fromTrack];
-		scale[toPattern][toTrack] = scale[fromPattern][fromTrack];
-		quantizeCV1[toPattern][toTrack] = quantizeCV1[fromPattern][fromTrack];
+		EncorePattern &to = editPattern(toPattern);
+		EncorePattern &from = *patterns[fromPattern];
+		to.nTracksAttibutes[toTrack].setMainAttributes(from.nTracksAttibutes[fromTrack].getMainAttributes());
+		to.nTracksAttibutes[toTrack].setRefAttributes(from.nTracksAttibutes[fromTrack].getRefAttributes());
+		to.trackHead[toTrack] = from.trackHead[fromTrack];
+		to.rootNote[toTrack] = from.rootNote[fromTrack];
+		to.scale[toTrack] = from.scale[fromTrack];
+		to.quantizeCV1[toTrack] = from.quantizeCV1[fromTrack];
 		for (int i=0; i<64; i++) {
 			pasteTrig(fromPattern,fromTrack,i,toPattern,toTrack,i);
 		}
 	}
 
 	void pasteTrig(const int fromPattern, const int fromTrack, const int fromTrig, const int toPattern, const int toTrack, const int toTrig) {
-		int index = nTrigsAttibutes[toPattern][toTrack][toTrig].getTrigIndex();
-		nTrigsAttibutes[toPattern][toTrack][toTrig].setMainAttributes(nTrigsAttibutes[fromPattern][fromTrack][fromTrig].getMainAttributes());
-		nTrigsAttibutes[toPattern][toTrack][toTrig].setTrigIndex(index);
-		nTrigsAttibutes[toPattern][toTrack][toTrig].setProbAttributes(nTrigsAttibutes[fromPattern][fromTrack][fromTrig].getProbAttributes());
-		trigSlide[toPattern][toTrack][toTrig] = trigSlide[fromPattern][fromTrack][fromTrig];
-		trigTrim[toPattern][toTrack][toTrig] = trigTrim[fromPattern][fromTrack][fromTrig];
-		trigLength[toPattern][toTrack][toTrig] = trigLength[fromPattern][fromTrack][fromTrig];
-		trigPulseDistance[toPattern][toTrack][toTrig] = trigPulseDistance[fromPattern][fromTrack][fromTrig];
-		trigCV1[toPattern][toTrack][toTrig] = trigCV1[fromPattern][fromTrack][fromTrig];
-		trigCV2[toPattern][toTrack][toTrig] = trigCV2[fromPattern][fromTrack][fromTrig];
-    trigSlideType[toPattern][toTrack][toTrig] = trigSlideType[fromPattern][fromTrack][fromTrig];
+		EncorePattern &to = editPattern(toPattern);
+		EncorePattern &from = *patterns[fromPattern];
+		int index = to.nTrigsAttibutes[toTrack][toTrig].getTrigIndex();
+		to.nTrigsAttibutes[toTrack][toTrig].setMainAttributes(from.nTrigsAttibutes[fromTrack][fromTrig].getMainAttributes());
+		to.nTrigsAttibutes[toTrack][toTrig].setTrigIndex(index);
+		to.nTrigsAttibutes[toTrack][toTrig].setProbAttributes(from.nTrigsAttibutes[fromTrack][fromTrig].getProbAttributes());
+		to.trigSlide[toTrack][toTrig] = from.trigSlide[fromTrack][fromTrig];
+		to.trigTrim[toTrack][toTrig] = from.trigTrim[fromTrack][fromTrig];
+		to.trigLength[toTrack][toTrig] = from.trigLength[fromTrack][fromTrig];
+		to.trigPulseDistance[toTrack][toTrig] = from.trigPulseDistance[fromTrack][fromTrig];
+		to.trigCV1[toTrack][toTrig] = from.trigCV1[fromTrack][fromTrig];
+		to.trigCV2[toTrack][toTrig] = from.trigCV2[fromTrack][fromTrig];
+    to.trigSlideType[toTrack][toTrig] = from.trigSlideType[fromTrack][fromTrig];
 	}
 
 	void pastePattern() {
@@ -1041,43 +1235,198 @@ struct ENCORE : BidooModule {
 		}
 	}
 
+	static void trigInit(EncorePattern &p, const int track, const int trig) {
+		p.nTrigsAttibutes[track][trig].init();
+		p.trigSlide[track][trig] = 0.0f;
+		p.trigTrim[track][trig] = 0;
+		p.trigLength[track][trig] = 15;
+		p.trigPulseDistance[track][trig] = 1;
+		p.trigCV1[track][trig] = 0.0f;
+		p.trigCV2[track][trig] = 0.0f;
+    p.trigSlideType[track][trig] = false;
+	}
+
+	static void trackInit(EncorePattern &p, const int track) {
+		p.nTracksAttibutes[track].init();
+		p.trackHead[track] = 0;
+		p.rootNote[track] = -1;
+		p.scale[track] = 0;
+		p.quantizeCV1[track] = 0;
+		for (int i=0; i<64; i++) {
+			trigInit(p, track, i);
+			p.nTrigsAttibutes[track][i].setTrigIndex(i);
+		}
+	}
+
+	static EncorePattern blankPatternInit() {
+		EncorePattern p = {};
+		for (int i=0; i<8; i++) {
+			trackInit(p, i);
+		}
+		return p;
+	}
+
 	void trigInit(const int pattern, const int track, const int trig) {
-		nTrigsAttibutes[pattern][track][trig].init();
-		trigSlide[pattern][track][trig] = 0.0f;
-		trigTrim[pattern][track][trig] = 0;
-		trigLength[pattern][track][trig] = 15;
-		trigPulseDistance[pattern][track][trig] = 1;
-		trigCV1[pattern][track][trig] = 0.0f;
-		trigCV2[pattern][track][trig] = 0.0f;
-    trigSlideType[pattern][track][trig] = false;
+		trigInit(editPattern(pattern), track, trig);
 	}
 
 	void pageInit(const int page) {
 		const int start = page*16;
 		for (int i=start; i<start+16; i++) {
-			trigInit(currentPattern, currentTrack, i);
-			nTrigsAttibutes[currentPattern][currentTrack][i].setTrigIndex(i);
+			EncorePattern &edited = editPattern(currentPattern);
+			trigInit(edited, currentTrack, i);
+			edited.nTrigsAttibutes[currentTrack][i].setTrigIndex(i);
 		}
 	}
 	
 	void trackInit(const int pattern, const int track) {
-		nTracksAttibutes[pattern][track].init();
-		trackHead[pattern][track] = 0;
-		rootNote[pattern][track] = -1;
-		scale[pattern][track] = 0;
-		quantizeCV1[pattern][track] = 0;
-		for (int i=0; i<64; i++) {
-			trigInit(pattern, track, i);
-			nTrigsAttibutes[pattern][track][i].setTrigIndex(i);
+		trackInit(editPattern(pattern), track);
+	}
+
+	void patternInit(const int pattern) {
+		if (!patternAllocated(pattern)) return; // a blank pattern is at init already
+		for (int i=0; i<8; i++) {
+			trackInit(pattern, i);
+		}
+		if (patternIsBlank(*patterns[pattern])) {
+			releasePattern(pattern);
 		}
 	}
 
-	void onReset() override {
+	bool patternAllocated(const int pattern) {
+		return patterns[pattern] != &blankPattern;
+	}
+
+	// UI side
+	EncorePattern &editPattern(const int pattern) {
+		EncorePattern *current = patterns[pattern];
+		if (current == &blankPattern) {
+			EncorePattern *block = patternPool.acquire();
+			*block = pristinePattern;
+			if (patterns[pattern].replace(current, block)) {
+				current = block;
+				blankHandoff[pattern] = true;
+			}
+			else {
+				// the audio thread gave it a block first
+				patternPool.giveBack(block);
+			}
+		}
+		return *current;
+	}
+
+	// audio side, nullptr while no spare block is ready
+	EncorePattern *tryEditPattern(const int pattern) {
+		EncorePattern *current = patterns[pattern];
+		if (current != &blankPattern) return current;
+		if (!heldBlock) {
+			heldBlock = patternPool.take();
+			if (!heldBlock) return nullptr;
+		}
+		*heldBlock = pristinePattern;
+		if (patterns[pattern].replace(current, heldBlock)) {
+			current = heldBlock;
+			heldBlock = nullptr;
+			if (pattern == currentPattern) {
+				playbackFromBlank(*current);
+			}
+		}
+		return current;
+	}
+
+	// audio side, a pattern that just left blankPattern carries on from where it was playing
+	void playbackFromBlank(EncorePattern &block) {
+		const unsigned long trackPlayback = TrackAttibutes::TRACK_FORWARD | TrackAttibutes::TRACK_PRE;
+		const unsigned long trigPlayback = TrigAttibutes::TRIG_INITIALIZED | TrigAttibutes::TRIG_SLEEPING;
+		for (int i=0; i<8; i++) {
+			TrackAttibutes &track = block.nTracksAttibutes[i];
+			track.mainAttributes = (track.mainAttributes & ~trackPlayback) | (blankPattern.nTracksAttibutes[i].mainAttributes & trackPlayback);
+			track.setRefAttributes(blankPattern.nTracksAttibutes[i].getRefAttributes());
+			block.trackHead[i] = blankPattern.trackHead[i];
+			for (int j=0; j<64; j++) {
+				TrigAttibutes &trig = block.nTrigsAttibutes[i][j];
+				trig.mainAttributes = (trig.mainAttributes & ~trigPlayback) | (blankPattern.nTrigsAttibutes[i][j].mainAttributes & trigPlayback);
+				trig.setTrigInCount(blankPattern.nTrigsAttibutes[i][j].getTrigInCount());
+			}
+		}
+	}
+
+	// UI side, the block is reused or freed once the audio thread can not hold it anymore
+	void releasePattern(const int pattern) {
+		EncorePattern *block = patterns[pattern];
+		if (block == &blankPattern) return;
+		if (pattern == currentPattern) {
+			for (int i=0; i<8; i++) {
+				blankPattern.trackHead[i] = block->trackHead[i];
+				blankPattern.nTracksAttibutes[i].setRefAttributes(block->nTracksAttibutes[i].getRefAttributes());
+			}
+		}
+		if (patterns[pattern].replace(block, &blankPattern)) {
+			patternPool.release(block);
+		}
+	}
+
+	// true when only the playback state differs from a pattern that was never written
+	bool patternIsBlank(const EncorePattern &pattern) {
+		const unsigned long trackPlayback = TrackAttibutes::TRACK_FORWARD | TrackAttibutes::TRACK_PRE;
+		const unsigned long trigPlayback = TrigAttibutes::TRIG_INITIALIZED | TrigAttibutes::TRIG_SLEEPING;
+		const unsigned long trigProbPlayback = TrigAttibutes::TRIG_INCOUNT;
+		const EncorePattern &blank = pristinePattern;
+		for (int i=0; i<8; i++) {
+			if (((pattern.nTracksAttibutes[i].mainAttributes ^ blank.nTracksAttibutes[i].mainAttributes) & ~trackPlayback)
+			|| (pattern.rootNote[i] != blank.rootNote[i])
+			|| (pattern.scale[i] != blank.scale[i])
+			|| (pattern.quantizeCV1[i] != blank.quantizeCV1[i])
+			|| (pattern.slideMode[i] != blank.slideMode[i])) {
+				return false;
+			}
+			for (int j=0; j<64; j++) {
+				if (((pattern.nTrigsAttibutes[i][j].mainAttributes ^ blank.nTrigsAttibutes[i][j].mainAttributes) & ~trigPlayback)
+				|| ((pattern.nTrigsAttibutes[i][j].probAttributes ^ blank.nTrigsAttibutes[i][j].probAttributes) & ~trigProbPlayback)
+				|| (pattern.trigSlide[i][j] != blank.trigSlide[i][j])
+				|| (pattern.trigSlideType[i][j] != blank.trigSlideType[i][j])
+				|| (pattern.trigTrim[i][j] != blank.trigTrim[i][j])
+				|| (pattern.trigLength[i][j] != blank.trigLength[i][j])
+				|| (pattern.trigPulseDistance[i][j] != blank.trigPulseDistance[i][j])
+				|| (pattern.trigCV1[i][j] != blank.trigCV1[i][j])
+				|| (pattern.trigCV2[i][j] != blank.trigCV2[i][j])) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void releaseEmptyPatterns() {
 		for (int i=0; i<8; i++) {
-			for (int j=0; j<8; j++) {
-				trackInit(i,j);
+			if (patternAllocated(i) && patternIsBlank(*patterns[i])) {
+				releasePattern(i);
 			}
 		}
+	}
+
+	void compactPatterns() {
+		releaseEmptyPatterns();
+		patternPool.compact();
+	}
+
+	int allocatedPatterns() {
+		int count = 0;
+		for (int i=0; i<8; i++) {
+			if (patternAllocated(i)) count++;
+		}
+		return count;
+	}
+
+	// pattern blocks held by the module, spare, retired and free ones and the blank pattern included
+	size_t patternFootprint() {
+		return (patternPool.allocated + 1) * sizeof(EncorePattern);
+	}
+
+	void onReset() override {
+		for (int i=0; i<8; i++) {
+			patternInit(i);
+		}
 		updateTrackToParams();
 		updateTrigToParams();
 	}
@@ -1086,7 +1435,7 @@ struct ENCORE : BidooModule {
 
 	bool patternIsSoloed() {
 		for (size_t i = 0; i < 8; i++) {
-			if (nTracksAttibutes[currentPattern][i].getTrackSolo()) {
+			if (patterns[currentPattern]->nTracksAttibutes[i].getTrackSolo()) {
 				return true;
 			}
 		}
@@ -1094,21 +1443,21 @@ struct ENCORE : BidooModule {
 	}
 
 	void trackSync(const int track, const int tHead) {
-		trackHead[currentPattern][track] = tHead%nTracksAttibutes[currentPattern][track].getTrackLength();
+		patterns[currentPattern]->trackHead[track] = tHead%patterns[currentPattern]->nTracksAttibutes[track].getTrackLength();
 	}
 
 	float trackGetGate(const int track, const int tPT) {
-		if (nTrigsAttibutes[currentPattern][track][tPT].getTrigActive() && !nTrigsAttibutes[currentPattern][track][tPT].getTrigSleeping()) {
+		if (patterns[currentPattern]->nTrigsAttibutes[track][tPT].getTrigActive() && !patterns[currentPattern]->nTrigsAttibutes[track][tPT].getTrigSleeping()) {
 			int rTP = trigGetRelativeTrackPosition(track, tPT);
 			if (rTP >= 0) {
-				if (rTP<trigLength[currentPattern][track][tPT]) {
+				if (rTP<patterns[currentPattern]->trigLength[track][tPT]) {
 					return 10.0f;
 				}
 				else {
-					int cPulses = (trigPulseDistance[currentPattern][track][tPT] == 0) ? 0 : (rTP/trigPulseDistance[currentPattern][track][tPT]);
-					return ((cPulses<nTrigsAttibutes[currentPattern][track][tPT].getTrigPulseCount())
-					&& (rTP>=(cPulses*trigPulseDistance[currentPattern][track][tPT]))
-					&& (rTP<=((cPulses*trigPulseDistance[currentPattern][track][tPT])+trigLength[currentPattern][track][tPT]))) ? 10.0f : 0.0f;
+					int cPulses = (patterns[currentPattern]->trigPulseDistance[track][tPT] == 0) ? 0 : (rTP/patterns[currentPattern]->trigPulseDistance[track][tPT]);
+					return ((cPulses<patterns[currentPattern]->nTrigsAttibutes[track][tPT].getTrigPulseCount())
+					&& (rTP>=(cPulses*patterns[currentPattern]->trigPulseDistance[track][tPT]))
+					&& (rTP<=((cPulses*patterns[currentPattern]->trigPulseDistance[track][tPT])+patterns[currentPattern]->trigLength[track][tPT]))) ? 10.0f : 0.0f;
 				}
 			}
 			else
@@ -1119,11 +1468,11 @@ struct ENCORE : BidooModule {
 	}
 
 	float trigGetRelativeTrackPosition(const int track, const int trig) {
-		return trackHead[currentPattern][track] - trigGetTrimedIndex(track, trig);
+		return patterns[currentPattern]->trackHead[track] - trigGetTrimedIndex(track, trig);
 	}
 
 	float trigGetFullLength(const int track, const int trig) {
-		return nTrigsAttibutes[currentPattern][track][trig].getTrigPulseCount() == 1 ? trigLength[currentPattern][track][trig] : ((nTrigsAttibutes[currentPattern][track][trig].getTrigPulseCount()*trigPulseDistance[currentPattern][track][trig]) + trigLength[currentPattern][track][trig]);
+		return patterns[currentPattern]->nTrigsAttibutes[track][trig].getTrigPulseCount() == 1 ? patterns[currentPattern]->trigLength[track][trig] : ((patterns[currentPattern]->nTrigsAttibutes[track][trig].getTrigPulseCount()*patterns[currentPattern]->trigPulseDistance[track][trig]) + patterns[currentPattern]->trigLength[track][trig]);
 	}
 
 	bool trigGetIsRead(const int track, const int trig, const int trackPosition) {
@@ -1132,39 +1481,39 @@ struct ENCORE : BidooModule {
 	}
 
 	float trigGetTrimedIndex(const int track, const int trig) {
-		return nTrigsAttibutes[currentPattern][track][trig].getTrigIndex()*32 + trigTrim[currentPattern][track][trig];
+		return patterns[currentPattern]->nTrigsAttibutes[track][trig].getTrigIndex()*32 + patterns[currentPattern]->trigTrim[track][trig];
 	}
 
 	float trackGetVO(const int track, const int tPT, const bool quantize = false) {
-		float vo = nTrigsAttibutes[currentPattern][track][tPT].getVO() + trsp[track];
-		if (trigSlide[currentPattern][track][tPT] == 0) {
-			return quantize ? std::get<0>(quant.closestVoltageInScale(vo, rootNote[currentPattern][track], scale[currentPattern][track])) : vo;
+		float vo = patterns[currentPattern]->nTrigsAttibutes[track][tPT].getVO() + trsp[track];
+		if (patterns[currentPattern]->trigSlide[track][tPT] == 0) {
+			return quantize ? std::get<0>(quant.closestVoltageInScale(vo, patterns[currentPattern]->rootNote[track], patterns[currentPattern]->scale[track])) : vo;
 		}
 		else
 		{
 			float fullLength = trigGetFullLength(track,tPT);
-			float voQ = quantize ? std::get<0>(quant.closestVoltageInScale(vo, rootNote[currentPattern][track], scale[currentPattern][track])) : vo;
+			float voQ = quantize ? std::get<0>(quant.closestVoltageInScale(vo, patterns[currentPattern]->rootNote[track], patterns[currentPattern]->scale[track])) : vo;
 			if (fullLength > 0.0f) {
-				if (slideMode[currentPattern][track]) {
-          if (trigSlideType[currentPattern][track][tPT]) {
+				if (patterns[currentPattern]->slideMode[track]) {
+          if (patterns[currentPattern]->trigSlideType[track][tPT]) {
             float subPhase = clamp(trigGetRelativeTrackPosition(track, tPT),0.0f,32.0f)/32.0f;
-  					return voQ - (1.0f - interpolateLinear(powTable[(int)(trigSlide[currentPattern][track][tPT]*99.0f)],9999.0f*subPhase)) * (voQ - prevVO[track]);
+  					return voQ - (1.0f - slideCurve.shape((int)(patterns[currentPattern]->trigSlide[track][tPT]*99.0f),9999.0f*subPhase)) * (voQ - prevVO[track]);
           }
           else
           {
             float subPhase = clamp(trigGetRelativeTrackPosition(track, tPT),0.0f,fullLength);
-  					return voQ - (1.0f - interpolateLinear(powTable[(int)(trigSlide[currentPattern][track][tPT]*99.0f)],9999.0f*subPhase/fullLength)) * (voQ - prevVO[track]);
+  					return voQ - (1.0f - slideCurve.shape((int)(patterns[currentPattern]->trigSlide[track][tPT]*99.0f),9999.0f*subPhase/fullLength)) * (voQ - prevVO[track]);
           }
 				}
 				else {
-          if (trigSlideType[currentPattern][track][tPT]) {
+          if (patterns[currentPattern]->trigSlideType[track][tPT]) {
             float subPhase = clamp(trigGetRelativeTrackPosition(track, tPT)/32.0f*(1.0f/max((int)abs(voQ - prevVO[track]),1)),0.0f,1.0f);
-  					return voQ - (1.0f - interpolateLinear(powTable[(int)(trigSlide[currentPattern][track][tPT]*99.0f)],9999.0f*subPhase)) * (voQ - prevVO[track]);
+  					return voQ - (1.0f - slideCurve.shape((int)(patterns[currentPattern]->trigSlide[track][tPT]*99.0f),9999.0f*subPhase)) * (voQ - prevVO[track]);
           }
           else
           {
             float subPhase = clamp(trigGetRelativeTrackPosition(track, tPT)*(1.0f/max((int)abs(voQ - prevVO[track]),1)),0.0f,fullLength);
-  					return voQ - (1.0f - interpolateLinear(powTable[(int)(trigSlide[currentPattern][track][tPT]*99.0f)],9999.0f*subPhase/fullLength)) * (voQ - prevVO[track]);
+  					return voQ - (1.0f - slideCurve.shape((int)(patterns[currentPattern]->trigSlide[track][tPT]*99.0f),9999.0f*subPhase/fullLength)) * (voQ - prevVO[track]);
           }
 				}
 			}
@@ -1175,96 +1524,96 @@ struct ENCORE : BidooModule {
 	}
 
 	void trackSetCurrentTrig(const int track, const bool fill, const bool pNei, const bool force=false, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		int cI = nTracksAttibutes[currentPattern][track].getTrackCurrentTrig();
-		if (((trackHead[currentPattern][track]/32) != cI) || force) {
-			//nTracksAttibutes[currentPattern][track].setTrackPre((nTrigsAttibutes[currentPattern][track][cI].getTrigActive() && nTrigsAttibutes[currentPattern][track][cI].hasProbability()) ? !nTrigsAttibutes[currentPattern][track][cI].getTrigSleeping() : nTracksAttibutes[currentPattern][track].getTrackPre());
-			nTrigsAttibutes[currentPattern][track][cI].setTrigInitialized(false);
-			cI = trackHead[currentPattern][track]/32;
-			nTracksAttibutes[currentPattern][track].setTrackCurrentTrig(cI);
-			nTrigsAttibutes[currentPattern][track][cI].init(fill,nTracksAttibutes[currentPattern][track].getTrackPre(),pNei, forceTrig, killTrig, dice);
-			nTracksAttibutes[currentPattern][track].setTrackPre((nTrigsAttibutes[currentPattern][track][cI].getTrigActive()
-			&& nTrigsAttibutes[currentPattern][track][cI].hasProbability()) ? !nTrigsAttibutes[currentPattern][track][cI].getTrigSleeping() : nTracksAttibutes[currentPattern][track].getTrackPre());
+		int cI = patterns[currentPattern]->nTracksAttibutes[track].getTrackCurrentTrig();
+		if (((patterns[currentPattern]->trackHead[track]/32) != cI) || force) {
+			//patterns[currentPattern]->nTracksAttibutes[track].setTrackPre((patterns[currentPattern]->nTrigsAttibutes[track][cI].getTrigActive() && patterns[currentPattern]->nTrigsAttibutes[track][cI].hasProbability()) ? !patterns[currentPattern]->nTrigsAttibutes[track][cI].getTrigSleeping() : patterns[currentPattern]->nTracksAttibutes[track].getTrackPre());
+			patterns[currentPattern]->nTrigsAttibutes[track][cI].setTrigInitialized(false);
+			cI = patterns[currentPattern]->trackHead[track]/32;
+			patterns[currentPattern]->nTracksAttibutes[track].setTrackCurrentTrig(cI);
+			patterns[currentPattern]->nTrigsAttibutes[track][cI].init(fill,patterns[currentPattern]->nTracksAttibutes[track].getTrackPre(),pNei, forceTrig, killTrig, dice);
+			patterns[currentPattern]->nTracksAttibutes[track].setTrackPre((patterns[currentPattern]->nTrigsAttibutes[track][cI].getTrigActive()
+			&& patterns[currentPattern]->nTrigsAttibutes[track][cI].hasProbability()) ? !patterns[currentPattern]->nTrigsAttibutes[track][cI].getTrigSleeping() : patterns[currentPattern]->nTracksAttibutes[track].getTrackPre());
 			trackSetNextTrig(track);
-			//nTrigsAttibutes[currentPattern][track][nTracksAttibutes[currentPattern][track].getTrackNextTrig()].init(fill,nTracksAttibutes[currentPattern][track].getTrackPre(), pNei, forceTrig, killTrig, dice);
+			//patterns[currentPattern]->nTrigsAttibutes[track][patterns[currentPattern]->nTracksAttibutes[track].getTrackNextTrig()].init(fill,patterns[currentPattern]->nTracksAttibutes[track].getTrackPre(), pNei, forceTrig, killTrig, dice);
 		}
 
-		int cPT = nTracksAttibutes[currentPattern][track].getTrackPlayedTrig();
-		if (trigGetIsRead(track, cI, trackHead[currentPattern][track])) {
-			if ((cI != cPT)	&& nTrigsAttibutes[currentPattern][track][cI].getTrigActive() && !nTrigsAttibutes[currentPattern][track][cI].getTrigSleeping()) {
-				nTracksAttibutes[currentPattern][track].setTrackPrevTrig(cPT);
-				nTracksAttibutes[currentPattern][track].setTrackPlayedTrig(cI);
+		int cPT = patterns[currentPattern]->nTracksAttibutes[track].getTrackPlayedTrig();
+		if (trigGetIsRead(track, cI, patterns[currentPattern]->trackHead[track])) {
+			if ((cI != cPT)	&& patterns[currentPattern]->nTrigsAttibutes[track][cI].getTrigActive() && !patterns[currentPattern]->nTrigsAttibutes[track][cI].getTrigSleeping()) {
+				patterns[currentPattern]->nTracksAttibutes[track].setTrackPrevTrig(cPT);
+				patterns[currentPattern]->nTracksAttibutes[track].setTrackPlayedTrig(cI);
 			}
 		}
 		else {
-			int cNT = nTracksAttibutes[currentPattern][track].getTrackNextTrig();
-			if (trigGetIsRead(track, cNT, trackHead[currentPattern][track]) && (cNT != cPT)
-			&& nTrigsAttibutes[currentPattern][track][cNT].getTrigActive()
-			&& !nTrigsAttibutes[currentPattern][track][cNT].getTrigSleeping())
+			int cNT = patterns[currentPattern]->nTracksAttibutes[track].getTrackNextTrig();
+			if (trigGetIsRead(track, cNT, patterns[currentPattern]->trackHead[track]) && (cNT != cPT)
+			&& patterns[currentPattern]->nTrigsAttibutes[track][cNT].getTrigActive()
+			&& !patterns[currentPattern]->nTrigsAttibutes[track][cNT].getTrigSleeping())
 			{
-				nTracksAttibutes[currentPattern][track].setTrackPrevTrig(cPT);
-				nTracksAttibutes[currentPattern][track].setTrackPlayedTrig(cNT);
+				patterns[currentPattern]->nTracksAttibutes[track].setTrackPrevTrig(cPT);
+				patterns[currentPattern]->nTracksAttibutes[track].setTrackPlayedTrig(cNT);
 			}
 		}
 	}
 
 	void trackReset(const int track, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		//nTracksAttibutes[currentPattern][track].setTrackPre(false);
-		nTracksAttibutes[currentPattern][track].setTrackForward(true);
+		//patterns[currentPattern]->nTracksAttibutes[track].setTrackPre(false);
+		patterns[currentPattern]->nTracksAttibutes[track].setTrackForward(true);
 
-		if (nTracksAttibutes[currentPattern][track].getTrackReadMode() == 1)
+		if (patterns[currentPattern]->nTracksAttibutes[track].getTrackReadMode() == 1)
 		{
-			nTracksAttibutes[currentPattern][track].setTrackForward(false);
-			trackHead[currentPattern][track] = nTracksAttibutes[currentPattern][track].getTrackLength()*32;
+			patterns[currentPattern]->nTracksAttibutes[track].setTrackForward(false);
+			patterns[currentPattern]->trackHead[track] = patterns[currentPattern]->nTracksAttibutes[track].getTrackLength()*32;
 			trackSetCurrentTrig(track, fill, pNei, true, forceTrig, killTrig, dice);
 		}
 		else
 		{
-			trackHead[currentPattern][track] = 0;
+			patterns[currentPattern]->trackHead[track] = 0;
 			trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
 		}
 	}
 
 	void trackSetNextTrig(const int track) {
-		int cI = nTracksAttibutes[currentPattern][track].getTrackCurrentTrig();
-		switch (nTracksAttibutes[currentPattern][track].getTrackReadMode()) {
+		int cI = patterns[currentPattern]->nTracksAttibutes[track].getTrackCurrentTrig();
+		switch (patterns[currentPattern]->nTracksAttibutes[track].getTrackReadMode()) {
 			case 0:
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig((cI == (nTracksAttibutes[currentPattern][track].getTrackLength()-1)) ? 0 : (cI+1)); break;
+					patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig((cI == (patterns[currentPattern]->nTracksAttibutes[track].getTrackLength()-1)) ? 0 : (cI+1)); break;
 			case 1:
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig((cI == 0) ? (nTracksAttibutes[currentPattern][track].getTrackLength()-1) : (cI-1)); break;
+					patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig((cI == 0) ? (patterns[currentPattern]->nTracksAttibutes[track].getTrackLength()-1) : (cI-1)); break;
 			case 2: {
 				if (cI == 0) {
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(nTracksAttibutes[currentPattern][track].getTrackLength() > 1 ? 1: 0);
+					patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig(patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() > 1 ? 1: 0);
 				}
-				else if (cI == (nTracksAttibutes[currentPattern][track].getTrackLength() - 1)) {
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(nTracksAttibutes[currentPattern][track].getTrackLength() > 1 ? (nTracksAttibutes[currentPattern][track].getTrackLength()-2) : 0);
+				else if (cI == (patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() - 1)) {
+					patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig(patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() > 1 ? (patterns[currentPattern]->nTracksAttibutes[track].getTrackLength()-2) : 0);
 				}
 				else {
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(clamp(cI + (nTracksAttibutes[currentPattern][track].getTrackForward() ? 1 : -1),0,nTracksAttibutes[currentPattern][track].getTrackLength() - 1));
+					patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig(clamp(cI + (patterns[currentPattern]->nTracksAttibutes[track].getTrackForward() ? 1 : -1),0,patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() - 1));
 				}
 			  break;
 			}
-			case 3: nTracksAttibutes[currentPattern][track].setTrackNextTrig((int)(random::uniform()*(nTracksAttibutes[currentPattern][track].getTrackLength() - 1))); break;
+			case 3: patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig((int)(random::uniform()*(patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() - 1))); break;
 			case 4:
 			{
 				float dice = random::uniform();
 				if (dice>=0.5f)
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(((cI+1) > (nTracksAttibutes[currentPattern][track].getTrackLength() - 1) ? 0 : (cI + 1)));
+					patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig(((cI+1) > (patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() - 1) ? 0 : (cI + 1)));
 				else if (dice<=0.25f)
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(cI == 0 ? (nTracksAttibutes[currentPattern][track].getTrackLength() - 1) : (cI - 1));
+					patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig(cI == 0 ? (patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() - 1) : (cI - 1));
 				else
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(cI);
+					patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig(cI);
 				break;
 			}
-			default : nTracksAttibutes[currentPattern][track].setTrackNextTrig(cI);
+			default : patterns[currentPattern]->nTracksAttibutes[track].setTrackNextTrig(cI);
 		}
 	}
 
 	void trackMoveNextForward(const int track, const bool clock, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		nTracksAttibutes[currentPattern][track].setTrackForward(true);
+		patterns[currentPattern]->nTracksAttibutes[track].setTrackForward(true);
 
-    if (clock) {trackHead[currentPattern][track] += nTracksAttibutes[currentPattern][track].getTrackSpeed();}
+    if (clock) {patterns[currentPattern]->trackHead[track] += patterns[currentPattern]->nTracksAttibutes[track].getTrackSpeed();}
 
-		if (trackHead[currentPattern][track] >= nTracksAttibutes[currentPattern][track].getTrackLength()*32) {
+		if (patterns[currentPattern]->trackHead[track] >= patterns[currentPattern]->nTracksAttibutes[track].getTrackLength()*32) {
 			trackReset(track, fill, pNei, forceTrig, killTrig, dice);
 			return;
 		}
@@ -1273,11 +1622,11 @@ struct ENCORE : BidooModule {
 	}
 
 	void trackMoveNextBackward(const int track, const bool clock, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		nTracksAttibutes[currentPattern][track].setTrackForward(false);
+		patterns[currentPattern]->nTracksAttibutes[track].setTrackForward(false);
 
-    if (clock) {trackHead[currentPattern][track] -= nTracksAttibutes[currentPattern][track].getTrackSpeed();}
+    if (clock) {patterns[currentPattern]->trackHead[track] -= patterns[currentPattern]->nTracksAttibutes[track].getTrackSpeed();}
 
-		if (trackHead[currentPattern][track] <= 0) {
+		if (patterns[currentPattern]->trackHead[track] <= 0) {
 			trackReset(track, fill, pNei, forceTrig, killTrig, dice);
 			return;
 		}
@@ -1286,25 +1635,25 @@ struct ENCORE : BidooModule {
 	}
 
 	void trackMoveNextPendulum(const int track, const bool clock, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		if (clock) {trackHead[currentPattern][track] = trackHead[currentPattern][track] + (nTracksAttibutes[currentPattern][track].getTrackForward() ? 1 : -1 ) * nTracksAttibutes[currentPattern][track].getTrackSpeed();}
+		if (clock) {patterns[currentPattern]->trackHead[track] = patterns[currentPattern]->trackHead[track] + (patterns[currentPattern]->nTracksAttibutes[track].getTrackForward() ? 1 : -1 ) * patterns[currentPattern]->nTracksAttibutes[track].getTrackSpeed();}
 
-		if (trackHead[currentPattern][track] >= nTracksAttibutes[currentPattern][track].getTrackLength()*32) {
-			nTracksAttibutes[currentPattern][track].setTrackForward(false);
-			trackHead[currentPattern][track] = (nTracksAttibutes[currentPattern][track].getTrackLength() == 1) ? 0 : (nTracksAttibutes[currentPattern][track].getTrackLength()-1)*32;
+		if (patterns[currentPattern]->trackHead[track] >= patterns[currentPattern]->nTracksAttibutes[track].getTrackLength()*32) {
+			patterns[currentPattern]->nTracksAttibutes[track].setTrackForward(false);
+			patterns[currentPattern]->trackHead[track] = (patterns[currentPattern]->nTracksAttibutes[track].getTrackLength() == 1) ? 0 : (patterns[currentPattern]->nTracksAttibutes[track].getTrackLength()-1)*32;
 		}
-		else if (trackHead[currentPattern][track] <= 0) {
-			nTracksAttibutes[currentPattern][track].setTrackForward(true);
-			trackHead[currentPattern][track] = 0;
+		else if (patterns[currentPattern]->trackHead[track] <= 0) {
+			patterns[currentPattern]->nTracksAttibutes[track].setTrackForward(true);
+			patterns[currentPattern]->trackHead[track] = 0;
 		}
 
 		trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
 	}
 
 	void trackMoveNextRandom(const int track, const bool clock, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		if (clock) {trackHead[currentPattern][track] += nTracksAttibutes[currentPattern][track].getTrackSpeed();}
+		if (clock) {patterns[currentPattern]->trackHead[track] += patterns[currentPattern]->nTracksAttibutes[track].getTrackSpeed();}
 
-		if (trackHead[currentPattern][track] >= (nTracksAttibutes[currentPattern][track].getTrackCurrentTrig()+1)*32) {
-			trackHead[currentPattern][track] = nTracksAttibutes[currentPattern][track].getTrackNextTrig()*32;
+		if (patterns[currentPattern]->trackHead[track] >= (patterns[currentPattern]->nTracksAttibutes[track].getTrackCurrentTrig()+1)*32) {
+			patterns[currentPattern]->trackHead[track] = patterns[currentPattern]->nTracksAttibutes[track].getTrackNextTrig()*32;
 			trackSetCurrentTrig(track, fill, pNei, true, forceTrig, killTrig, dice);
 			return;
 		}
@@ -1313,11 +1662,11 @@ struct ENCORE : BidooModule {
 	}
 
 	void trackMoveNextBrownian(const int track, const bool clock, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		nTracksAttibutes[currentPattern][track].setTrackForward(true);
-		if (clock) {trackHead[currentPattern][track] += nTracksAttibutes[currentPattern][track].getTrackSpeed();}
+		patterns[currentPattern]->nTracksAttibutes[track].setTrackForward(true);
+		if (clock) {patterns[currentPattern]->trackHead[track] += patterns[currentPattern]->nTracksAttibutes[track].getTrackSpeed();}
 
-		if (trackHead[currentPattern][track] >= (nTracksAttibutes[currentPattern][track].getTrackCurrentTrig()+1)*32) {
-			trackHead[currentPattern][track] = nTracksAttibutes[currentPattern][track].getTrackNextTrig()*32;
+		if (patterns[currentPattern]->trackHead[track] >= (patterns[currentPattern]->nTracksAttibutes[track].getTrackCurrentTrig()+1)*32) {
+			patterns[currentPattern]->trackHead[track] = patterns[currentPattern]->nTracksAttibutes[track].getTrackNextTrig()*32;
 			trackSetCurrentTrig(track, fill, pNei, true, forceTrig, killTrig, dice);
 			return;
 		}
@@ -1326,7 +1675,7 @@ struct ENCORE : BidooModule {
 	}
 
 	void trackMoveNext(const int track, const bool clock, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		switch (nTracksAttibutes[currentPattern][track].getTrackReadMode()) {
+		switch (patterns[currentPattern]->nTracksAttibutes[track].getTrackReadMode()) {
 			case 0: trackMoveNextForward(track, clock, fill, pNei, forceTrig, killTrig, dice); break;
 			case 1: trackMoveNextBackward(track, clock, fill, pNei, forceTrig, killTrig, dice); break;
 			case 2: trackMoveNextPendulum(track, clock, fill, pNei, forceTrig, killTrig, dice); break;
@@ -1338,8 +1687,21 @@ struct ENCORE : BidooModule {
 };
 
 void ENCORE::process(const ProcessArgs &args) {
+	patternPool.enter();
+#if defined(METAMODULE)
+	if (patternPool.spare.load(std::memory_order_relaxed) == nullptr) {
+		refillAsync.run_once();
+	}
+#endif
+
 	currentPattern = (int)clamp((inputs[PATTERN_INPUT].isConnected() ? rescale(clamp(inputs[PATTERN_INPUT].getVoltage(), 0.0f, 10.0f),0.0f,10.0f,0.0f,8.0f) : 0) + (int)params[PATTERN_PARAM].getValue(), 0.0f, 7.0f);
 
+	for (int i=0; i<8; i++) {
+		if (blankHandoff[i].load(std::memory_order_relaxed) && blankHandoff[i].exchange(false) && (i == currentPattern)) {
+			playbackFromBlank(*patterns[i]);
+		}
+	}
+
 	if (rightExpander.module && rightExpander.module->model == modelENCOREExpander) {
 		float *messagesFromExpander = (float*)rightExpander.consumerMessage;
 		for (int i=0; i<8; i++) {
@@ -1369,8 +1731,10 @@ void ENCORE::process(const ProcessArgs &args) {
 	solo = patternIsSoloed();
 
 	if (currentPattern != previousPattern) {
-		for (size_t i = 0; i<8; i++) {
-			trackSync(i, trackHead[previousPattern][i]);
+		if (previousPattern >= 0) {
+			for (size_t i = 0; i<8; i++) {
+				trackSync(i, patterns[previousPattern]->trackHead[i]);
+			}
 		}
 		previousPattern = currentPattern;
 		updateTrackToParams();
@@ -1383,7 +1747,7 @@ void ENCORE::process(const ProcessArgs &args) {
 	}
 
 	int pageOffset = trigPage*16;
-	int tCT = nTracksAttibutes[currentPattern][currentTrack].getTrackCurrentTrig();
+	int tCT = patterns[currentPattern]->nTracksAttibutes[currentTrack].getTrackCurrentTrig();
 	for (int i = 0; i<16; i++) {
 		int shiftedIndex = i + pageOffset;
 		if (tCT == shiftedIndex) {
@@ -1391,7 +1755,7 @@ void ENCORE::process(const ProcessArgs &args) {
 			lights[STEPS_LIGHTS+3*i+1].setBrightness(0.0f);
 			lights[STEPS_LIGHTS+3*i+2].setBrightness(0.0f);
 		}
-		else if (nTrigsAttibutes[currentPattern][currentTrack][shiftedIndex].getTrigActive()) {
+		else if (patterns[currentPattern]->nTrigsAttibutes[currentTrack][shiftedIndex].getTrigActive()) {
 			if (shiftedIndex == currentTrig) {
 				lights[STEPS_LIGHTS+3*i].setBrightness(0.0f);
 				lights[STEPS_LIGHTS+3*i+1].setBrightness(0.0f);
@@ -1430,7 +1794,7 @@ void ENCORE::process(const ProcessArgs &args) {
 		}
 
 		if (i<7) {
-				if (nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigOctave()==i) {
+				if (patterns[currentPattern]->nTrigsAttibutes[currentTrack][currentTrig].getTrigOctave()==i) {
 					lights[OCTAVE_LIGHTS+3*i+2].setBrightness(1.0f);
 				}
 				else {
@@ -1440,7 +1804,7 @@ void ENCORE::process(const ProcessArgs &args) {
 
 		if (i<8) {
 			if (trackActiveTriggers[i].process(inputs[TRACKACTIVE_INPUTS+i].getVoltage())) {
-				nTracksAttibutes[currentPattern][i].toggleTrackActive();
+				editPattern(currentPattern).nTracksAttibutes[i].toggleTrackActive();
 			}
 
 			if (currentTrack==i) {
@@ -1452,11 +1816,11 @@ void ENCORE::process(const ProcessArgs &args) {
 				lights[TRACKSELECT_LIGHTS+i*3+2].setBrightness(0.0f);
 			}
 
-			if (!solo && nTracksAttibutes[currentPattern][i].getTrackActive()) {
+			if (!solo && patterns[currentPattern]->nTracksAttibutes[i].getTrackActive()) {
 				lights[TRACKSONOFF_LIGHTS+i*3+1].setBrightness(1.0f);
 				lights[TRACKSONOFF_LIGHTS+i*3+2].setBrightness(0.0f);
 			}
-			else if (solo && nTracksAttibutes[currentPattern][i].getTrackSolo()) {
+			else if (solo && patterns[currentPattern]->nTracksAttibutes[i].getTrackSolo()) {
 				lights[TRACKSONOFF_LIGHTS+i*3+1].setBrightness(0.0f);
 				lights[TRACKSONOFF_LIGHTS+i*3+2].setBrightness(1.0f);
 			}
@@ -1497,7 +1861,7 @@ void ENCORE::process(const ProcessArgs &args) {
 					nTrackRight(i,rotRight[i], rotLen[i]);
 					updateTrigToParams();
 				}
-				trackReset(i, fill || fills[i], i == 0 ? false : nTracksAttibutes[currentPattern][i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
+				trackReset(i, fill || fills[i], i == 0 ? false : patterns[currentPattern]->nTracksAttibutes[i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
 			}
       else if (!inputs[TRACKRESET_INPUTS+i].isConnected() && globalReset) {
 				if (rotLeft[i]) {
@@ -1508,7 +1872,7 @@ void ENCORE::process(const ProcessArgs &args) {
 					nTrackRight(i,rotRight[i], rotLen[i]);
 					updateTrigToParams();
 				}
-				trackReset(i, fill || fills[i], i == 0 ? false : nTracksAttibutes[currentPattern][i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
+				trackReset(i, fill || fills[i], i == 0 ? false : patterns[currentPattern]->nTracksAttibutes[i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
 			}
 			else {
 				if (rotLeft[i]) {
@@ -1519,50 +1883,58 @@ void ENCORE::process(const ProcessArgs &args) {
 					nTrackRight(i,rotRight[i], rotLen[i]);
 					updateTrigToParams();
 				}
-				trackMoveNext(i, clockTrigged, fill || fills[i], i == 0 ? false : nTracksAttibutes[currentPattern][i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
+				trackMoveNext(i, clockTrigged, fill || fills[i], i == 0 ? false : patterns[currentPattern]->nTracksAttibutes[i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
 			}
 
-			int tPT = nTracksAttibutes[currentPattern][i].getTrackPlayedTrig();
+			int tPT = patterns[currentPattern]->nTracksAttibutes[i].getTrackPlayedTrig();
 
 			if ((currentTrack == i) && (params[RECORD_PARAM].getValue() == 1.0f)) {
 					if (inputs[GATE_INPUT].getVoltage()>0.1f) {
-						if (!noteIncoming) {
+						EncorePattern *edited = tryEditPattern(currentPattern);
+						if (!edited) {
+							// no spare block yet, the note is taken on a next sample
+						}
+						else if (!noteIncoming) {
+							EncorePattern &recorded = *edited;
 							noteIncoming = true;
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigActive(true);
+							recorded.nTrigsAttibutes[i][(long)recorded.trackHead[i]].setTrigActive(true);
 							if (params[QUANTIZE_PARAM].getValue() == 0.0f) {
-								trigTrim[currentPattern][i][(long)trackHead[currentPattern][i]] = trackHead[currentPattern][i] - (long)trackHead[currentPattern][i];
+								recorded.trigTrim[i][(long)recorded.trackHead[i]] = recorded.trackHead[i] - (long)recorded.trackHead[i];
 							} else {
-								trigTrim[currentPattern][i][(long)trackHead[currentPattern][i]] = 0.0f;
+								recorded.trigTrim[i][(long)recorded.trackHead[i]] = 0.0f;
 							}
 							currentIncomingVO = inputs[VO_INPUT].getVoltage();
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigOctave((long)currentIncomingVO+3.0f);
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigSemiTones((long)((currentIncomingVO-(long)currentIncomingVO)*12.f));
+							recorded.nTrigsAttibutes[i][(long)recorded.trackHead[i]].setTrigOctave((long)currentIncomingVO+3.0f);
+							recorded.nTrigsAttibutes[i][(long)recorded.trackHead[i]].setTrigSemiTones((long)((currentIncomingVO-(long)currentIncomingVO)*12.f));
 						}
 						else if (currentIncomingVO != inputs[VO_INPUT].getVoltage()) {
+							EncorePattern &recorded = *edited;
 							currentIncomingVO = inputs[VO_INPUT].getVoltage();
-							if (trackHead[currentPattern][i]>nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()) {
-								trigLength[currentPattern][i][tPT] = trackHead[currentPattern][i] - nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()-0.01f;
+							if (recorded.trackHead[i]>recorded.nTrigsAttibutes[i][tPT].getTrigIndex()) {
+								recorded.trigLength[i][tPT] = recorded.trackHead[i] - recorded.nTrigsAttibutes[i][tPT].getTrigIndex()-0.01f;
 							}
 							else {
-								trigLength[currentPattern][i][tPT] = nTracksAttibutes[currentPattern][i].getTrackLength() - nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()-0.01f;
+								recorded.trigLength[i][tPT] = recorded.nTracksAttibutes[i].getTrackLength() - recorded.nTrigsAttibutes[i][tPT].getTrigIndex()-0.01f;
 							}
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigActive(true);
+							recorded.nTrigsAttibutes[i][(long)recorded.trackHead[i]].setTrigActive(true);
 							if (params[QUANTIZE_PARAM].getValue() == 0.0f) {
-								trigTrim[currentPattern][i][(long)trackHead[currentPattern][i]] = trackHead[currentPattern][i] - (long)trackHead[currentPattern][i];
+								recorded.trigTrim[i][(long)recorded.trackHead[i]] = recorded.trackHead[i] - (long)recorded.trackHead[i];
 							} else {
-								trigTrim[currentPattern][i][(long)trackHead[currentPattern][i]] = 0.0f;
+								recorded.trigTrim[i][(long)recorded.trackHead[i]] = 0.0f;
 							}
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigOctave((long)currentIncomingVO+3.0f);
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigSemiTones((long)((currentIncomingVO-(long)currentIncomingVO)*12.f));
+							recorded.nTrigsAttibutes[i][(long)recorded.trackHead[i]].setTrigOctave((long)currentIncomingVO+3.0f);
+							recorded.nTrigsAttibutes[i][(long)recorded.trackHead[i]].setTrigSemiTones((long)((currentIncomingVO-(long)currentIncomingVO)*12.f));
 						}
 					} else {
-						if (noteIncoming) {
+						EncorePattern *edited = noteIncoming ? tryEditPattern(currentPattern) : nullptr;
+						if (edited) {
+							EncorePattern &recorded = *edited;
 							noteIncoming = false;
-							if (trackHead[currentPattern][i]>nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()) {
-								trigLength[currentPattern][i][tPT] = trackHead[currentPattern][i] - nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex();
+							if (recorded.trackHead[i]>recorded.nTrigsAttibutes[i][tPT].getTrigIndex()) {
+								recorded.trigLength[i][tPT] = recorded.trackHead[i] - recorded.nTrigsAttibutes[i][tPT].getTrigIndex();
 							}
 							else {
-								trigLength[currentPattern][i][tPT] = nTracksAttibutes[currentPattern][i].getTrackLength() - nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()-0.01f;
+								recorded.trigLength[i][tPT] = recorded.nTracksAttibutes[i].getTrackLength() - recorded.nTrigsAttibutes[i][tPT].getTrigIndex()-0.01f;
 							}
 							currentIncomingVO = -100.0f;
 						}
@@ -1570,14 +1942,14 @@ void ENCORE::process(const ProcessArgs &args) {
 			}
 
 
-			if ((solo && nTracksAttibutes[currentPattern][i].getTrackSolo()) || (!solo && nTracksAttibutes[currentPattern][i].getTrackActive())) {
+			if ((solo && patterns[currentPattern]->nTracksAttibutes[i].getTrackSolo()) || (!solo && patterns[currentPattern]->nTracksAttibutes[i].getTrackActive())) {
 				float gate = trackGetGate(i, tPT);
 				if (gate>0.0f) {
-					if (nTrigsAttibutes[currentPattern][i][tPT].getTrigType() == 0)
+					if (patterns[currentPattern]->nTrigsAttibutes[i][tPT].getTrigType() == 0)
 						outputs[GATE_OUTPUTS + i].setVoltage(gate);
-					else if (nTrigsAttibutes[currentPattern][i][tPT].getTrigType() == 1)
+					else if (patterns[currentPattern]->nTrigsAttibutes[i][tPT].getTrigType() == 1)
 						outputs[GATE_OUTPUTS + i].setVoltage(inputs[G1_INPUT].getVoltage());
-					else if (nTrigsAttibutes[currentPattern][i][tPT].getTrigType() == 2)
+					else if (patterns[currentPattern]->nTrigsAttibutes[i][tPT].getTrigType() == 2)
 						outputs[GATE_OUTPUTS + i].setVoltage(inputs[G2_INPUT].getVoltage());
 					else
 						outputs[GATE_OUTPUTS + i].setVoltage(0.0f);
@@ -1593,10 +1965,10 @@ void ENCORE::process(const ProcessArgs &args) {
 				prevTrig[i] = tPT;
 			}
 
-			bool q = rootNote[currentPattern][i]>=0 && scale[currentPattern][i]>0;
+			bool q = patterns[currentPattern]->rootNote[i]>=0 && patterns[currentPattern]->scale[i]>0;
 			outputs[VO_OUTPUTS + i].setVoltage(trackGetVO(i, tPT, q));
-			outputs[CV1_OUTPUTS + i].setVoltage(outputs[GATE_OUTPUTS + i].getVoltage() == 0.0f ? 0.0f : ((quantizeCV1[currentPattern][i]>0 && q) ? std::get<0>(quant.closestVoltageInScale(trigCV1[currentPattern][i][tPT]-4.0f, rootNote[currentPattern][i], scale[currentPattern][i])) : trigCV1[currentPattern][i][tPT]));
-			outputs[CV2_OUTPUTS + i].setVoltage(outputs[GATE_OUTPUTS + i].getVoltage() == 0.0f ? 0.0f : trigCV2[currentPattern][i][tPT]);
+			outputs[CV1_OUTPUTS + i].setVoltage(outputs[GATE_OUTPUTS + i].getVoltage() == 0.0f ? 0.0f : ((patterns[currentPattern]->quantizeCV1[i]>0 && q) ? std::get<0>(quant.closestVoltageInScale(patterns[currentPattern]->trigCV1[i][tPT]-4.0f, patterns[currentPattern]->rootNote[i], patterns[currentPattern]->scale[i])) : patterns[currentPattern]->trigCV1[i][tPT]));
+			outputs[CV2_OUTPUTS + i].setVoltage(outputs[GATE_OUTPUTS + i].getVoltage() == 0.0f ? 0.0f : patterns[currentPattern]->trigCV2[i][tPT]);
 		}
 	}
 	else {
@@ -1647,7 +2019,7 @@ struct EncoreoctaveBtn : SmallLEDLightBezel<RedGreenBlueLight> {
 					mod->params[ENCORE::OCTAVE_PARAMS+i].setValue(0.0f);
 				}
 				else {
-					mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].setTrigOctave(i);
+					mod->editPattern(mod->currentPattern).nTrigsAttibutes[mod->currentTrack][mod->currentTrig].setTrigOctave(i);
 				}
 			}
 			e.consume(this);
@@ -1872,8 +2244,8 @@ struct EncoretrackOnOffBtn : LEDLightBezel<RedGreenBlueLight> {
 					}
 				}
 				else {
-					mod->nTracksAttibutes[mod->currentPattern][i].toggleTrackSolo();
-					mod->params[ENCORE::TRACKSONOFF_PARAMS+i].setValue(mod->nTracksAttibutes[mod->currentPattern][getParamQuantity()->paramId - ENCORE::TRACKSONOFF_PARAMS].getTrackSolo() ? 2.0f : 0.0f);
+					mod->editPattern(mod->currentPattern).nTracksAttibutes[i].toggleTrackSolo();
+					mod->params[ENCORE::TRACKSONOFF_PARAMS+i].setValue(mod->patterns[mod->currentPattern]->nTracksAttibutes[getParamQuantity()->paramId - ENCORE::TRACKSONOFF_PARAMS].getTrackSolo() ? 2.0f : 0.0f);
 					mod->params[ENCORE::TRACKSELECT_PARAMS+i].setValue(1.0f);
 					mod->currentTrack=i;
 					mod->updateTrackToParams();
@@ -1885,8 +2257,8 @@ struct EncoretrackOnOffBtn : LEDLightBezel<RedGreenBlueLight> {
 		}
 		else if (e.button == GLFW_MOUSE_BUTTON_LEFT && e.action == GLFW_PRESS) {
 			if (!mod->solo) {
-				mod->nTracksAttibutes[mod->currentPattern][getParamQuantity()->paramId - ENCORE::TRACKSONOFF_PARAMS].toggleTrackActive();
-				if (mod->nTracksAttibutes[mod->currentPattern][getParamQuantity()->paramId - ENCORE::TRACKSONOFF_PARAMS].getTrackActive()) {
+				mod->editPattern(mod->currentPattern).nTracksAttibutes[getParamQuantity()->paramId - ENCORE::TRACKSONOFF_PARAMS].toggleTrackActive();
+				if (mod->patterns[mod->currentPattern]->nTracksAttibutes[getParamQuantity()->paramId - ENCORE::TRACKSONOFF_PARAMS].getTrackActive()) {
 					mod->params[getParamQuantity()->paramId - ENCORE::TRACKSONOFF_PARAMS].setValue(1.0f);
 				} else {
 					mod->params[getParamQuantity()->paramId - ENCORE::TRACKSONOFF_PARAMS].setValue(0.0f);
@@ -2004,13 +2376,13 @@ struct EncorenoteBtn : LEDLightBezel<RedGreenBlueLight> {
 	void onButton(const event::Button &e) override {
 		if (e.button == GLFW_MOUSE_BUTTON_LEFT && e.action == GLFW_PRESS) {
 			ENCORE *mod = static_cast<ENCORE*>(getParamQuantity()->module);
-			bool focused = mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].getTrigSemiTones() == getParamQuantity()->paramId - ENCORE::NOTE_PARAMS;
+			bool focused = mod->patterns[mod->currentPattern]->nTrigsAttibutes[mod->currentTrack][mod->currentTrig].getTrigSemiTones() == getParamQuantity()->paramId - ENCORE::NOTE_PARAMS;
 			if (focused) {
-				mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].toggleTrigActive();
+				mod->editPattern(mod->currentPattern).nTrigsAttibutes[mod->currentTrack][mod->currentTrig].toggleTrigActive();
 			}
 			else {
-				mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].setTrigSemiTones(getParamQuantity()->paramId - ENCORE::NOTE_PARAMS);
-				mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].setTrigActive(true);
+				mod->editPattern(mod->currentPattern).nTrigsAttibutes[mod->currentTrack][mod->currentTrig].setTrigSemiTones(getParamQuantity()->paramId - ENCORE::NOTE_PARAMS);
+				mod->editPattern(mod->currentPattern).nTrigsAttibutes[mod->currentTrack][mod->currentTrig].setTrigActive(true);
 			}
 			e.consume(this);
 			return;
@@ -2029,7 +2401,7 @@ struct EncorestepBtn : LEDLightBezel<RedGreenBlueLight> {
 	void onButton(const event::Button &e) override {
 		if (getParamQuantity() && getParamQuantity()->module && e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT && (e.mods & RACK_MOD_MASK) == (GLFW_MOD_SHIFT)) {
 			ENCORE *mod = static_cast<ENCORE*>(getParamQuantity()->module);
-			mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][getParamQuantity()->paramId - ENCORE::STEPS_PARAMS + mod->trigPage*16].toggleTrigActive();
+			mod->editPattern(mod->currentPattern).nTrigsAttibutes[mod->currentTrack][getParamQuantity()->paramId - ENCORE::STEPS_PARAMS + mod->trigPage*16].toggleTrigActive();
 			mod->currentTrig = getParamQuantity()->paramId - ENCORE::STEPS_PARAMS + mod->trigPage*16;
 			mod->updateTrigToParams();
 		}
@@ -2134,9 +2506,7 @@ struct EncorezouPatternBtn : BidooRoundBlackSnapKnob {
 
 			if (e.key == GLFW_KEY_E) {
 				ENCORE *mod = static_cast<ENCORE*>(getParamQuantity()->module);
-				for (int i=0; i<8; i++) {
-					mod->trackInit(mod->currentPattern,i);
-				}
+				mod->patternInit(mod->currentPattern);
 				mod->updateTrackToParams();
 				mod->updateTrigToParams();
 			}
@@ -2189,36 +2559,36 @@ struct ENCOREDisplay : TransparentWidget {
 
 			if (module) {
 				sPatternHeader << "Pattern " + to_string(module->currentPattern + 1) + " : " + module->labels[module->currentTrack];
-				sSteps << module->nTracksAttibutes[module->currentPattern][module->currentTrack].getTrackLength();
-				sSpeed << fixed << setprecision(2) << module->nTracksAttibutes[module->currentPattern][module->currentTrack].getTrackSpeed();
-				sRead << displayReadMode(module->nTracksAttibutes[module->currentPattern][module->currentTrack].getTrackReadMode());
-				sRootNote << quantizer::rootNotes[module->rootNote[module->currentPattern][module->currentTrack]+1].label.c_str();
-				sScale << quantizer::scales[module->scale[module->currentPattern][module->currentTrack]].label.c_str();
-				sQuantizeCV1 << (module->quantizeCV1[module->currentPattern][module->currentTrack] == 0 ? "Free" : "Qnt.");
+				sSteps << module->patterns[module->currentPattern]->nTracksAttibutes[module->currentTrack].getTrackLength();
+				sSpeed << fixed << setprecision(2) << module->patterns[module->currentPattern]->nTracksAttibutes[module->currentTrack].getTrackSpeed();
+				sRead << displayReadMode(module->patterns[module->currentPattern]->nTracksAttibutes[module->currentTrack].getTrackReadMode());
+				sRootNote << quantizer::rootNotes[module->patterns[module->currentPattern]->rootNote[module->currentTrack]+1].label.c_str();
+				sScale << quantizer::scales[module->patterns[module->currentPattern]->scale[module->currentTrack]].label.c_str();
+				sQuantizeCV1 << (module->patterns[module->currentPattern]->quantizeCV1[module->currentTrack] == 0 ? "Free" : "Qnt.");
 
 				sTrigHeader << "Trig " + to_string(module->currentTrig + 1);
-				sLen << fixed << setprecision(2) << (float)module->trigLength[module->currentPattern][module->currentTrack][module->currentTrig];
-				sPuls << to_string(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigPulseCount()).c_str();
-				sDist << fixed << setprecision(2) << (float)module->trigPulseDistance[module->currentPattern][module->currentTrack][module->currentTrig];
-				sType << displayTrigType(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigType()).c_str();
-				sTrim << fixed << setprecision(2) << module->trigTrim[module->currentPattern][module->currentTrack][module->currentTrig];
-				sSlide << fixed << setprecision(2) << module->trigSlide[module->currentPattern][module->currentTrack][module->currentTrig];
-				//sVO << displayNote(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigSemiTones(), module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigOctave());
-				sCV1 << fixed << setprecision(2) << module->trigCV1[module->currentPattern][module->currentTrack][module->currentTrig];
-				sCV2 << fixed << setprecision(2) << module->trigCV2[module->currentPattern][module->currentTrack][module->currentTrig];
-				sProb << displayProba(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigProba());
-        sSlideType << (module->trigSlideType[module->currentPattern][module->currentTrack][module->currentTrig] ? "1" : "FULL");
+				sLen << fixed << setprecision(2) << (float)module->patterns[module->currentPattern]->trigLength[module->currentTrack][module->currentTrig];
+				sPuls << to_string(module->patterns[module->currentPattern]->nTrigsAttibutes[module->currentTrack][module->currentTrig].getTrigPulseCount()).c_str();
+				sDist << fixed << setprecision(2) << (float)module->patterns[module->currentPattern]->trigPulseDistance[module->currentTrack][module->currentTrig];
+				sType << displayTrigType(module->patterns[module->currentPattern]->nTrigsAttibutes[module->currentTrack][module->currentTrig].getTrigType()).c_str();
+				sTrim << fixed << setprecision(2) << module->patterns[module->currentPattern]->trigTrim[module->currentTrack][module->currentTrig];
+				sSlide << fixed << setprecision(2) << module->patterns[module->currentPattern]->trigSlide[module->currentTrack][module->currentTrig];
+				//sVO << displayNote(module->patterns[module->currentPattern]->nTrigsAttibutes[module->currentTrack][module->currentTrig].getTrigSemiTones(), module->patterns[module->currentPattern]->nTrigsAttibutes[module->currentTrack][module->currentTrig].getTrigOctave());
+				sCV1 << fixed << setprecision(2) << module->patterns[module->currentPattern]->trigCV1[module->currentTrack][module->currentTrig];
+				sCV2 << fixed << setprecision(2) << module->patterns[module->currentPattern]->trigCV2[module->currentTrack][module->currentTrig];
+				sProb << displayProba(module->patterns[module->currentPattern]->nTrigsAttibutes[module->currentTrack][module->currentTrig].getTrigProba());
+        sSlideType << (module->patterns[module->currentPattern]->trigSlideType[module->currentTrack][module->currentTrig] ? "1" : "FULL");
 
 				nvgFontSize(args.vg, 10.0f);
-				if (module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigProba() < 2)
+				if (module->patterns[module->currentPattern]->nTrigsAttibutes[module->currentTrack][module->currentTrig].getTrigProba() < 2)
 				{
 					nvgText(args.vg, portX1[3], portY0[6], "Val.", NULL);
-					nvgText(args.vg, portX1[3], portY0[7], to_string(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigCount()).c_str(), NULL);
+					nvgText(args.vg, portX1[3], portY0[7], to_string(module->patterns[module->currentPattern]->nTrigsAttibutes[module->currentTrack][module->currentTrig].getTrigCount()).c_str(), NULL);
 				}
-				if (module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigProba() == 1)
+				if (module->patterns[module->currentPattern]->nTrigsAttibutes[module->currentTrack][module->currentTrig].getTrigProba() == 1)
 				{
 					nvgText(args.vg, portX1[4], portY0[6], "Base", NULL);
-					nvgText(args.vg, portX1[4], portY0[7], to_string(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigCountReset()).c_str(), NULL);
+					nvgText(args.vg, portX1[4], portY0[7], to_string(module->patterns[module->currentPattern]->nTrigsAttibutes[module->currentTrack][module->currentTrig].getTrigCountReset()).c_str(), NULL);
 				}
 			}
 			else {
@@ -2397,6 +2767,15 @@ struct EncoreBidooProbBlueKnob : BidooBlueSnapKnob {
 
 
 struct ENCOREWidget : BidooWidget {
+	// keeps a spare pattern block ready for the audio thread
+	void step() override {
+		ENCORE *encore = dynamic_cast<ENCORE*>(module);
+		if (encore) {
+			encore->patternPool.refill();
+		}
+		BidooWidget::step();
+	}
+
 	ENCOREWidget(ENCORE *module) {
 		setModule(module);
     prepareThemes(asset::plugin(pluginInstance, "res/ENCORE.svg"));
@@ -2765,7 +3144,7 @@ struct ENCOREWidget : BidooWidget {
 	struct EncoreTrackSlideModeItem : MenuItem {
 		ENCORE *module;
 		void onAction(const event::Action &e) override {
-			module->slideMode[module->currentPattern][module->currentTrack] = !module->slideMode[module->currentPattern][module->currentTrack];
+			module->editPattern(module->currentPattern).slideMode[module->currentTrack] = !module->patterns[module->currentPattern]->slideMode[module->currentTrack];
 		}
 	};
 
@@ -2823,9 +3202,7 @@ struct ENCOREWidget : BidooWidget {
 	struct EncoreInitPatternItem : MenuItem {
 		ENCORE *module;
 		void onAction(const event::Action &e) override {
-			for (int i=0; i<8; i++) {
-				module->trackInit(module->currentPattern,i);
-			}
+			module->patternInit(module->currentPattern);
 			module->updateTrackToParams();
 			module->updateTrigToParams();
 		}
@@ -2849,6 +3226,13 @@ struct ENCOREWidget : BidooWidget {
 		}
 	};
 
+	struct EncoreCompactItem : MenuItem {
+		ENCORE *module;
+		void onAction(const event::Action &e) override {
+			module->compactPatterns();
+		}
+	};
+
   struct labelTextField : TextField {
 
     ENCORE *module;
@@ -2897,7 +3281,7 @@ struct ENCOREWidget : BidooWidget {
 			}));
 
 			menu->addChild(createSubmenuItem("Track", "", [=](ui::Menu* menu) {
-				menu->addChild(construct<EncoreTrackSlideModeItem>(&MenuItem::text, module->slideMode[module->currentPattern][module->currentTrack] ? "Slide time✓/rate const." : "Slide time/rate✓ const.", &EncoreTrackSlideModeItem::module, module));
+				menu->addChild(construct<EncoreTrackSlideModeItem>(&MenuItem::text, module->patterns[module->currentPattern]->slideMode[module->currentTrack] ? "Slide time✓/rate const." : "Slide time/rate✓ const.", &EncoreTrackSlideModeItem::module, module));
 				menu->addChild(construct<EncoreInitTrackItem>(&MenuItem::text, "Erase (over+E)", &EncoreInitTrackItem::module, module));
 				menu->addChild(construct<EncoreCopyTrackItem>(&MenuItem::text, "Copy (over+C)", &EncoreCopyTrackItem::module, module));
 				menu->addChild(construct<EncorePasteTrackItem>(&MenuItem::text, "Paste (over+V)", &EncorePasteTrackItem::module, module));
@@ -2936,6 +3320,8 @@ struct ENCOREWidget : BidooWidget {
 				menu->addChild(construct<EncorePastePatternItem>(&MenuItem::text, "Paste (over+V)", &EncorePastePatternItem::module, module));
 				menu->addChild(construct<EncoreRandomizePatternItem>(&MenuItem::text, "Rand (over+R)", &EncoreRandomizePatternItem::module, module));
 				menu->addChild(construct<EncoreFullRandomizePatternItem>(&MenuItem::text, "Full Rand (over+T)", &EncoreFullRandomizePatternItem::module, module));
+				menu->addChild(new MenuSeparator());
+				menu->addChild(construct<EncoreCompactItem>(&MenuItem::text, "Compact memory", &MenuItem::rightText, string::f("%d/8 used, %d KB", module->allocatedPatterns(), (int)(module->patternFootprint() / 1024)), &EncoreCompactItem::module, module));
 			}));
 
 			menu->addChild(createSubmenuItem("Page", "", [=](ui::Menu* menu) {
@@ -122,7 +122,7 @@ struct MAGMA : BidooModule {
 	int sampleChannels;
 	int sampleRate;
 	int totalSampleCount;
-	vector<dsp::Frame<1>> playBuffer;
+	waves::SampleBuffer<1> playBuffer;
 	bool play = false;
 	std::string lastPath;
 	std::string waveFileName;
@@ -299,11 +299,9 @@ void MAGMA::loadSampleInternal() {
 	}
 	
 	lock();
-	playBuffer = waves::getMonoWav(lastPath, APP->engine->getSampleRate(), waveFileName, waveExtension, sampleChannels, sampleRate, totalSampleCount);
+	waves::getMonoWav(lastPath, APP->engine->getSampleRate(), waveFileName, waveExtension, sampleChannels, sampleRate, totalSampleCount, playBuffer);
 	unlock();
 	loading = false;
-
-	vector<dsp::Frame<1>>(playBuffer).swap(playBuffer);
 }
 
 void MAGMA::loadSample() {
@@ -569,6 +567,8 @@ struct MAGMAWidget : BidooWidget {
 		assert(module);
 		menu->addChild(new MenuSeparator());
 		menu->addChild(construct<MAGMAItem>(&MenuItem::text, "Load sample", &MAGMAItem::module, module));
+		appendResampleMenu(menu);
+		appendCompactMenu(menu);
 	}
 };
 
@@ -55,10 +55,15 @@ struct channel {
 	int sampleChannels;
 	int sampleRate;
 	int totalSampleCount;
-	vector<dsp::Frame<1>> playBuffer;
+	// what the audio thread plays, a load publishes a new one
+	waves::Published<waves::SampleBuffer<1>, 1> sample;
 	bool active=false;
 	int kill=-1;
 
+	enum Readers {
+		AUDIO_READER
+	};
+
 	void randomize() {
 		q=random::uniform();
 		freq=random::uniform();
@@ -131,6 +136,9 @@ struct OAI : BidooModule {
 	MetaModule::AsyncThread loadSampleAsync{this, [this]() {
 		this->loadSampleInternal();
 	}};
+	MetaModule::AsyncThread reclaimAsync{this, [this]() {
+		this->reclaim();
+	}};
 #endif
 
 	OAI() {
@@ -145,10 +153,6 @@ struct OAI : BidooModule {
 		configParam(FREQ_PARAM, 0.0f, 1.0f, 1.0f);
 		configParam(CHANNEL_PARAM, 0.0f, 15.0f, 0.0f);
 		configParam(KILL_PARAM, -1.0f, 15.0f, -1.0f);
-
-		for (int i=0; i<16; i++) {
-			channels[i].playBuffer.resize(0);
-		}
 	}
 
 	void process(const ProcessArgs &args) override;
@@ -156,6 +160,7 @@ struct OAI : BidooModule {
 	void loadSample();
 	void loadSampleInternal();
 	void saveSample();
+	void reclaim();
 
 	void onRandomize() override {
 		params[START_PARAM].setValue(random::uniform());
@@ -296,11 +301,34 @@ struct OAI : BidooModule {
 
 void OAI::loadSampleInternal() {
 	APP->engine->yieldWorkers();
-	channels[currentChannel].playBuffer = waves::getMonoWav(channels[currentChannel].lastPath, APP->engine->getSampleRate(), channels[currentChannel].waveFileName, channels[currentChannel].waveExtension,
-	 channels[currentChannel].sampleChannels, channels[currentChannel].sampleRate, channels[currentChannel].totalSampleCount);
+	mylock.lock();
+	channel &target = channels[currentChannel];
+	std::string path = target.lastPath;
+	mylock.unlock();
+
+	// decode aside, the audio thread keeps playing the previous buffer meanwhile
+	std::string waveFileName, waveExtension;
+	int sampleChannels = 0, sampleRate = 0, totalSampleCount = 0;
+	waves::SampleBuffer<1> *next = new waves::SampleBuffer<1>();
+	waves::getMonoWav(path, APP->engine->getSampleRate(), waveFileName, waveExtension, sampleChannels, sampleRate, totalSampleCount, *next);
+
+	mylock.lock();
+	target.waveFileName = waveFileName;
+	target.waveExtension = waveExtension;
+	target.sampleChannels = sampleChannels;
+	target.sampleRate = sampleRate;
+	target.totalSampleCount = totalSampleCount;
+	target.sample.publish(next);
 	loading = false;
+	mylock.unlock();
+}
 
-	vector<dsp::Frame<1>>(channels[currentChannel].playBuffer).swap(channels[currentChannel].playBuffer);
+void OAI::reclaim() {
+	mylock.lock();
+	for (int i=0; i<16; i++) {
+		channels[i].sample.reclaim();
+	}
+	mylock.unlock();
 }
 
 void OAI::loadSample() {
@@ -313,13 +341,14 @@ void OAI::loadSample() {
 
 void OAI::process(const ProcessArgs &args) {
 #if !defined(METAMODULE)
-	mylock.lock();
 	if (loading) {
 		loadSample();
 	}
-	mylock.unlock();
 #endif
-	if (channels[currentChannel].playBuffer.size()==0) {
+	const waves::SampleBuffer<1> *shown = channels[currentChannel].sample.enter(channel::AUDIO_READER);
+	const bool empty = shown->size()==0;
+	channels[currentChannel].sample.leave(channel::AUDIO_READER);
+	if (empty) {
 		lights[SAMPLE_LIGHT].setBrightness(1.0f);
 		lights[SAMPLE_LIGHT+1].setBrightness(0.0f);
 		lights[SAMPLE_LIGHT+2].setBrightness(0.0f);
@@ -358,7 +387,8 @@ void OAI::process(const ProcessArgs &args) {
 	outputs[POLY_OUTPUT].setChannels(c);
 
 	for (int i=0;i<c;i++) {
-		if (channels[i].playBuffer.size()>0) {
+		const waves::SampleBuffer<1> &playBuffer = *channels[i].sample.enter(channel::AUDIO_READER);
+		if (playBuffer.size()>0) {
 			float start = clamp(channels[i].start + (inputs[START_INPUT].isConnected() ? rescale(inputs[START_INPUT].getVoltage(i),0.0f,10.0f,0.0f,1.0f) : 0.0f), 0.0f, 1.0f);
 			float len = clamp(channels[i].len + (inputs[LEN_INPUT].isConnected() ? rescale(inputs[LEN_INPUT].getVoltage(i),0.0f,10.0f,0.0f,1.0f) : 0.0f), 0.0f, 1.0f);
 			float speed = clamp(channels[i].speed + (inputs[SPEED_INPUT].isConnected() ? rescale(inputs[SPEED_INPUT].getVoltage(i),0.0f,10.0f,0.0f,1.0f) : 0.0f), 0.0f, 10.0f);
@@ -370,7 +400,7 @@ void OAI::process(const ProcessArgs &args) {
 
 			if ((!channels[i].active || (gate==1.0f)) && (triggers[i].process(inputs[TRIG_INPUT].getVoltage(i)))) {
 				channels[i].active = true;
-				channels[i].head = start * channels[i].playBuffer.size();
+				channels[i].head = start * playBuffer.size();
 			}
 			else if ((gate==0.0f) && (inputs[TRIG_INPUT].getVoltage(i) == 0.0f)) {
 				channels[i].active = false;
@@ -387,7 +417,7 @@ void OAI::process(const ProcessArgs &args) {
 			if (channels[i].active) {
 				int xi = channels[i].head;
 				float xf = channels[i].head - xi;
-				float crossfaded = crossfade(channels[i].playBuffer[xi].samples[0], channels[i].playBuffer[xi + 1].samples[0], xf);
+				float crossfaded = crossfade(playBuffer[xi].samples[0], playBuffer[xi + 1].samples[0], xf);
 				channels[i].filter.setParams(freq, q, args.sampleRate);
 				channels[i].filter.calcOutput(crossfaded);
 				if (filterType == 0.0f) {
@@ -404,9 +434,9 @@ void OAI::process(const ProcessArgs &args) {
 				}
 
 				channels[i].head += speed;
-				if ((channels[i].head >= (channels[i].playBuffer.size()-1)) || (channels[i].head > ((start+len)*channels[i].playBuffer.size()))) {
+				if ((channels[i].head >= (playBuffer.size()-1)) || (channels[i].head > ((start+len)*playBuffer.size()))) {
 					if (loop && (gate==0.0f)) {
-						channels[i].head = start*channels[i].playBuffer.size();
+						channels[i].head = start*playBuffer.size();
 					}
 					else {
 						channels[i].active=false;
@@ -417,7 +447,17 @@ void OAI::process(const ProcessArgs &args) {
 				outputs[POLY_OUTPUT].setVoltage(0.0f,i);
 			}
 		}
+		channels[i].sample.leave(channel::AUDIO_READER);
 	}
+
+#if defined(METAMODULE)
+	for (int i=0;i<16;i++) {
+		if (channels[i].sample.retiring()) {
+			reclaimAsync.run_once();
+			break;
+		}
+	}
+#endif
 }
 
 struct OAIWidget : BidooWidget {
@@ -503,6 +543,8 @@ struct OAIWidget : BidooWidget {
 		assert(module);
 		menu->addChild(new MenuSeparator());
 		menu->addChild(construct<OAIItem>(&MenuItem::text, "Load sample", &OAIItem::module, module));
+		appendResampleMenu(menu);
+		appendCompactMenu(menu);
 	}
 };
 
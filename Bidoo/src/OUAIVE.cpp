@@ -48,11 +48,20 @@ struct OUAIVE : BidooModule {
 	};
 
 	bool play = false;
-	int channels;
   int sampleRate;
-  int totalSampleCount=0;
 	float samplePos = 0.0f;
-	vector<dsp::Frame<2>> playBuffer;
+	// what the audio thread and the display read, a load publishes a new one
+	struct Content {
+		waves::SampleBuffer<2> buffer;
+		waves::PeakPyramid<2> peaks;
+		int channels = 0;
+	};
+	enum Readers {
+		AUDIO_READER,
+		DISPLAY_READER,
+		NUM_READERS
+	};
+	waves::Published<Content, NUM_READERS> content;
 	std::string lastPath;
 	std::string waveFileName;
 	std::string waveExtension;
@@ -67,6 +76,7 @@ struct OUAIVE : BidooModule {
 	dsp::SchmittTrigger trigModeTrigger;
 	dsp::SchmittTrigger readModeTrigger;
 	dsp::SchmittTrigger posResetTrigger;
+	// serializes the writers, readers never take it
 	std::atomic<bool> locked{false};
 	bool first = true;
 	int eoc=0;
@@ -77,6 +87,11 @@ struct OUAIVE : BidooModule {
 	MetaModule::AsyncThread loadSampleAsync{this, [this]() {
 		this->loadSampleInternal();
 	}};
+	MetaModule::AsyncThread reclaimAsync{this, [this]() {
+		this->lock();
+		this->content.reclaim();
+		this->unlock();
+	}};
 #endif
 
 	OUAIVE() {
@@ -98,8 +113,6 @@ struct OUAIVE : BidooModule {
 		configOutput(OUTL_OUTPUT, "Out L");
 		configOutput(OUTR_OUTPUT, "Out R");
 		configOutput(EOC_OUTPUT, "EOC");
-
-		playBuffer.resize(0);
 	}
 
 	void process(const ProcessArgs &args) override;
@@ -155,13 +168,16 @@ void OUAIVE::loadSampleInternal() {
 	}
 
 	APP->engine->yieldWorkers();
+	// decoded aside, the audio thread keeps playing the previous sample until the publish
+	Content *next = new Content();
+	int frames = 0;
+	waves::getStereoWav(lastPath, APP->engine->getSampleRate(), 
+		waveFileName, waveExtension, next->channels, sampleRate, frames, next->buffer);
+	next->peaks.build(next->buffer);
 	lock();
-	playBuffer = waves::getStereoWav(lastPath, APP->engine->getSampleRate(), 
-		waveFileName, waveExtension, channels, sampleRate, totalSampleCount);
+	content.publish(next);
 	unlock();
 	loading = false;
-
-	vector<dsp::Frame<2>>(playBuffer).swap(playBuffer);
 }
 
 void OUAIVE::loadSample() {
@@ -176,6 +192,10 @@ void OUAIVE::process(const ProcessArgs &args) {
 	if (loading) {
 		loadSample();
 	}
+	const Content *playing = content.enter(AUDIO_READER);
+	const waves::SampleBuffer<2> &playBuffer = playing->buffer;
+	const int channels = playing->channels;
+	const int totalSampleCount = playBuffer.size();
 	if (trigModeTrigger.process(roundf(params[TRIG_MODE_PARAM].getValue()))) {
 		trigMode = (((int)trigMode + 1) % 3);
 	}
@@ -224,9 +244,6 @@ void OUAIVE::process(const ProcessArgs &args) {
 		float xf = samplePos - xi;
         
 		if (xi < playBuffer.size()) {
-			// Acquire lock only once before processing both channels
-			lock();
-			
 			if (channels == 1) {
 				// Mono processing
 				float nextSample = (xi + 1 < playBuffer.size()) ? 
@@ -236,19 +253,16 @@ void OUAIVE::process(const ProcessArgs &args) {
 				
 				// Set both outputs with the same value
 				float outputVoltage = 5.0f * crossfaded;
-				unlock();
 				outputs[OUTL_OUTPUT].setVoltage(outputVoltage);
 				outputs[OUTR_OUTPUT].setVoltage(outputVoltage);
 			}
 			else if (channels == 2) {
 				// Stereo processing
-				// Get sample data for both channels while holding the lock only once
 				float sample0L = playBuffer[xi].samples[0];
 				float sample0R = playBuffer[xi].samples[1];
 				
 				float sample1L = (xi + 1 < playBuffer.size()) ? playBuffer[xi + 1].samples[0] : sample0L;
 				float sample1R = (xi + 1 < playBuffer.size()) ? playBuffer[xi + 1].samples[1] : sample0R;
-				unlock();
 				
 				if (outputs[OUTL_OUTPUT].isConnected() && outputs[OUTR_OUTPUT].isConnected()) {
 					// Both outputs connected - process as stereo
@@ -317,7 +331,13 @@ void OUAIVE::process(const ProcessArgs &args) {
 	pulse = eocPulse.process(args.sampleTime);
 
 	outputs[EOC_OUTPUT].setVoltage(pulse ? 10 : 0);
+	content.leave(AUDIO_READER);
 
+#if defined(METAMODULE)
+	if (content.retiring()) {
+		reclaimAsync.run_once();
+	}
+#endif
 }
 
 struct OUAIVEDisplay : OpaqueWidget {
@@ -358,23 +378,20 @@ struct OUAIVEDisplay : OpaqueWidget {
 
 	void drawLayer(const DrawArgs& args, int layer) override {
 		if (layer == 1) {
-			if (module && module->playBuffer.size() > 0) {
-				// Copy buffer outside of lock to minimize lock time
+			if (module && module->content.retiring()) {
 				module->lock();
-				size_t bufferSize = std::min(size_t(module->totalSampleCount), module->playBuffer.size());
-				std::vector<float> vL(bufferSize);
-				std::vector<float> vR(bufferSize);
-				
-				// Batch copy the data while holding the lock
-				for (size_t i = 0; i < bufferSize; i++) {
-					vL[i] = module->playBuffer[i].samples[0];
-					if (module->channels > 1) {
-						vR[i] = module->playBuffer[i].samples[1];
-					} else {
-						vR[i] = module->playBuffer[i].samples[0]; // Copy mono to both channels
-					}
-				}
+				module->content.reclaim();
 				module->unlock();
+			}
+			const OUAIVE::Content *content = module ? module->content.enter(OUAIVE::DISPLAY_READER) : NULL;
+			if (content && content->buffer.size() > 0) {
+				// min/max per pixel from the peak pyramid, a few entries each whatever the length
+				const int pixels = width + 1;
+				std::vector<float> vL(pixels), vR(pixels), vLMin(pixels), vRMin(pixels);
+				size_t bufferSize = content->buffer.size();
+				content->peaks.draw(content->buffer, 0, -zoomLeftAnchor * bufferSize / zoomWidth, bufferSize / zoomWidth, pixels, vLMin.data(), vL.data());
+				content->peaks.draw(content->buffer, content->channels > 1 ? 1 : 0, -zoomLeftAnchor * bufferSize / zoomWidth, bufferSize / zoomWidth, pixels, vRMin.data(), vR.data());
+				module->content.leave(OUAIVE::DISPLAY_READER);
 				
 				nvgFontSize(args.vg, 14);
 				nvgFillColor(args.vg, YELLOW_BIDOO);
@@ -418,7 +435,7 @@ struct OUAIVEDisplay : OpaqueWidget {
 					{
 						nvgBeginPath(args.vg);
 						nvgStrokeWidth(args.vg, 2);
-						if (module->totalSampleCount>0) {
+						if (bufferSize>0) {
 							nvgMoveTo(args.vg, module->samplePos * zoomWidth / bufferSize + zoomLeftAnchor, 0);
 							nvgLineTo(args.vg, module->samplePos * zoomWidth / bufferSize + zoomLeftAnchor, 2 * height+10);
 						}
@@ -456,43 +473,30 @@ struct OUAIVEDisplay : OpaqueWidget {
 					//Draw waveform
 					nvgStrokeColor(args.vg, PINK_BIDOO);
 					nvgSave(args.vg);
-					Rect b = Rect(Vec(zoomLeftAnchor, 0), Vec(zoomWidth, height));
-					size_t inc = std::max(bufferSize/zoomWidth/4,1.f);
-					nvgScissor(args.vg, 0, b.pos.y, width, height);
+					nvgScissor(args.vg, 0, 0, width, height);
 					nvgBeginPath(args.vg);
-					for (size_t i = 0; i < bufferSize; i+=inc) {
-						float x, y;
-						x = (float)i/bufferSize;
-						y = (-1.f)*vL[i] / 2.0f + 0.5f;
-						Vec p;
-						p.x = b.pos.x + b.size.x * x;
-						p.y = b.pos.y + b.size.y * (1.0f - y);
-						if (i == 0) {
-							nvgMoveTo(args.vg, p.x, p.y);
+					for (int x = 0; x < pixels; x++) {
+						if (x == 0) {
+							nvgMoveTo(args.vg, x, height * (0.5f + 0.5f * vL[x]));
 						}
 						else {
-							nvgLineTo(args.vg, p.x, p.y);
+							nvgLineTo(args.vg, x, height * (0.5f + 0.5f * vL[x]));
 						}
+						nvgLineTo(args.vg, x, height * (0.5f + 0.5f * vLMin[x]));
 					}
 					nvgLineCap(args.vg, NVG_MITER);
 					nvgStrokeWidth(args.vg, 1);
 					nvgGlobalCompositeOperation(args.vg, NVG_LIGHTER);
 					nvgStroke(args.vg);
 
-					b = Rect(Vec(zoomLeftAnchor, height+10), Vec(zoomWidth, height));
-					nvgScissor(args.vg, 0, b.pos.y, width, height);
+					nvgScissor(args.vg, 0, height+10, width, height);
 					nvgBeginPath(args.vg);
-					for (size_t i = 0; i < bufferSize; i+=inc) {
-						float x, y;
-						x = (float)i/bufferSize;
-						y = (-1.f)*vR[i] / 2.0f + 0.5f;
-						Vec p;
-						p.x = b.pos.x + b.size.x * x;
-						p.y = b.pos.y + b.size.y * (1.0f - y);
-						if (i == 0)
-							nvgMoveTo(args.vg, p.x, p.y);
+					for (int x = 0; x < pixels; x++) {
+						if (x == 0)
+							nvgMoveTo(args.vg, x, height + 10 + height * (0.5f + 0.5f * vR[x]));
 						else
-							nvgLineTo(args.vg, p.x, p.y);
+							nvgLineTo(args.vg, x, height + 10 + height * (0.5f + 0.5f * vR[x]));
+						nvgLineTo(args.vg, x, height + 10 + height * (0.5f + 0.5f * vRMin[x]));
 					}
 					nvgLineCap(args.vg, NVG_MITER);
 					nvgStrokeWidth(args.vg, 1);
@@ -521,6 +525,9 @@ struct OUAIVEDisplay : OpaqueWidget {
 					nvgRestore(args.vg);
 				}
 			}
+			else if (content) {
+				module->content.leave(OUAIVE::DISPLAY_READER);
+			}
 		}
 		Widget::drawLayer(args, layer);
 	}
@@ -604,6 +611,8 @@ struct OUAIVEWidget : BidooWidget {
 
 		menu->addChild(new MenuSeparator());
 		menu->addChild(construct<OUAIVEItem>(&MenuItem::text, "Load sample", &OUAIVEItem::module, module));
+		appendResampleMenu(menu);
+		appendCompactMenu(menu);
 	}
 
 	void onPathDrop(const PathDropEvent& e) override {
@@ -60,7 +60,8 @@ struct POUPRE : BidooModule {
 	int sampleChannels;
 	int sampleRate;
 	int totalSampleCount;
-	vector<dsp::Frame<1>> playBuffer;
+	// what the audio thread plays, a load publishes a new one
+	waves::Published<waves::SampleBuffer<1>, 1> sample;
 	bool play = false;
 	std::string lastPath;
 	std::string waveFileName;
@@ -68,10 +69,19 @@ struct POUPRE : BidooModule {
 	dsp::SchmittTrigger presetTriggers[4];
 	std::atomic<bool> locked{false};
 
+	enum Readers {
+		AUDIO_READER
+	};
+
 #if defined(METAMODULE)
 	MetaModule::AsyncThread loadSampleAsync{this, [this]() {
 		this->loadSampleInternal();
 	}};
+	MetaModule::AsyncThread reclaimAsync{this, [this]() {
+		this->lock();
+		this->sample.reclaim();
+		this->unlock();
+	}};
 #endif
 
 	POUPRE() {
@@ -86,8 +96,6 @@ struct POUPRE : BidooModule {
 		configParam(PRESET_PARAM+1, 0.0f, 1.0f, 0.0f);
 		configParam(PRESET_PARAM+2, 0.0f, 1.0f, 0.0f);
 		configParam(PRESET_PARAM+3, 0.0f, 1.0f, 0.0f);
-
-		playBuffer.resize(0);
 	}
 
 	void process(const ProcessArgs &args) override;
@@ -183,11 +191,24 @@ void POUPRE::loadSampleInternal() {
 	}
 	
 	lock();
-	playBuffer = waves::getMonoWav(lastPath, APP->engine->getSampleRate(), waveFileName, waveExtension, sampleChannels, sampleRate, totalSampleCount);
+	std::string path = lastPath;
 	unlock();
-	loading = false;
 
-	vector<dsp::Frame<1>>(playBuffer).swap(playBuffer);
+	// decode aside, the audio thread keeps playing the previous buffer meanwhile
+	std::string fileName, extension;
+	int channelCount = 0, rate = 0, frames = 0;
+	waves::SampleBuffer<1> *next = new waves::SampleBuffer<1>();
+	waves::getMonoWav(path, APP->engine->getSampleRate(), fileName, extension, channelCount, rate, frames, *next);
+
+	lock();
+	waveFileName = fileName;
+	waveExtension = extension;
+	sampleChannels = channelCount;
+	sampleRate = rate;
+	totalSampleCount = frames;
+	sample.publish(next);
+	unlock();
+	loading = false;
 }
 
 void POUPRE::loadSample() {
@@ -202,6 +223,7 @@ void POUPRE::process(const ProcessArgs &args) {
 	if (loading) {
 		loadSample();
 	}
+	const waves::SampleBuffer<1> &playBuffer = *sample.enter(AUDIO_READER);
 	if (playBuffer.size()==0) {
 		lights[SAMPLE_LIGHT].setBrightness(1.0f);
 		lights[SAMPLE_LIGHT+1].setBrightness(0.0f);
@@ -320,6 +342,13 @@ void POUPRE::process(const ProcessArgs &args) {
 			outputs[POLY_OUTPUT].setVoltage(0.0f,i);
 		}
 	}
+	sample.leave(AUDIO_READER);
+
+#if defined(METAMODULE)
+	if (sample.retiring()) {
+		reclaimAsync.run_once();
+	}
+#endif
 }
 
 struct POUPREWidget : BidooWidget {
@@ -398,6 +427,8 @@ struct POUPREWidget : BidooWidget {
 		assert(module);
 		menu->addChild(new MenuSeparator());
 		menu->addChild(construct<POUPREItem>(&MenuItem::text, "Load sample", &POUPREItem::module, module));
+		appendResampleMenu(menu);
+		appendCompactMenu(menu);
 	}
 };
 
@@ -6,302 +6,53 @@
 #include <random>
 #include <algorithm>
 #include <iomanip>
+#include <atomic>
+#include <mutex>
 // #include <sstream>
 #include "dep/quantizer.hpp"
+#include "dep/slidecurve.hpp"
+#include "dep/waves.hpp"
+#include "dep/zoumaimessage.hpp"
+#include "dep/zoumaipattern.hpp"
+#include "dep/zoumaitracks.hpp"
 
-using namespace std;
-
-
-
-struct TrigAttibutes {
-
-	unsigned long mainAttributes;
-	unsigned long probAttributes;
-
-	static const unsigned long TRIG_ACTIVE					= 0x1;
-	static const unsigned long TRIG_INITIALIZED			= 0x2;
-	static const unsigned long TRIG_SLEEPING				= 0x4;
-	static const unsigned long TRIG_TYPE						= 0x18; static const unsigned long trigTypeShift = 3;
-	static const unsigned long TRIG_INDEX						= 0xFE0; static const unsigned long trigIndexShift = 5;
-	static const unsigned long TRIG_PULSECOUNT			= 0x7F000; static const unsigned long trigPulseCountShift = 12;
-	static const unsigned long TRIG_OCTAVE					= 0x780000; static const unsigned long trigOctaveShift = 19;
-	static const unsigned long TRIG_SEMITONES				= 0x7800000; static const unsigned long trigSemitonesShift = 23;
-
-	static const unsigned long TRIG_PROBA						= 0xFF;
-	static const unsigned long TRIG_COUNT						= 0xFF00; static const unsigned long trigCountShift = 8;
-	static const unsigned long TRIG_COUNTRESET			= 0xFF0000; static const unsigned long trigCountResetShift = 16;
-	static const unsigned long TRIG_INCOUNT					= 0xFF000000; static const unsigned long trigInCountShift = 24;
-
-
-	static const unsigned long intiMainAttributes = 1576960;
-	static const unsigned long intiProbAttributes = 91136;
-
-	inline void init() {
-		mainAttributes = intiMainAttributes;
-		probAttributes = intiProbAttributes;
-	}
-
-	inline void randomize() {
-		setTrigActive(random::uniform()>0.5f);
-		setTrigOctave(random::uniform()*2.0f + 2.0f);
-		setTrigSemiTones(random::uniform()*11.0f);
-	}
-
-	inline void randomizeProbs() {
-		setTrigProba(random::uniform()*7.0f);
-		setTrigCount(random::uniform()*100.0f);
-		setTrigCountReset(random::uniform()*100.0f);
-	}
-
-	inline void fullRandomize() {
-		randomize();
-		setTrigPulseCount(random::uniform()*10.0f);
-	}
-
-	inline bool getTrigActive() {return (mainAttributes & TRIG_ACTIVE) != 0;}
-	inline bool getTrigInitialized() {return (mainAttributes & TRIG_INITIALIZED) != 0;}
-	inline bool getTrigSleeping() {return (mainAttributes & TRIG_SLEEPING) != 0;}
-	inline int getTrigType() {return (mainAttributes & TRIG_TYPE) >> trigTypeShift;}
-	inline int getTrigIndex() {return (mainAttributes & TRIG_INDEX) >> trigIndexShift;}
-	inline int getTrigPulseCount() {return (mainAttributes & TRIG_PULSECOUNT) >> trigPulseCountShift;}
-	inline int getTrigOctave() {return (mainAttributes & TRIG_OCTAVE) >> trigOctaveShift;}
-	inline int getTrigSemiTones() {return (mainAttributes & TRIG_SEMITONES) >> trigSemitonesShift;}
-
-	inline int getTrigProba() {return (probAttributes & TRIG_PROBA);}
-	inline int getTrigCount() {return (probAttributes & TRIG_COUNT) >> trigCountShift;}
-	inline int getTrigCountReset() {return (probAttributes & TRIG_COUNTRESET) >> trigCountResetShift;}
-	inline int getTrigInCount() {return (probAttributes & TRIG_INCOUNT) >> trigInCountShift;}
-
-	inline unsigned long getMainAttributes() {return mainAttributes;}
-	inline unsigned long getProbAttributes() {return probAttributes;}
-
-	inline void setTrigActive(const bool trigActive) {mainAttributes &= ~TRIG_ACTIVE; if (trigActive) mainAttributes |= TRIG_ACTIVE;}
-	inline void setTrigInitialized(const bool trigInitialize) {mainAttributes &= ~TRIG_INITIALIZED; if (trigInitialize) mainAttributes |= TRIG_INITIALIZED;}
-	inline void setTrigSleeping(const bool trigSleep) {mainAttributes &= ~TRIG_SLEEPING; if (trigSleep) mainAttributes |= TRIG_SLEEPING;}
-	inline void setTrigType(const int trigType) {mainAttributes &= ~TRIG_TYPE; mainAttributes |= (trigType << trigTypeShift);}
-	inline void setTrigIndex(const int trigIndex) {mainAttributes &= ~TRIG_INDEX; mainAttributes |= (trigIndex << trigIndexShift);}
-	inline void setTrigPulseCount(const int trigPulseCount) {mainAttributes &= ~TRIG_PULSECOUNT; mainAttributes |= (trigPulseCount << trigPulseCountShift);}
-	inline void setTrigOctave(const int trigOctave) {mainAttributes &= ~TRIG_OCTAVE; mainAttributes |= (trigOctave << trigOctaveShift);}
-	inline void setTrigSemiTones(const int trigSemiTones) {mainAttributes &= ~TRIG_SEMITONES; mainAttributes |= (trigSemiTones << trigSemitonesShift);}
+#if defined(METAMODULE)
+#include "CoreModules/async_thread.hh"
+#endif
 
-	inline void setTrigProba(const int trigProba) {probAttributes &= ~TRIG_PROBA; probAttributes |= trigProba;}
-	inline void setTrigCount(const int trigCount) {probAttributes &= ~TRIG_COUNT; probAttributes |= (trigCount << trigCountShift);}
-	inline void setTrigCountReset(const int trigCountReset) {probAttributes &= ~TRIG_COUNTRESET; probAttributes |= (trigCountReset << trigCountResetShift);}
-	inline void setTrigInCount(const int trigInCount) {probAttributes &= ~TRIG_INCOUNT; probAttributes |= (trigInCount << trigInCountShift);}
-
-	inline void toggleTrigActive() {mainAttributes ^= TRIG_ACTIVE;}
-
-	inline void setMainAttributes(const unsigned long _mainAttributes) {mainAttributes = _mainAttributes;}
-	inline void setProbAttributes(const unsigned long _probAttributes) {probAttributes = _probAttributes;}
+using namespace std;
 
-	inline void up() {
-		if (getTrigSemiTones()==11) {
-			setTrigOctave(getTrigOctave()+1);
-			setTrigSemiTones(0);
-		}
-		else {
-			setTrigSemiTones(getTrigSemiTones()+1);
-		}
-	}
+// ENCORE has its own TrigAttibutes and TrackAttibutes, these come from their own namespace
+using zoumaipattern::TrigAttibutes;
+using zoumaipattern::TrackAttibutes;
 
-	inline void down() {
-		if (getTrigSemiTones()==0) {
-			setTrigOctave(getTrigOctave()-1);
-			setTrigSemiTones(11);
-		}
-		else {
-			setTrigSemiTones(getTrigSemiTones()-1);
-		}
-	}
+// A pattern as handed between the UI and the audio thread. Published blocks are never written
+// again : the UI edits a copy which records what the edit changed, the audio thread then only
+// takes those records from it (see ZOUMAI::beginEdit and ZOUMAI::patternAdopt).
+struct PatternBlock : zoumaipattern::Pattern {
+	static const int playbackKeep = -1;
+	static const int playbackReset = 64;
 
-	inline bool hasProbability() {
-		return (getTrigProba() != 4) && (getTrigProba() != 5) && !((getTrigProba() == 0) && (getTrigCount() == 100));
-	}
+	uint64_t trigsEdited[8] = {0};
+	int tracksEdited = 0;
+	// play position the edit gives a track : kept, reset or the one of the track it was pasted
+	// from (pattern*8 + track)
+	int playbackFrom[8] = {playbackKeep, playbackKeep, playbackKeep, playbackKeep, playbackKeep, playbackKeep, playbackKeep, playbackKeep};
 
-	inline float getVO() {
-		return (float)getTrigOctave() - 3.0f + (float)getTrigSemiTones()/12.0f;
+	inline void resetPlayback(const int track) {
+		playbackFrom[track] = playbackReset;
 	}
 
-	inline void init(const bool fill, const bool pre, const bool nei, const bool force, const bool kill, const float dice) {
-		if (!getTrigInitialized()) {
-
-			setTrigInitialized(true);
-
-			switch (getTrigProba()) {
-				case 0:  // DICE
-					if (force) {
-						setTrigSleeping(false);
-						break;
-					}
-					if (getTrigCount()<100) {
-						if (kill) {
-							setTrigSleeping(true);
-							break;
-						}
-						setTrigSleeping((random::uniform()*100)>=(clamp(getTrigCount()+dice*100,0.0f,100.0f)));
-					}
-					else
-						setTrigSleeping(false);
-					break;
-				case 1:  // COUNT
-					if (force) {
-						setTrigSleeping(false);
-						break;
-					}
-					if (kill) {
-						setTrigSleeping(true);
-						break;
-					}
-					setTrigSleeping(getTrigInCount() > getTrigCount());
-					setTrigInCount((getTrigInCount() >= getTrigCountReset()) ? 1 : (getTrigInCount() + 1));
-					break;
-				case 2:  // FILL
-					if (force) {
-						setTrigSleeping(false);
-						break;
-					}
-					if (kill) {
-						setTrigSleeping(true);
-						break;
-					}
-					setTrigSleeping(!fill);
-					break;
-				case 3:  // !FILL
-					if (force) {
-						setTrigSleeping(false);
-						break;
-					}
-					if (kill) {
-						setTrigSleeping(true);
-						break;
-					}
-					setTrigSleeping(fill);
-					break;
-				case 4:  // PRE
-					if (force) {
-						setTrigSleeping(false);
-						break;
-					}
-					if (kill) {
-						setTrigSleeping(true);
-						break;
-					}
-					setTrigSleeping(!pre);
-					break;
-				case 5:  // !PRE
-					if (force) {
-						setTrigSleeping(false);
-						break;
-					}
-					if (kill) {
-						setTrigSleeping(true);
-						break;
-					}
-					setTrigSleeping(pre);
-					break;
-				case 6:  // NEI
-					if (force) {
-						setTrigSleeping(false);
-						break;
-					}
-					if (kill) {
-						setTrigSleeping(true);
-						break;
-					}
-					setTrigSleeping(!nei);
-					break;
-				case 7:  // !NEI
-					if (force) {
-						setTrigSleeping(false);
-						break;
-					}
-					if (kill) {
-						setTrigSleeping(true);
-						break;
-					}
-					setTrigSleeping(nei);
-					break;
-				default:
-					setTrigSleeping(false);
-					break;
-			}
+	void clearEdits() {
+		for (int i=0; i<8; i++) {
+			trigsEdited[i] = 0;
+			playbackFrom[i] = playbackKeep;
 		}
+		tracksEdited = 0;
 	}
 };
 
-struct TrackAttibutes {
-
-	unsigned long mainAttributes;
-	unsigned long refAttributes;
-
-	static const unsigned long TRACK_ACTIVE					= 0x1;
-	static const unsigned long TRACK_FORWARD				= 0x2;
-	static const unsigned long TRACK_PRE						= 0x4;
-	static const unsigned long TRACK_SOLO						= 0x8;
-	static const unsigned long TRACK_LENGTH					= 0x7F0; static const unsigned long trackLengthShift = 4;
-	static const unsigned long TRACK_READMODE				= 0x3800; static const unsigned long trackReadModeShift = 11;
-	static const unsigned long TRACK_SPEED					= 0x1C000; static const unsigned long trackSpeedShift = 14;
-
-	static const unsigned long TRACK_CURRENTTRIG		= 0xFF;
-	static const unsigned long TRACK_PLAYEDTRIG			= 0xFF00; static const unsigned long trackPlayedTrigShift = 8;
-	static const unsigned long TRACK_PREVTRIG				= 0xFF0000; static const unsigned long trackPrevTrigShift = 16;
-	static const unsigned long TRACK_NEXTTRIG				= 0xFF000000; static const unsigned long trackNextTrigShift = 24;
-
-	static const unsigned long intiMainAttributes = 16643;
-	static const unsigned long intiRefAttributes = 0;
-
-	inline void init() {
-		mainAttributes = intiMainAttributes;
-		refAttributes = intiRefAttributes;
-	}
-
-	inline void randomize() {
-		setTrackLength(1+random::uniform()*63);
-		setTrackReadMode(random::uniform()*4);
-	}
-
-	inline void fullRandomize() {
-		randomize();
-		setTrackSpeed(1+random::uniform()*3);
-	}
-
-	inline bool getTrackActive() {return (mainAttributes & TRACK_ACTIVE) != 0;}
-	inline bool getTrackForward() {return (mainAttributes & TRACK_FORWARD) != 0;}
-	inline bool getTrackPre() {return (mainAttributes & TRACK_PRE) != 0;}
-	inline bool getTrackSolo() {return (mainAttributes & TRACK_SOLO) != 0;}
-	inline int getTrackLength() {return (mainAttributes & TRACK_LENGTH) >> trackLengthShift;}
-	inline int getTrackReadMode() {return (mainAttributes & TRACK_READMODE) >> trackReadModeShift;}
-	inline int getTrackSpeed() {return (mainAttributes & TRACK_SPEED) >> trackSpeedShift;}
-
-	inline int getTrackCurrentTrig() {return (refAttributes & TRACK_CURRENTTRIG);}
-	inline int getTrackPlayedTrig() {return (refAttributes & TRACK_PLAYEDTRIG) >> trackPlayedTrigShift;}
-	inline int getTrackPrevTrig() {return (refAttributes & TRACK_PREVTRIG) >> trackPrevTrigShift;}
-	inline int getTrackNextTrig() {return (refAttributes & TRACK_NEXTTRIG) >> trackNextTrigShift;}
-
-	inline unsigned long getMainAttributes() {return mainAttributes;}
-	inline unsigned long getRefAttributes() {return refAttributes;}
-
-	inline void setTrackActive(const bool trackActive) {mainAttributes &= ~TRACK_ACTIVE; if (trackActive) mainAttributes |= TRACK_ACTIVE;}
-	inline void setTrackForward(const bool trackForward) {mainAttributes &= ~TRACK_FORWARD; if (trackForward) mainAttributes |= TRACK_FORWARD;}
-	inline void setTrackPre(const bool trackPre) {mainAttributes &= ~TRACK_PRE; if (trackPre) mainAttributes |= TRACK_PRE;}
-	inline void setTrackSolo(const bool trackSolo) {mainAttributes &= ~TRACK_SOLO; if (trackSolo) mainAttributes |= TRACK_SOLO;}
-	inline void setTrackLength(const int trackLength) {mainAttributes &= ~TRACK_LENGTH; mainAttributes |= (trackLength << trackLengthShift);}
-	inline void setTrackReadMode(const int trackReadMode) {mainAttributes &= ~TRACK_READMODE; mainAttributes |= (trackReadMode << trackReadModeShift);}
-	inline void setTrackSpeed(const int trackSpeed) {mainAttributes &= ~TRACK_SPEED; mainAttributes |= (trackSpeed << trackSpeedShift);}
-
-	inline void setTrackCurrentTrig(const int trackCurrentTrig) {refAttributes &= ~TRACK_CURRENTTRIG; refAttributes |= trackCurrentTrig;}
-	inline void setTrackPlayedTrig(const int trackPlayedTrig) {refAttributes &= ~TRACK_PLAYEDTRIG; refAttributes |= (trackPlayedTrig << trackPlayedTrigShift);}
-	inline void setTrackPrevTrig(const int trackPrevTrig) {refAttributes &= ~TRACK_PREVTRIG; refAttributes |= (trackPrevTrig << trackPrevTrigShift);}
-	inline void setTrackNextTrig(const int trackNextTrig) {refAttributes &= ~TRACK_NEXTTRIG; refAttributes |= (trackNextTrig << trackNextTrigShift);}
-
-	inline void toggleTrackActive() {mainAttributes ^= TRACK_ACTIVE;}
-	inline void toggleTrackSolo() {mainAttributes ^= TRACK_SOLO;}
-
-	inline void setMainAttributes(const unsigned long _mainAttributes) {mainAttributes = _mainAttributes;}
-	inline void setRefAttributes(const unsigned long _refAttributes) {refAttributes = _refAttributes;}
-};
-
-struct ZOUMAI : BidooModule {
+struct ZOUMAI : BidooModule, zoumaitracks::Tracks {
 	enum ParamIds {
 		STEPS_PARAMS,
 		TRACKSONOFF_PARAMS = STEPS_PARAMS + 16,
@@ -376,10 +127,13 @@ struct ZOUMAI : BidooModule {
 	dsp::SchmittTrigger trackActiveTriggers[8];
 	dsp::SchmittTrigger fillTrigger;
 
-	float rightMessages[2][64] = {{0.0f}};
+	float rightMessages[2][zoumaimessage::size] = {{0.0f}};
+	int expanderSeq = -1;
+	int expanderPatternSent = -1;
+	bool expanderResync = false;
+	bool expanderResyncSent = false;
+	bool expanderEvents = false;
 
-	int currentPattern = 0;
-	int previousPattern = -1;
 	int currentTrack = 0;
 	int currentTrig = 0;
 	int trigPage = 0;
@@ -403,24 +157,55 @@ struct ZOUMAI : BidooModule {
 	int prevTrig[8] = {0};
 	float prevVO[8] = {0.0f};
 
+	float paramsSnapshot[NUM_PARAMS - TRACKLENGTH_PARAM] = {0.0f};
+	int paramsPattern = -1;
+	int paramsTrack = -1;
+	int paramsTrig = -1;
+	// build with -DZOUMAI_STATS to log how often attributes are written
+#ifdef ZOUMAI_STATS
+	unsigned long attributeWrites = 0;
+	unsigned long attributeWritesSamples = 0;
+#endif
+
 	quantizer::Quantizer quant;
 
-	TrigAttibutes nTrigsAttibutes[8][8][64];
-	TrackAttibutes nTracksAttibutes[8][8];
-	float trigSlide[8][8][64] = {{{0.0f}}};
-  bool trigSlideType[8][8][64] = {{{0}}};
-	float trigTrim[8][8][64] = {{{0.0f}}};
-	float trigLength[8][8][64] = {{{0.0f}}};
-	float trigPulseDistance[8][8][64] = {{{0.5f}}};
-	float trigCV1[8][8][64] = {{{0.0f}}};
-	float trigCV2[8][8][64] = {{{0.0f}}};
-	float trackHead[8][8] = {{0.0f}};
-	float trackCurrentTickCount[8][8] = {{0.0f}};
-	float trackLastTickCount[8][8] = {{22500.0f}};
-	int rootNote[8][8] = {{-1}};
-	int scale[8][8] = {{0}};
-	int quantizeCV1[8][8] = {{0}};
-	bool slideMode[8][8] = {{0}};
+	// published[p] is pattern p as the UI copies, shows and saves it, it is never written once
+	// published. The audio thread plays its own copy of the current pattern (work) and keeps the
+	// play state of every pattern apart from it, it is the only one to publish : the edits the UI
+	// hands over through pendingEdits and, every 20ms at most, work when it wrote to it. Blocks it
+	// replaces go back to the UI through retiredBlocks and spareBlocks are kept filled by the UI
+	// (see patternsRecycle), so that the audio thread neither waits nor allocates.
+	std::atomic<PatternBlock*> published[8];
+	std::atomic<PatternBlock*> pendingEdits[8];
+	std::atomic<bool> editsPending{false};
+	int editsPendingSamples = 0;
+	waves::SpscQueue<PatternBlock*, 4> spareBlocks;
+	static const size_t spareCount = 2;
+	static const size_t retiredCapacity = 16;
+	waves::SpscQueue<PatternBlock*, retiredCapacity> retiredBlocks;
+
+	// UI side, blocksMutex is held while a published block is read
+	std::mutex blocksMutex;
+	std::vector<PatternBlock*> freeBlocks;
+	PatternBlock *editBlock = nullptr;
+	PatternBlock *editBase = nullptr;
+	bool editBaseTaken = false;
+	int editPattern = 0;
+	// track or trig selected from the UI, the knobs are refreshed by the audio thread
+	std::atomic<bool> paramsRefresh{false};
+
+	// audio side
+	bool workDirty = false;
+	int workPublishSamples = 0;
+	// play state of the patterns not in work
+	TrackAttibutes trackPlayback[8][8] = {};
+	uint16_t trigPlayback[8][8][64] = {{{0}}};
+
+#if defined(METAMODULE)
+	MetaModule::AsyncThread recycleAsync{this, [this]() {
+		this->patternsRecycle();
+	}};
+#endif
 
 	bool fills[8] = {0};
 	bool forceTrigs[8] = {0};
@@ -433,7 +218,7 @@ struct ZOUMAI : BidooModule {
 
 	bool solo = false;
 
-	float powTable[100][10000] = {{0.0f}};
+	slidecurve::SlideCurve slideCurve;
 
   std::string labels[8] = {"Track 1","Track 2","Track 3","Track 4","Track 5","Track 6","Track 7","Track 8"};
 
@@ -487,22 +272,31 @@ struct ZOUMAI : BidooModule {
   	for (int i=0;i<8;i++) {
       configParam(TRACKSONOFF_PARAMS + i, 0.0f, 2.0f, 1.0f);
 			configParam(TRACKSELECT_PARAMS + i, 0.0f, 1.0f, i == currentTrack ? 1.0f : 0.0f);
-			for (int j=0;j<8;j++) {
-				for (int k=0;k<64;k++) {
-					nTrigsAttibutes[i][j][k].setTrigIndex(k);
-				}
-			}
+			published[i] = new PatternBlock();
+			pendingEdits[i] = nullptr;
   	}
 
-		for(int i=0; i<100;i++) {
-      for(int j=0; j<10000;j++) {
-				powTable[i][j] = powf(j*0.0001f,i*0.01f);
-			}
-		}
-
+		patternsRecycle();
 		onReset();
 	}
 
+	~ZOUMAI() {
+		PatternBlock *block;
+		for (int i=0; i<8; i++) {
+			delete published[i].load();
+			delete pendingEdits[i].load();
+		}
+		while (spareBlocks.pop(block)) {
+			delete block;
+		}
+		while (retiredBlocks.pop(block)) {
+			delete block;
+		}
+		for (PatternBlock *b : freeBlocks) {
+			delete b;
+		}
+	}
+
   unsigned int calc_GCD(unsigned int a, unsigned int b)
   {
     unsigned int shift, tmp;
@@ -546,36 +340,55 @@ struct ZOUMAI : BidooModule {
     array_cycle_left(_ptr, n, es, n - shift);
   }
 
-	void updateTrackToParams() {
-		params[TRACKLENGTH_PARAM].setValue(nTracksAttibutes[currentPattern][currentTrack].getTrackLength());
-		params[TRACKSPEED_PARAM].setValue(nTracksAttibutes[currentPattern][currentTrack].getTrackSpeed());
-		params[TRACKREADMODE_PARAM].setValue(nTracksAttibutes[currentPattern][currentTrack].getTrackReadMode());
-		params[TRACKROOTNOTE_PARAM].setValue(rootNote[currentPattern][currentTrack]);
-		params[TRACKSCALE_PARAM].setValue(scale[currentPattern][currentTrack]);
-		params[TRACKQUANTIZECV1_PARAM].setValue(quantizeCV1[currentPattern][currentTrack]);
-		params[TRACKSCALE_PARAM].setValue(scale[currentPattern][currentTrack]);
-		params[TRACKROOTNOTE_PARAM].setValue(rootNote[currentPattern][currentTrack]);
-		params[TRACKQUANTIZECV1_PARAM].setValue(quantizeCV1[currentPattern][currentTrack]);
-	}
-
-	void updateTrigToParams() {
-		params[TRIGLENGTH_PARAM].setValue(trigLength[currentPattern][currentTrack][currentTrig]);
-		params[TRIGSLIDE_PARAM].setValue(trigSlide[currentPattern][currentTrack][currentTrig]);
-		params[TRIGTYPE_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigType());
-		params[TRIGTRIM_PARAM].setValue(trigTrim[currentPattern][currentTrack][currentTrig]);
-		params[TRIGPULSECOUNT_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigPulseCount());
-		params[TRIGPULSEDISTANCE_PARAM].setValue(trigPulseDistance[currentPattern][currentTrack][currentTrig]);
-		params[TRIGCV1_PARAM].setValue(trigCV1[currentPattern][currentTrack][currentTrig]);
-		params[TRIGCV2_PARAM].setValue(trigCV2[currentPattern][currentTrack][currentTrig]);
-		params[TRIGPROBA_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigProba());
-		params[TRIGPROBACOUNT_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigCount());
-		params[TRIGPROBACOUNTRESET_PARAM].setValue(nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigCountReset());
-    params[TRIGSLIDETYPE_PARAM].setValue(trigSlideType[currentPattern][currentTrack][currentTrig]);
+	// The knobs follow the selected track/trig. A new selection reloads every knob, otherwise only the
+	// values that changed underneath the knobs (edits, loads, recording) are pushed, a knob being
+	// turned keeps its value.
+
+	void updateParams() {
+		const bool trackSelected = (paramsPattern != currentPattern) || (paramsTrack != currentTrack);
+		const bool trigSelected = trackSelected || (paramsTrig != currentTrig);
+		paramsPattern = currentPattern;
+		paramsTrack = currentTrack;
+		paramsTrig = currentTrig;
+		updateTrackToParams(trackSelected);
+		updateTrigToParams(trigSelected);
+	}
+
+	void valueToParam(const int paramId, const float value, const bool reload) {
+		if (reload || (value != paramsSnapshot[paramId-TRACKLENGTH_PARAM])) {
+			params[paramId].setValue(value);
+			paramsSnapshot[paramId-TRACKLENGTH_PARAM] = value;
+		}
+	}
+
+	void updateTrackToParams(const bool reload) {
+		valueToParam(TRACKLENGTH_PARAM, work.tracks[currentTrack].getTrackLength(), reload);
+		valueToParam(TRACKSPEED_PARAM, work.tracks[currentTrack].getTrackSpeed(), reload);
+		valueToParam(TRACKREADMODE_PARAM, work.tracks[currentTrack].getTrackReadMode(), reload);
+		valueToParam(TRACKROOTNOTE_PARAM, work.rootNote[currentTrack], reload);
+		valueToParam(TRACKSCALE_PARAM, work.scale[currentTrack], reload);
+		valueToParam(TRACKQUANTIZECV1_PARAM, work.quantizeCV1[currentTrack], reload);
+	}
+
+	void updateTrigToParams(const bool reload) {
+		TrigAttibutes &trig = work.trigs[currentTrack][currentTrig];
+		valueToParam(TRIGLENGTH_PARAM, trig.length, reload);
+		valueToParam(TRIGSLIDE_PARAM, trig.slide, reload);
+		valueToParam(TRIGTYPE_PARAM, trig.getTrigType(), reload);
+		valueToParam(TRIGTRIM_PARAM, trig.trim, reload);
+		valueToParam(TRIGPULSECOUNT_PARAM, trig.getTrigPulseCount(), reload);
+		valueToParam(TRIGPULSEDISTANCE_PARAM, trig.pulseDistance, reload);
+		valueToParam(TRIGCV1_PARAM, trig.cv1, reload);
+		valueToParam(TRIGCV2_PARAM, trig.cv2, reload);
+		valueToParam(TRIGPROBA_PARAM, trig.getTrigProba(), reload);
+		valueToParam(TRIGPROBACOUNT_PARAM, trig.getTrigCount(), reload);
+		valueToParam(TRIGPROBACOUNTRESET_PARAM, trig.getTrigCountReset(), reload);
+		valueToParam(TRIGSLIDETYPE_PARAM, trig.getTrigSlideType(), reload);
 	}
 
 	void updateTrigVO() {
 		for (int i=0;i<7;i++) {
-			if (nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigOctave()==i) {
+			if (work.trigs[currentTrack][currentTrig].getTrigOctave()==i) {
 				params[OCTAVE_PARAMS+i].setValue(1.0f);
 			}
 			else {
@@ -584,8 +397,8 @@ struct ZOUMAI : BidooModule {
 		}
 
 		for (int i=0;i<12;i++) {
-			bool focused = nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigSemiTones() == i;
-			bool tA = nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigActive();
+			bool focused = work.trigs[currentTrack][currentTrig].getTrigSemiTones() == i;
+			bool tA = work.trigs[currentTrack][currentTrig].getTrigActive();
 			if ((i!=1)&&(i!=3)&&(i!=6)&&(i!=8)&&(i!=10)) {
 				lights[NOTE_LIGHTS+3*i].setBrightness(focused ? 0.0f : 1.0f);
 				lights[NOTE_LIGHTS+3*i+1].setBrightness(focused ? (tA ? 1.0f : 0.5f) : 1.0f);
@@ -597,28 +410,95 @@ struct ZOUMAI : BidooModule {
 		}
 	}
 
+	// The track and trig knobs are compared with the values they had when last written (or pushed
+	// from the selected track/trig), attributes are only rewritten for the knobs that actually moved.
+
+	bool paramChanged(const int paramId) {
+		const float value = params[paramId].getValue();
+		if (value == paramsSnapshot[paramId-TRACKLENGTH_PARAM]) {
+			return false;
+		}
+		paramsSnapshot[paramId-TRACKLENGTH_PARAM] = value;
+		workDirty = true;
+#ifdef ZOUMAI_STATS
+		attributeWrites++;
+#endif
+		return true;
+	}
+
 	void updateParamsToTrack() {
-		nTracksAttibutes[currentPattern][currentTrack].setTrackLength(params[TRACKLENGTH_PARAM].getValue());
-		nTracksAttibutes[currentPattern][currentTrack].setTrackSpeed(params[TRACKSPEED_PARAM].getValue());
-		nTracksAttibutes[currentPattern][currentTrack].setTrackReadMode(params[TRACKREADMODE_PARAM].getValue());
-		rootNote[currentPattern][currentTrack]=params[TRACKROOTNOTE_PARAM].getValue();
-		scale[currentPattern][currentTrack]=params[TRACKSCALE_PARAM].getValue();
-		quantizeCV1[currentPattern][currentTrack]=params[TRACKQUANTIZECV1_PARAM].getValue();
+		bool changed = false;
+		if (paramChanged(TRACKLENGTH_PARAM)) {
+			work.tracks[currentTrack].setTrackLength(params[TRACKLENGTH_PARAM].getValue());
+			changed = true;
+		}
+		if (paramChanged(TRACKSPEED_PARAM)) {
+			work.tracks[currentTrack].setTrackSpeed(params[TRACKSPEED_PARAM].getValue());
+			changed = true;
+		}
+		if (paramChanged(TRACKREADMODE_PARAM)) {
+			work.tracks[currentTrack].setTrackReadMode(params[TRACKREADMODE_PARAM].getValue());
+			changed = true;
+		}
+		if (paramChanged(TRACKROOTNOTE_PARAM)) {
+			work.rootNote[currentTrack]=params[TRACKROOTNOTE_PARAM].getValue();
+		}
+		if (paramChanged(TRACKSCALE_PARAM)) {
+			work.scale[currentTrack]=params[TRACKSCALE_PARAM].getValue();
+		}
+		if (paramChanged(TRACKQUANTIZECV1_PARAM)) {
+			work.quantizeCV1[currentTrack]=params[TRACKQUANTIZECV1_PARAM].getValue();
+		}
+		if (changed) {
+			trackInvalidate(currentTrack);
+		}
 	}
 
 	void updateParamsToTrig() {
-		trigLength[currentPattern][currentTrack][currentTrig] = params[TRIGLENGTH_PARAM].getValue();
-    trigSlideType[currentPattern][currentTrack][currentTrig] = params[TRIGSLIDETYPE_PARAM].getValue();
-		trigSlide[currentPattern][currentTrack][currentTrig] =  params[TRIGSLIDE_PARAM].getValue();
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigType(params[TRIGTYPE_PARAM].getValue());
-		trigTrim[currentPattern][currentTrack][currentTrig] =  params[TRIGTRIM_PARAM].getValue();
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigPulseCount(params[TRIGPULSECOUNT_PARAM].getValue());
-		trigPulseDistance[currentPattern][currentTrack][currentTrig] = params[TRIGPULSEDISTANCE_PARAM].getValue();
-		trigCV1[currentPattern][currentTrack][currentTrig] = params[TRIGCV1_PARAM].getValue();
-		trigCV2[currentPattern][currentTrack][currentTrig] = params[TRIGCV2_PARAM].getValue();
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigProba(params[TRIGPROBA_PARAM].getValue());
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigCount(params[TRIGPROBACOUNT_PARAM].getValue());
-		nTrigsAttibutes[currentPattern][currentTrack][currentTrig].setTrigCountReset(params[TRIGPROBACOUNTRESET_PARAM].getValue());
+		bool changed = false;
+		if (paramChanged(TRIGLENGTH_PARAM)) {
+			work.trigs[currentTrack][currentTrig].length = params[TRIGLENGTH_PARAM].getValue();
+			changed = true;
+		}
+		if (paramChanged(TRIGSLIDETYPE_PARAM)) {
+			work.trigs[currentTrack][currentTrig].setTrigSlideType(params[TRIGSLIDETYPE_PARAM].getValue());
+		}
+		if (paramChanged(TRIGSLIDE_PARAM)) {
+			work.trigs[currentTrack][currentTrig].slide =  params[TRIGSLIDE_PARAM].getValue();
+		}
+		if (paramChanged(TRIGTYPE_PARAM)) {
+			work.trigs[currentTrack][currentTrig].setTrigType(params[TRIGTYPE_PARAM].getValue());
+		}
+		if (paramChanged(TRIGTRIM_PARAM)) {
+			work.trigs[currentTrack][currentTrig].trim =  params[TRIGTRIM_PARAM].getValue();
+			changed = true;
+		}
+		if (paramChanged(TRIGPULSECOUNT_PARAM)) {
+			work.trigs[currentTrack][currentTrig].setTrigPulseCount(params[TRIGPULSECOUNT_PARAM].getValue());
+			changed = true;
+		}
+		if (paramChanged(TRIGPULSEDISTANCE_PARAM)) {
+			work.trigs[currentTrack][currentTrig].pulseDistance = params[TRIGPULSEDISTANCE_PARAM].getValue();
+			changed = true;
+		}
+		if (paramChanged(TRIGCV1_PARAM)) {
+			work.trigs[currentTrack][currentTrig].cv1 = params[TRIGCV1_PARAM].getValue();
+		}
+		if (paramChanged(TRIGCV2_PARAM)) {
+			work.trigs[currentTrack][currentTrig].cv2 = params[TRIGCV2_PARAM].getValue();
+		}
+		if (paramChanged(TRIGPROBA_PARAM)) {
+			work.trigs[currentTrack][currentTrig].setTrigProba(params[TRIGPROBA_PARAM].getValue());
+		}
+		if (paramChanged(TRIGPROBACOUNT_PARAM)) {
+			work.trigs[currentTrack][currentTrig].setTrigCount(params[TRIGPROBACOUNT_PARAM].getValue());
+		}
+		if (paramChanged(TRIGPROBACOUNTRESET_PARAM)) {
+			work.trigs[currentTrack][currentTrig].setTrigCountReset(params[TRIGPROBACOUNTRESET_PARAM].getValue());
+		}
+		if (changed) {
+			trackInvalidate(currentTrack);
+		}
 	}
 
 
@@ -631,48 +511,18 @@ struct ZOUMAI : BidooModule {
     for(size_t i=0; i<8; i++) {
       json_object_set_new(rootJ, ("label" + to_string(i)).c_str(), json_string(labels[i].c_str()));
     }
-		for (size_t i = 0; i<8; i++) {
-			json_t *patternJ = json_object();
-			for (size_t j = 0; j < 8; j++) {
-				json_t *trackJ = json_object();
-				json_object_set_new(trackJ, "isActive", json_boolean(nTracksAttibutes[i][j].getTrackActive()));
-				json_object_set_new(trackJ, "isSolo", json_boolean(nTracksAttibutes[i][j].getTrackSolo()));
-				json_object_set_new(trackJ, "speed", json_real(nTracksAttibutes[i][j].getTrackSpeed()));
-				json_object_set_new(trackJ, "readMode", json_integer(nTracksAttibutes[i][j].getTrackReadMode()));
-				json_object_set_new(trackJ, "length", json_integer(nTracksAttibutes[i][j].getTrackLength()));
-				json_object_set_new(trackJ, "rootNote", json_integer(rootNote[i][j]));
-				json_object_set_new(trackJ, "scale", json_integer(scale[i][j]));
-				json_object_set_new(trackJ, "quantizeCV1", json_integer(quantizeCV1[i][j]));
-				json_object_set_new(trackJ, "slideMode", json_boolean(slideMode[i][j]));
-				for (int k = 0; k < nTracksAttibutes[i][j].getTrackLength(); k++) {
-					json_t *trigJ = json_object();
-					json_object_set_new(trigJ, "isActive", json_boolean(nTrigsAttibutes[i][j][k].getTrigActive()));
-					json_object_set_new(trigJ, "slide", json_real(trigSlide[i][j][k]));
-					json_object_set_new(trigJ, "trigType", json_integer(nTrigsAttibutes[i][j][k].getTrigType()));
-					json_object_set_new(trigJ, "index", json_integer(nTrigsAttibutes[i][j][k].getTrigIndex()));
-					json_object_set_new(trigJ, "trim", json_real(trigTrim[i][j][k]));
-					json_object_set_new(trigJ, "length", json_real(trigLength[i][j][k]));
-					json_object_set_new(trigJ, "pulseCount", json_integer(nTrigsAttibutes[i][j][k].getTrigPulseCount()));
-					json_object_set_new(trigJ, "pulseDistance", json_real(trigPulseDistance[i][j][k]));
-					json_object_set_new(trigJ, "proba", json_integer(nTrigsAttibutes[i][j][k].getTrigProba()));
-					json_object_set_new(trigJ, "count", json_integer(nTrigsAttibutes[i][j][k].getTrigCount()));
-					json_object_set_new(trigJ, "countReset", json_integer(nTrigsAttibutes[i][j][k].getTrigCountReset()));
-					json_object_set_new(trigJ, "octave", json_integer(nTrigsAttibutes[i][j][k].getTrigOctave()-3));
-					json_object_set_new(trigJ, "semitones", json_integer(nTrigsAttibutes[i][j][k].getTrigSemiTones()));
-					json_object_set_new(trigJ, "CV1", json_real(trigCV1[i][j][k]));
-					json_object_set_new(trigJ, "CV2", json_real(trigCV2[i][j][k]));
-          json_object_set_new(trigJ, "trigSlideType", json_boolean(trigSlideType[i][j][k]));
-					json_object_set_new(trackJ, ("trig" + to_string(k)).c_str() , trigJ);
-				}
-				json_object_set_new(patternJ, ("track" + to_string(j)).c_str() , trackJ);
-			}
-			json_object_set_new(rootJ, ("pattern" + to_string(i)).c_str(), patternJ);
-		}
+		blocksMutex.lock();
+		zoumaipattern::Pattern *blocks[8];
+		for (int i = 0; i<8; i++) blocks[i] = published[i].load();
+		const std::vector<uint8_t> patterns = zoumaipattern::patternsToChunk(blocks);
+		blocksMutex.unlock();
+		json_object_set_new(rootJ, "patterns", json_string(string::toBase64(patterns).c_str()));
 		return rootJ;
 	}
 
 	void dataFromJson(json_t *rootJ) override {
     BidooModule::dataFromJson(rootJ);
+		lockedBegin();
 		json_t *currentPatternJ = json_object_get(rootJ, "currentPattern");
 		if (currentPatternJ)
 			currentPattern = json_integer_value(currentPatternJ);
@@ -696,7 +546,19 @@ struct ZOUMAI : BidooModule {
       }
     }
 
+		zoumaipattern::Pattern *blocks[8];
+		for (int i = 0; i<8; i++) blocks[i] = published[i].load();
+		json_t *patternsJ = json_object_get(rootJ, "patterns");
+		if (!(json_is_string(patternsJ) && zoumaipattern::patternsFromChunk(string::fromBase64(json_string_value(patternsJ)), blocks))) {
+			patternsFromLegacyJson(rootJ);
+		}
+		lockedEnd();
+	}
+
+	// patches saved before the binary chunk : one json object per trig
+	void patternsFromLegacyJson(json_t *rootJ) {
 		for (size_t i=0; i<8;i++) {
+			zoumaipattern::Pattern &pattern = *published[i].load();
 			json_t *patternJ = json_object_get(rootJ, ("pattern" + to_string(i)).c_str());
 			if (patternJ){
 				for(size_t j=0; j<8;j++) {
@@ -704,477 +566,637 @@ struct ZOUMAI : BidooModule {
 					if (trackJ) {
 						json_t *isActiveJ = json_object_get(trackJ, "isActive");
 						if (isActiveJ)
-							nTracksAttibutes[i][j].setTrackActive(json_boolean_value(isActiveJ));
+							pattern.tracks[j].setTrackActive(json_boolean_value(isActiveJ));
 						json_t *isSoloJ = json_object_get(trackJ, "isSolo");
 						if (isSoloJ)
-							nTracksAttibutes[i][j].setTrackSolo(json_boolean_value(isSoloJ));
+							pattern.tracks[j].setTrackSolo(json_boolean_value(isSoloJ));
 						json_t *lengthJ = json_object_get(trackJ, "length");
 						if (lengthJ)
-							nTracksAttibutes[i][j].setTrackLength(json_integer_value(lengthJ));
+							pattern.tracks[j].setTrackLength(json_integer_value(lengthJ));
 						json_t *speedJ = json_object_get(trackJ, "speed");
 						if (speedJ)
-							nTracksAttibutes[i][j].setTrackSpeed(json_number_value(speedJ));
+							pattern.tracks[j].setTrackSpeed(json_number_value(speedJ));
 						json_t *readModeJ = json_object_get(trackJ, "readMode");
 						if (readModeJ)
-							nTracksAttibutes[i][j].setTrackReadMode(json_integer_value(readModeJ));
+							pattern.tracks[j].setTrackReadMode(json_integer_value(readModeJ));
 						json_t *rootNoteJ = json_object_get(trackJ, "rootNote");
 						if (rootNoteJ)
-							rootNote[i][j]=json_integer_value(rootNoteJ);
+							pattern.rootNote[j]=json_integer_value(rootNoteJ);
 						json_t *scaleJ = json_object_get(trackJ, "scale");
 						if (scaleJ)
-							scale[i][j]=json_integer_value(scaleJ);
+							pattern.scale[j]=json_integer_value(scaleJ);
 						json_t *quantizeCV1J = json_object_get(trackJ, "quantizeCV1");
 						if (quantizeCV1J)
-							quantizeCV1[i][j]=json_integer_value(quantizeCV1J);
+							pattern.quantizeCV1[j]=json_integer_value(quantizeCV1J);
 						json_t *slideModeJ = json_object_get(trackJ, "slideMode");
 						if (slideModeJ)
-							slideMode[i][j]=json_boolean_value(slideModeJ);
+							pattern.slideMode[j]=json_boolean_value(slideModeJ);
 					}
-					for(int k=0;k<nTracksAttibutes[i][j].getTrackLength();k++) {
+					for(int k=0;k<pattern.tracks[j].getTrackLength();k++) {
 						json_t *trigJ = json_object_get(trackJ, ("trig" + to_string(k)).c_str());
 						if (trigJ) {
 							json_t *isActiveJ = json_object_get(trigJ, "isActive");
 							if (isActiveJ)
-								nTrigsAttibutes[i][j][k].setTrigActive(json_boolean_value(isActiveJ));
+								pattern.trigs[j][k].setTrigActive(json_boolean_value(isActiveJ));
 							json_t *slideJ = json_object_get(trigJ, "slide");
 							if (slideJ)
-								trigSlide[i][j][k] = json_number_value(slideJ);
+								pattern.trigs[j][k].slide = json_number_value(slideJ);
 							json_t *trigTypeJ = json_object_get(trigJ, "trigType");
 							if (trigTypeJ)
-								nTrigsAttibutes[i][j][k].setTrigType(json_integer_value(trigTypeJ));
+								pattern.trigs[j][k].setTrigType(json_integer_value(trigTypeJ));
 							json_t *indexJ = json_object_get(trigJ, "index");
 							if (indexJ)
-								nTrigsAttibutes[i][j][k].setTrigIndex(json_integer_value(indexJ));
+								pattern.trigs[j][k].setTrigIndex(json_integer_value(indexJ));
 							json_t *trimJ = json_object_get(trigJ, "trim");
 							if (trimJ)
-								trigTrim[i][j][k] = json_number_value(trimJ);
+								pattern.trigs[j][k].trim = json_number_value(trimJ);
 							json_t *lengthJ = json_object_get(trigJ, "length");
 							if (lengthJ)
-								trigLength[i][j][k] = json_number_value(lengthJ);
+								pattern.trigs[j][k].length = json_number_value(lengthJ);
 							json_t *pulseCountJ = json_object_get(trigJ, "pulseCount");
 							if (pulseCountJ)
-								nTrigsAttibutes[i][j][k].setTrigPulseCount(json_integer_value(pulseCountJ));
+								pattern.trigs[j][k].setTrigPulseCount(json_integer_value(pulseCountJ));
 							json_t *pulseDistanceJ = json_object_get(trigJ, "pulseDistance");
 							if (pulseDistanceJ)
-								trigPulseDistance[i][j][k] =  json_number_value(pulseDistanceJ);
+								pattern.trigs[j][k].pulseDistance =  json_number_value(pulseDistanceJ);
 							json_t *probaJ = json_object_get(trigJ, "proba");
 							if (probaJ)
-								nTrigsAttibutes[i][j][k].setTrigProba(json_integer_value(probaJ));
+								pattern.trigs[j][k].setTrigProba(json_integer_value(probaJ));
 							json_t *countJ = json_object_get(trigJ, "count");
 							if (countJ)
-								nTrigsAttibutes[i][j][k].setTrigCount(json_integer_value(countJ));
+								pattern.trigs[j][k].setTrigCount(json_integer_value(countJ));
 							json_t *countResetJ = json_object_get(trigJ, "countReset");
 							if (countResetJ)
-								nTrigsAttibutes[i][j][k].setTrigCountReset(json_integer_value(countResetJ));
+								pattern.trigs[j][k].setTrigCountReset(json_integer_value(countResetJ));
 							json_t *octaveJ = json_object_get(trigJ, "octave");
 							if (octaveJ)
-								nTrigsAttibutes[i][j][k].setTrigOctave(json_integer_value(octaveJ)+3);
+								pattern.trigs[j][k].setTrigOctave(json_integer_value(octaveJ)+3);
 							json_t *semitonesJ = json_object_get(trigJ, "semitones");
 							if (semitonesJ)
-								nTrigsAttibutes[i][j][k].setTrigSemiTones(json_integer_value(semitonesJ));
+								pattern.trigs[j][k].setTrigSemiTones(json_integer_value(semitonesJ));
 							json_t *CV1J = json_object_get(trigJ, "CV1");
 							if (CV1J)
-								trigCV1[i][j][k] = json_number_value(CV1J);
+								pattern.trigs[j][k].cv1 = json_number_value(CV1J);
 							json_t *CV2J = json_object_get(trigJ, "CV2");
 							if (CV2J)
-								trigCV2[i][j][k] = json_number_value(CV2J);
+								pattern.trigs[j][k].cv2 = json_number_value(CV2J);
               json_t *trigSlideTypeJ = json_object_get(trigJ, "trigSlideType");
 							if (trigSlideTypeJ)
-								trigSlideType[i][j][k]=json_boolean_value(trigSlideTypeJ);
+								pattern.trigs[j][k].setTrigSlideType(json_boolean_value(trigSlideTypeJ));
 						}
 					}
 				}
 			}
 		}
-		updateTrackToParams();
-		updateTrigToParams();
 	}
 
-	void randomizeTrigNote(const int track, const int trig) {
-		nTrigsAttibutes[currentPattern][track][trig].fullRandomize();
+	// UI edits are made on a copy of the current pattern and handed over as a whole by endEdit, an
+	// edit not taken yet is taken back and edited further. The audio thread takes it on the next
+	// clock (at once when stopped, within 50ms when no clock is connected) : only the records the
+	// edit changed replace the ones it plays, the play position of the tracks is kept unless the
+	// edit reset it. Neither side ever waits for the other.
+
+	PatternBlock &beginEdit() {
+		blocksMutex.lock();
+		editPattern = currentPattern;
+		editBase = pendingEdits[editPattern].exchange(nullptr);
+		editBaseTaken = editBase != nullptr;
+		if (!editBaseTaken) {
+			editBase = published[editPattern].load();
+		}
+		editBlock = blockTake();
+		*editBlock = *editBase;
+		return *editBlock;
+	}
+
+	void endEdit() {
+		PatternBlock &e = *editBlock;
+		for (int i=0; i<8; i++) {
+			if ((e.tracks[i].mainAttributes != editBase->tracks[i].mainAttributes) || (e.rootNote[i] != editBase->rootNote[i]) || (e.scale[i] != editBase->scale[i])
+				|| (e.quantizeCV1[i] != editBase->quantizeCV1[i]) || (e.slideMode[i] != editBase->slideMode[i])) {
+				e.tracksEdited |= 1 << i;
+			}
+			for (int j=0; j<64; j++) {
+				if (memcmp(&e.trigs[i][j], &editBase->trigs[i][j], sizeof(TrigAttibutes)) != 0) {
+					e.trigsEdited[i] |= 1ull << j;
+				}
+			}
+		}
+		if (editBaseTaken) {
+			freeBlocks.push_back(editBase);
+		}
+		pendingEdits[editPattern].store(editBlock);
+		editsPending = true;
+		blocksMutex.unlock();
+	}
+
+	// pattern a paste reads from, during an edit
+	const zoumaipattern::Pattern &editSource(const int pattern) {
+		return pattern == editPattern ? *editBlock : *published[pattern].load();
+	}
+
+	bool trackSlideMode() {
+		std::lock_guard<std::mutex> guard(blocksMutex);
+		return published[currentPattern].load()->slideMode[currentTrack];
+	}
+
+	// blocksMutex held
+	PatternBlock *blockTake() {
+		if (freeBlocks.empty()) {
+			return new PatternBlock();
+		}
+		PatternBlock *block = freeBlocks.back();
+		freeBlocks.pop_back();
+		return block;
 	}
 
-	void randomizeTrigNotePlus(const int track, const int trig) {
-		nTrigsAttibutes[currentPattern][track][trig].fullRandomize();
-		trigSlide[currentPattern][track][trig]=random::uniform();
-    trigSlideType[currentPattern][track][trig]=random::uniform()>0.5f?true:false;
-		trigLength[currentPattern][track][trig]=random::uniform()*2.0f;
-		trigPulseDistance[currentPattern][track][trig]=random::uniform()*2.0f;
+	// UI side : takes back the blocks the audio thread replaced and keeps spare ones ready for it
+	void patternsRecycle() {
+		std::lock_guard<std::mutex> guard(blocksMutex);
+		PatternBlock *block;
+		while (retiredBlocks.pop(block)) {
+			freeBlocks.push_back(block);
+		}
+		while (spareBlocks.size() < spareCount) {
+			spareBlocks.push(blockTake());
+		}
 	}
 
-	void randomizeTrigProb(const int track, const int trig) {
-		nTrigsAttibutes[currentPattern][track][trig].randomizeProbs();
+	// engine locked (reset, randomize, load) : the published patterns are written in place and
+	// the edits not taken yet are dropped
+	void lockedBegin() {
+		blocksMutex.lock();
+		for (int i=0; i<8; i++) {
+			PatternBlock *block = pendingEdits[i].exchange(nullptr);
+			if (block) {
+				freeBlocks.push_back(block);
+			}
+		}
+		editsPending = false;
+		PatternBlock &block = *published[currentPattern].load();
+		static_cast<zoumaipattern::Pattern&>(block) = work;
+		block.clearPlayback();
+		playbackSave(currentPattern);
 	}
 
-	void randomizeTrigCV1(const int track, const int trig) {
-		trigCV1[currentPattern][track][trig]=random::uniform()*10.0f;
+	PatternBlock &lockedPattern(const int pattern) {
+		return *published[pattern].load();
 	}
 
-	void randomizeTrigCV2(const int track, const int trig) {
-		trigCV2[currentPattern][track][trig]=random::uniform()*10.0f;
+	void lockedEnd() {
+		for (int i=0; i<8; i++) {
+			PatternBlock &block = *published[i].load();
+			for (int j=0; j<8; j++) {
+				playbackApply(i, j, block.playbackFrom[j]);
+			}
+			block.clearPlayback();
+			block.clearEdits();
+		}
+		workLoad(currentPattern);
+		workDirty = false;
+		blocksMutex.unlock();
+		tracksInvalidate();
+		updateParams();
 	}
 
-	void fullRandomizeTrig(const int track, const int trig) {
-		randomizeTrigNotePlus(track, trig);
-		randomizeTrigProb(track, trig);
-		randomizeTrigCV1(track, trig);
-		randomizeTrigCV2(track, trig);
+	// The functions below run on the audio thread.
+
+	void playbackSave(const int pattern) {
+		for (int i=0; i<8; i++) {
+			trackPlayback[pattern][i].copyPlayback(work.tracks[i]);
+			for (int j=0; j<64; j++) {
+				trigPlayback[pattern][i][j] = work.trigs[i][j].getPlayback();
+			}
+		}
 	}
 
-	void randomizeTrack(const int track) {
-		nTracksAttibutes[currentPattern][track].randomize();
+	void workLoad(const int pattern) {
+		work = *published[pattern].load();
+		for (int i=0; i<8; i++) {
+			work.tracks[i].copyPlayback(trackPlayback[pattern][i]);
+			for (int j=0; j<64; j++) {
+				work.trigs[i][j].setPlayback(trigPlayback[pattern][i][j]);
+			}
+		}
 	}
 
-	void randomizeTrackTrigsNotes(const int track) {
+	// play position an edit gave to a track, into the saved play state of its pattern
+	void playbackApply(const int pattern, const int track, const int from) {
+		if (from == PatternBlock::playbackKeep) {
+			return;
+		}
+		if (from == PatternBlock::playbackReset) {
+			TrackAttibutes reset;
+			reset.init();
+			trackPlayback[pattern][track].copyPlayback(reset);
+			trackHead[pattern][track] = 0.0f;
+			trackCurrentTickCount[pattern][track] = 0.0f;
+			trackLastTickCount[pattern][track] = 22500.0f;
+			for (int i=0; i<64; i++) {
+				trigPlayback[pattern][track][i] = 0;
+			}
+			return;
+		}
+		const int fromPattern = from / 8;
+		const int fromTrack = from % 8;
+		trackPlayback[pattern][track].copyPlayback(trackPlayback[fromPattern][fromTrack]);
+		trackHead[pattern][track] = trackHead[fromPattern][fromTrack];
+		trackCurrentTickCount[pattern][track] = trackCurrentTickCount[fromPattern][fromTrack];
+		trackLastTickCount[pattern][track] = trackLastTickCount[fromPattern][fromTrack];
 		for (int i=0; i<64; i++) {
-			randomizeTrigNote(track,i);
+			trigPlayback[pattern][track][i] = trigPlayback[fromPattern][fromTrack][i];
 		}
 	}
 
-	void randomizeTrackTrigsNotesPlus(const int track) {
+	// retiredBlocks has room
+	void patternPublish(const int pattern, PatternBlock *block) {
+		retiredBlocks.push(published[pattern].exchange(block));
+	}
+
+	void patternsAdopt() {
+		editsPending = false;
+		editsPendingSamples = 0;
+		playbackSave(currentPattern);
+		bool workAdopted = false;
+		for (int i=0; i<8; i++) {
+			if (retiredBlocks.size() >= retiredCapacity) {
+				editsPending = true;
+				break;
+			}
+			PatternBlock *block = pendingEdits[i].exchange(nullptr);
+			if (block) {
+				patternAdopt(i, *block);
+				workAdopted = workAdopted || (i == currentPattern);
+			}
+		}
+		if (workAdopted) {
+			workLoad(currentPattern);
+			workDirty = false;
+			tracksInvalidate();
+			updateParams();
+		}
+	}
+
+	// records the edit did not change keep what the audio thread wrote since the copy
+	void patternAdopt(const int pattern, PatternBlock &e) {
+		const zoumaipattern::Pattern &from = pattern == currentPattern ? work : *published[pattern].load();
+		for (int i=0; i<8; i++) {
+			if (!(e.tracksEdited & (1 << i))) {
+				e.tracks[i] = from.tracks[i];
+				e.rootNote[i] = from.rootNote[i];
+				e.scale[i] = from.scale[i];
+				e.quantizeCV1[i] = from.quantizeCV1[i];
+				e.slideMode[i] = from.slideMode[i];
+			}
+			for (int j=0; j<64; j++) {
+				if (!(e.trigsEdited[i] & (1ull << j))) {
+					e.trigs[i][j] = from.trigs[i][j];
+				}
+			}
+			playbackApply(pattern, i, e.playbackFrom[i]);
+		}
+		e.clearPlayback();
+		e.clearEdits();
+		patternPublish(pattern, &e);
+	}
+
+	// false until the UI provides a spare block
+	bool workPublish() {
+		PatternBlock *block;
+		if ((retiredBlocks.size() >= retiredCapacity) || !spareBlocks.pop(block)) {
+			return false;
+		}
+		static_cast<zoumaipattern::Pattern&>(*block) = work;
+		block->clearPlayback();
+		block->clearEdits();
+		patternPublish(currentPattern, block);
+		workDirty = false;
+		workPublishSamples = 0;
+		return true;
+	}
+
+	// true when the current pattern changed, a switch waits for a spare block while work has
+	// writes to publish
+	bool patternSwitch(const int pattern) {
+		if ((pattern == currentPattern) || (workDirty && !workPublish())) {
+			return false;
+		}
+		playbackSave(currentPattern);
+		workLoad(pattern);
+		currentPattern = pattern;
+		return true;
+	}
+
+	// rotation from the expander, n > 0 to the left, n < 0 to the right
+	void workRotate(const int track, const int n, const int len) {
+		trigsCycle(work.trigs[track], len == 0 ? work.tracks[track].getTrackLength() : len, n);
+		trackInvalidate(track);
+		workDirty = true;
+	}
+
+	void randomizeTrigNote(PatternBlock &b, const int track, const int trig) {
+		b.trigs[track][trig].fullRandomize();
+	}
+
+	void randomizeTrigNotePlus(PatternBlock &b, const int track, const int trig) {
+		b.trigs[track][trig].fullRandomize();
+		b.trigs[track][trig].slide=random::uniform();
+    b.trigs[track][trig].setTrigSlideType(random::uniform()>0.5f);
+		b.trigs[track][trig].length=random::uniform()*2.0f;
+		b.trigs[track][trig].pulseDistance=random::uniform()*2.0f;
+	}
+
+	void randomizeTrigProb(PatternBlock &b, const int track, const int trig) {
+		b.trigs[track][trig].randomizeProbs();
+	}
+
+	void randomizeTrigCV1(PatternBlock &b, const int track, const int trig) {
+		b.trigs[track][trig].cv1=random::uniform()*10.0f;
+	}
+
+	void randomizeTrigCV2(PatternBlock &b, const int track, const int trig) {
+		b.trigs[track][trig].cv2=random::uniform()*10.0f;
+	}
+
+	void fullRandomizeTrig(PatternBlock &b, const int track, const int trig) {
+		randomizeTrigNotePlus(b, track, trig);
+		randomizeTrigProb(b, track, trig);
+		randomizeTrigCV1(b, track, trig);
+		randomizeTrigCV2(b, track, trig);
+	}
+
+	void randomizeTrack(PatternBlock &b, const int track) {
+		b.tracks[track].randomize();
+	}
+
+	void randomizeTrackTrigsNotes(PatternBlock &b, const int track) {
+		for (int i=0; i<64; i++) {
+			randomizeTrigNote(b, track,i);
+		}
+	}
+
+	void randomizeTrackTrigsNotesPlus(PatternBlock &b, const int track) {
 		for (int i=0; i<64; i++) {
-			randomizeTrigNotePlus(track,i);
+			randomizeTrigNotePlus(b, track,i);
 		}
 	}
 
-	void randomizeTrackTrigsProbs(const int track) {
+	void randomizeTrackTrigsProbs(PatternBlock &b, const int track) {
 		for (int i=0; i<64; i++) {
-			randomizeTrigProb(track,i);
+			randomizeTrigProb(b, track,i);
 		}
 	}
 
-	void randomizeTrackTrigsCV1(const int track) {
+	void randomizeTrackTrigsCV1(PatternBlock &b, const int track) {
 		for (int i=0; i<64; i++) {
-			randomizeTrigCV1(track,i);
+			randomizeTrigCV1(b, track,i);
 		}
 	}
 
-	void randomizeTrackTrigsCV2(const int track) {
+	void randomizeTrackTrigsCV2(PatternBlock &b, const int track) {
 		for (int i=0; i<64; i++) {
-			randomizeTrigCV2(track,i);
+			randomizeTrigCV2(b, track,i);
 		}
 	}
 
-	void fullRandomizeTrack(const int track) {
-		randomizeTrack(track);
+	void fullRandomizeTrack(PatternBlock &b, const int track) {
+		randomizeTrack(b, track);
 		for (int i=0; i<64; i++) {
-			fullRandomizeTrig(track,i);
+			fullRandomizeTrig(b, track,i);
 		}
 	}
 
-	void randomizePageTrigsNotes(const int page) {
+	void randomizePageTrigsNotes(PatternBlock &b, const int page) {
 		const int start = page * 16;
 		for (int i=start; i<start+16; i++) {
-			randomizeTrigNote(currentTrack,i);
+			randomizeTrigNote(b, currentTrack,i);
 		}
 	}
 
-	void randomizePageTrigsNotesPlus(const int page) {
+	void randomizePageTrigsNotesPlus(PatternBlock &b, const int page) {
 		const int start = page * 16;
 		for (int i=start; i<start+16; i++) {
-			randomizeTrigNotePlus(currentTrack,i);
+			randomizeTrigNotePlus(b, currentTrack,i);
 		}
 	}
 
-	void randomizePageTrigsProbs(const int page) {
+	void randomizePageTrigsProbs(PatternBlock &b, const int page) {
 		const int start = page * 16;
 		for (int i=start; i<start+16; i++) {
-			randomizeTrigProb(currentTrack,i);
+			randomizeTrigProb(b, currentTrack,i);
 		}
 	}
 
-	void randomizePageTrigsCV1(const int page) {
+	void randomizePageTrigsCV1(PatternBlock &b, const int page) {
 		const int start = page * 16;
 		for (int i=start; i<start+16; i++) {
-			randomizeTrigCV1(currentTrack,i);
+			randomizeTrigCV1(b, currentTrack,i);
 		}
 	}
 
-	void randomizePageTrigsCV2(const int page) {
+	void randomizePageTrigsCV2(PatternBlock &b, const int page) {
 		const int start = page * 16;
 		for (int i=start; i<start+16; i++) {
-			randomizeTrigCV2(currentTrack,i);
+			randomizeTrigCV2(b, currentTrack,i);
 		}
 	}
 
-	void fullRandomizePage(const int page) {
+	void fullRandomizePage(PatternBlock &b, const int page) {
 		const int start = page * 16;
 		for (int i=start; i<start+16; i++) {
-			fullRandomizeTrig(currentTrack,i);
+			fullRandomizeTrig(b, currentTrack,i);
 		}
 	}
 
-	void randomizePattern() {
+	void randomizePattern(PatternBlock &b) {
 		for (int i=0; i<8; i++) {
-			randomizeTrack(i);
+			randomizeTrack(b, i);
 		}
 	}
 
-	void randomizePatternNotes() {
+	void randomizePatternNotes(PatternBlock &b) {
 		for (int i=0; i<8; i++) {
-			randomizeTrackTrigsNotes(i);
+			randomizeTrackTrigsNotes(b, i);
 		}
 	}
 
-	void randomizePatternNotesPlus() {
+	void randomizePatternNotesPlus(PatternBlock &b) {
 		for (int i=0; i<8; i++) {
-			randomizeTrackTrigsNotesPlus(i);
+			randomizeTrackTrigsNotesPlus(b, i);
 		}
 	}
 
-	void randomizePatternNotesProbs() {
+	void randomizePatternNotesProbs(PatternBlock &b) {
 		for (int i=0; i<8; i++) {
-			randomizeTrackTrigsProbs(i);
+			randomizeTrackTrigsProbs(b, i);
 		}
 	}
 
-	void fullRandomizePattern() {
+	void fullRandomizePattern(PatternBlock &b) {
 		for (int i=0; i<8; i++) {
-			fullRandomizeTrack(i);
+			fullRandomizeTrack(b, i);
 		}
 	}
 
-	void nTrackLeft(const int track, const size_t n, const int len = 0) {
-		size_t tLen = len == 0 ? nTracksAttibutes[currentPattern][track].getTrackLength() : len;
-		array_cycle_left(trigSlide[currentPattern][track], tLen , sizeof(float), n);
-		array_cycle_left(trigTrim[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_left(trigLength[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_left(trigPulseDistance[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_left(trigCV1[currentPattern][track], (size_t) tLen, sizeof(float), n);
-		array_cycle_left(trigCV2[currentPattern][track], (size_t) tLen, sizeof(float), n);
-    array_cycle_left(trigSlideType[currentPattern][track], (size_t) tLen, sizeof(bool), n);
-
-		for (size_t j=0; j<n; j++) {
-			TrigAttibutes temp = nTrigsAttibutes[currentPattern][track][0];
-			for (size_t i = 0; i < tLen-1; i++) {
-				nTrigsAttibutes[currentPattern][track][i] = nTrigsAttibutes[currentPattern][track][i+1];
-				nTrigsAttibutes[currentPattern][track][i].setTrigIndex(i);
-			}
-			nTrigsAttibutes[currentPattern][track][tLen-1] = temp;
-			nTrigsAttibutes[currentPattern][track][tLen-1].setTrigIndex(tLen-1);
+	// n > 0 cycles to the left, n < 0 to the right
+	void trigsCycle(TrigAttibutes *trigs, const size_t tLen, const int n) {
+		if (n > 0) {
+			array_cycle_left(trigs, tLen, sizeof(TrigAttibutes), n);
+		}
+		else {
+			array_cycle_right(trigs, tLen, sizeof(TrigAttibutes), -n);
+		}
+		for (size_t i = 0; i < tLen; i++) {
+			trigs[i].setTrigIndex(i);
 		}
 	}
 
+	void nTrackLeft(PatternBlock &b, const int track, const size_t n, const int len = 0) {
+		size_t tLen = len == 0 ? b.tracks[track].getTrackLength() : len;
+		trigsCycle(b.trigs[track], tLen, n);
+	}
 
-	void nTrackRight(const int track, const size_t n, const int len = 0) {
-		size_t tLen = len == 0 ? nTracksAttibutes[currentPattern][track].getTrackLength() : len;
-		array_cycle_right(trigSlide[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigTrim[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigLength[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigPulseDistance[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigCV1[currentPattern][track], tLen, sizeof(float), n);
-		array_cycle_right(trigCV2[currentPattern][track], tLen, sizeof(float), n);
-    array_cycle_right(trigSlideType[currentPattern][track], (size_t) tLen, sizeof(bool), n);
 
-		for (size_t j=0; j<n; j++) {
-			TrigAttibutes temp = nTrigsAttibutes[currentPattern][track][tLen-1];
-			for (size_t i = tLen-1; i > 0; i--) {
-				nTrigsAttibutes[currentPattern][track][i] = nTrigsAttibutes[currentPattern][track][i-1];
-				nTrigsAttibutes[currentPattern][track][i].setTrigIndex(i);
-			}
-			nTrigsAttibutes[currentPattern][track][0] = temp;
-			nTrigsAttibutes[currentPattern][track][0].setTrigIndex(0);
-		}
+	void nTrackRight(PatternBlock &b, const int track, const size_t n, const int len = 0) {
+		size_t tLen = len == 0 ? b.tracks[track].getTrackLength() : len;
+		trigsCycle(b.trigs[track], tLen, -(int)n);
 	}
 
-	void trackUp(const int track) {
+	void trackUp(PatternBlock &b, const int track) {
 		for (int i = 0; i < 64; i++) {
-			nTrigsAttibutes[currentPattern][track][i].up();
+			b.trigs[track][i].up();
 		}
 	}
 
-	void trackDown(const int track) {
+	void trackDown(PatternBlock &b, const int track) {
 		for (int i = 0; i < 64; i++) {
-			nTrigsAttibutes[currentPattern][track][i].down();
+			b.trigs[track][i].down();
 		}
 	}
 
-	void trigUp(const int trig) {
-		nTrigsAttibutes[currentPattern][currentTrack][trig].up();
+	void trigUp(PatternBlock &b, const int trig) {
+		b.trigs[currentTrack][trig].up();
 	}
 
-	void trigDown(const int trig) {
-		nTrigsAttibutes[currentPattern][currentTrack][trig].down();
+	void trigDown(PatternBlock &b, const int trig) {
+		b.trigs[currentTrack][trig].down();
 	}
 
 
 	void onRandomize() override {
-		randomizePattern();
-		updateTrackToParams();
-		updateTrigToParams();
-	}
-
-	void pasteTrack(const int fromPattern, const int fromTrack, const int toPattern, const int toTrack) {
-		nTracksAttibutes[toPattern][toTrack].setMainAttributes(nTracksAttibutes[fromPattern][fromTrack].getMainAttributes());
-		nTracksAttibutes[toPattern][toTrack].setRefAttributes(nTracksAttibutes[fromPattern][fromTrack].getRefAttributes());
-		trackHead[toPattern][toTrack] = trackHead[fromPattern][fromTrack];
-		trackCurrentTickCount[toPattern][toTrack] = trackCurrentTickCount[fromPattern][fromTrack];
-		trackLastTickCount[toPattern][toTrack] = trackLastTickCount[fromPattern][fromTrack];
-		rootNote[toPattern][toTrack] = rootNote[fromPattern][fromTrack];
-		scale[toPattern][toTrack] = scale[fromPattern][fromTrack];
-		quantizeCV1[toPattern][toTrack] = quantizeCV1[fromPattern][fromTrack];
+		lockedBegin();
+		randomizePattern(lockedPattern(currentPattern));
+		lockedEnd();
+	}
+
+	void pasteTrack(PatternBlock &b, const int fromPattern, const int fromTrack, const int toTrack) {
+		const zoumaipattern::Pattern &from = editSource(fromPattern);
+		b.tracks[toTrack].setMainAttributes(from.tracks[fromTrack].mainAttributes);
+		b.rootNote[toTrack] = from.rootNote[fromTrack];
+		b.scale[toTrack] = from.scale[fromTrack];
+		b.quantizeCV1[toTrack] = from.quantizeCV1[fromTrack];
+		b.playbackFrom[toTrack] = fromPattern*8 + fromTrack;
 		for (int i=0; i<64; i++) {
-			pasteTrig(fromPattern,fromTrack,i,toPattern,toTrack,i);
+			pasteTrig(b, fromPattern,fromTrack,i,toTrack,i);
 		}
 	}
 
-	void pasteTrig(const int fromPattern, const int fromTrack, const int fromTrig, const int toPattern, const int toTrack, const int toTrig) {
-		int index = nTrigsAttibutes[toPattern][toTrack][toTrig].getTrigIndex();
-		nTrigsAttibutes[toPattern][toTrack][toTrig].setMainAttributes(nTrigsAttibutes[fromPattern][fromTrack][fromTrig].getMainAttributes());
-		nTrigsAttibutes[toPattern][toTrack][toTrig].setTrigIndex(index);
-		nTrigsAttibutes[toPattern][toTrack][toTrig].setProbAttributes(nTrigsAttibutes[fromPattern][fromTrack][fromTrig].getProbAttributes());
-		trigSlide[toPattern][toTrack][toTrig] = trigSlide[fromPattern][fromTrack][fromTrig];
-		trigTrim[toPattern][toTrack][toTrig] = trigTrim[fromPattern][fromTrack][fromTrig];
-		trigLength[toPattern][toTrack][toTrig] = trigLength[fromPattern][fromTrack][fromTrig];
-		trigPulseDistance[toPattern][toTrack][toTrig] = trigPulseDistance[fromPattern][fromTrack][fromTrig];
-		trigCV1[toPattern][toTrack][toTrig] = trigCV1[fromPattern][fromTrack][fromTrig];
-		trigCV2[toPattern][toTrack][toTrig] = trigCV2[fromPattern][fromTrack][fromTrig];
-    trigSlideType[toPattern][toTrack][toTrig] = trigSlideType[fromPattern][fromTrack][fromTrig];
+	void pasteTrig(PatternBlock &b, const int fromPattern, const int fromTrack, const int fromTrig, const int toTrack, const int toTrig) {
+		int index = b.trigs[toTrack][toTrig].getTrigIndex();
+		b.trigs[toTrack][toTrig] = editSource(fromPattern).trigs[fromTrack][fromTrig];
+		b.trigs[toTrack][toTrig].setTrigIndex(index);
 	}
 
-	void pastePattern() {
+	void pastePattern(PatternBlock &b) {
 		for (int i=0; i<8; i++) {
-			pasteTrack(copyPatternId,i,currentPattern,i);
+			pasteTrack(b, copyPatternId,i,i);
 			for (int j=0; j<64; j++) {
-				pasteTrig(copyPatternId,i,j,currentPattern,i,j);
+				pasteTrig(b, copyPatternId,i,j,i,j);
 			}
 		}
 	}
 
-	void pastePage(const int fromPage, const int toPage) {
+	void pastePage(PatternBlock &b, const int fromPage, const int toPage) {
 		for(int i=0; i<16; i++) {
-			pasteTrig(currentPattern,currentTrack,i+(fromPage*16),currentPattern,currentTrack,i+(toPage*16));
+			pasteTrig(b, editPattern,currentTrack,i+(fromPage*16),currentTrack,i+(toPage*16));
 		}
 	}
 
-	void trigInit(const int pattern, const int track, const int trig) {
-		nTrigsAttibutes[pattern][track][trig].init();
-		trigSlide[pattern][track][trig] = 0.0f;
-		trigTrim[pattern][track][trig] = 0.0f;
-		trigLength[pattern][track][trig] = 0.9f;
-		trigPulseDistance[pattern][track][trig] = 0.5f;
-		trigCV1[pattern][track][trig] = 0.0f;
-		trigCV2[pattern][track][trig] = 0.0f;
-    trigSlideType[pattern][track][trig] = false;
+	void trigInit(PatternBlock &b, const int track, const int trig) {
+		b.trigs[track][trig].init();
 	}
 
-	void pageInit(const int page) {
+	void pageInit(PatternBlock &b, const int page) {
 		const int start = page*16;
 		for (int i=start; i<start+16; i++) {
-			trigInit(currentPattern, currentTrack, i);
-			nTrigsAttibutes[currentPattern][currentTrack][i].setTrigIndex(i);
+			trigInit(b, currentTrack, i);
+			b.trigs[currentTrack][i].setTrigIndex(i);
 		}
 	}
 
-	void trackInit(const int pattern, const int track) {
-		nTracksAttibutes[pattern][track].init();
-		trackHead[pattern][track] = 0.0f;
-		trackCurrentTickCount[pattern][track] = 0.0f;
-		trackLastTickCount[pattern][track] = 22500.0f;
-		rootNote[pattern][track] = -1;
-		scale[pattern][track] = 0;
-		quantizeCV1[pattern][track] = 0;
+	void trackInit(PatternBlock &b, const int track) {
+		b.tracks[track].init();
+		b.rootNote[track] = -1;
+		b.scale[track] = 0;
+		b.quantizeCV1[track] = 0;
+		b.resetPlayback(track);
 		for (int i=0; i<64; i++) {
-			trigInit(pattern, track, i);
-			nTrigsAttibutes[pattern][track][i].setTrigIndex(i);
+			trigInit(b, track, i);
+			b.trigs[track][i].setTrigIndex(i);
 		}
 	}
 
 	void onReset() override {
+		lockedBegin();
 		for (int i=0; i<8; i++) {
 			for (int j=0; j<8; j++) {
-				trackInit(i,j);
+				trackInit(lockedPattern(i),j);
 			}
 		}
-		updateTrackToParams();
-		updateTrigToParams();
+		lockedEnd();
 	}
 
 	void process(const ProcessArgs &args) override;
 
 	bool patternIsSoloed() {
 		for (size_t i = 0; i < 8; i++) {
-			if (nTracksAttibutes[currentPattern][i].getTrackSolo()) {
+			if (work.tracks[i].getTrackSolo()) {
 				return true;
 			}
 		}
 		return false;
 	}
 
-	void trackSync(const int track, const float cCount, const float lCount, const float tHead) {
-		trackCurrentTickCount[currentPattern][track] = cCount;
-		trackLastTickCount[currentPattern][track] = lCount;
-		trackHead[currentPattern][track] = fmod(tHead,nTracksAttibutes[currentPattern][track].getTrackLength()) ;
-	}
-
-	float trackGetGate(const int track, const int tPT) {
-		if (nTrigsAttibutes[currentPattern][track][tPT].getTrigActive() && !nTrigsAttibutes[currentPattern][track][tPT].getTrigSleeping()) {
-			float rTP = trigGetRelativeTrackPosition(track, tPT);
-			if (rTP >= 0) {
-				if (rTP<trigLength[currentPattern][track][tPT]) {
-					return 10.0f;
-				}
-				else {
-					int cPulses = (trigPulseDistance[currentPattern][track][tPT] == 0) ? 0 : (int)(rTP/(float)trigPulseDistance[currentPattern][track][tPT]);
-					return ((cPulses<nTrigsAttibutes[currentPattern][track][tPT].getTrigPulseCount())
-					&& (rTP>=(cPulses*trigPulseDistance[currentPattern][track][tPT]))
-					&& (rTP<=((cPulses*trigPulseDistance[currentPattern][track][tPT])+trigLength[currentPattern][track][tPT]))) ? 10.0f : 0.0f;
-				}
-			}
-			else
-				return 0.0f;
-		}
-		else
-			return 0.0f;
-	}
-
-	float trigGetRelativeTrackPosition(const int track, const int trig) {
-		return trackHead[currentPattern][track] - trigGetTrimedIndex(track, trig);
-	}
-
-	float trigGetFullLength(const int track, const int trig) {
-		return nTrigsAttibutes[currentPattern][track][trig].getTrigPulseCount() == 1 ? trigLength[currentPattern][track][trig] : ((nTrigsAttibutes[currentPattern][track][trig].getTrigPulseCount()*trigPulseDistance[currentPattern][track][trig]) + trigLength[currentPattern][track][trig]);
-	}
-
-	bool trigGetIsRead(const int track, const int trig, const float trackPosition) {
-		float tI = trigGetTrimedIndex(track,trig);
-		return (trackPosition>=tI) && (trackPosition<=(tI+trigGetFullLength(track, trig)));
-	}
-
-	float trigGetTrimedIndex(const int track, const int trig) {
-		return nTrigsAttibutes[currentPattern][track][trig].getTrigIndex() + trigTrim[currentPattern][track][trig];
-	}
-
 	float trackGetVO(const int track, const int tPT, const bool quantize = false) {
-		float vo = nTrigsAttibutes[currentPattern][track][tPT].getVO() + trsp[track];
-		if (trigSlide[currentPattern][track][tPT] == 0.0f) {
-			return quantize ? std::get<0>(quant.closestVoltageInScale(vo, rootNote[currentPattern][track], scale[currentPattern][track])) : vo;
+		float vo = work.trigs[track][tPT].getVO() + trsp[track];
+		if (work.trigs[track][tPT].slide == 0.0f) {
+			return quantize ? std::get<0>(quant.closestVoltageInScale(vo, work.rootNote[track], work.scale[track])) : vo;
 		}
 		else
 		{
 			float fullLength = trigGetFullLength(track,tPT);
-			float voQ = quantize ? std::get<0>(quant.closestVoltageInScale(vo, rootNote[currentPattern][track], scale[currentPattern][track])) : vo;
+			float voQ = quantize ? std::get<0>(quant.closestVoltageInScale(vo, work.rootNote[track], work.scale[track])) : vo;
 			if (fullLength > 0.0f) {
-				if (slideMode[currentPattern][track]) {
-          if (trigSlideType[currentPattern][track][tPT]) {
+				if (work.slideMode[track]) {
+          if (work.trigs[track][tPT].getTrigSlideType()) {
             float subPhase = clamp(trigGetRelativeTrackPosition(track, tPT),0.0f,1.0f);
-  					return voQ - (1.0f - interpolateLinear(powTable[(int)(trigSlide[currentPattern][track][tPT]*99.0f)],9999.0f*subPhase)) * (voQ - prevVO[track]);
+  					return voQ - (1.0f - slideCurve.shape((int)(work.trigs[track][tPT].slide*99.0f),9999.0f*subPhase)) * (voQ - prevVO[track]);
           }
           else
           {
             float subPhase = clamp(trigGetRelativeTrackPosition(track, tPT),0.0f,fullLength);
-  					return voQ - (1.0f - interpolateLinear(powTable[(int)(trigSlide[currentPattern][track][tPT]*99.0f)],9999.0f*subPhase/fullLength)) * (voQ - prevVO[track]);
+  					return voQ - (1.0f - slideCurve.shape((int)(work.trigs[track][tPT].slide*99.0f),9999.0f*subPhase/fullLength)) * (voQ - prevVO[track]);
           }
 				}
 				else {
-          if (trigSlideType[currentPattern][track][tPT]) {
+          if (work.trigs[track][tPT].getTrigSlideType()) {
             float subPhase = clamp(trigGetRelativeTrackPosition(track, tPT)*(1.0f/max((int)abs(voQ - prevVO[track]),1)),0.0f,1.0f);
-  					return voQ - (1.0f - interpolateLinear(powTable[(int)(trigSlide[currentPattern][track][tPT]*99.0f)],9999.0f*subPhase)) * (voQ - prevVO[track]);
+  					return voQ - (1.0f - slideCurve.shape((int)(work.trigs[track][tPT].slide*99.0f),9999.0f*subPhase)) * (voQ - prevVO[track]);
           }
           else
           {
             float subPhase = clamp(trigGetRelativeTrackPosition(track, tPT)*(1.0f/max((int)abs(voQ - prevVO[track]),1)),0.0f,fullLength);
-  					return voQ - (1.0f - interpolateLinear(powTable[(int)(trigSlide[currentPattern][track][tPT]*99.0f)],9999.0f*subPhase/fullLength)) * (voQ - prevVO[track]);
+  					return voQ - (1.0f - slideCurve.shape((int)(work.trigs[track][tPT].slide*99.0f),9999.0f*subPhase/fullLength)) * (voQ - prevVO[track]);
           }
 				}
 			}
@@ -1184,228 +1206,72 @@ struct ZOUMAI : BidooModule {
 		}
 	}
 
-	void trackSetCurrentTrig(const int track, const bool fill, const bool pNei, const bool force=false, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		int cI = nTracksAttibutes[currentPattern][track].getTrackCurrentTrig();
-		if (((int)trackHead[currentPattern][track] != cI) || force) {
-			nTracksAttibutes[currentPattern][track].setTrackPre((nTrigsAttibutes[currentPattern][track][cI].getTrigActive() && nTrigsAttibutes[currentPattern][track][cI].hasProbability()) ? !nTrigsAttibutes[currentPattern][track][cI].getTrigSleeping() : nTracksAttibutes[currentPattern][track].getTrackPre());
-			nTrigsAttibutes[currentPattern][track][cI].setTrigInitialized(false);
-			nTracksAttibutes[currentPattern][track].setTrackCurrentTrig((int)trackHead[currentPattern][track]);
-			cI = nTracksAttibutes[currentPattern][track].getTrackCurrentTrig();
-			nTrigsAttibutes[currentPattern][track][cI].init(fill,nTracksAttibutes[currentPattern][track].getTrackPre(),pNei, forceTrig, killTrig, dice);
-			nTracksAttibutes[currentPattern][track].setTrackPre((nTrigsAttibutes[currentPattern][track][cI].getTrigActive()
-			&& nTrigsAttibutes[currentPattern][track][cI].hasProbability()) ? !nTrigsAttibutes[currentPattern][track][cI].getTrigSleeping() : nTracksAttibutes[currentPattern][track].getTrackPre());
-			trackSetNextTrig(track);
-			nTrigsAttibutes[currentPattern][track][nTracksAttibutes[currentPattern][track].getTrackNextTrig()].init(fill,nTracksAttibutes[currentPattern][track].getTrackPre(),pNei, forceTrig, killTrig, dice);
-		}
-
-		int cPT = nTracksAttibutes[currentPattern][track].getTrackPlayedTrig();
-		if (trigGetIsRead(track, cI, trackHead[currentPattern][track])) {
-			if ((cI != cPT)	&& nTrigsAttibutes[currentPattern][track][cI].getTrigActive() && !nTrigsAttibutes[currentPattern][track][cI].getTrigSleeping()) {
-				nTracksAttibutes[currentPattern][track].setTrackPrevTrig(cPT);
-				nTracksAttibutes[currentPattern][track].setTrackPlayedTrig(cI);
-			}
-		}
-		else {
-			int cNT = nTracksAttibutes[currentPattern][track].getTrackNextTrig();
-			if (trigGetIsRead(track, cNT, trackHead[currentPattern][track]) && (cNT != cPT)
-			&& nTrigsAttibutes[currentPattern][track][cNT].getTrigActive()
-			&& !nTrigsAttibutes[currentPattern][track][cNT].getTrigSleeping())
-			{
-				nTracksAttibutes[currentPattern][track].setTrackPrevTrig(cPT);
-				nTracksAttibutes[currentPattern][track].setTrackPlayedTrig(cNT);
-			}
-		}
-	}
-
-	void trackReset(const int track, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		nTracksAttibutes[currentPattern][track].setTrackPre(false);
-		nTracksAttibutes[currentPattern][track].setTrackForward(true);
-
-		if (nTracksAttibutes[currentPattern][track].getTrackReadMode() == 1)
-		{
-			nTracksAttibutes[currentPattern][track].setTrackForward(false);
-			trackHead[currentPattern][track] = nTracksAttibutes[currentPattern][track].getTrackLength()-1;
-			trackSetCurrentTrig(track, fill, pNei, true, forceTrig, killTrig, dice);
-			trackHead[currentPattern][track] = nTracksAttibutes[currentPattern][track].getTrackLength();
-		}
-		else
-		{
-			trackHead[currentPattern][track] = 0.0f;
-			trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
-		}
-	}
-
-	void trackSetNextTrig(const int track) {
-		int cI = nTracksAttibutes[currentPattern][track].getTrackCurrentTrig();
-		switch (nTracksAttibutes[currentPattern][track].getTrackReadMode()) {
-			case 0:
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig((cI == (nTracksAttibutes[currentPattern][track].getTrackLength()-1)) ? 0 : (cI+1)); break;
-			case 1:
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig((cI == 0) ? (nTracksAttibutes[currentPattern][track].getTrackLength()-1) : (cI-1)); break;
-			case 2: {
-				if (cI == 0) {
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(nTracksAttibutes[currentPattern][track].getTrackLength() > 1 ? 1: 0);
-				}
-				else if (cI == (nTracksAttibutes[currentPattern][track].getTrackLength() - 1)) {
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(nTracksAttibutes[currentPattern][track].getTrackLength() > 1 ? (nTracksAttibutes[currentPattern][track].getTrackLength()-2) : 0);
-				}
-				else {
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(clamp(cI + (nTracksAttibutes[currentPattern][track].getTrackForward() ? 1 : -1),0,nTracksAttibutes[currentPattern][track].getTrackLength() - 1));
-				}
-			  break;
-			}
-			case 3: nTracksAttibutes[currentPattern][track].setTrackNextTrig((int)(random::uniform()*(nTracksAttibutes[currentPattern][track].getTrackLength() - 1))); break;
-			case 4:
-			{
-				float dice = random::uniform();
-				if (dice>=0.5f)
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(((cI+1) > (nTracksAttibutes[currentPattern][track].getTrackLength() - 1) ? 0 : (cI + 1)));
-				else if (dice<=0.25f)
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(cI == 0 ? (nTracksAttibutes[currentPattern][track].getTrackLength() - 1) : (cI - 1));
-				else
-					nTracksAttibutes[currentPattern][track].setTrackNextTrig(cI);
-				break;
+	// the expander only writes a frame when something changed, rotations only last the sample they arrive in
+	void expanderReceive(const float *message) {
+		if (expanderEvents) {
+			for (int i=0; i<8; i++) {
+				rotLeft[i] = 0;
+				rotRight[i] = 0;
 			}
-			default : nTracksAttibutes[currentPattern][track].setTrackNextTrig(cI);
-		}
-	}
-
-	void trackMoveNextForward(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		nTracksAttibutes[currentPattern][track].setTrackForward(true);
-		if (step) {
-			trackHead[currentPattern][track] = round(trackHead[currentPattern][track]);
-			trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
-			trackCurrentTickCount[currentPattern][track] = 0.0f;
-		}
-		else {
-			trackCurrentTickCount[currentPattern][track]++;
-			trackHead[currentPattern][track] += nTracksAttibutes[currentPattern][track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
-		}
-
-		if (trackHead[currentPattern][track] >= nTracksAttibutes[currentPattern][track].getTrackLength()) {
-			trackReset(track, fill, pNei, forceTrig, killTrig, dice);
-			return;
-		}
-
-		trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
-	}
-
-	void trackMoveNextBackward(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		nTracksAttibutes[currentPattern][track].setTrackForward(false);
-		if (step) {
-			trackHead[currentPattern][track] = round(trackHead[currentPattern][track]);
-			trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
-			trackCurrentTickCount[currentPattern][track] = 0.0f;
-		}
-		else {
-			trackCurrentTickCount[currentPattern][track]++;
-			trackHead[currentPattern][track] -= nTracksAttibutes[currentPattern][track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
-		}
-
-		if (trackHead[currentPattern][track] <= 0) {
-			trackReset(track, fill, pNei, forceTrig, killTrig, dice);
-			return;
-		}
-
-		trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
-	}
-
-	void trackMoveNextPendulum(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		if (step) {
-			trackHead[currentPattern][track] = round(trackHead[currentPattern][track]);
-			trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
-			trackCurrentTickCount[currentPattern][track] = 0.0f;
-		}
-		else {
-			trackCurrentTickCount[currentPattern][track]++;
-			trackHead[currentPattern][track] = trackHead[currentPattern][track] + (nTracksAttibutes[currentPattern][track].getTrackForward() ? 1 : -1 ) * nTracksAttibutes[currentPattern][track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
-		}
-
-		if (trackHead[currentPattern][track] >= nTracksAttibutes[currentPattern][track].getTrackLength()) {
-			nTracksAttibutes[currentPattern][track].setTrackForward(false);
-			trackHead[currentPattern][track] = (nTracksAttibutes[currentPattern][track].getTrackLength() == 1) ? 1 : (nTracksAttibutes[currentPattern][track].getTrackLength()-1);
-		}
-		else if (trackHead[currentPattern][track] <= 0) {
-			nTracksAttibutes[currentPattern][track].setTrackForward(true);
-			trackHead[currentPattern][track] = nTracksAttibutes[currentPattern][track].getTrackLength() > 1 ? 1 : 0;
-		}
-
-		trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
-	}
-
-	void trackMoveNextRandom(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		nTracksAttibutes[currentPattern][track].setTrackForward(true);
-		if (step) {
-			trackHead[currentPattern][track] = round(trackHead[currentPattern][track]);
-			trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
-			trackCurrentTickCount[currentPattern][track] = 0.0f;
-		}
-		else {
-			trackCurrentTickCount[currentPattern][track]++;
-			trackHead[currentPattern][track] += nTracksAttibutes[currentPattern][track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
+			expanderEvents = false;
 		}
 
-		if (trackHead[currentPattern][track] >= nTracksAttibutes[currentPattern][track].getTrackCurrentTrig()+1) {
-			trackHead[currentPattern][track] = nTracksAttibutes[currentPattern][track].getTrackNextTrig();
-			trackSetCurrentTrig(track, fill, pNei, true, forceTrig, killTrig, dice);
+		const int seq = (int)message[zoumaimessage::SEQ];
+		if (((int)message[zoumaimessage::VERSION] != zoumaimessage::version) || (seq == expanderSeq)) {
 			return;
 		}
 
-		trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
-	}
-
-	void trackMoveNextBrownian(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		nTracksAttibutes[currentPattern][track].setTrackForward(true);
-		if (step) {
-			trackHead[currentPattern][track] = round(trackHead[currentPattern][track]);
-			trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
-			trackCurrentTickCount[currentPattern][track] = 0.0f;
-		}
-		else {
-			trackCurrentTickCount[currentPattern][track]++;
-			trackHead[currentPattern][track] += nTracksAttibutes[currentPattern][track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
-		}
-
-		if (trackHead[currentPattern][track] >= nTracksAttibutes[currentPattern][track].getTrackCurrentTrig()+1) {
-			trackHead[currentPattern][track] = nTracksAttibutes[currentPattern][track].getTrackNextTrig();
-			trackSetCurrentTrig(track, fill, pNei, true, forceTrig, killTrig, dice);
+		const bool full = (int)message[zoumaimessage::FLAGS] & zoumaimessage::flagFull;
+		if (!full && (expanderResync || (seq != (expanderSeq + 1) % zoumaimessage::seqModulo))) {
+			// dropped or reordered frame, the deltas can not be trusted until a full frame comes
+			expanderResync = true;
+			expanderSeq = seq;
 			return;
 		}
 
-		trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig);
-	}
-
-	void trackMoveNext(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
-		switch (nTracksAttibutes[currentPattern][track].getTrackReadMode()) {
-			case 0: trackMoveNextForward(track, step, fill, pNei, forceTrig, killTrig, dice); break;
-			case 1: trackMoveNextBackward(track, step, fill, pNei, forceTrig, killTrig, dice); break;
-			case 2: trackMoveNextPendulum(track, step, fill, pNei, forceTrig, killTrig, dice); break;
-			case 3: trackMoveNextRandom(track, step, fill, pNei, forceTrig, killTrig, dice); break;
-			case 4: trackMoveNextBrownian(track, step, fill, pNei, forceTrig, killTrig, dice); break;
-		}
+		const int dirty = (int)message[zoumaimessage::DIRTY];
+		const float *payload = message + zoumaimessage::headerSize;
+		for (int i=0; i<8; i++) {
+			if (!(dirty & (1 << i))) continue;
+			const int switches = (int)payload[zoumaimessage::TRACK_SWITCHES];
+			fills[i] = switches & zoumaimessage::switchFill;
+			forceTrigs[i] = switches & zoumaimessage::switchForce;
+			killTrigs[i] = switches & zoumaimessage::switchKill;
+			trsp[i] = payload[zoumaimessage::TRACK_TRSP];
+			dice[i] = payload[zoumaimessage::TRACK_DICE];
+			rotLeft[i] = payload[zoumaimessage::TRACK_ROTLEFT];
+			rotRight[i] = payload[zoumaimessage::TRACK_ROTRIGHT];
+			rotLen[i] = payload[zoumaimessage::TRACK_ROTLEN];
+			expanderEvents = expanderEvents || rotLeft[i] || rotRight[i];
+			payload += zoumaimessage::trackFields;
+		}
+		expanderSeq = seq;
+		expanderResync = false;
 	}
 
 };
 
 void ZOUMAI::process(const ProcessArgs &args) {
-	currentPattern = (int)clamp((inputs[PATTERN_INPUT].isConnected() ? rescale(clamp(inputs[PATTERN_INPUT].getVoltage(), 0.0f, 10.0f),0.0f,10.0f,0.0f,8.0f) : 0) + (int)params[PATTERN_PARAM].getValue(), 0.0f, 7.0f);
+	const int fromPattern = currentPattern;
+	const bool switched = patternSwitch((int)clamp((inputs[PATTERN_INPUT].isConnected() ? rescale(clamp(inputs[PATTERN_INPUT].getVoltage(), 0.0f, 10.0f),0.0f,10.0f,0.0f,8.0f) : 0) + (int)params[PATTERN_PARAM].getValue(), 0.0f, 7.0f));
 
 	if (rightExpander.module && rightExpander.module->model == modelZOUMAIExpander) {
-		float *messagesFromExpander = (float*)rightExpander.consumerMessage;
-		for (int i=0; i<8; i++) {
-			fills[i]=messagesFromExpander[i];
-			forceTrigs[i]=messagesFromExpander[i+8];
-			killTrigs[i]=messagesFromExpander[i+16];
-			trsp[i]=messagesFromExpander[i+24];
-			dice[i]=messagesFromExpander[i+32];
-			rotLeft[i]=messagesFromExpander[i+40];
-			rotRight[i]=messagesFromExpander[i+48];
-			rotLen[i]=messagesFromExpander[i+56];
-		}
+		expanderReceive((const float*)rightExpander.consumerMessage);
 
-		float *messagesToExpander = (float*)(rightExpander.module->leftExpander.producerMessage);
-		messagesToExpander[0] = currentPattern;
-		rightExpander.module->leftExpander.messageFlipRequested = true;
+		if ((currentPattern != expanderPatternSent) || (expanderResync != expanderResyncSent)) {
+			float *messagesToExpander = (float*)(rightExpander.module->leftExpander.producerMessage);
+			messagesToExpander[zoumaimessage::BACK_PATTERN] = currentPattern;
+			messagesToExpander[zoumaimessage::BACK_RESYNC] = expanderResync ? 1.0f : 0.0f;
+			rightExpander.module->leftExpander.messageFlipRequested = true;
+			expanderPatternSent = currentPattern;
+			expanderResyncSent = expanderResync;
+		}
+	}
+	else {
+		expanderSeq = -1;
+		expanderPatternSent = -1;
+		expanderResync = false;
+		expanderResyncSent = false;
 	}
 
 	if (inputs[FILL_INPUT].isConnected()) {
@@ -1418,13 +1284,16 @@ void ZOUMAI::process(const ProcessArgs &args) {
 
 	solo = patternIsSoloed();
 
-	if (currentPattern != previousPattern) {
+	if (switched) {
 		for (size_t i = 0; i<8; i++) {
-			trackSync(i,trackCurrentTickCount[previousPattern][i], trackLastTickCount[previousPattern][i], trackHead[previousPattern][i]);
+			trackSync(i,trackCurrentTickCount[fromPattern][i], trackLastTickCount[fromPattern][i], trackHead[fromPattern][i]);
 		}
-		previousPattern = currentPattern;
-		updateTrackToParams();
-		updateTrigToParams();
+		tracksInvalidate();
+		paramsRefresh = false;
+		updateParams();
+	}
+	else if (paramsRefresh.load(std::memory_order_relaxed) && paramsRefresh.exchange(false)) {
+		updateParams();
 	}
 	else {
 		updateTrigVO();
@@ -1432,8 +1301,17 @@ void ZOUMAI::process(const ProcessArgs &args) {
 		updateParamsToTrig();
 	}
 
+#ifdef ZOUMAI_STATS
+	// 18 attributes used to be rewritten on every sample
+	if (++attributeWritesSamples >= args.sampleRate) {
+		DEBUG("ZOUMAI attribute writes/s : %lu (per sample copy : %lu)", attributeWrites, 18 * attributeWritesSamples);
+		attributeWrites = 0;
+		attributeWritesSamples = 0;
+	}
+#endif
+
 	int pageOffset = trigPage*16;
-	int tCT = nTracksAttibutes[currentPattern][currentTrack].getTrackCurrentTrig();
+	int tCT = work.tracks[currentTrack].getTrackCurrentTrig();
 	for (int i = 0; i<16; i++) {
 		int shiftedIndex = i + pageOffset;
 		if (tCT == shiftedIndex) {
@@ -1441,7 +1319,7 @@ void ZOUMAI::process(const ProcessArgs &args) {
 			lights[STEPS_LIGHTS+3*i+1].setBrightness(0.0f);
 			lights[STEPS_LIGHTS+3*i+2].setBrightness(0.0f);
 		}
-		else if (nTrigsAttibutes[currentPattern][currentTrack][shiftedIndex].getTrigActive()) {
+		else if (work.trigs[currentTrack][shiftedIndex].getTrigActive()) {
 			if (shiftedIndex == currentTrig) {
 				lights[STEPS_LIGHTS+3*i].setBrightness(0.0f);
 				lights[STEPS_LIGHTS+3*i+1].setBrightness(0.0f);
@@ -1480,7 +1358,7 @@ void ZOUMAI::process(const ProcessArgs &args) {
 		}
 
 		if (i<7) {
-				if (nTrigsAttibutes[currentPattern][currentTrack][currentTrig].getTrigOctave()==i) {
+				if (work.trigs[currentTrack][currentTrig].getTrigOctave()==i) {
 					lights[OCTAVE_LIGHTS+3*i+2].setBrightness(1.0f);
 				}
 				else {
@@ -1490,7 +1368,8 @@ void ZOUMAI::process(const ProcessArgs &args) {
 
 		if (i<8) {
 			if (trackActiveTriggers[i].process(inputs[TRACKACTIVE_INPUTS+i].getVoltage())) {
-				nTracksAttibutes[currentPattern][i].toggleTrackActive();
+				work.tracks[i].toggleTrackActive();
+				workDirty = true;
 			}
 
 			if (currentTrack==i) {
@@ -1502,11 +1381,11 @@ void ZOUMAI::process(const ProcessArgs &args) {
 				lights[TRACKSELECT_LIGHTS+i*3+2].setBrightness(0.0f);
 			}
 
-			if (!solo && nTracksAttibutes[currentPattern][i].getTrackActive()) {
+			if (!solo && work.tracks[i].getTrackActive()) {
 				lights[TRACKSONOFF_LIGHTS+i*3+1].setBrightness(1.0f);
 				lights[TRACKSONOFF_LIGHTS+i*3+2].setBrightness(0.0f);
 			}
-			else if (solo && nTracksAttibutes[currentPattern][i].getTrackSolo()) {
+			else if (solo && work.tracks[i].getTrackSolo()) {
 				lights[TRACKSONOFF_LIGHTS+i*3+1].setBrightness(0.0f);
 				lights[TRACKSONOFF_LIGHTS+i*3+2].setBrightness(1.0f);
 			}
@@ -1554,98 +1433,111 @@ void ZOUMAI::process(const ProcessArgs &args) {
 			clockMaxCount++;
 		}
 
+		if (editsPending.load(std::memory_order_relaxed) && (clockTrigged || (!inputs[EXTCLOCK_INPUT].isConnected() && (++editsPendingSamples >= 0.05f * args.sampleRate)))) {
+			patternsAdopt();
+		}
+
 		for (int i=0; i<8;i++) {
+			bool recording = (currentTrack == i) && (params[RECORD_PARAM].getValue() == 1.0f);
+			bool scheduled = false;
 			if (trackResetTriggers[i].process(inputs[TRACKRESET_INPUTS+i].getVoltage())) {
 				if (rotLeft[i]) {
-					nTrackLeft(i,rotLeft[i], rotLen[i]);
-					updateTrigToParams();
+					workRotate(i, rotLeft[i], rotLen[i]);
+					updateTrigToParams(false);
 				}
 				else if (rotRight[i]) {
-					nTrackRight(i,rotRight[i], rotLen[i]);
-					updateTrigToParams();
+					workRotate(i, -rotRight[i], rotLen[i]);
+					updateTrigToParams(false);
 				}
-				trackReset(i, fill || fills[i], i == 0 ? false : nTracksAttibutes[currentPattern][i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
+				trackReset(i, fill || fills[i], i == 0 ? false : work.tracks[i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
 			}
       else if (!inputs[TRACKRESET_INPUTS+i].isConnected() && globalReset) {
 				if (rotLeft[i]) {
-					nTrackLeft(i,rotLeft[i], rotLen[i]);
-					updateTrigToParams();
+					workRotate(i, rotLeft[i], rotLen[i]);
+					updateTrigToParams(false);
 				}
 				else if (rotRight[i]) {
-					nTrackRight(i,rotRight[i], rotLen[i]);
-					updateTrigToParams();
+					workRotate(i, -rotRight[i], rotLen[i]);
+					updateTrigToParams(false);
 				}
-				trackReset(i, fill || fills[i], i == 0 ? false : nTracksAttibutes[currentPattern][i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
-				trackMoveNext(i, true, fill || fills[i], i == 0 ? false : nTracksAttibutes[currentPattern][i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
+				trackReset(i, fill || fills[i], i == 0 ? false : work.tracks[i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
+				trackMoveNext(i, true, fill || fills[i], i == 0 ? false : work.tracks[i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
 			}
 			else {
 				if (rotLeft[i]) {
-					nTrackLeft(i,rotLeft[i], rotLen[i]);
-					updateTrigToParams();
+					workRotate(i, rotLeft[i], rotLen[i]);
+					updateTrigToParams(false);
 				}
 				else if (rotRight[i]) {
-					nTrackRight(i,rotRight[i], rotLen[i]);
-					updateTrigToParams();
+					workRotate(i, -rotRight[i], rotLen[i]);
+					updateTrigToParams(false);
 				}
-				trackMoveNext(i, clockTrigged, fill || fills[i], i == 0 ? false : nTracksAttibutes[currentPattern][i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
+				scheduled = trackAdvance(i, clockTrigged, !recording, fill || fills[i], i == 0 ? false : work.tracks[i-1].getTrackPre(), forceTrigs[i], killTrigs[i], dice[i]);
 			}
 
-			int tPT = nTracksAttibutes[currentPattern][i].getTrackPlayedTrig();
+			int tPT = work.tracks[i].getTrackPlayedTrig();
 
-			if ((currentTrack == i) && (params[RECORD_PARAM].getValue() == 1.0f)) {
+			if (recording) {
 					if (inputs[GATE_INPUT].getVoltage()>0.1f) {
 						if (!noteIncoming) {
 							noteIncoming = true;
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigActive(true);
+							work.trigs[i][(long)trackHead[currentPattern][i]].setTrigActive(true);
 							if (params[QUANTIZE_PARAM].getValue() == 0.0f) {
-								trigTrim[currentPattern][i][(long)trackHead[currentPattern][i]] = trackHead[currentPattern][i] - (long)trackHead[currentPattern][i];
+								work.trigs[i][(long)trackHead[currentPattern][i]].trim = trackHead[currentPattern][i] - (long)trackHead[currentPattern][i];
 							} else {
-								trigTrim[currentPattern][i][(long)trackHead[currentPattern][i]] = 0.0f;
+								work.trigs[i][(long)trackHead[currentPattern][i]].trim = 0.0f;
 							}
 							currentIncomingVO = inputs[VO_INPUT].getVoltage();
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigOctave((long)currentIncomingVO+3.0f);
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigSemiTones((long)((currentIncomingVO-(long)currentIncomingVO)*12.f));
+							work.trigs[i][(long)trackHead[currentPattern][i]].setTrigOctave((long)currentIncomingVO+3.0f);
+							work.trigs[i][(long)trackHead[currentPattern][i]].setTrigSemiTones((long)((currentIncomingVO-(long)currentIncomingVO)*12.f));
+							workDirty = true;
 						}
 						else if (currentIncomingVO != inputs[VO_INPUT].getVoltage()) {
 							currentIncomingVO = inputs[VO_INPUT].getVoltage();
-							if (trackHead[currentPattern][i]>nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()) {
-								trigLength[currentPattern][i][tPT] = trackHead[currentPattern][i] - nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()-0.01f;
+							if (trackHead[currentPattern][i]>work.trigs[i][tPT].getTrigIndex()) {
+								work.trigs[i][tPT].length = trackHead[currentPattern][i] - work.trigs[i][tPT].getTrigIndex()-0.01f;
 							}
 							else {
-								trigLength[currentPattern][i][tPT] = nTracksAttibutes[currentPattern][i].getTrackLength() - nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()-0.01f;
+								work.trigs[i][tPT].length = work.tracks[i].getTrackLength() - work.trigs[i][tPT].getTrigIndex()-0.01f;
 							}
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigActive(true);
+							work.trigs[i][(long)trackHead[currentPattern][i]].setTrigActive(true);
 							if (params[QUANTIZE_PARAM].getValue() == 0.0f) {
-								trigTrim[currentPattern][i][(long)trackHead[currentPattern][i]] = trackHead[currentPattern][i] - (long)trackHead[currentPattern][i];
+								work.trigs[i][(long)trackHead[currentPattern][i]].trim = trackHead[currentPattern][i] - (long)trackHead[currentPattern][i];
 							} else {
-								trigTrim[currentPattern][i][(long)trackHead[currentPattern][i]] = 0.0f;
+								work.trigs[i][(long)trackHead[currentPattern][i]].trim = 0.0f;
 							}
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigOctave((long)currentIncomingVO+3.0f);
-							nTrigsAttibutes[currentPattern][i][(long)trackHead[currentPattern][i]].setTrigSemiTones((long)((currentIncomingVO-(long)currentIncomingVO)*12.f));
+							work.trigs[i][(long)trackHead[currentPattern][i]].setTrigOctave((long)currentIncomingVO+3.0f);
+							work.trigs[i][(long)trackHead[currentPattern][i]].setTrigSemiTones((long)((currentIncomingVO-(long)currentIncomingVO)*12.f));
+							workDirty = true;
 						}
 					} else {
 						if (noteIncoming) {
 							noteIncoming = false;
-							if (trackHead[currentPattern][i]>nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()) {
-								trigLength[currentPattern][i][tPT] = trackHead[currentPattern][i] - nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex();
+							if (trackHead[currentPattern][i]>work.trigs[i][tPT].getTrigIndex()) {
+								work.trigs[i][tPT].length = trackHead[currentPattern][i] - work.trigs[i][tPT].getTrigIndex();
 							}
 							else {
-								trigLength[currentPattern][i][tPT] = nTracksAttibutes[currentPattern][i].getTrackLength() - nTrigsAttibutes[currentPattern][i][tPT].getTrigIndex()-0.01f;
+								work.trigs[i][tPT].length = work.tracks[i].getTrackLength() - work.trigs[i][tPT].getTrigIndex()-0.01f;
 							}
+							workDirty = true;
 							currentIncomingVO = -100.0f;
 						}
 					}
 			}
 
 
-			if ((solo && nTracksAttibutes[currentPattern][i].getTrackSolo()) || (!solo && nTracksAttibutes[currentPattern][i].getTrackActive())) {
-				float gate = trackGetGate(i, tPT);
+			if (!scheduled) {
+				trackGateUpdate(i);
+			}
+
+			if ((solo && work.tracks[i].getTrackSolo()) || (!solo && work.tracks[i].getTrackActive())) {
+				float gate = trackGate[i];
 				if (gate>0.0f) {
-					if (nTrigsAttibutes[currentPattern][i][tPT].getTrigType() == 0)
+					if (work.trigs[i][tPT].getTrigType() == 0)
 						outputs[GATE_OUTPUTS + i].setVoltage(gate);
-					else if (nTrigsAttibutes[currentPattern][i][tPT].getTrigType() == 1)
+					else if (work.trigs[i][tPT].getTrigType() == 1)
 						outputs[GATE_OUTPUTS + i].setVoltage(inputs[G1_INPUT].getVoltage());
-					else if (nTrigsAttibutes[currentPattern][i][tPT].getTrigType() == 2)
+					else if (work.trigs[i][tPT].getTrigType() == 2)
 						outputs[GATE_OUTPUTS + i].setVoltage(inputs[G2_INPUT].getVoltage());
 					else
 						outputs[GATE_OUTPUTS + i].setVoltage(0.0f);
@@ -1661,18 +1553,31 @@ void ZOUMAI::process(const ProcessArgs &args) {
 				prevTrig[i] = tPT;
 			}
 
-			bool q = rootNote[currentPattern][i]>=0 && scale[currentPattern][i]>0;
+			bool q = work.rootNote[i]>=0 && work.scale[i]>0;
 			outputs[VO_OUTPUTS + i].setVoltage(trackGetVO(i, tPT, q));
-			outputs[CV1_OUTPUTS + i].setVoltage(outputs[GATE_OUTPUTS + i].getVoltage() == 0.0f ? 0.0f : ((quantizeCV1[currentPattern][i]>0 && q) ? std::get<0>(quant.closestVoltageInScale(trigCV1[currentPattern][i][tPT]-4.0f, rootNote[currentPattern][i], scale[currentPattern][i])) : trigCV1[currentPattern][i][tPT]));
-			outputs[CV2_OUTPUTS + i].setVoltage(outputs[GATE_OUTPUTS + i].getVoltage() == 0.0f ? 0.0f : trigCV2[currentPattern][i][tPT]);
+			outputs[CV1_OUTPUTS + i].setVoltage(outputs[GATE_OUTPUTS + i].getVoltage() == 0.0f ? 0.0f : ((work.quantizeCV1[i]>0 && q) ? std::get<0>(quant.closestVoltageInScale(work.trigs[i][tPT].cv1-4.0f, work.rootNote[i], work.scale[i])) : work.trigs[i][tPT].cv1));
+			outputs[CV2_OUTPUTS + i].setVoltage(outputs[GATE_OUTPUTS + i].getVoltage() == 0.0f ? 0.0f : work.trigs[i][tPT].cv2);
 		}
 	}
 	else {
+		if (editsPending.load(std::memory_order_relaxed)) {
+			patternsAdopt();
+		}
 		for (int i=0; i<8;i++) {
 			outputs[GATE_OUTPUTS + i].setVoltage(0.0f);
 		}
 	}
 
+	// a copy of work for the UI, every 20ms at most
+	if (workDirty && (++workPublishSamples >= 0.02f * args.sampleRate)) {
+		workPublish();
+	}
+
+#if defined(METAMODULE)
+	if (!retiredBlocks.empty() || (spareBlocks.size() < spareCount)) {
+		recycleAsync.run_once();
+	}
+#endif
 }
 
 struct recordBtn : SvgSwitch {
@@ -1715,7 +1620,8 @@ struct octaveBtn : SmallLEDLightBezel<RedGreenBlueLight> {
 					mod->params[ZOUMAI::OCTAVE_PARAMS+i].setValue(0.0f);
 				}
 				else {
-					mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].setTrigOctave(i);
+					mod->beginEdit().trigs[mod->currentTrack][mod->currentTrig].setTrigOctave(i);
+					mod->endEdit();
 				}
 			}
 			e.consume(this);
@@ -1739,7 +1645,7 @@ struct trigPageBtn : SmallLEDLightBezel<RedGreenBlueLight> {
 			if (mod->currentTrig>32) mod->currentTrig = mod->currentTrig - 32;
 			if (mod->currentTrig>16) mod->currentTrig = mod->currentTrig - 16;
 			mod->currentTrig = mod->trigPage*16 + mod->currentTrig;
-			mod->updateTrigToParams();
+			mod->paramsRefresh = true;
 			e.consume(this);
 		}
 		SmallLEDLightBezel<RedGreenBlueLight>::onButton(e);
@@ -1758,44 +1664,44 @@ struct trigPageBtn : SmallLEDLightBezel<RedGreenBlueLight> {
 
 			if (e.key == GLFW_KEY_V) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-			  mod->pastePage(mod->copyPageId, getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
-			  mod->updateTrigToParams();
+			  mod->pastePage(mod->beginEdit(), mod->copyPageId, getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
+			  mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_E) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->pageInit(getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
-				mod->updateTrigToParams();
+				mod->pageInit(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_T) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizePageTrigsNotes(getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
-				mod->updateTrigToParams();
+				mod->randomizePageTrigsNotes(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_Y) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizePageTrigsNotesPlus(getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
-				mod->updateTrigToParams();
+				mod->randomizePageTrigsNotesPlus(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_U) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizePageTrigsProbs(getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
-				mod->updateTrigToParams();
+				mod->randomizePageTrigsProbs(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_F) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizePageTrigsCV1(getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
-				mod->updateTrigToParams();
+				mod->randomizePageTrigsCV1(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_G) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizePageTrigsCV2(getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
-				mod->updateTrigToParams();
+				mod->randomizePageTrigsCV2(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRIGPAGE_PARAM);
+				mod->endEdit();
 			}
 		}
 		SmallLEDLightBezel<RedGreenBlueLight>::onHoverKey(e);
@@ -1818,8 +1724,7 @@ struct trackSelectBtn : SmallLEDLightBezel<RedGreenBlueLight> {
 				else {
 					mod->params[ZOUMAI::TRACKSELECT_PARAMS+i].setValue(1.0f);
 					mod->currentTrack=i;
-					mod->updateTrackToParams();
-					mod->updateTrigToParams();
+					mod->paramsRefresh = true;
 				}
 			}
 			e.consume(this);
@@ -1840,82 +1745,74 @@ struct trackSelectBtn : SmallLEDLightBezel<RedGreenBlueLight> {
 
 			if (e.key == GLFW_KEY_V) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->pasteTrack(mod->copyPatternId,mod->copyTrackId,mod->currentPattern,getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->pasteTrack(mod->beginEdit(), mod->copyPatternId,mod->copyTrackId,getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_E) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->trackInit(mod->currentPattern,getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->trackInit(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_R) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrack(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrack(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_T) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsNotes(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsNotes(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_Y) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsNotesPlus(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsNotesPlus(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_U) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsProbs(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsProbs(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_F) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsCV1(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsCV1(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_G) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsCV2(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsCV2(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_W) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->trackUp(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrigToParams();
+				mod->trackUp(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_S) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->trackDown(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
-				mod->updateTrigToParams();
+				mod->trackDown(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_A) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->nTrackLeft(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS,1);
-				mod->updateTrigToParams();
+				mod->nTrackLeft(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS,1);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_D) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->nTrackRight(getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS,1);
-				mod->updateTrigToParams();
+				mod->nTrackRight(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSELECT_PARAMS,1);
+				mod->endEdit();
 			}
 
 		}
@@ -1940,12 +1837,13 @@ struct trackOnOffBtn : LEDLightBezel<RedGreenBlueLight> {
 					}
 				}
 				else {
-					mod->nTracksAttibutes[mod->currentPattern][i].toggleTrackSolo();
-					mod->params[ZOUMAI::TRACKSONOFF_PARAMS+i].setValue(mod->nTracksAttibutes[mod->currentPattern][getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS].getTrackSolo() ? 2.0f : 0.0f);
+					PatternBlock &b = mod->beginEdit();
+					b.tracks[i].toggleTrackSolo();
+					mod->params[ZOUMAI::TRACKSONOFF_PARAMS+i].setValue(b.tracks[i].getTrackSolo() ? 2.0f : 0.0f);
+					mod->endEdit();
 					mod->params[ZOUMAI::TRACKSELECT_PARAMS+i].setValue(1.0f);
 					mod->currentTrack=i;
-					mod->updateTrackToParams();
-					mod->updateTrigToParams();
+					mod->paramsRefresh = true;
 				}
 			}
 			e.consume(this);
@@ -1953,12 +1851,14 @@ struct trackOnOffBtn : LEDLightBezel<RedGreenBlueLight> {
 		}
 		else if (e.button == GLFW_MOUSE_BUTTON_LEFT && e.action == GLFW_PRESS) {
 			if (!mod->solo) {
-				mod->nTracksAttibutes[mod->currentPattern][getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS].toggleTrackActive();
-				if (mod->nTracksAttibutes[mod->currentPattern][getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS].getTrackActive()) {
+				PatternBlock &b = mod->beginEdit();
+				b.tracks[getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS].toggleTrackActive();
+				if (b.tracks[getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS].getTrackActive()) {
 					mod->params[getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS].setValue(1.0f);
 				} else {
 					mod->params[getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS].setValue(0.0f);
 				}
+				mod->endEdit();
 			}
 			e.consume(this);
 			return;
@@ -1979,82 +1879,74 @@ struct trackOnOffBtn : LEDLightBezel<RedGreenBlueLight> {
 
 			if (e.key == GLFW_KEY_V) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->pasteTrack(mod->copyPatternId,mod->copyTrackId,mod->currentPattern,getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->pasteTrack(mod->beginEdit(), mod->copyPatternId,mod->copyTrackId,getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_E) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->trackInit(mod->currentPattern,getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->trackInit(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_R) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrack(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrack(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_T) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsNotes(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsNotes(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_Y) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsNotesPlus(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsNotesPlus(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_U) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsProbs(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsProbs(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_F) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsCV1(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsCV1(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_G) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizeTrackTrigsCV2(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizeTrackTrigsCV2(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_W) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->trackUp(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrigToParams();
+				mod->trackUp(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_S) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->trackDown(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
-				mod->updateTrigToParams();
+				mod->trackDown(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_A) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->nTrackLeft(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS,1);
-				mod->updateTrigToParams();
+				mod->nTrackLeft(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS,1);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_D) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->nTrackRight(getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS,1);
-				mod->updateTrigToParams();
+				mod->nTrackRight(mod->beginEdit(), getParamQuantity()->paramId - ZOUMAI::TRACKSONOFF_PARAMS,1);
+				mod->endEdit();
 			}
 
 		}
@@ -2072,14 +1964,16 @@ struct noteBtn : LEDLightBezel<RedGreenBlueLight> {
 	void onButton(const event::Button &e) override {
 		if (e.button == GLFW_MOUSE_BUTTON_LEFT && e.action == GLFW_PRESS) {
 			ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-			bool focused = mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].getTrigSemiTones() == getParamQuantity()->paramId - ZOUMAI::NOTE_PARAMS;
+			TrigAttibutes &trig = mod->beginEdit().trigs[mod->currentTrack][mod->currentTrig];
+			bool focused = trig.getTrigSemiTones() == getParamQuantity()->paramId - ZOUMAI::NOTE_PARAMS;
 			if (focused) {
-				mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].toggleTrigActive();
+				trig.toggleTrigActive();
 			}
 			else {
-				mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].setTrigSemiTones(getParamQuantity()->paramId - ZOUMAI::NOTE_PARAMS);
-				mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][mod->currentTrig].setTrigActive(true);
+				trig.setTrigSemiTones(getParamQuantity()->paramId - ZOUMAI::NOTE_PARAMS);
+				trig.setTrigActive(true);
 			}
+			mod->endEdit();
 			e.consume(this);
 			return;
 		}
@@ -2097,14 +1991,15 @@ struct stepBtn : LEDLightBezel<RedGreenBlueLight> {
 	void onButton(const event::Button &e) override {
 		if (getParamQuantity() && getParamQuantity()->module && e.action == GLFW_PRESS && e.button == GLFW_MOUSE_BUTTON_LEFT && (e.mods & RACK_MOD_MASK) == (GLFW_MOD_SHIFT)) {
 			ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-			mod->nTrigsAttibutes[mod->currentPattern][mod->currentTrack][getParamQuantity()->paramId - ZOUMAI::STEPS_PARAMS + mod->trigPage*16].toggleTrigActive();
+			mod->beginEdit().trigs[mod->currentTrack][getParamQuantity()->paramId - ZOUMAI::STEPS_PARAMS + mod->trigPage*16].toggleTrigActive();
+			mod->endEdit();
 			mod->currentTrig = getParamQuantity()->paramId - ZOUMAI::STEPS_PARAMS + mod->trigPage*16;
-			mod->updateTrigToParams();
+			mod->paramsRefresh = true;
 		}
 		else if (e.button == GLFW_MOUSE_BUTTON_LEFT && e.action == GLFW_PRESS) {
 			ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
 			mod->currentTrig = getParamQuantity()->paramId - ZOUMAI::STEPS_PARAMS + mod->trigPage*16;
-			mod->updateTrigToParams();
+			mod->paramsRefresh = true;
 		}
 
 		LEDLightBezel<RedGreenBlueLight>::onButton(e);
@@ -2125,53 +2020,53 @@ struct stepBtn : LEDLightBezel<RedGreenBlueLight> {
 			}
 
 			if (e.key == GLFW_KEY_V) {
-				mod->pasteTrig(mod->copyPatternId, mod->copyTrackId, mod->copyTrigId, mod->currentPattern, mod->currentTrack, trigId);
-				mod->updateTrigToParams();
+				mod->pasteTrig(mod->beginEdit(), mod->copyPatternId, mod->copyTrackId, mod->copyTrigId, mod->currentTrack, trigId);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_E) {
-				mod->trigInit(mod->currentPattern,mod->currentTrack, trigId);
-				mod->updateTrigToParams();
+				mod->trigInit(mod->beginEdit(), mod->currentTrack, trigId);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_R) {
-				mod->randomizeTrigNote(mod->currentTrack, trigId);
-				mod->updateTrigToParams();
+				mod->randomizeTrigNote(mod->beginEdit(), mod->currentTrack, trigId);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_T) {
-				mod->randomizeTrigNotePlus(mod->currentTrack, trigId);
-				mod->updateTrigToParams();
+				mod->randomizeTrigNotePlus(mod->beginEdit(), mod->currentTrack, trigId);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_Y) {
-				mod->randomizeTrigProb(mod->currentTrack, trigId);
-				mod->updateTrigToParams();
+				mod->randomizeTrigProb(mod->beginEdit(), mod->currentTrack, trigId);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_U) {
-				mod->fullRandomizeTrig(mod->currentTrack, trigId);
-				mod->updateTrigToParams();
+				mod->fullRandomizeTrig(mod->beginEdit(), mod->currentTrack, trigId);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_F) {
-				mod->randomizeTrigCV1(mod->currentTrack, trigId);
-				mod->updateTrigToParams();
+				mod->randomizeTrigCV1(mod->beginEdit(), mod->currentTrack, trigId);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_G) {
-				mod->randomizeTrigCV2(mod->currentTrack, trigId);
-				mod->updateTrigToParams();
+				mod->randomizeTrigCV2(mod->beginEdit(), mod->currentTrack, trigId);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_W) {
-				mod->trigUp(trigId);
-				mod->updateTrigToParams();
+				mod->trigUp(mod->beginEdit(), trigId);
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_S) {
-				mod->trigDown(trigId);
-				mod->updateTrigToParams();
+				mod->trigDown(mod->beginEdit(), trigId);
+				mod->endEdit();
 			}
 
 		}
@@ -2195,32 +2090,29 @@ struct zouPatternBtn : BidooRoundBlackSnapKnob {
 
 			if (e.key == GLFW_KEY_V) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->pastePattern();
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->pastePattern(mod->beginEdit());
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_E) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
+				PatternBlock &b = mod->beginEdit();
 				for (int i=0; i<8; i++) {
-					mod->trackInit(mod->currentPattern,i);
+					mod->trackInit(b,i);
 				}
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_R) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->randomizePattern();
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->randomizePattern(mod->beginEdit());
+				mod->endEdit();
 			}
 
 			if (e.key == GLFW_KEY_T) {
 				ZOUMAI *mod = static_cast<ZOUMAI*>(getParamQuantity()->module);
-				mod->fullRandomizePattern();
-				mod->updateTrackToParams();
-				mod->updateTrigToParams();
+				mod->fullRandomizePattern(mod->beginEdit());
+				mod->endEdit();
 			}
 		}
 		BidooRoundBlackSnapKnob::onHoverKey(e);
@@ -2256,37 +2148,39 @@ struct ZOUMAIDisplay : TransparentWidget {
 			nvgTextAlign(args.vg, NVG_ALIGN_CENTER);
 
 			if (module) {
+				std::lock_guard<std::mutex> guard(module->blocksMutex);
+				zoumaipattern::Pattern &pattern = *module->published[module->currentPattern].load();
 				sPatternHeader << "Pattern " + to_string(module->currentPattern + 1) + " : " + module->labels[module->currentTrack];
-				sSteps << module->nTracksAttibutes[module->currentPattern][module->currentTrack].getTrackLength();
-				sSpeed << fixed << setprecision(2) << module->nTracksAttibutes[module->currentPattern][module->currentTrack].getTrackSpeed();
-				sRead << displayReadMode(module->nTracksAttibutes[module->currentPattern][module->currentTrack].getTrackReadMode());
-				sRootNote << quantizer::rootNotes[module->rootNote[module->currentPattern][module->currentTrack]+1].label.c_str();
-				sScale << quantizer::scales[module->scale[module->currentPattern][module->currentTrack]].label.c_str();
-				sQuantizeCV1 << (module->quantizeCV1[module->currentPattern][module->currentTrack] == 0 ? "Free" : "Quant");
+				sSteps << pattern.tracks[module->currentTrack].getTrackLength();
+				sSpeed << fixed << setprecision(2) << pattern.tracks[module->currentTrack].getTrackSpeed();
+				sRead << displayReadMode(pattern.tracks[module->currentTrack].getTrackReadMode());
+				sRootNote << quantizer::rootNotes[pattern.rootNote[module->currentTrack]+1].label.c_str();
+				sScale << quantizer::scales[pattern.scale[module->currentTrack]].label.c_str();
+				sQuantizeCV1 << (pattern.quantizeCV1[module->currentTrack] == 0 ? "Free" : "Quant");
 
 				sTrigHeader << "Trig " + to_string(module->currentTrig + 1);
-				sLen << fixed << setprecision(2) << (float)module->trigLength[module->currentPattern][module->currentTrack][module->currentTrig];
-				sPuls << to_string(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigPulseCount()).c_str();
-				sDist << fixed << setprecision(2) << (float)module->trigPulseDistance[module->currentPattern][module->currentTrack][module->currentTrig];
-				sType << displayTrigType(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigType()).c_str();
-				sTrim << fixed << setprecision(2) << module->trigTrim[module->currentPattern][module->currentTrack][module->currentTrig];
-				sSlide << fixed << setprecision(2) << module->trigSlide[module->currentPattern][module->currentTrack][module->currentTrig];
-				//sVO << displayNote(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigSemiTones(), module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigOctave());
-				sCV1 << fixed << setprecision(2) << module->trigCV1[module->currentPattern][module->currentTrack][module->currentTrig];
-				sCV2 << fixed << setprecision(2) << module->trigCV2[module->currentPattern][module->currentTrack][module->currentTrig];
-				sProb << displayProba(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigProba());
-        sSlideType << (module->trigSlideType[module->currentPattern][module->currentTrack][module->currentTrig] ? "1" : "FULL");
+				sLen << fixed << setprecision(2) << (float)pattern.trigs[module->currentTrack][module->currentTrig].length;
+				sPuls << to_string(pattern.trigs[module->currentTrack][module->currentTrig].getTrigPulseCount()).c_str();
+				sDist << fixed << setprecision(2) << (float)pattern.trigs[module->currentTrack][module->currentTrig].pulseDistance;
+				sType << displayTrigType(pattern.trigs[module->currentTrack][module->currentTrig].getTrigType()).c_str();
+				sTrim << fixed << setprecision(2) << pattern.trigs[module->currentTrack][module->currentTrig].trim;
+				sSlide << fixed << setprecision(2) << pattern.trigs[module->currentTrack][module->currentTrig].slide;
+				//sVO << displayNote(pattern.trigs[module->currentTrack][module->currentTrig].getTrigSemiTones(), pattern.trigs[module->currentTrack][module->currentTrig].getTrigOctave());
+				sCV1 << fixed << setprecision(2) << pattern.trigs[module->currentTrack][module->currentTrig].cv1;
+				sCV2 << fixed << setprecision(2) << pattern.trigs[module->currentTrack][module->currentTrig].cv2;
+				sProb << displayProba(pattern.trigs[module->currentTrack][module->currentTrig].getTrigProba());
+        sSlideType << (pattern.trigs[module->currentTrack][module->currentTrig].getTrigSlideType() ? "1" : "FULL");
 
 				nvgFontSize(args.vg, 10.0f);
-				if (module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigProba() < 2)
+				if (pattern.trigs[module->currentTrack][module->currentTrig].getTrigProba() < 2)
 				{
 					nvgText(args.vg, portX1[3], portY0[6], "Val.", NULL);
-					nvgText(args.vg, portX1[3], portY0[7], to_string(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigCount()).c_str(), NULL);
+					nvgText(args.vg, portX1[3], portY0[7], to_string(pattern.trigs[module->currentTrack][module->currentTrig].getTrigCount()).c_str(), NULL);
 				}
-				if (module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigProba() == 1)
+				if (pattern.trigs[module->currentTrack][module->currentTrig].getTrigProba() == 1)
 				{
 					nvgText(args.vg, portX1[4], portY0[6], "Base", NULL);
-					nvgText(args.vg, portX1[4], portY0[7], to_string(module->nTrigsAttibutes[module->currentPattern][module->currentTrack][module->currentTrig].getTrigCountReset()).c_str(), NULL);
+					nvgText(args.vg, portX1[4], portY0[7], to_string(pattern.trigs[module->currentTrack][module->currentTrig].getTrigCountReset()).c_str(), NULL);
 				}
 			}
 			else {
@@ -2465,6 +2359,15 @@ struct BidooProbBlueKnob : BidooBlueSnapKnob {
 
 
 struct ZOUMAIWidget : BidooWidget {
+	// takes back the pattern blocks the audio thread replaced and keeps spare ones ready for it
+	void step() override {
+		ZOUMAI *zoumai = dynamic_cast<ZOUMAI*>(module);
+		if (zoumai) {
+			zoumai->patternsRecycle();
+		}
+		BidooWidget::step();
+	}
+
 	ZOUMAIWidget(ZOUMAI *module) {
 		setModule(module);
     prepareThemes(asset::plugin(pluginInstance, "res/ZOUMAI.svg"));
@@ -2591,8 +2494,8 @@ struct ZOUMAIWidget : BidooWidget {
 	struct ZouInitPageItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->pageInit(module->trigPage);
-			module->updateTrigToParams();
+			module->pageInit(module->beginEdit(), module->trigPage);
+			module->endEdit();
 		}
 	};
 
@@ -2610,56 +2513,56 @@ struct ZOUMAIWidget : BidooWidget {
 	struct ZouPastePageItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->pastePage(module->copyPageId, module->trigPage);
-			module->updateTrigToParams();
+			module->pastePage(module->beginEdit(), module->copyPageId, module->trigPage);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizePageTrigsNotesItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizePageTrigsNotes(module->trigPage);
-			module->updateTrigToParams();
+			module->randomizePageTrigsNotes(module->beginEdit(), module->trigPage);
+			module->endEdit();
 		}
 	};
 	
 	struct ZouRandomizePageTrigsNotesPlusItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizePageTrigsNotesPlus(module->trigPage);
-			module->updateTrigToParams();
+			module->randomizePageTrigsNotesPlus(module->beginEdit(), module->trigPage);
+			module->endEdit();
 		}
 	};
 	
 	struct ZouRandomizePageTrigsProbsItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizePageTrigsProbs(module->trigPage);
-			module->updateTrigToParams();
+			module->randomizePageTrigsProbs(module->beginEdit(), module->trigPage);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizePageTrigsCV1Item : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizePageTrigsCV1(module->trigPage);
-			module->updateTrigToParams();
+			module->randomizePageTrigsCV1(module->beginEdit(), module->trigPage);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizePageTrigsCV2Item : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizePageTrigsCV2(module->trigPage);
-			module->updateTrigToParams();
+			module->randomizePageTrigsCV2(module->beginEdit(), module->trigPage);
+			module->endEdit();
 		}
 	};
 
 	struct ZouInitTrigItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->trigInit(module->currentPattern,module->currentTrack, module->currentTrig);
-			module->updateTrigToParams();
+			module->trigInit(module->beginEdit(), module->currentTrack, module->currentTrig);
+			module->endEdit();
 		}
 	};
 
@@ -2678,72 +2581,72 @@ struct ZOUMAIWidget : BidooWidget {
 	struct ZouPasteTrigItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->pasteTrig(module->copyPatternId, module->copyTrackId, module->copyTrigId, module->currentPattern, module->currentTrack, module->currentTrig);
-			module->updateTrigToParams();
+			module->pasteTrig(module->beginEdit(), module->copyPatternId, module->copyTrackId, module->copyTrigId, module->currentTrack, module->currentTrig);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrigNoteItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrigNote(module->currentTrack, module->currentTrig);
-			module->updateTrigToParams();
+			module->randomizeTrigNote(module->beginEdit(), module->currentTrack, module->currentTrig);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrigNotePlusItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrigNotePlus(module->currentTrack, module->currentTrig);
-			module->updateTrigToParams();
+			module->randomizeTrigNotePlus(module->beginEdit(), module->currentTrack, module->currentTrig);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrigProbItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrigProb(module->currentTrack, module->currentTrig);
-			module->updateTrigToParams();
+			module->randomizeTrigProb(module->beginEdit(), module->currentTrack, module->currentTrig);
+			module->endEdit();
 		}
 	};
 
 	struct ZouFullRandomizeTrigItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->fullRandomizeTrig(module->currentTrack, module->currentTrig);
-			module->updateTrigToParams();
+			module->fullRandomizeTrig(module->beginEdit(), module->currentTrack, module->currentTrig);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrigCV1Item : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrigCV1(module->currentTrack, module->currentTrig);
-			module->updateTrigToParams();
+			module->randomizeTrigCV1(module->beginEdit(), module->currentTrack, module->currentTrig);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrigCV2Item : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrigCV2(module->currentTrack, module->currentTrig);
-			module->updateTrigToParams();
+			module->randomizeTrigCV2(module->beginEdit(), module->currentTrack, module->currentTrig);
+			module->endEdit();
 		}
 	};
 
 	struct ZouTrigUpItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->trigUp(module->currentTrig);
-			module->updateTrigToParams();
+			module->trigUp(module->beginEdit(), module->currentTrig);
+			module->endEdit();
 		}
 	};
 
 	struct ZouTrigDownItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->trigDown(module->currentTrig);
-			module->updateTrigToParams();
+			module->trigDown(module->beginEdit(), module->currentTrig);
+			module->endEdit();
 		}
 	};
 
@@ -2761,111 +2664,105 @@ struct ZOUMAIWidget : BidooWidget {
 	struct ZouPasteTrackItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->pasteTrack(module->copyPatternId, module->copyTrackId, module->currentPattern, module->currentTrack);
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->pasteTrack(module->beginEdit(), module->copyPatternId, module->copyTrackId, module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouInitTrackItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->trackInit(module->currentPattern, module->currentTrack);
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->trackInit(module->beginEdit(), module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrackItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrack(module->currentTrack);
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->randomizeTrack(module->beginEdit(), module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrackTrigsNotesItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrackTrigsNotes(module->currentTrack);
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->randomizeTrackTrigsNotes(module->beginEdit(), module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrackTrigsNotesPlusItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrackTrigsNotesPlus(module->currentTrack);
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->randomizeTrackTrigsNotesPlus(module->beginEdit(), module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrackTrigsProbsItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrackTrigsProbs(module->currentTrack);
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->randomizeTrackTrigsProbs(module->beginEdit(), module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrackTrigsCV1Item : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrackTrigsCV1(module->currentTrack);
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->randomizeTrackTrigsCV1(module->beginEdit(), module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizeTrackTrigsCV2Item : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizeTrackTrigsCV2(module->currentTrack);
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->randomizeTrackTrigsCV2(module->beginEdit(), module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouTrackSlideModeItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->slideMode[module->currentPattern][module->currentTrack] = !module->slideMode[module->currentPattern][module->currentTrack];
+			PatternBlock &b = module->beginEdit();
+			b.slideMode[module->currentTrack] = !b.slideMode[module->currentTrack];
+			module->endEdit();
 		}
 	};
 
 	struct ZouTrackUpItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->trackUp(module->currentTrack);
-			module->updateTrigToParams();
+			module->trackUp(module->beginEdit(), module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouTrackDownItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->trackDown(module->currentTrack);
-			module->updateTrigToParams();
+			module->trackDown(module->beginEdit(), module->currentTrack);
+			module->endEdit();
 		}
 	};
 
 	struct ZouTrackLeftItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->nTrackLeft(module->currentTrack,1);
-			module->updateTrigToParams();
+			module->nTrackLeft(module->beginEdit(), module->currentTrack,1);
+			module->endEdit();
 		}
 	};
 
 	struct ZouTrackRightItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->nTrackRight(module->currentTrack,1);
-			module->updateTrigToParams();
+			module->nTrackRight(module->beginEdit(), module->currentTrack,1);
+			module->endEdit();
 		}
 	};
 
@@ -2882,38 +2779,35 @@ struct ZOUMAIWidget : BidooWidget {
 	struct ZouPastePatternItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->pastePattern();
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->pastePattern(module->beginEdit());
+			module->endEdit();
 		}
 	};
 
 	struct ZouInitPatternItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
+			PatternBlock &b = module->beginEdit();
 			for (int i=0; i<8; i++) {
-				module->trackInit(module->currentPattern,i);
+				module->trackInit(b,i);
 			}
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->endEdit();
 		}
 	};
 
 	struct ZouRandomizePatternItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->randomizePattern();
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->randomizePattern(module->beginEdit());
+			module->endEdit();
 		}
 	};
 
 	struct ZouFullRandomizePatternItem : MenuItem {
 		ZOUMAI *module;
 		void onAction(const event::Action &e) override {
-			module->fullRandomizePattern();
-			module->updateTrackToParams();
-			module->updateTrigToParams();
+			module->fullRandomizePattern(module->beginEdit());
+			module->endEdit();
 		}
 	};
 
@@ -2965,7 +2859,7 @@ struct ZOUMAIWidget : BidooWidget {
 			}));
 
 			menu->addChild(createSubmenuItem("Track", "", [=](ui::Menu* menu) {
-				menu->addChild(construct<ZouTrackSlideModeItem>(&MenuItem::text, module->slideMode[module->currentPattern][module->currentTrack] ? "Slide time✓/rate const." : "Slide time/rate✓ const.", &ZouTrackSlideModeItem::module, module));
+				menu->addChild(construct<ZouTrackSlideModeItem>(&MenuItem::text, module->trackSlideMode() ? "Slide time✓/rate const." : "Slide time/rate✓ const.", &ZouTrackSlideModeItem::module, module));
 				menu->addChild(construct<ZouInitTrackItem>(&MenuItem::text, "Erase (over+E)", &ZouInitTrackItem::module, module));
 				menu->addChild(construct<ZouCopyTrackItem>(&MenuItem::text, "Copy (over+C)", &ZouCopyTrackItem::module, module));
 				menu->addChild(construct<ZouPasteTrackItem>(&MenuItem::text, "Paste (over+V)", &ZouPasteTrackItem::module, module));
@@ -1,6 +1,7 @@
 #include "plugin.hpp"
 #include "dsp/digital.hpp"
 #include "BidooComponents.hpp"
+#include "dep/zoumaimessage.hpp"
 
 struct ZOUMAIExpander : BidooModule {
 	enum ParamIds {
@@ -33,7 +34,16 @@ struct ZOUMAIExpander : BidooModule {
 		NUM_LIGHTS = TRSPTYPE_LIGHT + 8*3
 	};
 
-	float leftMessages[2][1] = {};
+	float leftMessages[2][zoumaimessage::backSize] = {};
+	float sent[8][zoumaimessage::trackFields] = {{0.0f}};
+	int seq = 0;
+	bool connected = false;
+	// build with -DZOUMAI_STATS to log the frames and tracks sent
+#ifdef ZOUMAI_STATS
+	unsigned long framesSent = 0;
+	unsigned long tracksSent = 0;
+	unsigned long framesSamples = 0;
+#endif
 
 	dsp::SchmittTrigger fillTrigger[8];
 	dsp::SchmittTrigger forceTrigger[8];
@@ -156,15 +166,17 @@ struct ZOUMAIExpander : BidooModule {
 	void process(const ProcessArgs &args) override {
 		if (leftExpander.module && (leftExpander.module->model == modelZOUMAI)) {
 			float *messagesFromZou = (float*)leftExpander.consumerMessage;
-			if (messagesFromZou[0] != currentPattern) {
-				currentPattern = messagesFromZou[0];
+			if (messagesFromZou[zoumaimessage::BACK_PATTERN] != currentPattern) {
+				currentPattern = messagesFromZou[zoumaimessage::BACK_PATTERN];
 				updateParams();
 			}
-			leftExpander.module->rightExpander.messageFlipRequested = true;
+			const bool full = !connected || (messagesFromZou[zoumaimessage::BACK_RESYNC] != 0.0f);
+			connected = true;
 
 			updateValues();
 
-			float *messagesToZou = (float*)leftExpander.module->rightExpander.producerMessage;
+			float payload[8][zoumaimessage::trackFields];
+			int dirty = full ? 0xFF : 0;
 			for (int i=0; i<8; i++) {
 				if (inputs[FILL_INPUT+i].isConnected()) {
 					if (((inputs[FILL_INPUT+i].getVoltage() > 0.0f) && !fills[i]) || ((inputs[FILL_INPUT+i].getVoltage() == 0.0f) && fills[i])) fills[i]=!fills[i];
@@ -172,7 +184,6 @@ struct ZOUMAIExpander : BidooModule {
 				if (fillTrigger[i].process(params[FILL_PARAM+i].getValue())) {
 					fills[i] = !fills[i];
 				}
-				messagesToZou[i]=fills[i];
 				lights[FILL_LIGHT+i*3+1].setBrightness(fills[i]?1.0f:0.0f);
 
 				if (inputs[FORCE_INPUT+i].isConnected()) {
@@ -181,7 +192,6 @@ struct ZOUMAIExpander : BidooModule {
 				if (forceTrigger[i].process(params[FORCE_PARAM+i].getValue())) {
 					forceTrigs[i] = !forceTrigs[i];
 				}
-				messagesToZou[i+8]=forceTrigs[i];
 				lights[FORCE_LIGHT+i*3+1].setBrightness(forceTrigs[i]?1.0f:0.0f);
 
 				if (inputs[KILL_INPUT+i].isConnected()) {
@@ -190,7 +200,6 @@ struct ZOUMAIExpander : BidooModule {
 				if (killTrigger[i].process(params[KILL_PARAM+i].getValue())) {
 					killTrigs[i] = !killTrigs[i];
 				}
-				messagesToZou[i+16]=killTrigs[i];
 				lights[KILL_LIGHT+i*3+1].setBrightness(killTrigs[i]?1.0f:0.0f);
 
 				if (trspTypeTrigger[i].process(params[TRSPTYPE_PARAM+i].getValue())) {
@@ -204,22 +213,63 @@ struct ZOUMAIExpander : BidooModule {
 				lights[TRSPTYPE_LIGHT+i*3+1].setBrightness(trspType[i] == 1.0f ? 0.0f : 1.0f);
 				lights[TRSPTYPE_LIGHT+i*3+2].setBrightness(trspType[i] == 1.0f ? 1.0f : 0.0f);
 
-				if (inputs[TRSP_INPUT+i].isConnected()) {
-					messagesToZou[i+24]=inputs[TRSP_INPUT+i].getVoltage()/trspType[i];
-				}
-				else {
-					messagesToZou[i+24]=0.0f;
+				float *track = payload[i];
+				track[zoumaimessage::TRACK_SWITCHES] = (fills[i] ? zoumaimessage::switchFill : 0) | (forceTrigs[i] ? zoumaimessage::switchForce : 0) | (killTrigs[i] ? zoumaimessage::switchKill : 0);
+				track[zoumaimessage::TRACK_TRSP] = inputs[TRSP_INPUT+i].isConnected() ? inputs[TRSP_INPUT+i].getVoltage()/trspType[i] : 0.0f;
+				track[zoumaimessage::TRACK_DICE] = clamp(rescale(inputs[DICE_INPUT+i].getVoltage(),-10.0f,10.0f,-1.0f,1.0f) + params[DICE_PARAM+i].getValue(),-1.0f,1.0f);
+				track[zoumaimessage::TRACK_ROTLEFT] = rotLeftTrigger[i].process(inputs[ROTLEFT_INPUT+i].getVoltage()) ? params[ROTSHIFT_PARAM+i].getValue() : 0.0f;
+				track[zoumaimessage::TRACK_ROTRIGHT] = rotRightTrigger[i].process(inputs[ROTRIGHT_INPUT+i].getVoltage()) ? params[ROTSHIFT_PARAM+i].getValue() : 0.0f;
+				track[zoumaimessage::TRACK_ROTLEN] = params[ROTLEN_PARAM+i].getValue();
+
+				// rotations are events, remembered as 0 so that only a new trigger makes the track dirty
+				for (int j=0; j<zoumaimessage::trackFields; j++) {
+					if (track[j] != sent[i][j]) {
+						dirty |= 1 << i;
+						break;
+					}
 				}
+			}
 
-				messagesToZou[i+32]=clamp(rescale(inputs[DICE_INPUT+i].getVoltage(),-10.0f,10.0f,-1.0f,1.0f) + params[DICE_PARAM+i].getValue(),-1.0f,1.0f);
-
-				messagesToZou[i+40]=rotLeftTrigger[i].process(inputs[ROTLEFT_INPUT+i].getVoltage()) ? params[ROTSHIFT_PARAM+i].getValue() : 0.0f;
-
-				messagesToZou[i+48]=rotRightTrigger[i].process(inputs[ROTRIGHT_INPUT+i].getVoltage()) ? params[ROTSHIFT_PARAM+i].getValue() : 0.0f;
-
-				messagesToZou[i+56]=params[ROTLEN_PARAM+i].getValue();
+			if (dirty) {
+				float *messagesToZou = (float*)leftExpander.module->rightExpander.producerMessage;
+				seq = (seq + 1) % zoumaimessage::seqModulo;
+				messagesToZou[zoumaimessage::VERSION] = zoumaimessage::version;
+				messagesToZou[zoumaimessage::SEQ] = seq;
+				messagesToZou[zoumaimessage::FLAGS] = full ? zoumaimessage::flagFull : 0;
+				messagesToZou[zoumaimessage::DIRTY] = dirty;
+				float *track = messagesToZou + zoumaimessage::headerSize;
+				for (int i=0; i<8; i++) {
+					if (!(dirty & (1 << i))) continue;
+					for (int j=0; j<zoumaimessage::trackFields; j++) {
+						track[j] = payload[i][j];
+						sent[i][j] = payload[i][j];
+					}
+					sent[i][zoumaimessage::TRACK_ROTLEFT] = 0.0f;
+					sent[i][zoumaimessage::TRACK_ROTRIGHT] = 0.0f;
+					track += zoumaimessage::trackFields;
+#ifdef ZOUMAI_STATS
+					tracksSent++;
+#endif
+				}
+				leftExpander.module->rightExpander.messageFlipRequested = true;
+#ifdef ZOUMAI_STATS
+				framesSent++;
+#endif
 			}
 		}
+		else {
+			connected = false;
+		}
+
+#ifdef ZOUMAI_STATS
+		// a full 64 floats frame used to be sent on every sample
+		if (++framesSamples >= args.sampleRate) {
+			DEBUG("ZOUMAI expander frames/s : %lu, tracks/s : %lu (per sample frames : %lu)", framesSent, tracksSent, framesSamples);
+			framesSent = 0;
+			tracksSent = 0;
+			framesSamples = 0;
+		}
+#endif
 	}
 
 };
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace chunk {
+
+  // Little-endian binary chunk helpers used to store module data as a single
+  // base64 string in the patch instead of thousands of json objects.
+  // Layout : magic (u32), version (u16), reserved (u16), payload, FNV-1a 32 checksum of
+  // everything before it (u32).
+
+  static const size_t headerSize = 8;
+  static const size_t checksumSize = 4;
+
+  static inline uint32_t checksum(const uint8_t *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= data[i];
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  struct Writer {
+    std::vector<uint8_t> data;
+
+    // reserve is the expected payload size
+    Writer(const uint32_t magic, const uint16_t version, const size_t reserve = 0) {
+      data.reserve(headerSize + reserve + checksumSize);
+      u32(magic);
+      u16(version);
+      u16(0);
+    }
+
+    void u8(const uint8_t v) {
+      data.push_back(v);
+    }
+
+    void u16(const uint16_t v) {
+      data.push_back(v & 0xFF);
+      data.push_back((v >> 8) & 0xFF);
+    }
+
+    void u32(const uint32_t v) {
+      data.push_back(v & 0xFF);
+      data.push_back((v >> 8) & 0xFF);
+      data.push_back((v >> 16) & 0xFF);
+      data.push_back((v >> 24) & 0xFF);
+    }
+
+    void f32(const float v) {
+      uint32_t bits;
+      memcpy(&bits, &v, sizeof(bits));
+      u32(bits);
+    }
+
+    // appends the checksum, call once when done
+    const std::vector<uint8_t> &finish() {
+      u32(checksum(data.data(), data.size()));
+      return data;
+    }
+  };
+
+  struct Reader {
+    const uint8_t *data;
+    size_t size;
+    size_t pos = 0;
+    uint16_t version = 0;
+    bool valid = false;
+
+    // checks size, magic and checksum, version is left to the caller
+    Reader(const std::vector<uint8_t> &buffer, const uint32_t magic) : data(buffer.data()), size(buffer.size()) {
+      if (size < headerSize + checksumSize) return;
+      const size_t payloadEnd = size - checksumSize;
+      pos = payloadEnd;
+      const uint32_t expected = u32();
+      if (checksum(data, payloadEnd) != expected) return;
+      pos = 0;
+      size = payloadEnd;
+      if (u32() != magic) return;
+      version = u16();
+      u16();
+      valid = true;
+    }
+
+    // false once a read went past the end of the payload
+    bool ok() const {
+      return valid && (pos <= size);
+    }
+
+    uint8_t u8() {
+      if (pos + 1 > size) { pos = size + 1; return 0; }
+      return data[pos++];
+    }
+
+    uint16_t u16() {
+      if (pos + 2 > size) { pos = size + 1; return 0; }
+      uint16_t v = data[pos] | (data[pos+1] << 8);
+      pos += 2;
+      return v;
+    }
+
+    uint32_t u32() {
+      if (pos + 4 > size) { pos = size + 1; return 0; }
+      uint32_t v = (uint32_t)data[pos] | ((uint32_t)data[pos+1] << 8) | ((uint32_t)data[pos+2] << 16) | ((uint32_t)data[pos+3] << 24);
+      pos += 4;
+      return v;
+    }
+
+    float f32() {
+      uint32_t bits = u32();
+      float v;
+      memcpy(&v, &bits, sizeof(v));
+      return v;
+    }
+  };
+
+}
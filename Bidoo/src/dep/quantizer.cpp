@@ -3,69 +3,112 @@
 
 namespace quantizer {
 
-  Quantizer::Quantizer() {
+  static Table *sharedTable = nullptr;
+  static int sharedCount = 0;
+
+  static Table *buildTable() {
+    Table *t = new Table();
     for (int l=0; l<12; l++) {
       for(int i=0; i<numScales; i++) {
+        int firstSemitone = 0;
         int index = 0;
         for (int j=0; j<11; j++) {
           for (int k=0; k<scales[i].numNotes;k++) {
             float pitch = -5.f + l/12.0f + j + scales[i].intervals[k]/12.0f;
             if ((pitch>=-4.0f) && (pitch<=6.0f)) {
-              map[l][i][index]=pitch;
+              if (index == 0) {
+                t->firstRank[l][i] = j * scales[i].numNotes;
+                firstSemitone = l + scales[i].intervals[k];
+              }
+              t->map[l][i][index]=pitch;
               index++;
             }
           }
         }
+        for (int pc=0; pc<12; pc++) {
+          int count = 0;
+          for (int k=0; k<scales[i].numNotes;k++) {
+            if ((l + scales[i].intervals[k]) % 12 <= pc) count++;
+          }
+          t->rank[l][i][pc] = count;
+        }
+        if (scales[i].numNotes > 0) {
+          t->firstRank[l][i] += (firstSemitone/12) * scales[i].numNotes + t->rank[l][i][firstSemitone%12];
+        }
       }
     }
+    return t;
   }
 
-  std::tuple<float, int> getNearest(float x, float y, float target, int lower, int upper) {
-    if (target - x >= y - target)
-    {
-      return std::make_tuple(y,upper);
+  Quantizer::Quantizer() {
+    if (sharedCount++ == 0) {
+      sharedTable = buildTable();
     }
-    else
-    {
-      return std::make_tuple(x,lower);
+    table = sharedTable;
+  }
+
+  Quantizer::~Quantizer() {
+    if (--sharedCount == 0) {
+      delete sharedTable;
+      sharedTable = nullptr;
     }
   }
 
-  std::tuple<float, int> getNearestElement(float arr[], int n, float target) {
-   if (target <= arr[0]) {
-     return std::make_tuple(arr[0],0);
-   }
+  // index of the scale note at or below voltsIn, using the pitch class ranks instead of
+  // searching map, clamped so that index+1 is still in map
+  static inline int lowerIndex(const Table *t, const int rootNote, const int scale, const float voltsIn) {
+    const int n = scales[scale].numNotes*10;
+    const int semitone = (int)rack::math::clamp((voltsIn + 5.0f) * 12.0f, 0.0f, 131.0f);
+    const int index = (semitone/12) * scales[scale].numNotes + t->rank[rootNote][scale][semitone%12] - t->firstRank[rootNote][scale];
+    return index < 0 ? 0 : (index > n-2 ? n-2 : index);
+  }
 
-   if (target >= arr[n - 1]) {
-     return std::make_tuple(arr[n - 1],n-1);
-   }
+  // same result as a nearest search over the n first map values, ties go up
+  static inline std::tuple<float, int> getNearestElement(const Table *t, const int rootNote, const int scale, const float target) {
+    const float *arr = t->map[rootNote][scale];
+    const int n = scales[scale].numNotes*10;
+    if (target <= arr[0]) {
+      return std::make_tuple(arr[0],0);
+    }
 
-   int left = 0, right = n, mid = 0;
-   while (left < right) {
-      mid = (left + right) / 2;
-      if (arr[mid] == target) {
-        return std::make_tuple(arr[mid],mid);
-      }
+    if (target >= arr[n - 1]) {
+      return std::make_tuple(arr[n - 1],n-1);
+    }
 
-      if (target < arr[mid]) {
-        if ((mid > 0) && (target > arr[mid - 1])) {
-          return getNearest(arr[mid - 1], arr[mid], target, mid-1, mid);
-        }
-        right = mid;
-      }
-      else
-      {
-       if ((mid < n - 1) && (target < arr[mid + 1])) {
-         return getNearest(arr[mid], arr[mid + 1], target, mid, mid+1);
-       }
-       left = mid + 1;
-      }
-   }
-   return std::make_tuple(arr[mid],mid);
+    const int lower = lowerIndex(t, rootNote, scale, target);
+    if (target - arr[lower] >= arr[lower+1] - target) {
+      return std::make_tuple(arr[lower+1],lower+1);
+    }
+    return std::make_tuple(arr[lower],lower);
+  }
+
+  // map indices as floats, exact in this range, to stay with float_4 selects
+  static inline rack::simd::float_4 getNearestIndex(const Table *t, const int rootNote, const int scale, const rack::simd::float_4 target) {
+    const float *arr = t->map[rootNote][scale];
+    const int n = scales[scale].numNotes*10;
+    rack::simd::float_4 lower, x, y;
+    for (int c=0; c<4; c++) {
+      const int i = lowerIndex(t, rootNote, scale, target[c]);
+      lower[c] = i;
+      x[c] = arr[i];
+      y[c] = arr[i+1];
+    }
+    rack::simd::float_4 index = rack::simd::ifelse(target - x >= y - target, lower + 1.0f, lower);
+    index = rack::simd::ifelse(target >= arr[n - 1], rack::simd::float_4(n - 1), index);
+    return rack::simd::ifelse(target <= arr[0], rack::simd::float_4(0.0f), index);
+  }
+
+  static inline rack::simd::float_4 gather(const float *arr, const rack::simd::float_4 index, const int offset, const int n) {
+    rack::simd::float_4 result;
+    for (int c=0; c<4; c++) {
+      const int i = (int)index[c] + offset;
+      result[c] = arr[i > n ? n : i];
+    }
+    return result;
   }
 
   std::tuple<float, int> Quantizer::quantize(float voltsIn) {
-    return getNearestElement(map[0][26], scales[26].numNotes*10, voltsIn);
+    return getNearestElement(table, 0, 26, voltsIn);
   }
 
   std::string Quantizer::noteName(float voltsIn) {
@@ -94,8 +137,18 @@ namespace quantizer {
       return Quantizer::quantize(voltsIn);
     }
     else {
-      return getNearestElement(map[rootNote][scale], scales[scale].numNotes*10, voltsIn);
+      return getNearestElement(table, rootNote, scale, voltsIn);
+    }
+  }
+
+  rack::simd::float_4 Quantizer::closestVoltageInScale(const rack::simd::float_4 voltsIn, const int rootNote, const int scale) {
+    if (scale == 0) {
+      return voltsIn;
     }
+    const int l = rootNote == -1 ? 0 : rootNote;
+    const int s = rootNote == -1 ? 26 : scale;
+    const rack::simd::float_4 index = getNearestIndex(table, l, s, voltsIn);
+    return gather(table->map[l][s], index, 0, scales[s].numNotes*10);
   }
 
   Chord Quantizer::closestChordInScale(float voltsIn, int rootNote, int scale) {
@@ -124,14 +177,49 @@ namespace quantizer {
     else {
       float pitch;
       int index;
-      std::tie(pitch, index) = getNearestElement(map[rootNote][scale], scales[scale].numNotes*10, voltsIn);
+      std::tie(pitch, index) = getNearestElement(table, rootNote, scale, voltsIn);
       result.tonic = pitch;
-      result.third = map[rootNote][scale][rack::math::clamp(index+2,0,scales[scale].numNotes*10)];
-      result.fifth = map[rootNote][scale][rack::math::clamp(index+4,0,scales[scale].numNotes*10)];
-      result.seventh = map[rootNote][scale][rack::math::clamp(index+6,0,scales[scale].numNotes*10)];
-      result.ninth = map[rootNote][scale][rack::math::clamp(index+8,0,scales[scale].numNotes*10)];
-      result.eleventh = map[rootNote][scale][rack::math::clamp(index+10,0,scales[scale].numNotes*10)];
-      result.thirteenth = map[rootNote][scale][rack::math::clamp(index+12,0,scales[scale].numNotes*10)];
+      result.third = table->map[rootNote][scale][rack::math::clamp(index+2,0,scales[scale].numNotes*10)];
+      result.fifth = table->map[rootNote][scale][rack::math::clamp(index+4,0,scales[scale].numNotes*10)];
+      result.seventh = table->map[rootNote][scale][rack::math::clamp(index+6,0,scales[scale].numNotes*10)];
+      result.ninth = table->map[rootNote][scale][rack::math::clamp(index+8,0,scales[scale].numNotes*10)];
+      result.eleventh = table->map[rootNote][scale][rack::math::clamp(index+10,0,scales[scale].numNotes*10)];
+      result.thirteenth = table->map[rootNote][scale][rack::math::clamp(index+12,0,scales[scale].numNotes*10)];
+    }
+    return result;
+  }
+
+  Chord4 Quantizer::closestChordInScale(const rack::simd::float_4 voltsIn, const int rootNote, const int scale) {
+    Chord4 result;
+    if (scale == 0) {
+      result.tonic = voltsIn;
+      result.third = voltsIn;
+      result.fifth = voltsIn;
+      result.seventh = voltsIn;
+      result.ninth = voltsIn;
+      result.eleventh = voltsIn;
+      result.thirteenth = voltsIn;
+    }
+    else if (rootNote==-1) {
+      result.tonic = closestVoltageInScale(voltsIn, rootNote, scale);
+      result.third = result.tonic;
+      result.fifth = result.tonic;
+      result.seventh = result.tonic;
+      result.ninth = result.tonic;
+      result.eleventh = result.tonic;
+      result.thirteenth = result.tonic;
+    }
+    else {
+      const float *arr = table->map[rootNote][scale];
+      const int n = scales[scale].numNotes*10;
+      const rack::simd::float_4 index = getNearestIndex(table, rootNote, scale, voltsIn);
+      result.tonic = gather(arr, index, 0, n);
+      result.third = gather(arr, index, 2, n);
+      result.fifth = gather(arr, index, 4, n);
+      result.seventh = gather(arr, index, 6, n);
+      result.ninth = gather(arr, index, 8, n);
+      result.eleventh = gather(arr, index, 10, n);
+      result.thirteenth = gather(arr, index, 12, n);
     }
     return result;
   }
@@ -96,11 +96,34 @@ namespace quantizer {
   };
 
 
+  struct Chord4 {
+    rack::simd::float_4 tonic;
+    rack::simd::float_4 third;
+    rack::simd::float_4 fifth;
+    rack::simd::float_4 seventh;
+    rack::simd::float_4 ninth;
+    rack::simd::float_4 eleventh;
+    rack::simd::float_4 thirteenth;
+  };
+
+  // Every root/scale map, built by the first Quantizer alive and freed with the last one.
+  // Instances are created and destroyed from the UI thread.
+  // rank counts the scale notes up to each pitch class so a voltage maps straight to
+  // its two neighbours in map, firstRank is the rank of map[..][..][0].
+  struct Table {
+    float map[12][numScales][121];
+    int8_t rank[12][numScales][12];
+    int16_t firstRank[12][numScales];
+  };
+
   struct Quantizer {
 
-    float map[12][numScales][121] = {{{0.0f}}};
+    const Table *table;
 
     Quantizer();
+    ~Quantizer();
+    Quantizer(const Quantizer&) = delete;
+    Quantizer& operator=(const Quantizer&) = delete;
 
     std::tuple<float, int> quantize(float voltsIn);
 
@@ -110,8 +133,12 @@ namespace quantizer {
 
     std::tuple<float, int> closestVoltageInScale(const float inVolts, const int rootNote, const int scale);
 
+    rack::simd::float_4 closestVoltageInScale(const rack::simd::float_4 inVolts, const int rootNote, const int scale);
+
     Chord closestChordInScale(const float inVolts, const int rootNote, const int scale);
 
+    Chord4 closestChordInScale(const rack::simd::float_4 inVolts, const int rootNote, const int scale);
+
   };
 
 }
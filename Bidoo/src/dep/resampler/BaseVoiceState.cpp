@@ -64,6 +64,7 @@ BaseVoiceState::BaseVoiceState ()
 ,	_table_len (0)
 ,	_table (0)
 ,	_ovrspl_flag (true)
+,	_reverse_flag (false)
 {
 	_pos._all  = 0;
 	_step._all = static_cast <Int64> (0x80000000UL);
@@ -81,6 +82,7 @@ BaseVoiceState &	BaseVoiceState::operator = (const BaseVoiceState &other)
 	_table_len   = other._table_len;
 	_table       = other._table;
 	_ovrspl_flag = other._ovrspl_flag;
+	_reverse_flag = other._reverse_flag;
 
 	return (*this);
 }
@@ -119,6 +121,11 @@ void	BaseVoiceState::compute_step (long pitch)
 	));
 	assert (_step._all >= static_cast <Int64> (1UL << 31));
 	_step._all = shift_bidi (_step._all, shift);
+
+	if (_reverse_flag)
+	{
+		_step._all = -_step._all;
+	}
 }
 
 
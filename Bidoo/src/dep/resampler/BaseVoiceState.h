@@ -69,6 +69,7 @@ public:
 	long				_table_len;
 	int				_table;
 	bool				_ovrspl_flag;
+	bool				_reverse_flag;	// Step is negated, the table is read backward
 
 
 
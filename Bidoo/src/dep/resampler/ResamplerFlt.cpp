@@ -78,6 +78,7 @@ ResamplerFlt::ResamplerFlt ()
 ,	_fade_flag (false)
 ,	_fade_needed_flag (false)
 ,	_can_use_flag (false)
+,	_reverse_flag (false)
 {
 	_dwnspl.set_coefs (_dwnspl_coef_arr);
 	_buf.resize (_buf_len * 2);
@@ -265,12 +266,59 @@ Int64	ResamplerFlt::get_playback_pos () const
 
 
 
+/*
+==============================================================================
+Name: set_reverse
+Description:
+	Set the reading direction. When reversed, the playback position decreases
+	by the step given by the pitch, so a single MipMapFlt serves both
+	directions. Position is kept, change is immediate, without crossfading.
+	Can be called before set_sample().
+Input parameters:
+	- reverse_flag: true to read the sample backward.
+Throws: Nothing
+==============================================================================
+*/
+
+void	ResamplerFlt::set_reverse (bool reverse_flag)
+{
+	_reverse_flag = reverse_flag;
+
+	for (int voice = 0; voice < VoiceInfo_NBR_ELT; ++voice)
+	{
+		BaseVoiceState &	voc = _voice_arr [voice];
+		if (voc._reverse_flag != reverse_flag)
+		{
+			voc._reverse_flag = reverse_flag;
+			voc._step._all = -voc._step._all;
+		}
+	}
+}
+
+
+
+/*
+==============================================================================
+Name: is_reverse
+Returns: true if the sample is read backward.
+Throws: Nothing
+==============================================================================
+*/
+
+bool	ResamplerFlt::is_reverse () const
+{
+	return (_reverse_flag);
+}
+
+
+
 /*
 ==============================================================================
 Name: interpolate_block
 Description:
 	Generates a block of resampled data. Care must be taken in order no to let
-	the playback position overtake the sample length. Except during MIP-map
+	the playback position overtake the sample length, or go below 0 when
+	reading backward. Except during MIP-map
 	crossfading, CPU load per output sample is roughly constant and not
 	dependent on the resampling ratio.
 Input parameters:
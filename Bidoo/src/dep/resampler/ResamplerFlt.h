@@ -21,7 +21,8 @@ This is the "ready to use" class for sample interpolation. How to proceed:
 
 7. Optionally specify a playback position.
 
-8. Generate a block of interpolated data.
+8. Generate a block of interpolated data. Call set_reverse() to read the
+   sample backward from the current position, using the same MipMapFlt.
 
 9. You can go back to either 5, 6, 7 or 8.
 
@@ -29,8 +30,9 @@ Instance of this class can be assimilated to a "voice", a single unit of
 monophonic sound generation. You can change the sample each time it is
 needed, making it handy for polyponic synthesiser implementation.
 
-In any case, NEVER EVER let the playback position exceed the sample length.
-Check the current position and pitch before generating a new block.
+In any case, NEVER EVER let the playback position exceed the sample length,
+nor go below 0 when reading backward. Check the current position and pitch
+before generating a new block.
 
 --- Legal stuff ---
 
@@ -105,6 +107,9 @@ public:
 	void				set_playback_pos (Int64 pos);
 	Int64				get_playback_pos () const;
 
+	void				set_reverse (bool reverse_flag);
+	bool				is_reverse () const;
+
 	void				interpolate_block (float dest_ptr [], long nbr_spl);
 	void				clear_buffers ();
 
@@ -151,6 +156,7 @@ private:
 	bool				_fade_flag;
 	bool				_fade_needed_flag;
 	bool				_can_use_flag;
+	bool				_reverse_flag;
 
 	static const double
 						_dwnspl_coef_arr [Downsampler2Flt::NBR_COEFS];
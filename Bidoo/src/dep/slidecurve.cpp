@@ -0,0 +1,51 @@
+#include "slidecurve.hpp"
+#include <cmath>
+
+namespace slidecurve {
+
+  static Table *sharedTable = nullptr;
+  static int sharedCount = 0;
+
+  static Table *buildTable() {
+    Table *t = new Table;
+    for (int i=0; i<numCurves; i++) {
+      for (int j=0; j<=headPoints; j++) {
+        t->head[i][j] = powf(j*gridStep, i*0.01f);
+      }
+      for (int j=0; j<=tailPoints; j++) {
+        float u = (float)j/tailPoints;
+        t->tail[i][j] = powf(u*u*u, i*0.01f);
+      }
+    }
+    return t;
+  }
+
+  SlideCurve::SlideCurve() {
+    if (sharedCount++ == 0) {
+      sharedTable = buildTable();
+    }
+    table = sharedTable;
+  }
+
+  SlideCurve::~SlideCurve() {
+    if (--sharedCount == 0) {
+      delete sharedTable;
+      sharedTable = nullptr;
+    }
+  }
+
+  float SlideCurve::shape(const int curve, const float x) const {
+    const int c = curve < 0 ? 0 : (curve >= numCurves ? numCurves-1 : curve);
+    const float xc = x < 0.0f ? 0.0f : (x > gridMax ? gridMax : x);
+    if (xc < headPoints) {
+      const int xi = (int)xc;
+      const float xf = xc - xi;
+      return table->head[c][xi] + (table->head[c][xi+1] - table->head[c][xi]) * xf;
+    }
+    const float u = cbrtf(xc*gridStep) * tailPoints;
+    const int ui = u >= tailPoints ? tailPoints - 1 : (int)u;
+    const float uf = u - ui;
+    return table->tail[c][ui] + (table->tail[c][ui+1] - table->tail[c][ui]) * uf;
+  }
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace slidecurve {
+
+  // Slide curves y = x^(curve/100), curve in [0, 99], looked up the same way the
+  // former per-module powTable[100][10000] was : shape(curve, 9999*phase).
+  //
+  // The first headPoints steps of the former 1e-4 grid are kept verbatim (that is
+  // where low exponents are steep), the rest is sampled on a cube root axis.
+  // Against the former table the absolute error is below 6e-5 of the slide
+  // interval for every curve and phase, for ~58KB shared by all instances
+  // instead of 4MB per instance.
+
+  static constexpr int numCurves = 100;
+  static constexpr int headPoints = 16;
+  static constexpr int tailPoints = 128;
+  static constexpr float gridStep = 0.0001f;
+  static constexpr float gridMax = 9999.0f;
+
+  struct Table {
+    float head[numCurves][headPoints + 1];
+    float tail[numCurves][tailPoints + 1];
+  };
+
+  // Reference counted, built by the first SlideCurve alive and freed with the last one.
+  // Instances are created and destroyed from the UI thread.
+  struct SlideCurve {
+    const Table *table;
+
+    SlideCurve();
+    ~SlideCurve();
+    SlideCurve(const SlideCurve&) = delete;
+    SlideCurve& operator=(const SlideCurve&) = delete;
+
+    // x is the position on the former 10000 points grid, in [0, 9999]
+    float shape(const int curve, const float x) const;
+  };
+
+}
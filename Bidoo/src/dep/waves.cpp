@@ -1,174 +1,855 @@
-#include "waves.hpp"
-#include "AudioFile/AudioFile.h"
-#define DR_WAV_IMPLEMENTATION
-#include "dr_wav/dr_wav.h"
-#include <dsp/resampler.hpp>
-
-namespace waves {
-
-  std::vector<rack::dsp::Frame<1>> getMonoWav(const std::string path, const float currentSampleRate, std::string &waveFileName, std::string &waveExtension, int &sampleChannels, int &sampleRate, int &sampleCount) {
-    waveFileName = rack::system::getFilename(path);
-    waveExtension = rack::system::getExtension(waveFileName);
-    std::vector<rack::dsp::Frame<1>> result;
-    if (rack::string::uppercase(waveExtension) == ".WAV") {
-      unsigned int c;
-      unsigned int sr;
-      drwav_uint64 sc;
-      float* pSampleData;
-      pSampleData = drwav_open_file_and_read_pcm_frames_f32(path.c_str(), &c, &sr, &sc, NULL);
-      if (pSampleData != NULL)  {
-        sampleChannels = c;
-        sampleRate = sr;
-        for (long long unsigned int i=0; i < sc; i = i + c) {
-          rack::dsp::Frame<1> frame;
-          if (sampleChannels == 2) {
-            frame.samples[0] = (pSampleData[i] + pSampleData[i+1])/2.0f;
-          }
-          else {
-            frame.samples[0] = pSampleData[i];
-          }
-          result.push_back(frame);
-        }
-        sampleCount = sc/c;
-        drwav_free(pSampleData, NULL);
-      }
-    }
-    else if (rack::string::uppercase(waveExtension) == ".AIFF") {
-      AudioFile<float> audioFile;
-      if (audioFile.load (path.c_str()))  {
-        sampleChannels = audioFile.getNumChannels();
-        sampleRate = audioFile.getSampleRate();
-        sampleCount = audioFile.getNumSamplesPerChannel();
-        for (int i=0; i < sampleCount; i++) {
-          rack::dsp::Frame<1> frame;
-          if (sampleChannels == 2) {
-            frame.samples[0] = (audioFile.samples[0][i] + audioFile.samples[1][i])/2.0f;
-          }
-          else {
-            frame.samples[0] = audioFile.samples[0][i];
-          }
-          result.push_back(frame);
-        }
-      }
-    }
-
-    if ((sampleRate != currentSampleRate) && (sampleCount>0)) {
-      rack::dsp::SampleRateConverter<1> conv;
-      conv.setRates(sampleRate, currentSampleRate);
-      conv.setQuality(SPEEX_RESAMPLER_QUALITY_DESKTOP);
-      
-      // Calculate output buffer size based on ratio of sample rates with some extra padding
-      int outCount = ceil(sampleCount * (currentSampleRate / (float)sampleRate) * 1.5);
-      std::vector<rack::dsp::Frame<1>> subResult(outCount);
-      
-      // Process the conversion
-      conv.process(&result[0], &sampleCount, &subResult[0], &outCount);
-      subResult.resize(outCount); // Resize to actual size used
-      sampleCount = outCount;
-      return subResult;
-    }
-
-    return result;
-  }
-
-  std::vector<rack::dsp::Frame<2>> getStereoWav(const std::string path, const float currentSampleRate, std::string &waveFileName, std::string &waveExtension, int &sampleChannels, int &sampleRate, int &sampleCount) {
-    waveFileName = rack::system::getFilename(path);
-    waveExtension = rack::system::getExtension(waveFileName);
-    std::vector<rack::dsp::Frame<2>> result;
-
-    // Convert extension to uppercase for comparison
-    std::string upperExt = rack::string::uppercase(waveExtension);
-    
-    // Check if extension is supported
-    if (upperExt != ".WAV" && upperExt != ".AIFF") {
-        // Return empty buffer for unsupported format
-        sampleChannels = 0;
-        sampleRate = 0;
-        sampleCount = 0;
-        return result;
-    }
-
-    if (upperExt == ".WAV") {
-      unsigned int c;
-      unsigned int sr;
-      drwav_uint64 sc;
-      float* pSampleData;
-      pSampleData = drwav_open_file_and_read_pcm_frames_f32(path.c_str(), &c, &sr, &sc, NULL);
-      if (pSampleData != NULL)  {
-        sampleChannels = c;
-        sampleRate = sr;
-        sc = 2 * sc;
-        for (long long unsigned int i=0; i < sc; i = i + c) {
-          rack::dsp::Frame<2> frame;
-          frame.samples[0] = pSampleData[i];
-  				if (sampleChannels == 2)
-  					frame.samples[1] = (float)pSampleData[i+1];
-  				else
-  					frame.samples[1] = (float)pSampleData[i];
-          result.push_back(frame);
-        }
-        sampleCount = sc/c;
-        drwav_free(pSampleData, NULL);
-      }
-    }
-    else if (upperExt == ".AIFF") {
-      AudioFile<float> audioFile;
-      if (audioFile.load (path.c_str()))  {
-        sampleChannels = audioFile.getNumChannels();
-        sampleRate = audioFile.getSampleRate();
-        sampleCount = audioFile.getNumSamplesPerChannel();
-        for (int i=0; i < sampleCount; i++) {
-          rack::dsp::Frame<2> frame;
-          frame.samples[0] = audioFile.samples[0][i];
-  				if (sampleChannels == 2)
-  					frame.samples[1] = audioFile.samples[1][i];
-  				else
-  					frame.samples[1] = audioFile.samples[0][i];
-          result.push_back(frame);
-        }
-      }
-    }
-
-    if ((sampleRate != currentSampleRate) && (sampleCount>0)) {
-      rack::dsp::SampleRateConverter<2> conv;
-      conv.setRates(sampleRate, currentSampleRate);
-      conv.setQuality(SPEEX_RESAMPLER_QUALITY_DESKTOP);
-      
-      // Calculate output buffer size based on ratio of sample rates with some extra padding
-      int outCount = ceil(sampleCount * (currentSampleRate / (float)sampleRate) * 1.5);
-      std::vector<rack::dsp::Frame<2>> subResult(outCount);
-      
-      // Process the conversionbut a 4
-      conv.process(&result[0], &sampleCount, &subResult[0], &outCount);
-      subResult.resize(outCount); // Resize to actual size used
-      sampleCount = outCount;
-      return subResult;
-    }
-
-    return result;
-  }
-
-  void saveWave(std::vector<rack::dsp::Frame<2>> &sample, int sampleRate, std::string path) {
-    drwav_data_format format;
-    format.container = drwav_container_riff;
-    format.format = DR_WAVE_FORMAT_PCM;
-    format.channels = 2;
-    format.sampleRate = sampleRate;
-    format.bitsPerSample = 32;
-
-    int *pSamples = (int*)calloc(2*sample.size(),sizeof(int));
-    memset(pSamples, 0, 2*sample.size()*sizeof(int));
-    for (unsigned int i = 0; i < sample.size(); i++) {
-    	*(pSamples+2*i)= floor(sample[i].samples[0]*1990000000);
-    	*(pSamples+2*i+1)= floor(sample[i].samples[1]*1990000000);
-    }
-
-    drwav wav;
-    drwav_init_file_write(&wav, path.c_str(), &format, NULL);
-    drwav_uint64 framesWritten = drwav_write_pcm_frames(&wav, sample.size(), pSamples);
-    drwav_uninit(&wav);
-
-    free(pSamples);
-  }
-
-}
+#include "waves.hpp"
+#define DR_WAV_IMPLEMENTATION
+#include "dr_wav/dr_wav.h"
+#include <mutex>
+#include <sys/stat.h>
+
+namespace waves {
+
+  // frames decoded per drwav_read_pcm_frames_f32 call
+  static constexpr drwav_uint64 chunkFrames = 4096;
+
+#if defined(METAMODULE)
+  static size_t memoryBudget = 64 << 20;
+#else
+  static size_t memoryBudget = 0;
+#endif
+
+  void setMemoryBudget(const size_t bytes) {
+    memoryBudget = bytes;
+  }
+
+  size_t getMemoryBudget() {
+    return memoryBudget;
+  }
+
+  // high takes about twice the load time of medium, see tests/waves_resample.cpp
+  static int resampleQuality = RESAMPLE_MEDIUM;
+
+  void setResampleQuality(const int quality) {
+    resampleQuality = rack::math::clamp(quality, 0, NUM_RESAMPLE_QUALITIES - 1);
+  }
+
+  int getResampleQuality() {
+    return resampleQuality;
+  }
+
+#if defined(METAMODULE)
+  static bool compactSamples = true;
+#else
+  static bool compactSamples = false;
+#endif
+
+  void setCompactSamples(const bool compact) {
+    compactSamples = compact;
+  }
+
+  bool getCompactSamples() {
+    return compactSamples;
+  }
+
+  static int saveFormat = SAVE_INT32;
+
+  void setSaveFormat(const int format) {
+    saveFormat = rack::math::clamp(format, 0, NUM_SAVE_FORMATS - 1);
+  }
+
+  int getSaveFormat() {
+    return saveFormat;
+  }
+
+  template <int N>
+  static inline void store(SampleBuffer<N> &out, const size_t i, const rack::dsp::Frame<N> &frame) {
+    out.set(i, frame);
+  }
+
+  // what a pooled buffer was decoded from and with
+  template <int N>
+  struct PoolEntry {
+    std::string path;
+    int64_t modified = 0;
+    int64_t fileSize = 0;
+    int targetRate = 0;
+    int quality = 0;
+    bool compact = false;
+    int channels = 0;
+    int rate = 0;
+    std::weak_ptr<typename SampleBuffer<N>::Storage> storage;
+
+    bool matches(const PoolEntry &other) const {
+      return (path == other.path) && (modified == other.modified) && (fileSize == other.fileSize) && (targetRate == other.targetRate)
+        && (quality == other.quality) && (compact == other.compact);
+    }
+  };
+
+  static std::mutex poolMutex;
+  static std::vector<PoolEntry<1>> monoPool;
+  static std::vector<PoolEntry<2>> stereoPool;
+
+  static std::vector<PoolEntry<1>> &getPool(const SampleBuffer<1> &) {
+    return monoPool;
+  }
+
+  static std::vector<PoolEntry<2>> &getPool(const SampleBuffer<2> &) {
+    return stereoPool;
+  }
+
+  // drops entries whose last buffer is gone, poolMutex held
+  template <int N>
+  static void purge(std::vector<PoolEntry<N>> &pool) {
+    pool.erase(std::remove_if(pool.begin(), pool.end(), [](const PoolEntry<N> &e) { return e.storage.expired(); }), pool.end());
+  }
+
+  // live storage for key, poolMutex held
+  template <int N>
+  static std::shared_ptr<typename SampleBuffer<N>::Storage> findPooled(std::vector<PoolEntry<N>> &pool, PoolEntry<N> &key) {
+    purge(pool);
+    for (const PoolEntry<N> &e : pool) {
+      if (e.matches(key)) {
+        std::shared_ptr<typename SampleBuffer<N>::Storage> shared = e.storage.lock();
+        if (shared) {
+          key.channels = e.channels;
+          key.rate = e.rate;
+          return shared;
+        }
+      }
+    }
+    return NULL;
+  }
+
+  size_t getPooledSamples() {
+    poolMutex.lock();
+    purge(monoPool);
+    purge(stereoPool);
+    const size_t n = monoPool.size() + stereoPool.size();
+    poolMutex.unlock();
+    return n;
+  }
+
+  // a rewritten file gets decoded again even if its time and size did not change
+  static void forget(const std::string &path) {
+    poolMutex.lock();
+    monoPool.erase(std::remove_if(monoPool.begin(), monoPool.end(), [&](const PoolEntry<1> &e) { return e.path == path; }), monoPool.end());
+    stereoPool.erase(std::remove_if(stereoPool.begin(), stereoPool.end(), [&](const PoolEntry<2> &e) { return e.path == path; }), stereoPool.end());
+    poolMutex.unlock();
+  }
+
+  static double besselI0(const double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+      term *= (x / (2.0 * k)) * (x / (2.0 * k));
+      sum += term;
+    }
+    return sum;
+  }
+
+  // Offline resampler fed the input chunk by chunk, writing into a buffer sized once for the
+  // whole sample. Output frame i sits at input position i*inRate/outRate, kept as an integer
+  // ratio so there is no drift, input outside the sample is silence.
+  // FIR tiers use a Kaiser windowed sinc with one kernel row per phase when the rates only
+  // produce a few distinct phases (44.1k/48k : 147 or 160), interpolated rows otherwise.
+  template <int N>
+  struct Resampler {
+    static constexpr int maxExactPhases = 1024;
+    static constexpr int interpolatedPhases = 256;
+
+    uint64_t inRate;
+    uint64_t outRate;
+    uint64_t phaseDivider = 1;
+    int halfTaps = 1;
+    int phases = 0;
+    bool exact = false;
+    std::vector<float> kernel;
+    std::vector<rack::dsp::Frame<N>> window;
+    uint64_t windowStart = 0;
+    uint64_t next = 0;
+
+    Resampler(const uint64_t inRate, const uint64_t outRate, const int quality) : inRate(inRate), outRate(outRate) {
+      if (quality == RESAMPLE_FAST) {
+        return;
+      }
+      halfTaps = quality == RESAMPLE_HIGH ? 32 : 12;
+      const double beta = quality == RESAMPLE_HIGH ? 9.0 : 7.0;
+      const double cutoff = 0.5 * std::min(1.0, (double)outRate / inRate) * (quality == RESAMPLE_HIGH ? 0.95 : 0.88);
+
+      uint64_t a = inRate, b = outRate;
+      while (b != 0) {
+        const uint64_t r = a % b;
+        a = b;
+        b = r;
+      }
+      exact = outRate / a <= maxExactPhases;
+      phaseDivider = a;
+      phases = exact ? outRate / a : interpolatedPhases;
+
+      const int rows = exact ? phases : phases + 1;
+      kernel.resize(rows * 2 * halfTaps);
+      for (int p = 0; p < rows; p++) {
+        float *row = &kernel[p * 2 * halfTaps];
+        double sum = 0.0;
+        for (int m = 0; m < 2 * halfTaps; m++) {
+          // distance from the output position to input pos + m - halfTaps + 1
+          const double u = (double)p / phases + halfTaps - 1 - m;
+          const double x = 2.0 * cutoff * u;
+          const double sinc = x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+          const double w = u / halfTaps;
+          const double kaiser = w * w >= 1.0 ? 0.0 : besselI0(beta * sqrt(1.0 - w * w)) / besselI0(beta);
+          row[m] = sinc * kaiser;
+          sum += row[m];
+        }
+        for (int m = 0; m < 2 * halfTaps; m++) {
+          row[m] /= sum;
+        }
+      }
+    }
+
+    static uint64_t outputCount(const uint64_t inCount, const uint64_t inRate, const uint64_t outRate) {
+      return (inCount * outRate + inRate - 1) / inRate;
+    }
+
+    inline const rack::dsp::Frame<N> &input(const int64_t j, const uint64_t available) const {
+      static const rack::dsp::Frame<N> silence = {};
+      return ((j < 0) || ((uint64_t)j >= available)) ? silence : window[j - windowStart];
+    }
+
+    // Appends count input frames and computes every output frame it can into out, from next
+    // on. last flushes the end of the sample. Only the input the next outputs need is kept.
+    template <typename Buffer>
+    void process(const rack::dsp::Frame<N> *in, const size_t count, const bool last, Buffer &out) {
+      window.insert(window.end(), in, in + count);
+      const uint64_t available = windowStart + window.size();
+
+      while (next < out.size()) {
+        const uint64_t num = next * inRate;
+        const uint64_t pos = num / outRate;
+        if (last ? (pos >= available) : (pos + halfTaps >= available)) {
+          break;
+        }
+        rack::dsp::Frame<N> frame;
+        if (phases == 0) {
+          const float frac = (float)(num % outRate) / outRate;
+          const rack::dsp::Frame<N> &x0 = input(pos, available);
+          const rack::dsp::Frame<N> &x1 = input(pos + 1, available);
+          for (int c = 0; c < N; c++) {
+            frame.samples[c] = x0.samples[c] + (x1.samples[c] - x0.samples[c]) * frac;
+          }
+        }
+        else {
+          float interpolated[64];
+          const float *coefs = interpolated;
+          if (exact) {
+            coefs = &kernel[((num % outRate) / phaseDivider) * 2 * halfTaps];
+          }
+          else {
+            const float phase = (float)(num % outRate) / outRate * phases;
+            const int p = (int)phase;
+            const float t = phase - p;
+            const float *row0 = &kernel[p * 2 * halfTaps];
+            const float *row1 = row0 + 2 * halfTaps;
+            for (int m = 0; m < 2 * halfTaps; m++) {
+              interpolated[m] = row0[m] + (row1[m] - row0[m]) * t;
+            }
+          }
+          const int64_t first = (int64_t)pos - halfTaps + 1;
+          for (int c = 0; c < N; c++) {
+            frame.samples[c] = 0.0f;
+          }
+          if ((first >= 0) && ((uint64_t)first + 2 * halfTaps <= available)) {
+            const rack::dsp::Frame<N> *x = &window[first - windowStart];
+            for (int m = 0; m < 2 * halfTaps; m++) {
+              for (int c = 0; c < N; c++) {
+                frame.samples[c] += x[m].samples[c] * coefs[m];
+              }
+            }
+          }
+          else {
+            for (int m = 0; m < 2 * halfTaps; m++) {
+              const rack::dsp::Frame<N> &x = input(first + m, available);
+              for (int c = 0; c < N; c++) {
+                frame.samples[c] += x.samples[c] * coefs[m];
+              }
+            }
+          }
+        }
+        store(out, next, frame);
+        next++;
+      }
+
+      const int64_t keep = (int64_t)((next * inRate) / outRate) - halfTaps + 1;
+      if (keep > (int64_t)windowStart) {
+        const uint64_t drop = std::min((uint64_t)keep - windowStart, (uint64_t)window.size());
+        window.erase(window.begin(), window.begin() + drop);
+        windowStart += drop;
+      }
+    }
+  };
+
+  static inline void toFrame(const float *in, const unsigned int channels, rack::dsp::Frame<1> &frame) {
+    frame.samples[0] = channels >= 2 ? (in[0] + in[1])/2.0f : in[0];
+  }
+
+  static inline void toFrame(const float *in, const unsigned int channels, rack::dsp::Frame<2> &frame) {
+    frame.samples[0] = in[0];
+    frame.samples[1] = channels >= 2 ? in[1] : in[0];
+  }
+
+  static int64_t getFileSize(const std::string &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? (int64_t)info.st_size : -1;
+  }
+
+  static inline uint32_t readBigEndian(const uint8_t *b, const int bytes) {
+    uint32_t v = 0;
+    for (int i = 0; i < bytes; i++) {
+      v = (v << 8) | b[i];
+    }
+    return v;
+  }
+
+  // 80 bit IEEE extended, the AIFF sample rate
+  static double readExtended(const uint8_t *b) {
+    const int exponent = ((b[0] & 0x7f) << 8) | b[1];
+    const uint64_t mantissa = ((uint64_t)readBigEndian(b + 2, 4) << 32) | readBigEndian(b + 6, 4);
+    if ((exponent == 0) && (mantissa == 0)) {
+      return 0.0;
+    }
+    const double v = ldexp((double)mantissa, exponent - 16383 - 63);
+    return (b[0] & 0x80) ? -v : v;
+  }
+
+  struct AiffHeader {
+    int channels = 0;
+    uint64_t frames = 0;
+    int bitDepth = 0;
+    double sampleRate = 0.0;
+    bool littleEndian = false;
+    bool floating = false;
+    uint64_t dataPos = 0;
+    uint64_t dataSize = 0;
+  };
+
+  // FORM AIFF/AIFC, COMM and SSND chunks in any order, uncompressed or sowt/fl32/fl64 AIFC
+  static bool readAiffHeader(FILE *file, const int64_t fileSize, AiffHeader &header) {
+    uint8_t b[32];
+    if ((fread(b, 1, 12, file) != 12) || memcmp(b, "FORM", 4) || (memcmp(b + 8, "AIFF", 4) && memcmp(b + 8, "AIFC", 4))) {
+      return false;
+    }
+    const bool aifc = !memcmp(b + 8, "AIFC", 4);
+    bool comm = false;
+    bool ssnd = false;
+    int64_t pos = 12;
+    while (!(comm && ssnd) && (pos + 8 <= fileSize)) {
+      if (fseek(file, pos, SEEK_SET) || (fread(b, 1, 8, file) != 8)) {
+        return false;
+      }
+      const uint32_t size = readBigEndian(b + 4, 4);
+      if (!memcmp(b, "COMM", 4)) {
+        if ((size < (aifc ? 22u : 18u)) || (fread(b, 1, aifc ? 22 : 18, file) != (aifc ? 22u : 18u))) {
+          return false;
+        }
+        header.channels = readBigEndian(b, 2);
+        header.frames = readBigEndian(b + 2, 4);
+        header.bitDepth = readBigEndian(b + 6, 2);
+        header.sampleRate = readExtended(b + 8);
+        if (aifc && !memcmp(b + 18, "sowt", 4)) {
+          header.littleEndian = true;
+        }
+        else if (aifc && (!memcmp(b + 18, "fl32", 4) || !memcmp(b + 18, "FL32", 4))) {
+          header.floating = true;
+          header.bitDepth = 32;
+        }
+        else if (aifc && (!memcmp(b + 18, "fl64", 4) || !memcmp(b + 18, "FL64", 4))) {
+          header.floating = true;
+          header.bitDepth = 64;
+        }
+        else if (aifc && memcmp(b + 18, "NONE", 4) && memcmp(b + 18, "twos", 4)) {
+          return false;
+        }
+        comm = true;
+      }
+      else if (!memcmp(b, "SSND", 4)) {
+        if ((size < 8) || (fread(b, 1, 8, file) != 8)) {
+          return false;
+        }
+        const uint32_t offset = readBigEndian(b, 4);
+        header.dataPos = pos + 16 + offset;
+        header.dataSize = size >= 8 + offset ? size - 8 - offset : 0;
+        ssnd = true;
+      }
+      pos += 8 + (int64_t)size + (size & 1);
+    }
+    if (!comm || !ssnd || (header.channels <= 0) || (header.bitDepth <= 0) || (header.bitDepth > (header.floating ? 64 : 32))
+      || !(header.sampleRate >= 1.0) || (header.sampleRate > 10000000.0)) {
+      return false;
+    }
+    if ((int64_t)header.dataPos > fileSize) {
+      header.dataSize = 0;
+    }
+    else if ((int64_t)(header.dataPos + header.dataSize) > fileSize) {
+      header.dataSize = fileSize - header.dataPos;
+    }
+    header.frames = std::min(header.frames, header.dataSize / (header.channels * ((header.bitDepth + 7) / 8)));
+    return true;
+  }
+
+  SampleInfo probe(const std::string &path) {
+    SampleInfo info;
+    const std::string upperExt = rack::string::uppercase(rack::system::getExtension(path));
+    const int64_t fileSize = getFileSize(path);
+    if (fileSize < 0) {
+      return info;
+    }
+    if (upperExt == ".WAV") {
+      drwav wav;
+      if (!drwav_init_file(&wav, path.c_str(), NULL)) {
+        return info;
+      }
+      info.frames = wav.totalPCMFrameCount;
+      info.channels = wav.channels;
+      info.sampleRate = wav.sampleRate;
+      info.bitDepth = wav.bitsPerSample;
+      info.floating = wav.translatedFormatTag == DR_WAVE_FORMAT_IEEE_FLOAT;
+      const uint64_t frameBytes = (uint64_t)wav.channels * (wav.bitsPerSample / 8);
+      if (((wav.translatedFormatTag == DR_WAVE_FORMAT_PCM) || info.floating) && (frameBytes > 0)) {
+        const uint64_t available = (int64_t)wav.dataChunkDataPos < fileSize ? fileSize - wav.dataChunkDataPos : 0;
+        info.frames = std::min(info.frames, available / frameBytes);
+      }
+      drwav_uninit(&wav);
+      info.valid = (info.channels > 0) && (info.sampleRate > 0);
+    }
+    else if (upperExt == ".AIFF") {
+      FILE *file = fopen(path.c_str(), "rb");
+      if (!file) {
+        return info;
+      }
+      AiffHeader header;
+      info.valid = readAiffHeader(file, fileSize, header);
+      fclose(file);
+      if (info.valid) {
+        info.frames = header.frames;
+        info.channels = header.channels;
+        info.sampleRate = std::round(header.sampleRate);
+        info.bitDepth = header.bitDepth;
+        info.floating = header.floating;
+      }
+    }
+    return info;
+  }
+
+  size_t SampleInfo::estimate(const int n, const float targetRate) const {
+    const uint64_t rate = std::round(targetRate);
+    const uint64_t count = (sampleRate > 0) && (rate > 0) && (rate != (uint64_t)sampleRate) ? Resampler<1>::outputCount(frames, sampleRate, rate) : frames;
+    return count * n * (compactSamples ? sizeof(int16_t) : sizeof(float));
+  }
+
+  // Takes the decoded file chunkFrames at a time and writes it straight into result, which
+  // is sized once from the header, resampling on the way when the file rate is not
+  // targetRate, so the peak is the sample itself plus one chunk.
+  template <int N, typename Buffer>
+  struct ChunkWriter {
+    Buffer &result;
+    const bool resample;
+    Resampler<N> resampler;
+    std::vector<rack::dsp::Frame<N>> converted;
+    uint64_t done = 0;
+
+    ChunkWriter(Buffer &result, const uint64_t frames, const uint64_t fileRate, const uint64_t targetRate) : result(result),
+      resample((fileRate > 0) && (targetRate > 0) && (fileRate != targetRate)),
+      resampler(resample ? fileRate : 1, resample ? targetRate : 1, resampleQuality), converted(chunkFrames) {
+      result.resize(resample ? Resampler<N>::outputCount(frames, fileRate, targetRate) : frames);
+    }
+
+    // read interleaved frames of the file channel count
+    void write(const float *chunk, const uint64_t read, const unsigned int channels) {
+      for (uint64_t i = 0; i < read; i++) {
+        toFrame(&chunk[i * channels], channels, converted[i]);
+      }
+      if (resample) {
+        resampler.process(converted.data(), read, false, result);
+      }
+      else {
+        for (uint64_t i = 0; i < read; i++) {
+          store(result, done + i, converted[i]);
+        }
+      }
+      done += read;
+    }
+
+    void finish() {
+      if (resample) {
+        resampler.process((const rack::dsp::Frame<N>*)NULL, 0, true, result);
+      }
+      // truncated data chunk
+      result.resize(resample ? resampler.next : done);
+    }
+  };
+
+  template <int N, typename Buffer>
+  static void readWav(const std::string &path, const uint64_t targetRate, Buffer &result, int &sampleChannels, int &sampleRate, int &sampleCount) {
+    drwav wav;
+    if (!drwav_init_file(&wav, path.c_str(), NULL)) {
+      return;
+    }
+    if (wav.channels == 0) {
+      drwav_uninit(&wav);
+      return;
+    }
+
+    ChunkWriter<N, Buffer> writer(result, wav.totalPCMFrameCount, wav.sampleRate, targetRate);
+    std::vector<float> chunk(chunkFrames * wav.channels);
+    while (writer.done < wav.totalPCMFrameCount) {
+      const drwav_uint64 read = drwav_read_pcm_frames_f32(&wav, std::min(chunkFrames, wav.totalPCMFrameCount - writer.done), chunk.data());
+      if (read == 0) {
+        break;
+      }
+      writer.write(chunk.data(), read, wav.channels);
+    }
+    writer.finish();
+
+    sampleChannels = wav.channels;
+    sampleRate = wav.sampleRate;
+    sampleCount = result.size();
+    drwav_uninit(&wav);
+  }
+
+  // big endian integers of any width up to 32 bits, left justified as AIFF stores them,
+  // sowt little endian ones, or fl32/fl64 floats
+  static void decodeAiff(const uint8_t *in, const size_t count, const AiffHeader &header, float *out) {
+    const int bytes = (header.bitDepth + 7) / 8;
+    if (header.floating) {
+      for (size_t i = 0; i < count; i++, in += bytes) {
+        if (bytes == 8) {
+          const uint64_t bits = ((uint64_t)readBigEndian(in, 4) << 32) | readBigEndian(in + 4, 4);
+          double d;
+          memcpy(&d, &bits, 8);
+          out[i] = d;
+        }
+        else {
+          const uint32_t bits = readBigEndian(in, 4);
+          memcpy(&out[i], &bits, 4);
+        }
+      }
+      return;
+    }
+    const int shift = 32 - 8 * bytes;
+    for (size_t i = 0; i < count; i++, in += bytes) {
+      uint32_t v = 0;
+      for (int b = 0; b < bytes; b++) {
+        v = (v << 8) | in[header.littleEndian ? bytes - 1 - b : b];
+      }
+      out[i] = (int32_t)(v << shift) * (1.0f / 2147483648.0f);
+    }
+  }
+
+  template <int N, typename Buffer>
+  static void readAiff(const std::string &path, const uint64_t targetRate, Buffer &result, int &sampleChannels, int &sampleRate, int &sampleCount) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) {
+      return;
+    }
+    AiffHeader header;
+    if (!readAiffHeader(file, getFileSize(path), header) || fseek(file, header.dataPos, SEEK_SET)) {
+      fclose(file);
+      return;
+    }
+
+    const uint64_t rate = std::round(header.sampleRate);
+    const size_t frameBytes = header.channels * ((header.bitDepth + 7) / 8);
+    ChunkWriter<N, Buffer> writer(result, header.frames, rate, targetRate);
+    std::vector<uint8_t> raw(chunkFrames * frameBytes);
+    std::vector<float> chunk(chunkFrames * header.channels);
+    while (writer.done < header.frames) {
+      const size_t read = fread(raw.data(), frameBytes, std::min((uint64_t)chunkFrames, header.frames - writer.done), file);
+      if (read == 0) {
+        break;
+      }
+      decodeAiff(raw.data(), read * header.channels, header, chunk.data());
+      writer.write(chunk.data(), read, header.channels);
+    }
+    writer.finish();
+    fclose(file);
+
+    sampleChannels = header.channels;
+    sampleRate = rate;
+    sampleCount = result.size();
+  }
+
+  // Decoding is done outside poolMutex so a long load does not hold back the others, two
+  // modules loading the same file at once may both decode it, the first one in is shared.
+  template <int N>
+  static void loadSample(const std::string &path, const float currentSampleRate, std::string &waveFileName, std::string &waveExtension, int &sampleChannels, int &sampleRate, int &sampleCount, SampleBuffer<N> &result) {
+    waveFileName = rack::system::getFilename(path);
+    waveExtension = rack::system::getExtension(waveFileName);
+    const std::string upperExt = rack::string::uppercase(waveExtension);
+    result.reset(compactSamples);
+    sampleCount = 0;
+
+    if ((upperExt != ".WAV") && (upperExt != ".AIFF")) {
+      sampleChannels = 0;
+      sampleRate = 0;
+      return;
+    }
+
+    PoolEntry<N> key;
+    key.path = path;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0) {
+      key.modified = info.st_mtime;
+      key.fileSize = info.st_size;
+    }
+    key.targetRate = std::round(currentSampleRate);
+    key.quality = resampleQuality;
+    key.compact = compactSamples;
+    std::vector<PoolEntry<N>> &pool = getPool(result);
+
+    poolMutex.lock();
+    std::shared_ptr<typename SampleBuffer<N>::Storage> shared = findPooled(pool, key);
+    poolMutex.unlock();
+
+    if (!shared) {
+      // rejected from the header, before anything is allocated
+      const SampleInfo info = probe(path);
+      if (!info.valid || ((memoryBudget > 0) && (info.estimate(N, currentSampleRate) > memoryBudget))) {
+        sampleChannels = info.channels;
+        sampleRate = info.sampleRate;
+        return;
+      }
+
+      SampleBuffer<N> loaded;
+      loaded.reset(key.compact);
+      if (upperExt == ".WAV") {
+        readWav<N>(path, key.targetRate, loaded, key.channels, key.rate, sampleCount);
+      }
+      else {
+        readAiff<N>(path, key.targetRate, loaded, key.channels, key.rate, sampleCount);
+      }
+      if (loaded.size() == 0) {
+        sampleChannels = key.channels;
+        sampleRate = key.rate;
+        sampleCount = 0;
+        return;
+      }
+      loaded.storage->pooled = true;
+
+      poolMutex.lock();
+      PoolEntry<N> other = key;
+      shared = findPooled(pool, other);
+      if (shared) {
+        key = other;
+      }
+      else {
+        shared = loaded.storage;
+        key.storage = shared;
+        pool.push_back(key);
+      }
+      poolMutex.unlock();
+    }
+
+    result.share(shared);
+    sampleChannels = key.channels;
+    sampleRate = key.rate;
+    sampleCount = result.size();
+  }
+
+  void getMonoWav(const std::string path, const float currentSampleRate, std::string &waveFileName, std::string &waveExtension, int &sampleChannels, int &sampleRate, int &sampleCount, SampleBuffer<1> &result) {
+    loadSample<1>(path, currentSampleRate, waveFileName, waveExtension, sampleChannels, sampleRate, sampleCount, result);
+  }
+
+  void getStereoWav(const std::string path, const float currentSampleRate, std::string &waveFileName, std::string &waveExtension, int &sampleChannels, int &sampleRate, int &sampleCount, SampleBuffer<2> &result) {
+    loadSample<2>(path, currentSampleRate, waveFileName, waveExtension, sampleChannels, sampleRate, sampleCount, result);
+  }
+
+  static inline double uniform(uint32_t &seed) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed * (1.0 / 4294967296.0);
+  }
+
+  // one sample, little endian, integers with a TPDF dither of +-1 LSB
+  static inline void encode(const float x, const int format, uint32_t &seed, uint8_t *out) {
+    uint32_t bits;
+    int bytes = 4;
+    if (format == SAVE_FLOAT32) {
+      memcpy(&bits, &x, 4);
+    }
+    else {
+      bytes = format == SAVE_INT16 ? 2 : (format == SAVE_INT24 ? 3 : 4);
+      const double scale = (double)(1LL << (8 * bytes - 1)) - 1.0;
+      const double v = x * scale + uniform(seed) - uniform(seed);
+      bits = (uint32_t)(int32_t)llrint(v > scale ? scale : (v < -scale - 1.0 ? -scale - 1.0 : v));
+    }
+    for (int b = 0; b < bytes; b++) {
+      out[b] = (bits >> (8 * b)) & 0xff;
+    }
+  }
+
+  bool SaveJob::start(const SampleBuffer<2> &buffer, const int rate, const std::string &destination) {
+    if (busy()) {
+      return false;
+    }
+    sample = buffer;
+    sampleRate = rate;
+    format = saveFormat;
+    path = destination;
+    written = 0;
+    total = sample.size();
+    state = SAVE_PENDING;
+    return true;
+  }
+
+  void SaveJob::run() {
+    if (state != SAVE_PENDING) {
+      return;
+    }
+    state = SAVE_RUNNING;
+
+    drwav_data_format wavFormat;
+    wavFormat.container = drwav_container_riff;
+    wavFormat.format = format == SAVE_FLOAT32 ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    wavFormat.channels = 2;
+    wavFormat.sampleRate = sampleRate;
+    wavFormat.bitsPerSample = format == SAVE_INT16 ? 16 : (format == SAVE_INT24 ? 24 : 32);
+
+    drwav wav;
+    bool ok = drwav_init_file_write(&wav, path.c_str(), &wavFormat, NULL);
+    if (ok) {
+      const size_t frameBytes = 2 * wavFormat.bitsPerSample / 8;
+      std::vector<uint8_t> chunk(chunkFrames * frameBytes);
+      uint32_t seed = 0x9e3779b9u;
+      const size_t count = sample.size();
+      size_t done = 0;
+      while (ok && (done < count)) {
+        const size_t n = std::min((size_t)chunkFrames, count - done);
+        for (size_t i = 0; i < n; i++) {
+          for (int c = 0; c < 2; c++) {
+            encode(sample.sample(done + i, c), format, seed, &chunk[i * frameBytes + c * frameBytes / 2]);
+          }
+        }
+        ok = drwav_write_raw(&wav, n * frameBytes, chunk.data()) == n * frameBytes;
+        done += n;
+        written = done;
+      }
+      drwav_uninit(&wav);
+    }
+
+    sample.reset(false);
+    forget(path);
+    state = ok ? SAVE_DONE : SAVE_FAILED;
+  }
+
+  void saveWave(const SampleBuffer<2> &sample, int sampleRate, std::string path) {
+    SaveJob job;
+    job.start(sample, sampleRate, path);
+    job.run();
+  }
+
+  OnsetDetector::~OnsetDetector() {
+    if (setup) {
+      pffft_destroy_setup(setup);
+      pffft_aligned_free(in);
+      pffft_aligned_free(out);
+    }
+  }
+
+  void OnsetDetector::start(const SampleBuffer<2> &buffer, const unsigned bufferVersion, const int onsetFeature) {
+    sample = buffer;
+    version = bufferVersion;
+    feature = onsetFeature;
+    next = 0;
+    // windows with at least a frame after them, as the energy scan always did
+    const size_t count = sample.size() > window ? (sample.size() - 1) / window : 0;
+    values.assign(count, 0.0f);
+    offsets.assign(count, 0);
+    if (feature == ONSET_SPECTRAL_FLUX) {
+      if (!setup) {
+        setup = pffft_new_setup(fftSize, PFFFT_REAL);
+        in = (float*)pffft_aligned_malloc(fftSize * sizeof(float));
+        out = (float*)pffft_aligned_malloc(fftSize * sizeof(float));
+        hann.resize(fftSize);
+        for (int k = 0; k < fftSize; k++) {
+          hann[k] = 0.5f - 0.5f * cosf(2.0f * M_PI * k / fftSize);
+        }
+      }
+      magnitudes.assign(fftSize / 2, 0.0f);
+    }
+    running = true;
+  }
+
+  bool OnsetDetector::step() {
+    if (!running) {
+      return false;
+    }
+    const size_t end = std::min(values.size(), next + stepWindows);
+    for (; next < end; next++) {
+      const size_t from = next * window;
+      float nrgy = 0.0f;
+      bool silent = true;
+      for (int k = 0; k < window; k++) {
+        const float s = sample.sample(from + k, 0);
+        nrgy += 100 * s * s / window;
+        if (silent && (s == 0.0f)) {
+          offsets[next] = k;
+          silent = false;
+        }
+      }
+      if (feature == ONSET_ENERGY) {
+        values[next] = nrgy;
+        continue;
+      }
+      // spectrum of the fftSize frames ending with the window, against the previous window
+      for (int k = 0; k < fftSize; k++) {
+        const long j = (long)(from + window) - fftSize + k;
+        in[k] = j >= 0 ? 0.5f * (sample.sample(j, 0) + sample.sample(j, 1)) * hann[k] : 0.0f;
+      }
+      pffft_transform_ordered(setup, in, out, NULL, PFFFT_FORWARD);
+      float flux = 0.0f;
+      for (int k = 1; k < fftSize / 2; k++) {
+        const float m = log1pf(sqrtf(out[2 * k] * out[2 * k] + out[2 * k + 1] * out[2 * k + 1]));
+        flux += std::max(0.0f, m - magnitudes[k]);
+        magnitudes[k] = m;
+      }
+      values[next] = flux;
+    }
+    if (next < values.size()) {
+      return false;
+    }
+    if (feature == ONSET_SPECTRAL_FLUX) {
+      // the first window is measured against silence, it does not set the scale
+      float peak = 0.0f;
+      for (size_t i = 1; i < values.size(); i++) {
+        peak = std::max(peak, values[i]);
+      }
+      const float scale = peak > 0.0f ? 10.0f / peak : 0.0f;
+      for (float &v : values) {
+        v = std::min(10.0f, v * scale);
+      }
+    }
+    sample.reset(sample.compact);
+    running = false;
+    return true;
+  }
+
+  void OnsetDetector::slices(const float threshold, std::vector<int> &result) const {
+    result.clear();
+    result.push_back(0);
+    if (feature == ONSET_ENERGY) {
+      float prev = 0.0f;
+      for (size_t i = 0; i < values.size(); i++) {
+        if ((values[i] > threshold) && (values[i] > 10 * prev)) {
+          result.push_back(i * window + offsets[i]);
+        }
+        prev = values[i];
+      }
+      return;
+    }
+    // peaks of the flux over threshold
+    for (size_t i = 1; i < values.size(); i++) {
+      if ((values[i] > threshold) && (values[i] >= values[i - 1]) && ((i + 1 == values.size()) || (values[i] > values[i + 1]))) {
+        result.push_back(i * window + offsets[i]);
+      }
+    }
+  }
+
+}
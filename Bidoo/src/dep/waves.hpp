@@ -1,12 +1,660 @@
 #pragma once
 #include <rack.hpp>
+#include <memory>
+#include <atomic>
 
 namespace waves {
 
-std::vector<rack::dsp::Frame<1>> getMonoWav(const std::string path, const float currentSampleRate, std::string &waveFileName, std::string &waveExtension, int &sampleChannels, int &sampleRate, int &sampleCount);
+// Largest decoded sample, in bytes, getMonoWav/getStereoWav will allocate, 0 for no limit.
+// Defaults to 64MB on MetaModule.
+void setMemoryBudget(const size_t bytes);
 
-std::vector<rack::dsp::Frame<2>> getStereoWav(const std::string path, const float currentSampleRate, std::string &waveFileName, std::string &waveExtension, int &sampleChannels, int &sampleRate, int &sampleCount);
+size_t getMemoryBudget();
 
-void saveWave(std::vector<rack::dsp::Frame<2>> &sample, int sampleRate, std::string path);
+// Quality used when a sample rate differs from the engine one, applies to the next loads.
+enum ResampleQualities {
+  RESAMPLE_FAST,
+  RESAMPLE_MEDIUM,
+  RESAMPLE_HIGH,
+  NUM_RESAMPLE_QUALITIES
+};
+
+static const std::string resampleQualityLabels[NUM_RESAMPLE_QUALITIES] = {"Fast (linear)", "Medium (24 taps FIR)", "High (64 taps FIR)"};
+
+void setResampleQuality(const int quality);
+
+int getResampleQuality();
+
+// Sample frames stored as floats or, in compact mode, as 16 bit integers converted back on
+// read : half the memory for a quantization error below -90dBFS, values are clipped to
+// [-1, 1]. The mode is picked with reset, the loaders use getCompactSamples().
+// Copies share the same storage, which is copied on the first write when someone else
+// holds it. Buffers handed out by the sample pool are never written, whoever edits one
+// gets a private copy and the other modules keep the file as loaded.
+template <int N>
+struct SampleBuffer {
+  struct Storage {
+    bool compact = false;
+    bool pooled = false;
+    std::vector<rack::dsp::Frame<N>> frames;
+    std::vector<int16_t> samples;
+  };
+
+  bool compact = false;
+  std::shared_ptr<Storage> storage;
+  // read side, refreshed after each change
+  const rack::dsp::Frame<N> *frameData = NULL;
+  const int16_t *sampleData = NULL;
+  size_t count = 0;
+
+  static inline int16_t toInt16(const float x) {
+    return (int16_t)lrintf((x > 1.0f ? 1.0f : (x < -1.0f ? -1.0f : x)) * 32767.0f);
+  }
+
+  void refresh() {
+    frameData = storage ? storage->frames.data() : NULL;
+    sampleData = storage ? storage->samples.data() : NULL;
+    count = storage ? (compact ? storage->samples.size() / N : storage->frames.size()) : 0;
+  }
+
+  // storage this buffer can write to
+  Storage &edit() {
+    if (!storage) {
+      storage = std::make_shared<Storage>();
+      storage->compact = compact;
+    }
+    else if (storage->pooled || (storage.use_count() > 1)) {
+      std::shared_ptr<Storage> copy = std::make_shared<Storage>(*storage);
+      copy->pooled = false;
+      storage = copy;
+    }
+    return *storage;
+  }
+
+  void share(const std::shared_ptr<Storage> &shared) {
+    storage = shared;
+    compact = shared ? shared->compact : compact;
+    refresh();
+  }
+
+  // empties the buffer, the storage is freed with its last user
+  void reset(const bool compactMode) {
+    storage.reset();
+    compact = compactMode;
+    refresh();
+  }
+
+  size_t size() const {
+    return count;
+  }
+
+  size_t bytes() const {
+    if (!storage) return 0;
+    return compact ? storage->samples.capacity() * sizeof(int16_t) : storage->frames.capacity() * sizeof(rack::dsp::Frame<N>);
+  }
+
+  void clear() {
+    resize(0);
+  }
+
+  void resize(const size_t n) {
+    Storage &s = edit();
+    if (compact) s.samples.resize(n * N);
+    else s.frames.resize(n);
+    refresh();
+  }
+
+  void reserve(const size_t n) {
+    Storage &s = edit();
+    if (compact) s.samples.reserve(n * N);
+    else s.frames.reserve(n);
+    refresh();
+  }
+
+  inline float sample(const size_t i, const int c) const {
+    return compact ? sampleData[i * N + c] * (1.0f / 32767.0f) : frameData[i].samples[c];
+  }
+
+  inline rack::dsp::Frame<N> operator[](const size_t i) const {
+    rack::dsp::Frame<N> frame;
+    for (int c = 0; c < N; c++) {
+      frame.samples[c] = sample(i, c);
+    }
+    return frame;
+  }
+
+  inline void set(const size_t i, const rack::dsp::Frame<N> &frame) {
+    Storage &s = edit();
+    if (compact) {
+      for (int c = 0; c < N; c++) {
+        s.samples[i * N + c] = toInt16(frame.samples[c]);
+      }
+    }
+    else {
+      s.frames[i] = frame;
+    }
+    refresh();
+  }
+
+  void push_back(const rack::dsp::Frame<N> &frame) {
+    resize(size() + 1);
+    set(size() - 1, frame);
+  }
+
+  void append(const rack::dsp::Frame<N> *in, const size_t n) {
+    const size_t start = size();
+    resize(start + n);
+    Storage &s = *storage;
+    for (size_t i = 0; i < n; i++) {
+      if (compact) {
+        for (int c = 0; c < N; c++) {
+          s.samples[(start + i) * N + c] = toInt16(in[i].samples[c]);
+        }
+      }
+      else {
+        s.frames[start + i] = in[i];
+      }
+    }
+  }
+
+  // removes frames [from, to)
+  void erase(const size_t from, const size_t to) {
+    Storage &s = edit();
+    if (compact) s.samples.erase(s.samples.begin() + from * N, s.samples.begin() + to * N);
+    else s.frames.erase(s.frames.begin() + from, s.frames.begin() + to);
+    refresh();
+  }
+};
+
+// Min/max overview of a sample for the displays. Level k keeps one peak per 2^(6+k) frames
+// and is built from the level below, so a pixel is drawn from a handful of entries whatever
+// the sample length or zoom, spans under 64 frames are read from the buffer. update redoes
+// the levels from a frame on, after an append (recording) or an erase (slice delete).
+template <int N>
+struct PeakPyramid {
+  static constexpr int baseShift = 6;
+
+  struct Peak {
+    int16_t min[N];
+    int16_t max[N];
+  };
+
+  std::vector<std::vector<Peak>> levels;
+  size_t frames = 0;
+
+  void clear() {
+    levels.clear();
+    frames = 0;
+  }
+
+  void build(const SampleBuffer<N> &buffer) {
+    levels.clear();
+    update(buffer, 0);
+  }
+
+  void update(const SampleBuffer<N> &buffer, const size_t from) {
+    frames = buffer.size();
+    size_t first = std::min(from, frames) >> baseShift;
+    size_t count = (frames + (1 << baseShift) - 1) >> baseShift;
+    size_t level = 0;
+    while (true) {
+      if (levels.size() <= level) {
+        levels.emplace_back();
+      }
+      std::vector<Peak> &peaks = levels[level];
+      peaks.resize(count);
+      for (size_t i = first; i < count; i++) {
+        Peak &p = peaks[i];
+        if (level == 0) {
+          const size_t end = std::min(frames, (i + 1) << baseShift);
+          for (int c = 0; c < N; c++) {
+            float lo = buffer.sample(i << baseShift, c);
+            float hi = lo;
+            for (size_t j = (i << baseShift) + 1; j < end; j++) {
+              const float x = buffer.sample(j, c);
+              lo = std::min(lo, x);
+              hi = std::max(hi, x);
+            }
+            p.min[c] = SampleBuffer<N>::toInt16(lo);
+            p.max[c] = SampleBuffer<N>::toInt16(hi);
+          }
+        }
+        else {
+          const std::vector<Peak> &below = levels[level - 1];
+          p = below[2 * i];
+          if (2 * i + 1 < below.size()) {
+            for (int c = 0; c < N; c++) {
+              p.min[c] = std::min(p.min[c], below[2 * i + 1].min[c]);
+              p.max[c] = std::max(p.max[c], below[2 * i + 1].max[c]);
+            }
+          }
+        }
+      }
+      if (count <= 1) {
+        break;
+      }
+      first >>= 1;
+      count = (count + 1) >> 1;
+      level++;
+    }
+    levels.resize(level + 1);
+  }
+
+  // min and max of channel c in the frames [start + x * framesPerPixel, start + (x+1) *
+  // framesPerPixel) for x in [0, pixels), 0 outside the sample
+  void draw(const SampleBuffer<N> &buffer, const int c, const double start, const double framesPerPixel, const int pixels, float *lo, float *hi) const {
+    const size_t n = std::min(frames, buffer.size());
+    for (int x = 0; x < pixels; x++) {
+      const double a = start + x * framesPerPixel;
+      const size_t from = a <= 0.0 ? 0 : (size_t)a;
+      size_t to = std::min(n, (size_t)std::max(0.0, std::ceil(a + framesPerPixel)));
+      lo[x] = 0.0f;
+      hi[x] = 0.0f;
+      if (from >= n) {
+        continue;
+      }
+      to = std::max(to, from + 1);
+      const size_t span = to - from;
+      if (span < ((size_t)1 << baseShift) || levels.empty()) {
+        lo[x] = hi[x] = buffer.sample(from, c);
+        for (size_t j = from + 1; j < to; j++) {
+          const float v = buffer.sample(j, c);
+          lo[x] = std::min(lo[x], v);
+          hi[x] = std::max(hi[x], v);
+        }
+        continue;
+      }
+      // coarsest level whose peaks are not wider than the span, edge peaks may overlap
+      // the neighbour pixels by less than a pixel
+      size_t level = 0;
+      while ((level + 1 < levels.size()) && (((size_t)1 << (baseShift + level + 1)) <= span)) {
+        level++;
+      }
+      const int shift = baseShift + level;
+      const std::vector<Peak> &peaks = levels[level];
+      int16_t l = peaks[from >> shift].min[c];
+      int16_t h = peaks[from >> shift].max[c];
+      for (size_t i = (from >> shift) + 1; i <= ((to - 1) >> shift); i++) {
+        l = std::min(l, peaks[i].min[c]);
+        h = std::max(h, peaks[i].max[c]);
+      }
+      lo[x] = l * (1.0f / 32767.0f);
+      hi[x] = h * (1.0f / 32767.0f);
+    }
+  }
+};
+
+// Single producer single consumer ring, push and pop never allocate nor lock. Each side
+// must stay on one thread, size is what the ring holds.
+template <typename T, size_t S>
+struct SpscQueue {
+  T items[S];
+  std::atomic<size_t> readIndex{0};
+  std::atomic<size_t> writeIndex{0};
+
+  size_t size() const {
+    return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  // producer side, false when full
+  bool push(const T &item) {
+    const size_t w = writeIndex.load(std::memory_order_relaxed);
+    if (w - readIndex.load(std::memory_order_acquire) >= S) {
+      return false;
+    }
+    items[w % S] = item;
+    writeIndex.store(w + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side, false when empty
+  bool pop(T &item) {
+    const size_t r = readIndex.load(std::memory_order_relaxed);
+    if (r == writeIndex.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = items[r % S];
+    readIndex.store(r + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+// Read copy update handoff of an immutable T. Readers (the audio thread, the display, one
+// slot each) enter, use the pointer and leave : a load and two stores, they never wait.
+// Writers, serialized by the caller, copy what they change and publish the new T, the old
+// one is retired and deleted by a later publish or reclaim once every reader that could
+// still hold it has left or entered again.
+template <typename T, int R = 2>
+struct Published {
+  std::atomic<T*> current{NULL};
+  std::atomic<uint64_t> epoch{1};
+  // epoch a reader entered at, 0 while it is out
+  std::atomic<uint64_t> readers[R];
+  // writer side
+  std::vector<std::pair<T*, uint64_t>> retired;
+  std::atomic<size_t> pending{0};
+
+  Published() {
+    for (int r = 0; r < R; r++) {
+      readers[r].store(0);
+    }
+    current.store(new T());
+  }
+  Published(const Published &) = delete;
+  Published &operator=(const Published &) = delete;
+
+  ~Published() {
+    delete current.load();
+    for (auto &old : retired) {
+      delete old.first;
+    }
+  }
+
+  const T *enter(const int r) {
+    readers[r].store(epoch.load());
+    return current.load();
+  }
+
+  void leave(const int r) {
+    readers[r].store(0);
+  }
+
+  // writer side, what to copy from
+  const T &get() const {
+    return *current.load();
+  }
+
+  // true while retired values wait for reclaim, readable from any side
+  bool retiring() const {
+    return pending.load() > 0;
+  }
+
+  void publish(T *next) {
+    T *old = current.exchange(next);
+    retired.push_back(std::make_pair(old, epoch.fetch_add(1)));
+    reclaim();
+  }
+
+  // writer side, deletes what no reader can hold anymore
+  void reclaim() {
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); i++) {
+      bool held = false;
+      for (int r = 0; r < R; r++) {
+        const uint64_t e = readers[r].load();
+        held = held || ((e != 0) && (e <= retired[i].second));
+      }
+      if (held) retired[kept++] = retired[i];
+      else delete retired[i].first;
+    }
+    retired.resize(kept);
+    pending.store(kept);
+  }
+};
+
+// Recording take kept in fixed size segments. reserve allocates them off the audio thread
+// and hands them over through a single producer single consumer ring, so push only writes
+// frames and pops segments : it never allocates nor locks. Once the take is stopped, stitch
+// appends it to a buffer, from the same side as reserve, and recycles the segments.
+template <int N>
+struct RecordArena {
+  static constexpr size_t segmentFrames = 1 << 14;
+  // segments kept ready, about 1.4s at 48kHz
+  static constexpr size_t ahead = 4;
+  static constexpr size_t ringSize = 8;
+
+  enum States {
+    ARENA_IDLE,
+    ARENA_RECORDING,
+    ARENA_STOPPED
+  };
+
+  struct Segment {
+    Segment *next = NULL;
+    rack::dsp::Frame<N> frames[segmentFrames];
+  };
+
+  SpscQueue<Segment*, ringSize> ring;
+  std::atomic<int> state{ARENA_IDLE};
+  // written by the audio side, read by stitch once the take is stopped
+  Segment *first = NULL;
+  Segment *last = NULL;
+  size_t length = 0;
+  size_t limit = 0;
+
+  RecordArena() {}
+  RecordArena(const RecordArena &) = delete;
+  RecordArena &operator=(const RecordArena &) = delete;
+
+  ~RecordArena() {
+    while (first) {
+      Segment *next = first->next;
+      delete first;
+      first = next;
+    }
+    Segment *s = NULL;
+    while (ring.pop(s)) {
+      delete s;
+    }
+  }
+
+  size_t ready() const {
+    return ring.size();
+  }
+
+  // reserve side
+  bool give(Segment *s) {
+    s->next = NULL;
+    return ring.push(s);
+  }
+
+  // tops the ring up, new zeroes the frames so their pages are mapped before the audio
+  // thread writes them
+  void reserve() {
+    while (ready() < ahead) {
+      give(new Segment());
+    }
+  }
+
+  // audio side, false while the previous take waits for stitch
+  bool start(const size_t maxFrames) {
+    if (state.load(std::memory_order_acquire) != ARENA_IDLE) {
+      return false;
+    }
+    first = NULL;
+    last = NULL;
+    length = 0;
+    limit = maxFrames;
+    state.store(ARENA_RECORDING, std::memory_order_release);
+    return true;
+  }
+
+  // audio side, false once the take reached its limit or the reserved segments ran out
+  bool push(const rack::dsp::Frame<N> &frame) {
+    if (length >= limit) {
+      return false;
+    }
+    const size_t offset = length % segmentFrames;
+    if (offset == 0) {
+      Segment *s = NULL;
+      if (!ring.pop(s)) {
+        return false;
+      }
+      if (last) last->next = s;
+      else first = s;
+      last = s;
+    }
+    last->frames[offset] = frame;
+    length++;
+    return true;
+  }
+
+  void stop() {
+    state.store(ARENA_STOPPED, std::memory_order_release);
+  }
+
+  bool recording() const {
+    return state.load(std::memory_order_acquire) == ARENA_RECORDING;
+  }
+
+  bool stopped() const {
+    return state.load(std::memory_order_acquire) == ARENA_STOPPED;
+  }
+
+  // reserve side, appends the stopped take to buffer and gets ready for the next one, the
+  // segments beyond what the ring keeps ahead are freed
+  void stitch(SampleBuffer<N> &buffer) {
+    buffer.reserve(buffer.size() + length);
+    size_t left = length;
+    while (first) {
+      Segment *next = first->next;
+      const size_t n = std::min(left, (size_t)segmentFrames);
+      buffer.append(first->frames, n);
+      left -= n;
+      if ((ready() >= ahead) || !give(first)) {
+        delete first;
+      }
+      first = next;
+    }
+    last = NULL;
+    length = 0;
+    state.store(ARENA_IDLE, std::memory_order_release);
+  }
+};
+
+// Storage mode of the next loads and recordings, compact by default on MetaModule.
+void setCompactSamples(const bool compact);
+
+bool getCompactSamples();
+
+// What a WAV or AIFF file holds, read from its header only. frames is capped to the data
+// actually in the file, so a truncated file reports what a load would get.
+struct SampleInfo {
+  bool valid = false;
+  uint64_t frames = 0;
+  int channels = 0;
+  int sampleRate = 0;
+  int bitDepth = 0;
+  bool floating = false;
+
+  // bytes a load into n channels at targetRate allocates, in the current storage mode
+  size_t estimate(const int n, const float targetRate) const;
+};
+
+SampleInfo probe(const std::string &path);
+
+// Loads go through a process wide pool keyed by path, modification time, size, target rate,
+// resample quality and storage mode : a file already held by another module, or another
+// OAI channel, is shared instead of decoded again. Entries go away with their last buffer.
+void getMonoWav(const std::string path, const float currentSampleRate, std::string &waveFileName, std::string &waveExtension, int &sampleChannels, int &sampleRate, int &sampleCount, SampleBuffer<1> &result);
+
+void getStereoWav(const std::string path, const float currentSampleRate, std::string &waveFileName, std::string &waveExtension, int &sampleChannels, int &sampleRate, int &sampleCount, SampleBuffer<2> &result);
+
+// number of files currently held by the pool
+size_t getPooledSamples();
+
+// Output format of the saves, integer depths get TPDF dither, applies to the next saves.
+enum SaveFormats {
+  SAVE_INT16,
+  SAVE_INT24,
+  SAVE_INT32,
+  SAVE_FLOAT32,
+  NUM_SAVE_FORMATS
+};
+
+static const std::string saveFormatLabels[NUM_SAVE_FORMATS] = {"16 bit", "24 bit", "32 bit", "32 bit float"};
+
+void setSaveFormat(const int format);
+
+int getSaveFormat();
+
+// Background save of a stereo buffer. start takes a snapshot sharing the buffer storage,
+// the module only pays for a copy if it writes to the buffer before the save is over. run
+// then writes the file chunk by chunk, from whatever thread the module saves on, while the
+// widget reads state and progress.
+struct SaveJob {
+  enum States {
+    SAVE_IDLE,
+    SAVE_PENDING,
+    SAVE_RUNNING,
+    SAVE_DONE,
+    SAVE_FAILED
+  };
+
+  SampleBuffer<2> sample;
+  int sampleRate = 0;
+  int format = SAVE_INT32;
+  std::string path;
+  std::atomic<int> state{SAVE_IDLE};
+  std::atomic<size_t> written{0};
+  std::atomic<size_t> total{0};
+
+  // false while a previous save is not over
+  bool start(const SampleBuffer<2> &buffer, const int rate, const std::string &destination);
+  void run();
+
+  bool busy() const {
+    return (state == SAVE_PENDING) || (state == SAVE_RUNNING);
+  }
+
+  float progress() const {
+    const size_t n = total;
+    return n > 0 ? (float)written / n : (state == SAVE_DONE ? 1.0f : 0.0f);
+  }
+};
+
+// blocking save in the current save format
+void saveWave(const SampleBuffer<2> &sample, int sampleRate, std::string path);
+
+// Onset detection function, one value per 256 frames window.
+enum OnsetFeatures {
+  ONSET_ENERGY,
+  ONSET_SPECTRAL_FLUX,
+  NUM_ONSET_FEATURES
+};
+
+static const std::string onsetFeatureLabels[NUM_ONSET_FEATURES] = {"Energy", "Spectral flux"};
+
+// Transient detection split in two : the features of a sample are computed once, a few
+// windows per step from a background thread, then slices only thresholds the cached array
+// so a sensitivity change costs one pass over a value per window. Energy is the left channel
+// power, spectral flux the positive magnitude change of a 1024 points spectrum of the mid
+// channel, normalized to 10 so the thresholds read alike. All calls come from one thread.
+struct OnsetDetector {
+  static constexpr int window = 256;
+  static constexpr int fftSize = 1024;
+  static constexpr size_t stepWindows = 256;
+
+  SampleBuffer<2> sample;
+  int feature = ONSET_ENERGY;
+  unsigned version = 0;
+  bool running = false;
+  size_t next = 0;
+  std::vector<float> values;
+  // first silent frame of each window, where the slice goes
+  std::vector<uint8_t> offsets;
+  // spectral flux state, allocated with the first flux job
+  PFFFT_Setup *setup = NULL;
+  float *in = NULL;
+  float *out = NULL;
+  std::vector<float> hann;
+  std::vector<float> magnitudes;
+
+  OnsetDetector() {}
+  OnsetDetector(const OnsetDetector &) = delete;
+  OnsetDetector &operator=(const OnsetDetector &) = delete;
+  ~OnsetDetector();
+
+  // drops the current job and analyses buffer, tagged with the caller version
+  void start(const SampleBuffer<2> &buffer, const unsigned bufferVersion, const int onsetFeature);
+  // true when this step finished the job
+  bool step();
+  // frames where the windows go over threshold, starting with 0
+  void slices(const float threshold, std::vector<int> &result) const;
+};
 
 }
@@ -0,0 +1,48 @@
+#pragma once
+
+namespace zoumaimessage {
+
+  // ZOUMAIExpander -> ZOUMAI frames, only written when something changed :
+  // version, sequence number, flags, dirty tracks mask, then trackFields floats
+  // for each dirty track in ascending order.
+  // A frame that does not follow the last applied one makes ZOUMAI ask for a full
+  // frame (all tracks) and ignore everything else until it gets one.
+
+  static constexpr int version = 1;
+  static constexpr int size = 64;
+  static constexpr int seqModulo = 1 << 16;
+
+  enum HeaderIds {
+    VERSION,
+    SEQ,
+    FLAGS,
+    DIRTY,
+    headerSize
+  };
+
+  static constexpr int flagFull = 0x1;
+
+  enum TrackIds {
+    TRACK_SWITCHES,
+    TRACK_TRSP,
+    TRACK_DICE,
+    TRACK_ROTLEFT,
+    TRACK_ROTRIGHT,
+    TRACK_ROTLEN,
+    trackFields
+  };
+
+  static constexpr int switchFill = 0x1;
+  static constexpr int switchForce = 0x2;
+  static constexpr int switchKill = 0x4;
+
+  // ZOUMAI -> ZOUMAIExpander, written when one of the values changes
+  enum BackIds {
+    BACK_PATTERN,
+    BACK_RESYNC,
+    backSize
+  };
+
+  static_assert(headerSize + 8 * trackFields <= size, "a full frame has to fit in the message");
+
+}
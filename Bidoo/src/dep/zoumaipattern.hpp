@@ -0,0 +1,437 @@
+#pragma once
+#include <rack.hpp>
+#include <cstdint>
+#include <vector>
+#include "chunk.hpp"
+
+namespace zoumaipattern {
+
+  // One 32 bytes record per trig, stored contiguously per track so that evaluating, copying or
+  // rotating trigs only ever touches whole records.
+  struct TrigAttibutes {
+
+    uint32_t mainAttributes = 0;
+    uint32_t probAttributes = 0;
+    float slide = 0.0f;
+    float trim = 0.0f;
+    float length = 0.9f;
+    float pulseDistance = 0.5f;
+    float cv1 = 0.0f;
+    float cv2 = 0.0f;
+
+    static const unsigned long TRIG_ACTIVE					= 0x1;
+    static const unsigned long TRIG_INITIALIZED			= 0x2;
+    static const unsigned long TRIG_SLEEPING				= 0x4;
+    static const unsigned long TRIG_TYPE						= 0x18; static const unsigned long trigTypeShift = 3;
+    static const unsigned long TRIG_INDEX						= 0xFE0; static const unsigned long trigIndexShift = 5;
+    static const unsigned long TRIG_PULSECOUNT			= 0x7F000; static const unsigned long trigPulseCountShift = 12;
+    static const unsigned long TRIG_OCTAVE					= 0x780000; static const unsigned long trigOctaveShift = 19;
+    static const unsigned long TRIG_SEMITONES				= 0x7800000; static const unsigned long trigSemitonesShift = 23;
+    static const unsigned long TRIG_SLIDETYPE				= 0x8000000;
+
+    static const unsigned long TRIG_PROBA						= 0xFF;
+    static const unsigned long TRIG_COUNT						= 0xFF00; static const unsigned long trigCountShift = 8;
+    static const unsigned long TRIG_COUNTRESET			= 0xFF0000; static const unsigned long trigCountResetShift = 16;
+    static const unsigned long TRIG_INCOUNT					= 0xFF000000; static const unsigned long trigInCountShift = 24;
+
+
+    static const unsigned long intiMainAttributes = 1576960;
+    static const unsigned long intiProbAttributes = 91136;
+
+    inline void init() {
+      mainAttributes = intiMainAttributes;
+      probAttributes = intiProbAttributes;
+      slide = 0.0f;
+      trim = 0.0f;
+      length = 0.9f;
+      pulseDistance = 0.5f;
+      cv1 = 0.0f;
+      cv2 = 0.0f;
+    }
+
+    inline void randomize() {
+      setTrigActive(rack::random::uniform()>0.5f);
+      setTrigOctave(rack::random::uniform()*2.0f + 2.0f);
+      setTrigSemiTones(rack::random::uniform()*11.0f);
+    }
+
+    inline void randomizeProbs() {
+      setTrigProba(rack::random::uniform()*7.0f);
+      setTrigCount(rack::random::uniform()*100.0f);
+      setTrigCountReset(rack::random::uniform()*100.0f);
+    }
+
+    inline void fullRandomize() {
+      randomize();
+      setTrigPulseCount(rack::random::uniform()*10.0f);
+    }
+
+    inline bool getTrigActive() {return (mainAttributes & TRIG_ACTIVE) != 0;}
+    inline bool getTrigInitialized() {return (mainAttributes & TRIG_INITIALIZED) != 0;}
+    inline bool getTrigSleeping() {return (mainAttributes & TRIG_SLEEPING) != 0;}
+    inline int getTrigType() {return (mainAttributes & TRIG_TYPE) >> trigTypeShift;}
+    inline int getTrigIndex() {return (mainAttributes & TRIG_INDEX) >> trigIndexShift;}
+    inline int getTrigPulseCount() {return (mainAttributes & TRIG_PULSECOUNT) >> trigPulseCountShift;}
+    inline int getTrigOctave() {return (mainAttributes & TRIG_OCTAVE) >> trigOctaveShift;}
+    inline int getTrigSemiTones() {return (mainAttributes & TRIG_SEMITONES) >> trigSemitonesShift;}
+    inline bool getTrigSlideType() {return (mainAttributes & TRIG_SLIDETYPE) != 0;}
+
+    inline int getTrigProba() {return (probAttributes & TRIG_PROBA);}
+    inline int getTrigCount() {return (probAttributes & TRIG_COUNT) >> trigCountShift;}
+    inline int getTrigCountReset() {return (probAttributes & TRIG_COUNTRESET) >> trigCountResetShift;}
+    inline int getTrigInCount() {return (probAttributes & TRIG_INCOUNT) >> trigInCountShift;}
+
+    inline uint32_t getMainAttributes() {return mainAttributes;}
+    inline uint32_t getProbAttributes() {return probAttributes;}
+
+    inline void setTrigActive(const bool trigActive) {mainAttributes &= ~TRIG_ACTIVE; if (trigActive) mainAttributes |= TRIG_ACTIVE;}
+    inline void setTrigInitialized(const bool trigInitialize) {mainAttributes &= ~TRIG_INITIALIZED; if (trigInitialize) mainAttributes |= TRIG_INITIALIZED;}
+    inline void setTrigSleeping(const bool trigSleep) {mainAttributes &= ~TRIG_SLEEPING; if (trigSleep) mainAttributes |= TRIG_SLEEPING;}
+    inline void setTrigType(const int trigType) {mainAttributes &= ~TRIG_TYPE; mainAttributes |= (trigType << trigTypeShift);}
+    inline void setTrigIndex(const int trigIndex) {mainAttributes &= ~TRIG_INDEX; mainAttributes |= (trigIndex << trigIndexShift);}
+    inline void setTrigPulseCount(const int trigPulseCount) {mainAttributes &= ~TRIG_PULSECOUNT; mainAttributes |= (trigPulseCount << trigPulseCountShift);}
+    inline void setTrigOctave(const int trigOctave) {mainAttributes &= ~TRIG_OCTAVE; mainAttributes |= (trigOctave << trigOctaveShift);}
+    inline void setTrigSemiTones(const int trigSemiTones) {mainAttributes &= ~TRIG_SEMITONES; mainAttributes |= (trigSemiTones << trigSemitonesShift);}
+    inline void setTrigSlideType(const bool trigSlideType) {mainAttributes &= ~TRIG_SLIDETYPE; if (trigSlideType) mainAttributes |= TRIG_SLIDETYPE;}
+
+    inline void setTrigProba(const int trigProba) {probAttributes &= ~TRIG_PROBA; probAttributes |= trigProba;}
+    inline void setTrigCount(const int trigCount) {probAttributes &= ~TRIG_COUNT; probAttributes |= (trigCount << trigCountShift);}
+    inline void setTrigCountReset(const int trigCountReset) {probAttributes &= ~TRIG_COUNTRESET; probAttributes |= (trigCountReset << trigCountResetShift);}
+    inline void setTrigInCount(const int trigInCount) {probAttributes &= ~TRIG_INCOUNT; probAttributes |= (trigInCount << trigInCountShift);}
+
+    inline void toggleTrigActive() {mainAttributes ^= TRIG_ACTIVE;}
+
+    inline void setMainAttributes(const uint32_t _mainAttributes) {mainAttributes = _mainAttributes;}
+    inline void setProbAttributes(const uint32_t _probAttributes) {probAttributes = _probAttributes;}
+
+    // probability state written while playing
+    inline void copyPlayback(const TrigAttibutes &from) {
+      mainAttributes = (mainAttributes & ~(TRIG_INITIALIZED | TRIG_SLEEPING)) | (from.mainAttributes & (TRIG_INITIALIZED | TRIG_SLEEPING));
+      probAttributes = (probAttributes & ~TRIG_INCOUNT) | (from.probAttributes & TRIG_INCOUNT);
+    }
+
+    inline void clearPlayback() {
+      mainAttributes &= ~(TRIG_INITIALIZED | TRIG_SLEEPING);
+      probAttributes &= ~TRIG_INCOUNT;
+    }
+
+    // the same bits packed in 10, for the patterns that are not played
+    inline uint16_t getPlayback() const {
+      return ((mainAttributes & (TRIG_INITIALIZED | TRIG_SLEEPING)) >> 1) | ((probAttributes & TRIG_INCOUNT) >> (trigInCountShift - 2));
+    }
+
+    inline void setPlayback(const uint16_t playback) {
+      mainAttributes = (mainAttributes & ~(TRIG_INITIALIZED | TRIG_SLEEPING)) | ((playback << 1) & (TRIG_INITIALIZED | TRIG_SLEEPING));
+      probAttributes = (probAttributes & ~TRIG_INCOUNT) | (((uint32_t)playback << (trigInCountShift - 2)) & TRIG_INCOUNT);
+    }
+
+    inline void up() {
+      if (getTrigSemiTones()==11) {
+        setTrigOctave(getTrigOctave()+1);
+        setTrigSemiTones(0);
+      }
+      else {
+        setTrigSemiTones(getTrigSemiTones()+1);
+      }
+    }
+
+    inline void down() {
+      if (getTrigSemiTones()==0) {
+        setTrigOctave(getTrigOctave()-1);
+        setTrigSemiTones(11);
+      }
+      else {
+        setTrigSemiTones(getTrigSemiTones()-1);
+      }
+    }
+
+    inline bool hasProbability() {
+      return (getTrigProba() != 4) && (getTrigProba() != 5) && !((getTrigProba() == 0) && (getTrigCount() == 100));
+    }
+
+    inline float getVO() {
+      return (float)getTrigOctave() - 3.0f + (float)getTrigSemiTones()/12.0f;
+    }
+
+    inline void init(const bool fill, const bool pre, const bool nei, const bool force, const bool kill, const float dice) {
+      if (!getTrigInitialized()) {
+
+        setTrigInitialized(true);
+
+        switch (getTrigProba()) {
+          case 0:  // DICE
+            if (force) {
+              setTrigSleeping(false);
+              break;
+            }
+            if (getTrigCount()<100) {
+              if (kill) {
+                setTrigSleeping(true);
+                break;
+              }
+              setTrigSleeping((rack::random::uniform()*100)>=(rack::math::clamp(getTrigCount()+dice*100,0.0f,100.0f)));
+            }
+            else
+              setTrigSleeping(false);
+            break;
+          case 1:  // COUNT
+            if (force) {
+              setTrigSleeping(false);
+              break;
+            }
+            if (kill) {
+              setTrigSleeping(true);
+              break;
+            }
+            setTrigSleeping(getTrigInCount() > getTrigCount());
+            setTrigInCount((getTrigInCount() >= getTrigCountReset()) ? 1 : (getTrigInCount() + 1));
+            break;
+          case 2:  // FILL
+            if (force) {
+              setTrigSleeping(false);
+              break;
+            }
+            if (kill) {
+              setTrigSleeping(true);
+              break;
+            }
+            setTrigSleeping(!fill);
+            break;
+          case 3:  // !FILL
+            if (force) {
+              setTrigSleeping(false);
+              break;
+            }
+            if (kill) {
+              setTrigSleeping(true);
+              break;
+            }
+            setTrigSleeping(fill);
+            break;
+          case 4:  // PRE
+            if (force) {
+              setTrigSleeping(false);
+              break;
+            }
+            if (kill) {
+              setTrigSleeping(true);
+              break;
+            }
+            setTrigSleeping(!pre);
+            break;
+          case 5:  // !PRE
+            if (force) {
+              setTrigSleeping(false);
+              break;
+            }
+            if (kill) {
+              setTrigSleeping(true);
+              break;
+            }
+            setTrigSleeping(pre);
+            break;
+          case 6:  // NEI
+            if (force) {
+              setTrigSleeping(false);
+              break;
+            }
+            if (kill) {
+              setTrigSleeping(true);
+              break;
+            }
+            setTrigSleeping(!nei);
+            break;
+          case 7:  // !NEI
+            if (force) {
+              setTrigSleeping(false);
+              break;
+            }
+            if (kill) {
+              setTrigSleeping(true);
+              break;
+            }
+            setTrigSleeping(nei);
+            break;
+          default:
+            setTrigSleeping(false);
+            break;
+        }
+      }
+    }
+  };
+
+  static_assert(sizeof(TrigAttibutes) == 32, "trig records are expected to be 32 bytes");
+
+  struct TrackAttibutes {
+
+    unsigned long mainAttributes;
+    unsigned long refAttributes;
+
+    static const unsigned long TRACK_ACTIVE					= 0x1;
+    static const unsigned long TRACK_FORWARD				= 0x2;
+    static const unsigned long TRACK_PRE						= 0x4;
+    static const unsigned long TRACK_SOLO						= 0x8;
+    static const unsigned long TRACK_LENGTH					= 0x7F0; static const unsigned long trackLengthShift = 4;
+    static const unsigned long TRACK_READMODE				= 0x3800; static const unsigned long trackReadModeShift = 11;
+    static const unsigned long TRACK_SPEED					= 0x1C000; static const unsigned long trackSpeedShift = 14;
+
+    static const unsigned long TRACK_CURRENTTRIG		= 0xFF;
+    static const unsigned long TRACK_PLAYEDTRIG			= 0xFF00; static const unsigned long trackPlayedTrigShift = 8;
+    static const unsigned long TRACK_PREVTRIG				= 0xFF0000; static const unsigned long trackPrevTrigShift = 16;
+    static const unsigned long TRACK_NEXTTRIG				= 0xFF000000; static const unsigned long trackNextTrigShift = 24;
+
+    static const unsigned long intiMainAttributes = 16643;
+    static const unsigned long intiRefAttributes = 0;
+
+    inline void init() {
+      mainAttributes = intiMainAttributes;
+      refAttributes = intiRefAttributes;
+    }
+
+    inline void randomize() {
+      setTrackLength(1+rack::random::uniform()*63);
+      setTrackReadMode(rack::random::uniform()*4);
+    }
+
+    inline void fullRandomize() {
+      randomize();
+      setTrackSpeed(1+rack::random::uniform()*3);
+    }
+
+    inline bool getTrackActive() {return (mainAttributes & TRACK_ACTIVE) != 0;}
+    inline bool getTrackForward() {return (mainAttributes & TRACK_FORWARD) != 0;}
+    inline bool getTrackPre() {return (mainAttributes & TRACK_PRE) != 0;}
+    inline bool getTrackSolo() {return (mainAttributes & TRACK_SOLO) != 0;}
+    inline int getTrackLength() {return (mainAttributes & TRACK_LENGTH) >> trackLengthShift;}
+    inline int getTrackReadMode() {return (mainAttributes & TRACK_READMODE) >> trackReadModeShift;}
+    inline int getTrackSpeed() {return (mainAttributes & TRACK_SPEED) >> trackSpeedShift;}
+
+    inline int getTrackCurrentTrig() {return (refAttributes & TRACK_CURRENTTRIG);}
+    inline int getTrackPlayedTrig() {return (refAttributes & TRACK_PLAYEDTRIG) >> trackPlayedTrigShift;}
+    inline int getTrackPrevTrig() {return (refAttributes & TRACK_PREVTRIG) >> trackPrevTrigShift;}
+    inline int getTrackNextTrig() {return (refAttributes & TRACK_NEXTTRIG) >> trackNextTrigShift;}
+
+    inline unsigned long getMainAttributes() {return mainAttributes;}
+    inline unsigned long getRefAttributes() {return refAttributes;}
+
+    inline void setTrackActive(const bool trackActive) {mainAttributes &= ~TRACK_ACTIVE; if (trackActive) mainAttributes |= TRACK_ACTIVE;}
+    inline void setTrackForward(const bool trackForward) {mainAttributes &= ~TRACK_FORWARD; if (trackForward) mainAttributes |= TRACK_FORWARD;}
+    inline void setTrackPre(const bool trackPre) {mainAttributes &= ~TRACK_PRE; if (trackPre) mainAttributes |= TRACK_PRE;}
+    inline void setTrackSolo(const bool trackSolo) {mainAttributes &= ~TRACK_SOLO; if (trackSolo) mainAttributes |= TRACK_SOLO;}
+    inline void setTrackLength(const int trackLength) {mainAttributes &= ~TRACK_LENGTH; mainAttributes |= (trackLength << trackLengthShift);}
+    inline void setTrackReadMode(const int trackReadMode) {mainAttributes &= ~TRACK_READMODE; mainAttributes |= (trackReadMode << trackReadModeShift);}
+    inline void setTrackSpeed(const int trackSpeed) {mainAttributes &= ~TRACK_SPEED; mainAttributes |= (trackSpeed << trackSpeedShift);}
+
+    inline void setTrackCurrentTrig(const int trackCurrentTrig) {refAttributes &= ~TRACK_CURRENTTRIG; refAttributes |= trackCurrentTrig;}
+    inline void setTrackPlayedTrig(const int trackPlayedTrig) {refAttributes &= ~TRACK_PLAYEDTRIG; refAttributes |= (trackPlayedTrig << trackPlayedTrigShift);}
+    inline void setTrackPrevTrig(const int trackPrevTrig) {refAttributes &= ~TRACK_PREVTRIG; refAttributes |= (trackPrevTrig << trackPrevTrigShift);}
+    inline void setTrackNextTrig(const int trackNextTrig) {refAttributes &= ~TRACK_NEXTTRIG; refAttributes |= (trackNextTrig << trackNextTrigShift);}
+
+    inline void toggleTrackActive() {mainAttributes ^= TRACK_ACTIVE;}
+    inline void toggleTrackSolo() {mainAttributes ^= TRACK_SOLO;}
+
+    inline void setMainAttributes(const unsigned long _mainAttributes) {mainAttributes = _mainAttributes;}
+    inline void setRefAttributes(const unsigned long _refAttributes) {refAttributes = _refAttributes;}
+
+    // read position and direction written while playing
+    inline void copyPlayback(const TrackAttibutes &from) {
+      mainAttributes = (mainAttributes & ~(TRACK_FORWARD | TRACK_PRE)) | (from.mainAttributes & (TRACK_FORWARD | TRACK_PRE));
+      refAttributes = from.refAttributes;
+    }
+
+    inline void clearPlayback() {
+      mainAttributes &= ~(TRACK_FORWARD | TRACK_PRE);
+      refAttributes = 0;
+    }
+  };
+
+  // One pattern as the UI sees it. The play state (see the copyPlayback functions) is kept
+  // apart by ZOUMAI and cleared here, a pattern only changes when it is edited.
+  struct Pattern {
+    TrigAttibutes trigs[8][64];
+    TrackAttibutes tracks[8];
+    int rootNote[8];
+    int scale[8];
+    int quantizeCV1[8];
+    bool slideMode[8];
+
+    inline void clearPlayback() {
+      for (int i = 0; i < 8; i++) {
+        tracks[i].clearPlayback();
+        for (int j = 0; j < 64; j++) {
+          trigs[i][j].clearPlayback();
+        }
+      }
+    }
+  };
+
+  // Binary pattern chunk, see chunk.hpp. Version 1 payload, for each pattern and track :
+  // track main attributes (u32), root note, scale, quantize CV1, slide mode (u8 each),
+  // then for each of the 64 trigs : main and prob attributes (u32), slide, trim, length,
+  // pulse distance, CV1, CV2 (f32) and slide type (u8).
+  // Runtime only bits (initialized, sleeping, in count) are not stored.
+
+  static const uint32_t patternsChunkMagic = 0x4D554F5A; // "ZOUM"
+  static const uint16_t patternsChunkVersion = 1;
+  static const size_t patternsChunkPayloadSize = 8*8*(8+64*33);
+  static const size_t patternsChunkSize = chunk::headerSize + patternsChunkPayloadSize + chunk::checksumSize;
+
+  inline std::vector<uint8_t> patternsToChunk(Pattern *const patterns[8]) {
+    chunk::Writer w(patternsChunkMagic, patternsChunkVersion, patternsChunkPayloadSize);
+    for (int i = 0; i<8; i++) {
+      Pattern &pattern = *patterns[i];
+      for (int j = 0; j<8; j++) {
+        w.u32(pattern.tracks[j].getMainAttributes());
+        w.u8((uint8_t)(int8_t)pattern.rootNote[j]);
+        w.u8(pattern.scale[j]);
+        w.u8(pattern.quantizeCV1[j]);
+        w.u8(pattern.slideMode[j]);
+        for (int k = 0; k<64; k++) {
+          TrigAttibutes &trig = pattern.trigs[j][k];
+          w.u32(trig.getMainAttributes() & ~(TrigAttibutes::TRIG_INITIALIZED | TrigAttibutes::TRIG_SLEEPING | TrigAttibutes::TRIG_SLIDETYPE));
+          w.u32(trig.getProbAttributes() & ~TrigAttibutes::TRIG_INCOUNT);
+          w.f32(trig.slide);
+          w.f32(trig.trim);
+          w.f32(trig.length);
+          w.f32(trig.pulseDistance);
+          w.f32(trig.cv1);
+          w.f32(trig.cv2);
+          w.u8(trig.getTrigSlideType());
+        }
+      }
+    }
+    return w.finish();
+  }
+
+  // leaves patterns untouched and returns false when the chunk is not a valid version 1 chunk
+  inline bool patternsFromChunk(const std::vector<uint8_t> &data, Pattern *const patterns[8]) {
+    chunk::Reader r(data, patternsChunkMagic);
+    if (!r.ok() || (r.version != patternsChunkVersion) || (data.size() != patternsChunkSize)) {
+      return false;
+    }
+    for (int i = 0; i<8; i++) {
+      Pattern &pattern = *patterns[i];
+      for (int j = 0; j<8; j++) {
+        pattern.tracks[j].setMainAttributes(r.u32());
+        pattern.rootNote[j] = (int8_t)r.u8();
+        pattern.scale[j] = r.u8();
+        pattern.quantizeCV1[j] = r.u8();
+        pattern.slideMode[j] = r.u8();
+        for (int k = 0; k<64; k++) {
+          TrigAttibutes &trig = pattern.trigs[j][k];
+          trig.setMainAttributes(r.u32());
+          trig.setProbAttributes(r.u32());
+          trig.slide = r.f32();
+          trig.trim = r.f32();
+          trig.length = r.f32();
+          trig.pulseDistance = r.f32();
+          trig.cv1 = r.f32();
+          trig.cv2 = r.f32();
+          trig.setTrigSlideType(r.u8());
+        }
+      }
+    }
+    return r.ok();
+  }
+
+}
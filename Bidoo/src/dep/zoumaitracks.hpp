@@ -0,0 +1,366 @@
+#pragma once
+#include <rack.hpp>
+#include <algorithm>
+#include <cmath>
+#include "zoumaipattern.hpp"
+
+namespace zoumaitracks {
+
+  // Play heads of the 8 tracks of the pattern being played (work) and how they move through its
+  // trigs, kept apart from the module so that the sample accurate event stream can be checked
+  // without a module (see tests/zoumaitracks_schedule.cpp). Heads and tick counts are kept for every
+  // pattern, only those of currentPattern move.
+  struct Tracks {
+    zoumaipattern::Pattern work = {};
+    int currentPattern = 0;
+    float trackHead[8][8] = {{0.0f}};
+    float trackCurrentTickCount[8][8] = {{0.0f}};
+    float trackLastTickCount[8][8] = {{0.0f}};
+
+    bool trackScheduled[8] = {0};
+    float trackEventLow[8] = {0.0f};
+    float trackEventHigh[8] = {0.0f};
+    float trackGate[8] = {0.0f};
+
+    void trackSync(const int track, const float cCount, const float lCount, const float tHead) {
+      trackCurrentTickCount[currentPattern][track] = cCount;
+      trackLastTickCount[currentPattern][track] = lCount;
+      trackHead[currentPattern][track] = std::fmod(tHead,work.tracks[track].getTrackLength()) ;
+    }
+
+    float trackGetGate(const int track, const int tPT) {
+      if (work.trigs[track][tPT].getTrigActive() && !work.trigs[track][tPT].getTrigSleeping()) {
+        float rTP = trigGetRelativeTrackPosition(track, tPT);
+        if (rTP >= 0) {
+          if (rTP<work.trigs[track][tPT].length) {
+            return 10.0f;
+          }
+          else {
+            int cPulses = (work.trigs[track][tPT].pulseDistance == 0) ? 0 : (int)(rTP/(float)work.trigs[track][tPT].pulseDistance);
+            return ((cPulses<work.trigs[track][tPT].getTrigPulseCount())
+            && (rTP>=(cPulses*work.trigs[track][tPT].pulseDistance))
+            && (rTP<=((cPulses*work.trigs[track][tPT].pulseDistance)+work.trigs[track][tPT].length))) ? 10.0f : 0.0f;
+          }
+        }
+        else
+          return 0.0f;
+      }
+      else
+        return 0.0f;
+    }
+
+    float trigGetRelativeTrackPosition(const int track, const int trig) {
+      return trackHead[currentPattern][track] - trigGetTrimedIndex(track, trig);
+    }
+
+    float trigGetFullLength(const int track, const int trig) {
+      return work.trigs[track][trig].getTrigPulseCount() == 1 ? work.trigs[track][trig].length : ((work.trigs[track][trig].getTrigPulseCount()*work.trigs[track][trig].pulseDistance) + work.trigs[track][trig].length);
+    }
+
+    bool trigGetIsRead(const int track, const int trig, const float trackPosition) {
+      float tI = trigGetTrimedIndex(track,trig);
+      return (trackPosition>=tI) && (trackPosition<=(tI+trigGetFullLength(track, trig)));
+    }
+
+    float trigGetTrimedIndex(const int track, const int trig) {
+      return work.trigs[track][trig].getTrigIndex() + work.trigs[track][trig].trim;
+    }
+
+    void trackSetCurrentTrig(const int track, const bool fill, const bool pNei, const bool force=false, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
+      int cI = work.tracks[track].getTrackCurrentTrig();
+      if (((int)trackHead[currentPattern][track] != cI) || force) {
+        work.tracks[track].setTrackPre((work.trigs[track][cI].getTrigActive() && work.trigs[track][cI].hasProbability()) ? !work.trigs[track][cI].getTrigSleeping() : work.tracks[track].getTrackPre());
+        work.trigs[track][cI].setTrigInitialized(false);
+        work.tracks[track].setTrackCurrentTrig((int)trackHead[currentPattern][track]);
+        cI = work.tracks[track].getTrackCurrentTrig();
+        work.trigs[track][cI].init(fill,work.tracks[track].getTrackPre(),pNei, forceTrig, killTrig, dice);
+        work.tracks[track].setTrackPre((work.trigs[track][cI].getTrigActive()
+        && work.trigs[track][cI].hasProbability()) ? !work.trigs[track][cI].getTrigSleeping() : work.tracks[track].getTrackPre());
+        trackSetNextTrig(track);
+        work.trigs[track][work.tracks[track].getTrackNextTrig()].init(fill,work.tracks[track].getTrackPre(),pNei, forceTrig, killTrig, dice);
+      }
+
+      int cPT = work.tracks[track].getTrackPlayedTrig();
+      if (trigGetIsRead(track, cI, trackHead[currentPattern][track])) {
+        if ((cI != cPT)	&& work.trigs[track][cI].getTrigActive() && !work.trigs[track][cI].getTrigSleeping()) {
+          work.tracks[track].setTrackPrevTrig(cPT);
+          work.tracks[track].setTrackPlayedTrig(cI);
+        }
+      }
+      else {
+        int cNT = work.tracks[track].getTrackNextTrig();
+        if (trigGetIsRead(track, cNT, trackHead[currentPattern][track]) && (cNT != cPT)
+        && work.trigs[track][cNT].getTrigActive()
+        && !work.trigs[track][cNT].getTrigSleeping())
+        {
+          work.tracks[track].setTrackPrevTrig(cPT);
+          work.tracks[track].setTrackPlayedTrig(cNT);
+        }
+      }
+    }
+
+    void trackReset(const int track, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
+      work.tracks[track].setTrackPre(false);
+      work.tracks[track].setTrackForward(true);
+
+      if (work.tracks[track].getTrackReadMode() == 1)
+      {
+        work.tracks[track].setTrackForward(false);
+        trackHead[currentPattern][track] = work.tracks[track].getTrackLength()-1;
+        trackSetCurrentTrig(track, fill, pNei, true, forceTrig, killTrig, dice);
+        trackHead[currentPattern][track] = work.tracks[track].getTrackLength();
+      }
+      else
+      {
+        trackHead[currentPattern][track] = 0.0f;
+        trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
+      }
+    }
+
+    void trackSetNextTrig(const int track) {
+      int cI = work.tracks[track].getTrackCurrentTrig();
+      switch (work.tracks[track].getTrackReadMode()) {
+        case 0:
+            work.tracks[track].setTrackNextTrig((cI == (work.tracks[track].getTrackLength()-1)) ? 0 : (cI+1)); break;
+        case 1:
+            work.tracks[track].setTrackNextTrig((cI == 0) ? (work.tracks[track].getTrackLength()-1) : (cI-1)); break;
+        case 2: {
+          if (cI == 0) {
+            work.tracks[track].setTrackNextTrig(work.tracks[track].getTrackLength() > 1 ? 1: 0);
+          }
+          else if (cI == (work.tracks[track].getTrackLength() - 1)) {
+            work.tracks[track].setTrackNextTrig(work.tracks[track].getTrackLength() > 1 ? (work.tracks[track].getTrackLength()-2) : 0);
+          }
+          else {
+            work.tracks[track].setTrackNextTrig(rack::math::clamp(cI + (work.tracks[track].getTrackForward() ? 1 : -1),0,work.tracks[track].getTrackLength() - 1));
+          }
+          break;
+        }
+        case 3: work.tracks[track].setTrackNextTrig((int)(rack::random::uniform()*(work.tracks[track].getTrackLength() - 1))); break;
+        case 4:
+        {
+          float dice = rack::random::uniform();
+          if (dice>=0.5f)
+            work.tracks[track].setTrackNextTrig(((cI+1) > (work.tracks[track].getTrackLength() - 1) ? 0 : (cI + 1)));
+          else if (dice<=0.25f)
+            work.tracks[track].setTrackNextTrig(cI == 0 ? (work.tracks[track].getTrackLength() - 1) : (cI - 1));
+          else
+            work.tracks[track].setTrackNextTrig(cI);
+          break;
+        }
+        default : work.tracks[track].setTrackNextTrig(cI);
+      }
+    }
+
+    void trackMoveNextForward(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
+      work.tracks[track].setTrackForward(true);
+      if (step) {
+        trackHead[currentPattern][track] = std::round(trackHead[currentPattern][track]);
+        trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
+        trackCurrentTickCount[currentPattern][track] = 0.0f;
+      }
+      else {
+        trackCurrentTickCount[currentPattern][track]++;
+        trackHead[currentPattern][track] += work.tracks[track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
+      }
+
+      if (trackHead[currentPattern][track] >= work.tracks[track].getTrackLength()) {
+        trackReset(track, fill, pNei, forceTrig, killTrig, dice);
+        return;
+      }
+
+      trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
+    }
+
+    void trackMoveNextBackward(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
+      work.tracks[track].setTrackForward(false);
+      if (step) {
+        trackHead[currentPattern][track] = std::round(trackHead[currentPattern][track]);
+        trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
+        trackCurrentTickCount[currentPattern][track] = 0.0f;
+      }
+      else {
+        trackCurrentTickCount[currentPattern][track]++;
+        trackHead[currentPattern][track] -= work.tracks[track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
+      }
+
+      if (trackHead[currentPattern][track] <= 0) {
+        trackReset(track, fill, pNei, forceTrig, killTrig, dice);
+        return;
+      }
+
+      trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
+    }
+
+    void trackMoveNextPendulum(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
+      if (step) {
+        trackHead[currentPattern][track] = std::round(trackHead[currentPattern][track]);
+        trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
+        trackCurrentTickCount[currentPattern][track] = 0.0f;
+      }
+      else {
+        trackCurrentTickCount[currentPattern][track]++;
+        trackHead[currentPattern][track] = trackHead[currentPattern][track] + (work.tracks[track].getTrackForward() ? 1 : -1 ) * work.tracks[track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
+      }
+
+      if (trackHead[currentPattern][track] >= work.tracks[track].getTrackLength()) {
+        work.tracks[track].setTrackForward(false);
+        trackHead[currentPattern][track] = (work.tracks[track].getTrackLength() == 1) ? 1 : (work.tracks[track].getTrackLength()-1);
+      }
+      else if (trackHead[currentPattern][track] <= 0) {
+        work.tracks[track].setTrackForward(true);
+        trackHead[currentPattern][track] = work.tracks[track].getTrackLength() > 1 ? 1 : 0;
+      }
+
+      trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
+    }
+
+    void trackMoveNextRandom(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
+      work.tracks[track].setTrackForward(true);
+      if (step) {
+        trackHead[currentPattern][track] = std::round(trackHead[currentPattern][track]);
+        trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
+        trackCurrentTickCount[currentPattern][track] = 0.0f;
+      }
+      else {
+        trackCurrentTickCount[currentPattern][track]++;
+        trackHead[currentPattern][track] += work.tracks[track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
+      }
+
+      if (trackHead[currentPattern][track] >= work.tracks[track].getTrackCurrentTrig()+1) {
+        trackHead[currentPattern][track] = work.tracks[track].getTrackNextTrig();
+        trackSetCurrentTrig(track, fill, pNei, true, forceTrig, killTrig, dice);
+        return;
+      }
+
+      trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig, dice);
+    }
+
+    void trackMoveNextBrownian(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
+      work.tracks[track].setTrackForward(true);
+      if (step) {
+        trackHead[currentPattern][track] = std::round(trackHead[currentPattern][track]);
+        trackLastTickCount[currentPattern][track] = trackCurrentTickCount[currentPattern][track];
+        trackCurrentTickCount[currentPattern][track] = 0.0f;
+      }
+      else {
+        trackCurrentTickCount[currentPattern][track]++;
+        trackHead[currentPattern][track] += work.tracks[track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
+      }
+
+      if (trackHead[currentPattern][track] >= work.tracks[track].getTrackCurrentTrig()+1) {
+        trackHead[currentPattern][track] = work.tracks[track].getTrackNextTrig();
+        trackSetCurrentTrig(track, fill, pNei, true, forceTrig, killTrig, dice);
+        return;
+      }
+
+      trackSetCurrentTrig(track, fill, pNei, false, forceTrig, killTrig);
+    }
+
+    void trackMoveNext(const int track, const bool step, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
+      switch (work.tracks[track].getTrackReadMode()) {
+        case 0: trackMoveNextForward(track, step, fill, pNei, forceTrig, killTrig, dice); break;
+        case 1: trackMoveNextBackward(track, step, fill, pNei, forceTrig, killTrig, dice); break;
+        case 2: trackMoveNextPendulum(track, step, fill, pNei, forceTrig, killTrig, dice); break;
+        case 3: trackMoveNextRandom(track, step, fill, pNei, forceTrig, killTrig, dice); break;
+        case 4: trackMoveNextBrownian(track, step, fill, pNei, forceTrig, killTrig, dice); break;
+      }
+    }
+
+    // Between two events nothing but the head moves : the current trig, the played trig and the gate
+    // only change when the head crosses an integer or one of the gate edges of the trigs around it.
+    // trackSchedule stores the open head interval around the next edges, trackMoveNextScheduled
+    // then only advances the head as long as it stays inside it. Any write to work has to call
+    // trackInvalidate, ZOUMAI::patternsAdopt invalidates every track.
+
+    void trackInvalidate(const int track) {
+      trackScheduled[track] = false;
+    }
+
+    void tracksInvalidate() {
+      for (int i=0; i<8; i++) {
+        trackScheduled[i] = false;
+      }
+    }
+
+    void trackScheduleEdge(const float edge, const float head, float &low, float &high) {
+      if (edge > head) {
+        high = std::min(high, edge);
+      }
+      else if (edge < head) {
+        low = std::max(low, edge);
+      }
+      else {
+        low = head;
+        high = head;
+      }
+    }
+
+    void trackScheduleTrig(const int track, const int trig, const float head, float &low, float &high) {
+      const float tI = trigGetTrimedIndex(track, trig);
+      const float tLength = work.trigs[track][trig].length;
+      const float tDistance = work.trigs[track][trig].pulseDistance;
+      trackScheduleEdge(tI, head, low, high);
+      trackScheduleEdge(tI + tLength, head, low, high);
+      trackScheduleEdge(tI + trigGetFullLength(track, trig), head, low, high);
+      if (tDistance > 0.0f) {
+        const int pulses = work.trigs[track][trig].getTrigPulseCount();
+        for (int k = 1; k <= pulses; k++) {
+          trackScheduleEdge(tI + k * tDistance, head, low, high);
+          trackScheduleEdge(tI + k * tDistance + tLength, head, low, high);
+        }
+      }
+    }
+
+    void trackSchedule(const int track) {
+      // keep clear of the edges so float rounding in the gate maths can't fall on the wrong side
+      static const float margin = 1e-4f;
+      const float head = trackHead[currentPattern][track];
+      float low = floorf(head);
+      float high = low + 1.0f;
+      trackScheduleTrig(track, work.tracks[track].getTrackPlayedTrig(), head, low, high);
+      trackScheduleTrig(track, work.tracks[track].getTrackCurrentTrig(), head, low, high);
+      trackScheduleTrig(track, work.tracks[track].getTrackNextTrig(), head, low, high);
+      trackEventLow[track] = low + margin;
+      trackEventHigh[track] = high - margin;
+      trackScheduled[track] = trackEventLow[track] < trackEventHigh[track];
+    }
+
+    bool trackMoveNextScheduled(const int track) {
+      if (!trackScheduled[track]) {
+        return false;
+      }
+      const float delta = work.tracks[track].getTrackSpeed()/trackLastTickCount[currentPattern][track];
+      const float head = trackHead[currentPattern][track];
+      float nextHead;
+      switch (work.tracks[track].getTrackReadMode()) {
+        case 1: nextHead = head - delta; break;
+        case 2: nextHead = work.tracks[track].getTrackForward() ? (head + delta) : (head - delta); break;
+        default: nextHead = head + delta;
+      }
+      if ((nextHead <= trackEventLow[track]) || (nextHead >= trackEventHigh[track])) {
+        return false;
+      }
+      trackCurrentTickCount[currentPattern][track]++;
+      trackHead[currentPattern][track] = nextHead;
+      return true;
+    }
+
+    // One sample of a track : the head only takes the long way through trackMoveNext on a clock,
+    // when it leaves the scheduled interval or when schedule is false (recording).
+    bool trackAdvance(const int track, const bool step, const bool schedule, const bool fill, const bool pNei, const bool forceTrig = false, const bool killTrig = false, const float dice = 0.0f) {
+      const bool scheduled = !step && schedule && trackMoveNextScheduled(track);
+      if (!scheduled) {
+        trackMoveNext(track, step, fill, pNei, forceTrig, killTrig, dice);
+      }
+      return scheduled;
+    }
+
+    // gate of the played trig, then the interval it holds in
+    void trackGateUpdate(const int track) {
+      trackGate[track] = trackGetGate(track, work.tracks[track].getTrackPlayedTrig());
+      trackSchedule(track);
+    }
+  };
+
+}
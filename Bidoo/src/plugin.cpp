@@ -1,4 +1,5 @@
 #include "plugin.hpp"
+#include "dep/waves.hpp"
 // #include <iostream>
 
 #if defined(METAMODULE_BUILTIN)
@@ -27,8 +28,8 @@ void init(rack::Plugin *p) {
 	p->addModel(modelDILEMO);
 	// p->addModel(modelDTROY);
 	p->addModel(modelDUKE);
-	// p->addModel(modelENCORE);
-	// // p->addModel(modelENCOREExpander);
+	p->addModel(modelENCORE);
+	p->addModel(modelENCOREExpander);
 	p->addModel(modelEDSAROS);
 	p->addModel(modelEMILE);
 	// p->addModel(modelFLAME);
@@ -102,15 +103,55 @@ void BidooWidget::appendContextMenu(Menu *menu) {
 	}));
 }
 
+void BidooWidget::ResampleQualityItem::onAction(const event::Action &e) {
+	waves::setResampleQuality(quality);
+	pWidget->writeDefaults();
+}
+
+// shared by the sample modules, the quality is global and kept in Bidoo.json
+void BidooWidget::appendResampleMenu(Menu *menu) {
+	menu->addChild(createSubmenuItem("Resampling", waves::resampleQualityLabels[waves::getResampleQuality()], [=](ui::Menu* menu) {
+		for (int i = 0; i < waves::NUM_RESAMPLE_QUALITIES; i++) {
+			menu->addChild(construct<ResampleQualityItem>(&MenuItem::text, waves::getResampleQuality() == i ? waves::resampleQualityLabels[i] + " ✓" : waves::resampleQualityLabels[i], &ResampleQualityItem::pWidget, this, &ResampleQualityItem::quality, i));
+		}
+	}));
+}
+
+void BidooWidget::CompactSamplesItem::onAction(const event::Action &e) {
+	waves::setCompactSamples(!waves::getCompactSamples());
+	pWidget->writeDefaults();
+}
+
+// applies to the next loads and recordings
+void BidooWidget::appendCompactMenu(Menu *menu) {
+	menu->addChild(construct<CompactSamplesItem>(&MenuItem::text, "16 bit sample storage", &MenuItem::rightText, CHECKMARK(waves::getCompactSamples()), &CompactSamplesItem::pWidget, this));
+}
+
+void BidooWidget::SaveFormatItem::onAction(const event::Action &e) {
+	waves::setSaveFormat(format);
+	pWidget->writeDefaults();
+}
+
+void BidooWidget::appendSaveFormatMenu(Menu *menu) {
+	menu->addChild(createSubmenuItem("Save format", waves::saveFormatLabels[waves::getSaveFormat()], [=](ui::Menu* menu) {
+		for (int i = 0; i < waves::NUM_SAVE_FORMATS; i++) {
+			menu->addChild(construct<SaveFormatItem>(&MenuItem::text, waves::getSaveFormat() == i ? waves::saveFormatLabels[i] + " ✓" : waves::saveFormatLabels[i], &SaveFormatItem::pWidget, this, &SaveFormatItem::format, i));
+		}
+	}));
+}
+
 unsigned int packedColor(int r, int g, int b, int a) {
 	return r + (g << 8) + (b << 16) + (a << 24);
 }
 
-void BidooWidget::writeThemeAndContrastAsDefault() {
+void BidooWidget::writeDefaults() {
 	json_t *settingsJ = json_object();
 
 	// defaultPanelTheme
 	json_object_set_new(settingsJ, "themeDefault", json_integer(defaultPanelTheme));
+	json_object_set_new(settingsJ, "resampleQuality", json_integer(waves::getResampleQuality()));
+	json_object_set_new(settingsJ, "compactSamples", json_boolean(waves::getCompactSamples()));
+	json_object_set_new(settingsJ, "saveFormat", json_integer(waves::getSaveFormat()));
 
 	std::string settingsFilename = asset::user("Bidoo.json");
 	FILE *file = fopen(settingsFilename.c_str(), "w");
@@ -121,12 +162,12 @@ void BidooWidget::writeThemeAndContrastAsDefault() {
 	json_decref(settingsJ);
 }
 
-void BidooWidget::readThemeAndContrastFromDefault() {
+void BidooWidget::readDefaults() {
 	std::string settingsFilename = asset::user("Bidoo.json");
 	FILE *file = fopen(settingsFilename.c_str(), "r");
 	if (!file) {
 		defaultPanelTheme = 0;
-		writeThemeAndContrastAsDefault();
+		writeDefaults();
 		return;
 	}
 	json_error_t error;
@@ -134,7 +175,7 @@ void BidooWidget::readThemeAndContrastFromDefault() {
 	if (!settingsJ) {
 		fclose(file);
 		defaultPanelTheme = 0;
-		writeThemeAndContrastAsDefault();
+		writeDefaults();
 		return;
 	}
 
@@ -147,13 +188,28 @@ void BidooWidget::readThemeAndContrastFromDefault() {
 		defaultPanelTheme = 0;
 	}
 
+	json_t *resampleQualityJ = json_object_get(settingsJ, "resampleQuality");
+	if (resampleQualityJ) {
+		waves::setResampleQuality(json_integer_value(resampleQualityJ));
+	}
+
+	json_t *compactSamplesJ = json_object_get(settingsJ, "compactSamples");
+	if (compactSamplesJ) {
+		waves::setCompactSamples(json_boolean_value(compactSamplesJ));
+	}
+
+	json_t *saveFormatJ = json_object_get(settingsJ, "saveFormat");
+	if (saveFormatJ) {
+		waves::setSaveFormat(json_integer_value(saveFormatJ));
+	}
+
 	fclose(file);
 	json_decref(settingsJ);
 	return;
 }
 
 void BidooWidget::prepareThemes(const std::string& filename) {
-	readThemeAndContrastFromDefault();
+	readDefaults();
 
 	setPanel(APP->window->loadSvg(filename));
 }
@@ -162,7 +218,7 @@ void BidooWidget::step() {
 	// if (module) {
 	// 	if ((dynamic_cast<BidooModule*>(module)->loadDefault) && (dynamic_cast<BidooModule*>(module)->themeId == -1)) {
 	// 		dynamic_cast<BidooModule*>(module)->loadDefault = false;
-	// 		readThemeAndContrastFromDefault();
+	// 		readDefaults();
 	// 		dynamic_cast<BidooModule*>(module)->themeId = defaultPanelTheme;
 	// 		if (defaultPanelTheme == 0) {
 	// 			lightPanel->setVisible(true);
@@ -240,7 +296,7 @@ void BidooWidget::step() {
 	// 	}
 	// }
 	// else {
-	// 	readThemeAndContrastFromDefault();
+	// 	readDefaults();
 	// 	if (defaultPanelTheme == 0) {
 	// 		lightPanel->setVisible(true);
 	// 		darkPanel->setVisible(false);
@@ -88,7 +88,7 @@ struct BidooWidget : ModuleWidget {
 	int defaultPanelTheme = 0;
 
 	BidooWidget() {
-		readThemeAndContrastFromDefault();
+		readDefaults();
 	}
 
 	struct LightItem : MenuItem {
@@ -98,7 +98,7 @@ struct BidooWidget : ModuleWidget {
 			module->themeId = 0;
 			module->themeChanged = true;
 			pWidget->defaultPanelTheme = 0;
-			pWidget->writeThemeAndContrastAsDefault();
+			pWidget->writeDefaults();
 		}
 	};
 
@@ -109,7 +109,7 @@ struct BidooWidget : ModuleWidget {
 			module->themeId = 1;
 			module->themeChanged = true;
 			pWidget->defaultPanelTheme = 1;
-			pWidget->writeThemeAndContrastAsDefault();
+			pWidget->writeDefaults();
 		}
 	};
 
@@ -120,7 +120,7 @@ struct BidooWidget : ModuleWidget {
 			module->themeId = 2;
 			module->themeChanged = true;
 			pWidget->defaultPanelTheme = 2;
-			pWidget->writeThemeAndContrastAsDefault();
+			pWidget->writeDefaults();
 		}
 	};
 
@@ -131,7 +131,7 @@ struct BidooWidget : ModuleWidget {
 			module->themeId = 3;
 			module->themeChanged = true;
 			pWidget->defaultPanelTheme = 3;
-			pWidget->writeThemeAndContrastAsDefault();
+			pWidget->writeDefaults();
 		}
 	};
 
@@ -142,13 +142,33 @@ struct BidooWidget : ModuleWidget {
 			module->themeId = 4;
 			module->themeChanged = true;
 			pWidget->defaultPanelTheme = 4;
-			pWidget->writeThemeAndContrastAsDefault();
+			pWidget->writeDefaults();
 		}
 	};
 
-	void writeThemeAndContrastAsDefault();
-	void readThemeAndContrastFromDefault();
+	struct ResampleQualityItem : MenuItem {
+		BidooWidget *pWidget;
+		int quality;
+		void onAction(const event::Action &e) override;
+	};
+
+	struct CompactSamplesItem : MenuItem {
+		BidooWidget *pWidget;
+		void onAction(const event::Action &e) override;
+	};
+
+	struct SaveFormatItem : MenuItem {
+		BidooWidget *pWidget;
+		int format;
+		void onAction(const event::Action &e) override;
+	};
+
+	void writeDefaults();
+	void readDefaults();
 	void prepareThemes(const std::string& filename);
 	void appendContextMenu(Menu *menu) override;
+	void appendResampleMenu(Menu *menu);
+	void appendCompactMenu(Menu *menu);
+	void appendSaveFormatMenu(Menu *menu);
 	void step() override;
 };
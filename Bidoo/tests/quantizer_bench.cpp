@@ -0,0 +1,98 @@
+// Nearest note cost per value : the old binary search over the map, the rank lookup that
+// replaced it and its float_4 entry point, for the voltage alone and for the chord. The
+// float_4 results are checked against the old search first, ties included.
+
+#include "quantizer_reference.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+static const int rounds = 200;
+
+// scales a module would use, from the shortest map to the longest
+static const int benchScales[] = {24, 1, 22, 31, 45};
+
+// keeps the timed loops from being optimized away
+static volatile float sink = 0.0f;
+
+static bool same(const float a, const float b) {
+  return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+template <typename F>
+static double nsPerValue(const std::vector<float> &values, F f) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r<rounds; r++) {
+    f();
+  }
+  const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  return ns / ((double)rounds * values.size());
+}
+
+int main() {
+  static quantizer_reference::Maps reference;
+  quantizer::Quantizer q;
+  int failures = 0;
+
+  for (int r=-1; r<12; r++) {
+    for (int s=0; s<quantizer::numScales; s++) {
+      std::vector<float> values = quantizer_reference::voltages(reference, r, s);
+      while (values.size() % 4) values.push_back(0.0f);
+      for (size_t i = 0; i<values.size(); i+=4) {
+        const rack::simd::float_4 in = rack::simd::float_4::load(&values[i]);
+        const rack::simd::float_4 got = q.closestVoltageInScale(in, r, s);
+        const quantizer::Chord4 chord = q.closestChordInScale(in, r, s);
+        for (int c = 0; c<4; c++) {
+          const float expected = std::get<0>(quantizer_reference::closestVoltageInScale(reference, values[i+c], r, s));
+          const quantizer::Chord e = quantizer_reference::closestChordInScale(reference, values[i+c], r, s);
+          if (!same(expected, got[c]) || !same(e.tonic, chord.tonic[c]) || !same(e.third, chord.third[c]) || !same(e.fifth, chord.fifth[c])
+            || !same(e.seventh, chord.seventh[c]) || !same(e.ninth, chord.ninth[c]) || !same(e.eleventh, chord.eleventh[c]) || !same(e.thirteenth, chord.thirteenth[c])) {
+            if (failures++ == 0) {
+              printf("  float_4 root %d scale %d at %a : %a/%a\n", r, s, values[i+c], expected, got[c]);
+            }
+          }
+        }
+      }
+    }
+  }
+  if (failures) {
+    printf("  FAILED\n");
+    return 1;
+  }
+
+  // 1V/oct inputs wandering over the range like an LFO or a sequencer would
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> u(-4.5f, 6.5f);
+  std::vector<float> values(4096);
+  for (float &v : values) v = u(rng);
+
+  printf("  ns per value         search   scalar  float_4 | chord search   scalar  float_4\n");
+  for (int s : benchScales) {
+    const int root = 3;
+    const double searchNs = nsPerValue(values, [&]() {
+      for (float v : values) sink += std::get<0>(quantizer_reference::closestVoltageInScale(reference, v, root, s));
+    });
+    const double scalarNs = nsPerValue(values, [&]() {
+      for (float v : values) sink += std::get<0>(q.closestVoltageInScale(v, root, s));
+    });
+    const double simdNs = nsPerValue(values, [&]() {
+      rack::simd::float_4 acc = 0.0f;
+      for (size_t i = 0; i<values.size(); i+=4) acc = acc + q.closestVoltageInScale(rack::simd::float_4::load(&values[i]), root, s);
+      sink += acc[0] + acc[1] + acc[2] + acc[3];
+    });
+    const double chordSearchNs = nsPerValue(values, [&]() {
+      for (float v : values) sink += quantizer_reference::closestChordInScale(reference, v, root, s).thirteenth;
+    });
+    const double chordScalarNs = nsPerValue(values, [&]() {
+      for (float v : values) sink += q.closestChordInScale(v, root, s).thirteenth;
+    });
+    const double chordSimdNs = nsPerValue(values, [&]() {
+      rack::simd::float_4 acc = 0.0f;
+      for (size_t i = 0; i<values.size(); i+=4) acc = acc + q.closestChordInScale(rack::simd::float_4::load(&values[i]), root, s).thirteenth;
+      sink += acc[0] + acc[1] + acc[2] + acc[3];
+    });
+    printf("  %-16s %8.2f %8.2f %8.2f | %12.2f %8.2f %8.2f\n", quantizer::scales[s].label.c_str(), searchNs, scalarNs, simdNs, chordSearchNs, chordScalarNs, chordSimdNs);
+  }
+  return 0;
+}
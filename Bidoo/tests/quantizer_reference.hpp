@@ -0,0 +1,159 @@
+#pragma once
+// The quantizer as it was before the shared tables : one map per instance and a binary
+// search for the nearest note. Kept here so the tests can check the current one against it.
+
+#include "quantizer.hpp"
+
+namespace quantizer_reference {
+
+  using quantizer::numScales;
+  using quantizer::scales;
+
+  // the old constructor only wrote the notes in range, the rest stays at zero like in the shared table
+  struct Maps {
+    float map[12][numScales][121] = {};
+
+    Maps() {
+      for (int l=0; l<12; l++) {
+        for(int i=0; i<numScales; i++) {
+          int index = 0;
+          for (int j=0; j<11; j++) {
+            for (int k=0; k<scales[i].numNotes;k++) {
+              float pitch = -5.f + l/12.0f + j + scales[i].intervals[k]/12.0f;
+              if ((pitch>=-4.0f) && (pitch<=6.0f)) {
+                map[l][i][index]=pitch;
+                index++;
+              }
+            }
+          }
+        }
+      }
+    }
+  };
+
+  inline std::tuple<float, int> getNearest(float x, float y, float target, int lower, int upper) {
+    if (target - x >= y - target)
+    {
+      return std::make_tuple(y,upper);
+    }
+    else
+    {
+      return std::make_tuple(x,lower);
+    }
+  }
+
+  inline std::tuple<float, int> getNearestElement(const float arr[], int n, float target) {
+   if (target <= arr[0]) {
+     return std::make_tuple(arr[0],0);
+   }
+
+   if (target >= arr[n - 1]) {
+     return std::make_tuple(arr[n - 1],n-1);
+   }
+
+   int left = 0, right = n, mid = 0;
+   while (left < right) {
+      mid = (left + right) / 2;
+      if (arr[mid] == target) {
+        return std::make_tuple(arr[mid],mid);
+      }
+
+      if (target < arr[mid]) {
+        if ((mid > 0) && (target > arr[mid - 1])) {
+          return getNearest(arr[mid - 1], arr[mid], target, mid-1, mid);
+        }
+        right = mid;
+      }
+      else
+      {
+       if ((mid < n - 1) && (target < arr[mid + 1])) {
+         return getNearest(arr[mid], arr[mid + 1], target, mid, mid+1);
+       }
+       left = mid + 1;
+      }
+   }
+   return std::make_tuple(arr[mid],mid);
+  }
+
+  inline std::tuple<float, int> quantize(const Maps &m, float voltsIn) {
+    return getNearestElement(m.map[0][26], scales[26].numNotes*10, voltsIn);
+  }
+
+  inline std::tuple<float, int> closestVoltageInScale(const Maps &m, float voltsIn, int rootNote, int scale) {
+    if (scale == 0) {
+      return std::make_tuple(voltsIn,0);
+    }
+    else if (rootNote==-1) {
+      return quantize(m, voltsIn);
+    }
+    else {
+      return getNearestElement(m.map[rootNote][scale], scales[scale].numNotes*10, voltsIn);
+    }
+  }
+
+  inline quantizer::Chord closestChordInScale(const Maps &m, float voltsIn, int rootNote, int scale) {
+    quantizer::Chord result;
+    if (scale == 0) {
+      result.tonic = voltsIn;
+      result.third = voltsIn;
+      result.fifth = voltsIn;
+      result.seventh = voltsIn;
+      result.ninth = voltsIn;
+      result.eleventh = voltsIn;
+      result.thirteenth = voltsIn;
+    }
+    else if (rootNote==-1) {
+      float pitch;
+      int index;
+      std::tie(pitch, index) = quantize(m, voltsIn);
+      result.tonic = pitch;
+      result.third = result.tonic;
+      result.fifth = result.tonic;
+      result.seventh = result.tonic;
+      result.ninth = result.tonic;
+      result.eleventh = result.tonic;
+      result.thirteenth = result.tonic;
+    }
+    else {
+      const float *map = m.map[rootNote][scale];
+      const int n = scales[scale].numNotes*10;
+      float pitch;
+      int index;
+      std::tie(pitch, index) = getNearestElement(map, n, voltsIn);
+      result.tonic = pitch;
+      result.third = map[rack::math::clamp(index+2,0,n)];
+      result.fifth = map[rack::math::clamp(index+4,0,n)];
+      result.seventh = map[rack::math::clamp(index+6,0,n)];
+      result.ninth = map[rack::math::clamp(index+8,0,n)];
+      result.eleventh = map[rack::math::clamp(index+10,0,n)];
+      result.thirteenth = map[rack::math::clamp(index+12,0,n)];
+    }
+    return result;
+  }
+
+  // a sweep over -6V..7V plus every note of the map, its float neighbours and the midpoints
+  // between two notes, where the ties are decided
+  inline std::vector<float> voltages(const Maps &m, int rootNote, int scale) {
+    std::vector<float> result;
+    for (int i=0; i<=13000; i++) {
+      result.push_back(-6.0f + i * 0.001f);
+    }
+    if ((rootNote >= 0) && (scale > 0)) {
+      const float *map = m.map[rootNote][scale];
+      const int n = scales[scale].numNotes*10;
+      for (int i=0; i<n; i++) {
+        result.push_back(map[i]);
+        result.push_back(std::nextafter(map[i], 10.0f));
+        result.push_back(std::nextafter(map[i], -10.0f));
+        if (i < n-1) {
+          const float half = (map[i] + map[i+1]) * 0.5f;
+          result.push_back(half);
+          result.push_back(std::nextafter(half, 10.0f));
+          result.push_back(std::nextafter(half, -10.0f));
+        }
+      }
+    }
+    return result;
+  }
+
+}
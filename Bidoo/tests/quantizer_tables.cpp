@@ -0,0 +1,55 @@
+// Shared quantizer tables against the per instance maps they replaced : every root and scale
+// map must be bit identical, and the nearest note and chord the same as with the old binary
+// search, for the 12 roots and the 46 scales (and no root).
+
+#include "quantizer_reference.hpp"
+#include <cstdio>
+#include <cstring>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  "); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static bool same(const float a, const float b) {
+  return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static bool same(const quantizer::Chord &a, const quantizer::Chord &b) {
+  return same(a.tonic, b.tonic) && same(a.third, b.third) && same(a.fifth, b.fifth) && same(a.seventh, b.seventh)
+    && same(a.ninth, b.ninth) && same(a.eleventh, b.eleventh) && same(a.thirteenth, b.thirteenth);
+}
+
+int main() {
+  static quantizer_reference::Maps reference;
+  quantizer::Quantizer q;
+
+  {
+    quantizer::Quantizer other;
+    CHECK(other.table == q.table, "instances do not share the table");
+  }
+  CHECK(memcmp(reference.map, q.table->map, sizeof(reference.map)) == 0, "maps differ");
+
+  long values = 0;
+  for (int r=-1; r<12; r++) {
+    for (int s=0; s<quantizer::numScales; s++) {
+      int mismatches = 0;
+      for (float v : quantizer_reference::voltages(reference, r, s)) {
+        float expected, got;
+        int expectedIndex, gotIndex;
+        std::tie(expected, expectedIndex) = quantizer_reference::closestVoltageInScale(reference, v, r, s);
+        std::tie(got, gotIndex) = q.closestVoltageInScale(v, r, s);
+        const bool chord = same(quantizer_reference::closestChordInScale(reference, v, r, s), q.closestChordInScale(v, r, s));
+        if (!same(expected, got) || (expectedIndex != gotIndex) || !chord) {
+          if (mismatches++ == 0) {
+            CHECK(false, "root %d scale %d at %a : %a/%a index %d/%d chord %s", r, s, v, expected, got, expectedIndex, gotIndex, chord ? "same" : "differs");
+          }
+        }
+        values++;
+      }
+    }
+  }
+
+  printf("  %ld values over 13 roots and %d scales\n", values, quantizer::numScales);
+  printf("  %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+// 16 bit sample storage against float storage : the same signals written through append, set
+// and the WAV loaders must null below -90dBFS, whatever their level. Values over full scale
+// are clipped to it.
+
+#include "waves.hpp"
+#include "dr_wav/dr_wav.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+static const double limitDb = -90.0;
+static const int rate = 44100;
+static const size_t frames = 1 << 18;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  "); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static double db(const double x) {
+  return 20.0 * log10(x > 1e-12 ? x : 1e-12);
+}
+
+// peak and rms of the difference, in dBFS
+template <int N>
+static void null(const char *label, const waves::SampleBuffer<N> &f, const waves::SampleBuffer<N> &c) {
+  CHECK(!f.compact && c.compact, "%s : storage modes", label);
+  CHECK(f.size() == c.size(), "%s : %zu frames against %zu", label, c.size(), f.size());
+  double peak = 0.0;
+  double sum = 0.0;
+  for (size_t i = 0; i<f.size(); i++) {
+    for (int k = 0; k<N; k++) {
+      const double e = (double)c.sample(i, k) - f.sample(i, k);
+      peak = std::max(peak, fabs(e));
+      sum += e * e;
+    }
+  }
+  const double rms = sqrt(sum / ((double)f.size() * N));
+  printf("  %-24s peak %6.1f dBFS rms %6.1f dBFS, %zu bytes instead of %zu\n", label, db(peak), db(rms), c.bytes(), f.bytes());
+  CHECK(db(peak) < limitDb, "%s : peak error %.1f dBFS", label, db(peak));
+}
+
+static void signal(std::vector<rack::dsp::Frame<2>> &out, const float gain) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+  out.resize(frames);
+  for (size_t i = 0; i<frames; i++) {
+    out[i].samples[0] = gain * u(rng);
+    out[i].samples[1] = gain * sinf(2.0f * M_PI * 441.0f * i / rate);
+  }
+}
+
+static bool writeWav(const std::string &path, const std::vector<rack::dsp::Frame<2>> &in) {
+  drwav_data_format format;
+  format.container = drwav_container_riff;
+  format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+  format.channels = 2;
+  format.sampleRate = rate;
+  format.bitsPerSample = 32;
+  drwav wav;
+  if (!drwav_init_file_write(&wav, path.c_str(), &format, NULL)) {
+    return false;
+  }
+  drwav_write_pcm_frames(&wav, in.size(), in.data());
+  drwav_uninit(&wav);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  std::vector<rack::dsp::Frame<2>> in;
+
+  // noise and sine at full scale, -20dB and -60dB
+  const float gains[] = {0.999f, 0.1f, 0.001f};
+  const char *levels[] = {"full scale", "-20dB", "-60dB"};
+  for (int g = 0; g<3; g++) {
+    const float gain = gains[g];
+    signal(in, gain);
+    char label[32];
+    snprintf(label, sizeof(label), "append %s", levels[g]);
+    waves::SampleBuffer<2> f, c;
+    f.reset(false);
+    c.reset(true);
+    f.append(in.data(), in.size());
+    c.append(in.data(), in.size());
+    null(label, f, c);
+
+    // recordings write frame by frame
+    waves::SampleBuffer<2> fs, cs;
+    fs.reset(false);
+    cs.reset(true);
+    fs.resize(in.size());
+    cs.resize(in.size());
+    for (size_t i = 0; i<in.size(); i++) {
+      fs.set(i, in[i]);
+      cs.set(i, in[i]);
+    }
+    snprintf(label, sizeof(label), "set %s", levels[g]);
+    null(label, fs, cs);
+  }
+
+  {
+    waves::SampleBuffer<1> c;
+    c.reset(true);
+    const rack::dsp::Frame<1> hot[4] = {{{1.5f}}, {{-3.0f}}, {{1.0f}}, {{-1.0f}}};
+    c.append(hot, 4);
+    CHECK(c.sample(0, 0) == 1.0f && c.sample(1, 0) == -1.0f && c.sample(2, 0) == 1.0f && c.sample(3, 0) == -1.0f, "over full scale is not clipped to it");
+  }
+
+  // the loaders, at the file rate so nothing is resampled
+  const std::string path = argc > 1 ? argv[1] : "waves_compact.wav";
+  signal(in, 0.999f);
+  if (!writeWav(path, in)) {
+    printf("  can not write %s\n", path.c_str());
+    return 1;
+  }
+  std::string name, extension;
+  int channels = 0, sampleRate = 0, count = 0;
+  {
+    waves::SampleBuffer<2> f, c;
+    waves::setCompactSamples(false);
+    waves::getStereoWav(path, rate, name, extension, channels, sampleRate, count, f);
+    waves::setCompactSamples(true);
+    waves::getStereoWav(path, rate, name, extension, channels, sampleRate, count, c);
+    CHECK(f.size() == frames, "getStereoWav : %zu frames", f.size());
+    null("getStereoWav", f, c);
+  }
+  {
+    waves::SampleBuffer<1> f, c;
+    waves::setCompactSamples(false);
+    waves::getMonoWav(path, rate, name, extension, channels, sampleRate, count, f);
+    waves::setCompactSamples(true);
+    waves::getMonoWav(path, rate, name, extension, channels, sampleRate, count, c);
+    CHECK(f.size() == frames, "getMonoWav : %zu frames", f.size());
+    null("getMonoWav", f, c);
+  }
+  remove(path.c_str());
+
+  printf("  %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
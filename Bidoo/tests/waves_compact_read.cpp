@@ -0,0 +1,76 @@
+// Read cost of the 16 bit sample storage against float storage and a plain frame vector, for
+// the reads the sample players do : one frame, and a linear interpolation between two
+// frames at a fractional position moving faster than the sample rate.
+
+#include "waves.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+static const size_t frames = 1 << 21;
+static const int rounds = 16;
+static const float speed = 1.37f;
+
+// keeps the timed loops from being optimized away
+static volatile float sink = 0.0f;
+
+template <typename F>
+static double nsPerRead(F f) {
+  const auto start = std::chrono::steady_clock::now();
+  float acc = 0.0f;
+  for (int r = 0; r<rounds; r++) {
+    acc += f(r);
+  }
+  sink = acc;
+  const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  return ns / ((double)rounds * (frames - 2));
+}
+
+// frame by frame from start, both channels
+template <typename B>
+static float straight(const B &b, const int start) {
+  float acc = 0.0f;
+  for (size_t i = start; i<frames - 2; i++) {
+    const rack::dsp::Frame<2> f = b[i];
+    acc += f.samples[0] + f.samples[1];
+  }
+  return acc;
+}
+
+// playback at a pitched up speed from start, both channels
+template <typename B>
+static float interpolated(const B &b, const int start) {
+  float acc = 0.0f;
+  float pos = start;
+  for (size_t i = 0; i<frames - 2; i++) {
+    pos += speed;
+    if (pos >= frames - 2) pos -= frames - 2;
+    const int xi = pos;
+    const float xf = pos - xi;
+    const rack::dsp::Frame<2> a = b[xi];
+    const rack::dsp::Frame<2> c = b[xi + 1];
+    acc += rack::math::crossfade(a.samples[0], c.samples[0], xf) + rack::math::crossfade(a.samples[1], c.samples[1], xf);
+  }
+  return acc;
+}
+
+int main() {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+  std::vector<rack::dsp::Frame<2>> in(frames);
+  for (size_t i = 0; i<frames; i++) {
+    in[i].samples[0] = u(rng);
+    in[i].samples[1] = u(rng);
+  }
+  waves::SampleBuffer<2> f, c;
+  f.reset(false);
+  c.reset(true);
+  f.append(in.data(), frames);
+  c.append(in.data(), frames);
+
+  printf("  ns per stereo read   straight  interpolated\n");
+  printf("  %-18s %10.2f %13.2f\n", "std::vector", nsPerRead([&](int r) { return straight(in, r); }), nsPerRead([&](int r) { return interpolated(in, r); }));
+  printf("  %-18s %10.2f %13.2f\n", "float storage", nsPerRead([&](int r) { return straight(f, r); }), nsPerRead([&](int r) { return interpolated(f, r); }));
+  printf("  %-18s %10.2f %13.2f\n", "16 bit storage", nsPerRead([&](int r) { return straight(c, r); }), nsPerRead([&](int r) { return interpolated(c, r); }));
+  return 0;
+}
@@ -0,0 +1,132 @@
+// waves::Published under the load the sample modules put on it : a loader publishing whole
+// new contents and holding the writer lock across its decode, an editor publishing edited
+// copies, a display reading and reclaiming, against an audio thread. The audio side enters
+// and leaves without any loop to retry : each load holds the writer lock until the audio side
+// has run a few blocks, which never happens if it waits on the writers. It must also only see
+// whole contents in publishing order, and nothing may be left retired at the end.
+
+#include "waves.hpp"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+using namespace std::chrono;
+
+static const int loads = 500;
+static const int edits = 10000;
+// audio blocks each load waits for with the writer lock held, and for how long at most
+static const long blocksPerLoad = 16;
+static const milliseconds stall(2000);
+
+enum Readers {
+  AUDIO_READER,
+  DISPLAY_READER,
+  NUM_READERS
+};
+
+// every value holds its generation, a torn or freed content shows as a mismatch
+struct Content {
+  std::vector<int> data;
+  int generation = 0;
+};
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("  "); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static bool whole(const Content *c) {
+  for (int v : c->data) {
+    if (v != c->generation) return false;
+  }
+  return true;
+}
+
+int main() {
+  waves::Published<Content, NUM_READERS> content;
+  std::mutex writer;
+  std::atomic<int> generation{0};
+  std::atomic<int> writers{2};
+  std::atomic<long> audioBlocks{0};
+  std::atomic<long> torn{0};
+  std::atomic<int> stalledLoads{0};
+
+  std::thread loader([&]() {
+    for (int i = 0; i<loads; i++) {
+      std::lock_guard<std::mutex> lock(writer);
+      const long before = audioBlocks.load();
+      Content *next = new Content();
+      next->generation = ++generation;
+      next->data.assign(4096 + (i % 7) * 1024, next->generation);
+      const auto start = steady_clock::now();
+      while ((stalledLoads.load() == 0) && (audioBlocks.load() < before + blocksPerLoad)) {
+        if (steady_clock::now() - start > stall) {
+          stalledLoads++;
+          break;
+        }
+        std::this_thread::sleep_for(microseconds(50));
+      }
+      content.publish(next);
+    }
+    writers--;
+  });
+
+  std::thread editor([&]() {
+    for (int i = 0; i<edits; i++) {
+      {
+        std::lock_guard<std::mutex> lock(writer);
+        Content *next = new Content(content.get());
+        next->generation = ++generation;
+        for (int &v : next->data) v = next->generation;
+        content.publish(next);
+      }
+      std::this_thread::yield();
+    }
+    writers--;
+  });
+
+  std::thread display([&]() {
+    while (writers.load() > 0) {
+      {
+        std::lock_guard<std::mutex> lock(writer);
+        if (content.retiring()) content.reclaim();
+      }
+      const Content *c = content.enter(DISPLAY_READER);
+      if (!whole(c)) torn++;
+      content.leave(DISPLAY_READER);
+      std::this_thread::sleep_for(milliseconds(1));
+    }
+  });
+
+  // audio, one block per pass
+  int last = 0;
+  long long worst = 0;
+  long slow = 0;
+  while (writers.load() > 0) {
+    const auto start = steady_clock::now();
+    const Content *c = content.enter(AUDIO_READER);
+    const auto entered = steady_clock::now();
+    if (!whole(c) || (c->generation < last)) torn++;
+    last = c->generation;
+    content.leave(AUDIO_READER);
+    const long long ns = duration_cast<nanoseconds>(entered - start).count();
+    worst = std::max(worst, ns);
+    slow += ns > 10000 ? 1 : 0;
+    audioBlocks++;
+    if ((audioBlocks.load() & 63) == 0) std::this_thread::yield();
+  }
+
+  loader.join();
+  editor.join();
+  display.join();
+  content.reclaim();
+
+  // the worst enter includes the audio thread being descheduled, it is reported, not checked
+  printf("  %d loads, %d edits, %ld audio blocks, worst enter %lld ns, %ld over 10us\n", loads, edits, audioBlocks.load(), worst, slow);
+  CHECK(torn.load() == 0, "%ld torn or out of order reads", torn.load());
+  CHECK(stalledLoads.load() == 0, "audio stalled during %d of the %d loads", stalledLoads.load(), loads);
+  CHECK(content.retired.empty(), "%zu contents left retired", content.retired.size());
+  CHECK(content.get().generation == generation.load(), "current is generation %d, last published %d", content.get().generation, generation.load());
+  printf("  %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
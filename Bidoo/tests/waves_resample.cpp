@@ -0,0 +1,167 @@
+// Load time and peak heap of a 5 minutes 48kHz stereo WAV loaded into a 44.1kHz engine : the
+// speex path the loaders used before (whole file decoded, then converted into a 1.5x buffer)
+// against waves::getStereoWav with each resampling quality.
+
+#include "waves.hpp"
+#include "dr_wav/dr_wav.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static const int fileRate = 48000;
+static const int engineRate = 44100;
+static const int seconds = 300;
+
+// heap in use and its peak, through operator new and the dr_wav callbacks of the speex path
+static std::atomic<size_t> heapUsed{0};
+static std::atomic<size_t> heapPeak{0};
+
+static void *counted(size_t size) {
+  size_t *p = (size_t*)malloc(size + sizeof(size_t) * 2);
+  if (!p) return NULL;
+  p[0] = size;
+  const size_t used = heapUsed += size;
+  size_t peak = heapPeak.load();
+  while ((used > peak) && !heapPeak.compare_exchange_weak(peak, used)) {}
+  return p + 2;
+}
+
+static void uncounted(void *ptr) {
+  if (!ptr) return;
+  size_t *p = (size_t*)ptr - 2;
+  heapUsed -= p[0];
+  free(p);
+}
+
+void *operator new(size_t size) {
+  void *p = counted(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  uncounted(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  uncounted(p);
+}
+
+static void *drMalloc(size_t size, void *) {
+  return counted(size);
+}
+
+static void *drRealloc(void *ptr, size_t size, void *) {
+  void *p = counted(size);
+  if (p && ptr) {
+    const size_t old = ((size_t*)ptr)[-2];
+    memcpy(p, ptr, old < size ? old : size);
+  }
+  uncounted(ptr);
+  return p;
+}
+
+static void drFree(void *ptr, void *) {
+  uncounted(ptr);
+}
+
+// getStereoWav as it was, for WAV files
+static std::vector<rack::dsp::Frame<2>> speexStereoWav(const std::string &path, const float currentSampleRate, int &sampleCount) {
+  std::vector<rack::dsp::Frame<2>> result;
+  drwav_allocation_callbacks callbacks = {NULL, drMalloc, drRealloc, drFree};
+  unsigned int c;
+  unsigned int sr;
+  drwav_uint64 sc;
+  float *pSampleData = drwav_open_file_and_read_pcm_frames_f32(path.c_str(), &c, &sr, &sc, &callbacks);
+  if (pSampleData == NULL) {
+    sampleCount = 0;
+    return result;
+  }
+  for (drwav_uint64 i = 0; i < sc * c; i += c) {
+    rack::dsp::Frame<2> frame;
+    frame.samples[0] = pSampleData[i];
+    frame.samples[1] = c == 2 ? pSampleData[i+1] : pSampleData[i];
+    result.push_back(frame);
+  }
+  sampleCount = sc;
+  drwav_free(pSampleData, &callbacks);
+
+  rack::dsp::SampleRateConverter<2> conv;
+  conv.setRates(sr, currentSampleRate);
+  conv.setQuality(SPEEX_RESAMPLER_QUALITY_DESKTOP);
+  int outCount = ceil(sampleCount * (currentSampleRate / (float)sr) * 1.5);
+  std::vector<rack::dsp::Frame<2>> subResult(outCount);
+  conv.process(&result[0], &sampleCount, &subResult[0], &outCount);
+  subResult.resize(outCount);
+  sampleCount = outCount;
+  return subResult;
+}
+
+static bool writeWav(const std::string &path) {
+  drwav_data_format format;
+  format.container = drwav_container_riff;
+  format.format = DR_WAVE_FORMAT_PCM;
+  format.channels = 2;
+  format.sampleRate = fileRate;
+  format.bitsPerSample = 16;
+  drwav wav;
+  if (!drwav_init_file_write(&wav, path.c_str(), &format, NULL)) {
+    return false;
+  }
+  std::vector<int16_t> block(2 * fileRate);
+  for (int s = 0; s < seconds; s++) {
+    for (int i = 0; i < fileRate; i++) {
+      const double t = (double)(s * fileRate + i) / fileRate;
+      block[2*i] = (int16_t)(16000.0 * sin(2.0 * M_PI * 440.0 * t));
+      block[2*i+1] = (int16_t)(16000.0 * sin(2.0 * M_PI * 660.0 * t));
+    }
+    drwav_write_pcm_frames(&wav, fileRate, block.data());
+  }
+  drwav_uninit(&wav);
+  return true;
+}
+
+static void report(const char *label, const double ms, const size_t frames) {
+  printf("  %-24s %8.1f ms %8.1f MB peak %10zu frames\n", label, ms, heapPeak.load() / 1048576.0, frames);
+}
+
+int main(int argc, char **argv) {
+  const std::string path = argc > 1 ? argv[1] : "waves_resample.wav";
+  if (!writeWav(path)) {
+    printf("  can not write %s\n", path.c_str());
+    return 1;
+  }
+  printf("  %d s stereo %d Hz into %d Hz, output alone is %.1f MB\n", seconds, fileRate, engineRate, (double)seconds * engineRate * sizeof(rack::dsp::Frame<2>) / 1048576.0);
+
+  {
+    heapPeak = heapUsed.load();
+    const size_t base = heapUsed;
+    const auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    std::vector<rack::dsp::Frame<2>> result = speexStereoWav(path, engineRate, count);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    heapPeak -= base;
+    report("speex (before)", ms, result.size());
+  }
+
+  for (int q = 0; q < waves::NUM_RESAMPLE_QUALITIES; q++) {
+    waves::setResampleQuality(q);
+    waves::setCompactSamples(false);
+    heapPeak = heapUsed.load();
+    const size_t base = heapUsed;
+    const auto start = std::chrono::steady_clock::now();
+    std::string name, extension;
+    int channels = 0, rate = 0, count = 0;
+    waves::SampleBuffer<2> result;
+    waves::getStereoWav(path, engineRate, name, extension, channels, rate, count, result);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    heapPeak -= base;
+    report(waves::resampleQualityLabels[q].c_str(), ms, result.count);
+  }
+
+  remove(path.c_str());
+  return 0;
+}
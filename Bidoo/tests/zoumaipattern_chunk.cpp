@@ -0,0 +1,122 @@
+// Round trip of the ZOUMAI binary pattern chunk : every stored field comes back, runtime
+// only bits are dropped, damaged, truncated or foreign chunks are rejected untouched.
+
+#include "zoumaipattern.hpp"
+#include <cstdio>
+#include <random>
+
+using namespace zoumaipattern;
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("  failed line %d : %s\n", __LINE__, #cond); failures++; } } while (0)
+
+static void randomize(Pattern &p, std::mt19937 &rng) {
+  std::uniform_real_distribution<float> f(-10.0f, 10.0f);
+  for (int j = 0; j<8; j++) {
+    p.tracks[j].setMainAttributes(rng());
+    p.rootNote[j] = (int)(rng() % 24) - 12;
+    p.scale[j] = rng() % 46;
+    p.quantizeCV1[j] = rng() % 2;
+    p.slideMode[j] = rng() % 2;
+    for (int k = 0; k<64; k++) {
+      TrigAttibutes &t = p.trigs[j][k];
+      t.setMainAttributes(rng());
+      t.setProbAttributes(rng());
+      t.slide = f(rng);
+      t.trim = f(rng);
+      t.length = f(rng);
+      t.pulseDistance = f(rng);
+      t.cv1 = f(rng);
+      t.cv2 = f(rng);
+    }
+  }
+}
+
+static bool same(Pattern &a, Pattern &b) {
+  for (int j = 0; j<8; j++) {
+    if (a.tracks[j].getMainAttributes() != b.tracks[j].getMainAttributes()) return false;
+    if ((a.rootNote[j] != b.rootNote[j]) || (a.scale[j] != b.scale[j])) return false;
+    if ((a.quantizeCV1[j] != b.quantizeCV1[j]) || (a.slideMode[j] != b.slideMode[j])) return false;
+    for (int k = 0; k<64; k++) {
+      TrigAttibutes &x = a.trigs[j][k];
+      TrigAttibutes &y = b.trigs[j][k];
+      const uint32_t runtime = TrigAttibutes::TRIG_INITIALIZED | TrigAttibutes::TRIG_SLEEPING;
+      if ((x.getMainAttributes() & ~runtime) != (y.getMainAttributes() & ~runtime)) return false;
+      if ((x.getProbAttributes() & ~TrigAttibutes::TRIG_INCOUNT) != (y.getProbAttributes() & ~TrigAttibutes::TRIG_INCOUNT)) return false;
+      if ((x.slide != y.slide) || (x.trim != y.trim) || (x.length != y.length)) return false;
+      if ((x.pulseDistance != y.pulseDistance) || (x.cv1 != y.cv1) || (x.cv2 != y.cv2)) return false;
+    }
+  }
+  return true;
+}
+
+static bool rejected(const std::vector<uint8_t> &data, Pattern (&reference)[8]) {
+  static Pattern target[8];
+  Pattern *targets[8];
+  for (int i = 0; i<8; i++) {
+    target[i] = reference[i];
+    targets[i] = &target[i];
+  }
+  if (patternsFromChunk(data, targets)) return false;
+  for (int i = 0; i<8; i++) {
+    if (!same(target[i], reference[i])) return false;
+  }
+  return true;
+}
+
+int main() {
+  static Pattern source[8];
+  static Pattern loaded[8];
+  Pattern *sources[8];
+  Pattern *loadeds[8];
+  std::mt19937 rng(1);
+  for (int i = 0; i<8; i++) {
+    randomize(source[i], rng);
+    sources[i] = &source[i];
+    loadeds[i] = &loaded[i];
+  }
+
+  const std::vector<uint8_t> data = patternsToChunk(sources);
+  CHECK(data.size() == patternsChunkSize);
+  CHECK(data.size() == chunk::headerSize + patternsChunkPayloadSize + chunk::checksumSize);
+  CHECK(patternsFromChunk(data, loadeds));
+  for (int i = 0; i<8; i++) {
+    CHECK(same(source[i], loaded[i]));
+    for (int j = 0; j<8; j++) {
+      for (int k = 0; k<64; k++) {
+        CHECK((loaded[i].trigs[j][k].getMainAttributes() & (TrigAttibutes::TRIG_INITIALIZED | TrigAttibutes::TRIG_SLEEPING)) == 0);
+        CHECK((loaded[i].trigs[j][k].getProbAttributes() & TrigAttibutes::TRIG_INCOUNT) == 0);
+      }
+    }
+  }
+
+  // saving what was loaded gives the same bytes
+  CHECK(patternsToChunk(loadeds) == data);
+
+  // the default pattern survives too
+  static Pattern blank[8];
+  Pattern *blanks[8];
+  for (int i = 0; i<8; i++) blanks[i] = &blank[i];
+  CHECK(patternsFromChunk(patternsToChunk(blanks), loadeds));
+  for (int i = 0; i<8; i++) CHECK(same(blank[i], loaded[i]));
+
+  std::vector<uint8_t> damaged = data;
+  damaged[chunk::headerSize + 1000] ^= 0x10;
+  CHECK(rejected(damaged, source));
+
+  std::vector<uint8_t> truncated(data.begin(), data.end() - 1);
+  CHECK(rejected(truncated, source));
+  CHECK(rejected(std::vector<uint8_t>(), source));
+
+  chunk::Writer other(patternsChunkMagic, patternsChunkVersion + 1);
+  for (size_t i = 0; i<patternsChunkPayloadSize; i++) other.u8(0);
+  CHECK(rejected(other.finish(), source));
+
+  chunk::Writer foreign(patternsChunkMagic + 1, patternsChunkVersion);
+  for (size_t i = 0; i<patternsChunkPayloadSize; i++) foreign.u8(0);
+  CHECK(rejected(foreign.finish(), source));
+
+  printf("  %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
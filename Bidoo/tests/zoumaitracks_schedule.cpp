@@ -0,0 +1,179 @@
+// ZOUMAI scheduler against the every sample path : for randomized patterns, clocks, resets and
+// edits, a player moving every track through trackMoveNext on each sample and one going through
+// trackAdvance/trackGateUpdate (what ZOUMAI::process does) must give the same gate, played trig
+// and head on every sample.
+
+#include "zoumaitracks.hpp"
+#include <cstdio>
+#include <random>
+
+using namespace zoumaipattern;
+
+static const int seeds = 48;
+static const int samples = 96000;
+
+struct Setup {
+  bool fill;
+  bool force;
+  bool kill;
+  float dice;
+};
+
+static void randomizePattern(Pattern &p, std::mt19937 &rng) {
+  std::uniform_real_distribution<float> u(0.0f, 1.0f);
+  for (int j = 0; j<8; j++) {
+    p.tracks[j].init();
+    p.tracks[j].setTrackLength(1 + rng() % 64);
+    p.tracks[j].setTrackReadMode(rng() % 5);
+    p.tracks[j].setTrackSpeed(1 + rng() % 4);
+    for (int k = 0; k<64; k++) {
+      TrigAttibutes &t = p.trigs[j][k];
+      t.init();
+      t.setTrigIndex(k);
+      t.setTrigActive(u(rng) > 0.4f);
+      t.setTrigPulseCount(rng() % 9);
+      t.setTrigProba(rng() % 8);
+      t.setTrigCount(1 + rng() % 100);
+      t.setTrigCountReset(1 + rng() % 100);
+      t.trim = (rng() % 4 == 0) ? 0.0f : (u(rng) * 2.0f - 1.0f);
+      t.length = (rng() % 8 == 0) ? 0.0f : (u(rng) * 4.0f);
+      t.pulseDistance = (rng() % 4 == 0) ? 0.0f : (u(rng) * 2.0f);
+    }
+  }
+}
+
+static void start(zoumaitracks::Tracks &t, const Pattern &p) {
+  t.work = p;
+  t.currentPattern = 0;
+  for (int i = 0; i<8; i++) {
+    t.trackHead[0][i] = 0.0f;
+    t.trackCurrentTickCount[0][i] = 0.0f;
+    t.trackLastTickCount[0][i] = 22500.0f;
+    t.trackInvalidate(i);
+  }
+}
+
+// the same edit on both players, only the scheduled one is told
+static void edit(zoumaitracks::Tracks &t, const bool scheduled, const int track, const int trig, const uint32_t what, const float value) {
+  TrigAttibutes &tr = t.work.trigs[track][trig];
+  switch (what % 6) {
+    case 0: tr.setTrigActive(!tr.getTrigActive()); break;
+    case 1: tr.length = value * 4.0f; break;
+    case 2: tr.trim = value * 2.0f - 1.0f; break;
+    case 3: tr.pulseDistance = value * 2.0f; break;
+    case 4: t.work.tracks[track].setTrackSpeed(1 + (int)(value * 3.99f)); break;
+    case 5: t.work.tracks[track].setTrackLength(1 + (int)(value * 63.99f)); break;
+  }
+  if (scheduled) {
+    t.trackInvalidate(track);
+  }
+}
+
+struct Frame {
+  float gate;
+  float head;
+  int played;
+};
+
+// one sample of the 8 tracks, the way ZOUMAI::process drives them
+static void step(zoumaitracks::Tracks &t, const bool scheduled, const bool clock, const bool reset, const Setup &s, Frame *frames) {
+  for (int i = 0; i<8; i++) {
+    const bool pNei = i == 0 ? false : t.work.tracks[i-1].getTrackPre();
+    bool held = false;
+    if (reset) {
+      t.trackReset(i, s.fill, pNei, s.force, s.kill, s.dice);
+      t.trackMoveNext(i, true, s.fill, pNei, s.force, s.kill, s.dice);
+    }
+    else if (scheduled) {
+      held = t.trackAdvance(i, clock, true, s.fill, pNei, s.force, s.kill, s.dice);
+    }
+    else {
+      t.trackMoveNext(i, clock, s.fill, pNei, s.force, s.kill, s.dice);
+    }
+    const int played = t.work.tracks[i].getTrackPlayedTrig();
+    if (!scheduled) {
+      frames[i].gate = t.trackGetGate(i, played);
+    }
+    else {
+      if (!held) {
+        t.trackGateUpdate(i);
+      }
+      frames[i].gate = t.trackGate[i];
+    }
+    frames[i].head = t.trackHead[0][i];
+    frames[i].played = played;
+  }
+}
+
+// runs samples of one seed on a player, events only depend on the seed
+static void run(zoumaitracks::Tracks &t, const bool scheduled, const Pattern &p, const int seed, std::vector<Frame> &frames, unsigned long &held) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> u(0.0f, 1.0f);
+  const Setup s = {rng() % 4 == 0, rng() % 8 == 0, rng() % 8 == 0, u(rng) - 0.5f};
+  rack::random::local().seed(seed, 1);
+  start(t, p);
+  int period = 2000 + rng() % 20000;
+  int nextClock = 0;
+  int clockMaxCount = 0;
+  frames.resize((size_t)samples * 8);
+  held = 0;
+  for (int n = 0; n<samples; n++) {
+    const bool clock = n == nextClock;
+    if (clock) {
+      if (clockMaxCount>0) {
+        for (int i = 0; i<8; i++) t.trackLastTickCount[0][i] = clockMaxCount;
+      }
+      clockMaxCount = 0;
+      // tempo drifts now and then
+      if (rng() % 8 == 0) period = 2000 + rng() % 20000;
+      nextClock = n + period;
+    }
+    else {
+      clockMaxCount++;
+    }
+    const bool reset = rng() % 40000 == 0;
+    if (rng() % 2000 == 0) {
+      const int track = rng() % 8;
+      const int trig = rng() % 64;
+      const uint32_t what = rng();
+      edit(t, scheduled, track, trig, what, u(rng));
+    }
+    step(t, scheduled, clock, reset, s, &frames[(size_t)n * 8]);
+    if (scheduled) {
+      for (int i = 0; i<8; i++) held += t.trackScheduled[i] ? 1 : 0;
+    }
+  }
+}
+
+int main() {
+  static zoumaitracks::Tracks reference;
+  static zoumaitracks::Tracks scheduled;
+  static Pattern pattern;
+  std::vector<Frame> expected;
+  std::vector<Frame> got;
+  int failures = 0;
+  unsigned long held = 0;
+  unsigned long total = 0;
+  for (int seed = 1; seed<=seeds; seed++) {
+    std::mt19937 rng(seed * 7919);
+    randomizePattern(pattern, rng);
+    unsigned long unused;
+    run(reference, false, pattern, seed, expected, unused);
+    unsigned long seedHeld;
+    run(scheduled, true, pattern, seed, got, seedHeld);
+    held += seedHeld;
+    total += (unsigned long)samples * 8;
+    for (size_t f = 0; f<expected.size(); f++) {
+      const Frame &e = expected[f];
+      const Frame &g = got[f];
+      if ((e.gate != g.gate) || (e.head != g.head) || (e.played != g.played)) {
+        printf("  seed %d sample %d track %d : gate %g/%g head %.7g/%.7g played %d/%d\n", seed, (int)(f / 8), (int)(f % 8), e.gate, g.gate, e.head, g.head, e.played, g.played);
+        failures++;
+        break;
+      }
+    }
+  }
+  printf("  %d seeds, %.1f%% of the track samples inside a scheduled interval\n", seeds, 100.0 * held / total);
+  printf("  %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}